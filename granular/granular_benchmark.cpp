@@ -0,0 +1,750 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Contact-heavy granular benchmark.
+//
+// A box container (no top) is filled with (at least) N granular particles,
+// created by a particle generator (FillBoxContainer) from candidates sampled on
+// a regular grid, in a hexagonal close packing, or with a Poisson-disk
+// distribution, which settle under gravity. Particles are created from body
+// templates, so that particles of the same shape share their collision shapes
+// and assets. The particles are either all spheres or a mix of spheres, boxes,
+// ellipsoids, and capsules of the same bounding radius. Both contact methods
+// are supported: DVI (complementarity, ChSystem) and DEM (penalty,
+// ChSystemDEM).
+//
+// The settled state is saved with WriteCheckpoint; later runs with the same
+// method, shapes, sampling, and N start from the checkpoint (warm start) instead of
+// settling again. The measurement phase then runs a fixed number of steps
+// from the settled state and reports, for each N, the steps per second, the
+// number of contacts per step, the time split between collision detection
+// (broadphase and narrowphase), the solver, and the rest of the step, and the
+// growth of the process resident memory per particle.
+//
+// To measure the effect of the body ordering on the step time, the settled
+// state is then restored from the checkpoint with the bodies sorted along a
+// space-filling curve (Morton or Hilbert), and the same number of steps is
+// measured again. Optionally, the bodies are re-sorted every few steps during
+// this second measurement (checkpoint round-trip with SortBodies); the time
+// spent re-sorting is reported separately.
+//
+// Optionally, a number of animation frames is finally recorded both with
+// WriteBodies (full-precision text) and as a compact snapshot stream, to
+// report the size reduction and the decoded pose errors of the latter.
+//
+// Usage:
+//   granular_benchmark [-m dvi|dem] [-shapes spheres|mixed] [-n <N1,N2,...>]
+//                      [-g grid|hcp|poisson] [-h <step>] [-t <settle time>] [-s <steps>]
+//                      [-j <threads>] [-o none|morton|hilbert]
+//                      [-r <resort interval>] [-a <frames>] [-f]
+//
+// Defaults: DVI, spheres, N = 1000,10000,100000, HCP sampling, step 1e-3 (DVI) or 1e-4
+// (DEM), settling for 0.5 s, 100 measured steps, 1 thread, Hilbert ordering
+// (none: no sorted measurement), no re-sorting, no animation frames. With -f,
+// existing checkpoints are ignored (and overwritten).
+// The results are recorded as metrics of the test JSON output.
+//
+// =============================================================================
+
+#include <ostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+#include "core/ChFileutils.h"
+#include "core/ChTimer.h"
+#include "core/ChMathematics.h"
+#include "physics/ChSystem.h"
+#include "physics/ChSystemDEM.h"
+
+#include "ChronoValidation_config.h"
+#include "utils/ChUtilsCreators.h"
+#include "utils/ChUtilsGeometry.h"
+#include "utils/ChUtilsInputOutput.h"
+#include "utils/ChUtilsMemory.h"
+#include "utils/ChUtilsSnapshot.h"
+#include "utils/ChUtilsTrace.h"
+
+#include "BaseTest.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local variables
+//
+static const std::string val_dir = "../RESULTS/";
+static const std::string out_dir = val_dir + "granular/";
+
+static const double radius = 0.05;       // bounding radius of a particle
+static const double density = 2000;      // particle density
+static const double spacing = 2.5;       // sampling separation (in particle radii)
+static const double hthick = 0.1;        // half-thickness of container walls
+static const double gravity = 9.80665;   // gravitational acceleration
+
+static const double snapshot_resolution = 1e-3 * radius;  // snapshot position grid
+static const int    snapshot_bits = 12;                   // snapshot bits per quaternion component
+
+// =============================================================================
+// Local functions
+//
+
+// Benchmark settings.
+struct GranularSettings {
+  bool   dem;           // DEM (true) or DVI (false) contact method
+  bool   mixed;         // mixed shapes (true) or spheres only (false)
+  utils::SamplingType sampling;    // sampling of the particle positions
+  double step;          // integration step size
+  double settle_time;   // length of the settling phase
+  int    num_steps;     // number of measured steps
+  int    num_threads;   // number of solver threads
+  bool   fresh;         // ignore existing checkpoints?
+  utils::SpaceFillingCurve curve;  // body ordering of the sorted measurement
+  int    resort_steps;  // re-sorting interval (0: never)
+  int    anim_frames;   // number of recorded animation frames
+};
+
+// Results for one number of particles.
+struct GranularPoint {
+  GranularPoint() : num_particles(0), warm_start(false), settle_time(0), steps_per_second(0),
+                    contacts_per_step(0), broad_fraction(0), narrow_fraction(0), solver_fraction(0),
+                    memory_per_particle(0), sorted_steps_per_second(0), resort_time(0),
+                    anim_compression(0), anim_pos_error(0), anim_rot_error(0) {}
+
+  int    num_particles;
+  bool   warm_start;           // started from a checkpoint?
+  double settle_time;          // wall clock time of the settling phase (seconds)
+  double steps_per_second;
+  double contacts_per_step;
+  double broad_fraction;       // fraction of the step time in the broadphase
+  double narrow_fraction;      // fraction of the step time in the narrowphase
+  double solver_fraction;      // fraction of the step time in the solver
+  double memory_per_particle;  // resident memory growth per particle (bytes)
+  double sorted_steps_per_second;  // with the bodies sorted along the curve
+  double resort_time;          // wall clock time spent re-sorting (seconds)
+  double anim_compression;     // size of text output over size of snapshot stream
+  double anim_pos_error;       // maximum decoded position error (last frame)
+  double anim_rot_error;       // maximum decoded rotation angle error (last frame)
+};
+
+// Number of particles per side, and container half-dimensions for the given
+// number of particles: a square footprint (with room for about as many
+// particles per side as there are regular grid layers), and twice that height.
+static int GetGridSide(int num_particles)
+{
+  int side = (int)std::ceil(std::pow((double)num_particles, 1.0 / 3));
+  return (side < 1) ? 1 : side;
+}
+
+static ChVector<> GetContainerHalfDims(int num_particles)
+{
+  int    side = GetGridSide(num_particles);
+  double hw = 0.5 * side * spacing * radius;
+  return ChVector<>(hw, hw, 2 * hw + spacing * radius);
+}
+
+// Create the system for the given contact method, sized for the given number
+// of particles.
+static ChSystem* CreateSystem(const GranularSettings& settings, int num_particles)
+{
+  ChVector<> hdim = GetContainerHalfDims(num_particles);
+  double scene_size = 4 * std::max(hdim.x, hdim.z);
+  unsigned int max_objects = (unsigned int)num_particles + 16;
+
+  ChSystem* system;
+  if (settings.dem) {
+    system = new ChSystemDEM(true, true, max_objects, scene_size);
+  } else {
+    system = new ChSystem(max_objects, scene_size);
+    system->SetMaxPenetrationRecoverySpeed(0.1);
+    system->SetIterLCPmaxItersSpeed(50);
+    system->SetTolForce(1e-4);
+    system->SetLcpSolverType(settings.num_threads > 1 ? ChSystem::LCP_ITERATIVE_SOR_MULTITHREAD
+                                                      : ChSystem::LCP_ITERATIVE_SOR);
+  }
+
+  system->Set_G_acc(ChVector<>(0, 0, -gravity));
+  system->SetParallelThreadNumber(settings.num_threads);
+
+  return system;
+}
+
+// Return the name of a sampling type.
+static const char* SamplingName(utils::SamplingType type)
+{
+  switch (type) {
+    case utils::REGULAR_GRID: return "grid";
+    case utils::HCP_PACK:     return "hcp";
+    default:                  return "poisson";
+  }
+}
+
+// Parse the name of a sampling type.
+static bool ParseSampling(const std::string& str, utils::SamplingType& type)
+{
+  if (str == "grid")
+    type = utils::REGULAR_GRID;
+  else if (str == "hcp")
+    type = utils::HCP_PACK;
+  else if (str == "poisson")
+    type = utils::POISSON_DISK;
+  else
+    return false;
+  return true;
+}
+
+// Return the lowest fill height (within a small fraction of the separation) at
+// which the generator produces at least the given number of particles in a
+// container with the given horizontal half-dimensions. The positions are only
+// generated, no bodies are created.
+static double GetFillHeight(utils::ChParticleGenerator& gen,
+                            utils::SamplingType         type,
+                            double                      sep,
+                            const ChVector<>&           hdim,
+                            int                         num_particles)
+{
+  std::vector<ChVector<> > pos;
+  std::vector<int>         types;
+
+  double lo = 0;
+  double hi = sep;
+  while (gen.GenerateBox(type, sep, ChVector<>(0, 0, 0.5 * hi), ChVector<>(hdim.x, hdim.y, 0.5 * hi), pos, types) <
+         num_particles) {
+    lo = hi;
+    hi *= 2;
+  }
+
+  while (hi - lo > 0.01 * sep) {
+    double mid = 0.5 * (lo + hi);
+    if (gen.GenerateBox(type, sep, ChVector<>(0, 0, 0.5 * mid), ChVector<>(hdim.x, hdim.y, 0.5 * mid), pos, types) <
+        num_particles)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  return hi;
+}
+
+// Create the container and fill it with at least the given number of
+// particles. Returns the number of particles created.
+static int CreateGranularBed(ChSystem* system, const GranularSettings& settings, int num_particles)
+{
+  ChSharedPtr<ChMaterialSurfaceBase> mat;
+
+  if (settings.dem) {
+    ChSharedPtr<ChMaterialSurfaceDEM> mat_dem(new ChMaterialSurfaceDEM);
+    mat_dem->SetYoungModulus(1e7f);
+    mat_dem->SetPoissonRatio(0.3f);
+    mat_dem->SetFriction(0.4f);
+    mat_dem->SetRestitution(0.1f);
+    mat = ChSharedPtr<ChMaterialSurfaceBase>(mat_dem);
+  } else {
+    ChSharedPtr<ChMaterialSurface> mat_dvi(new ChMaterialSurface);
+    mat_dvi->SetFriction(0.4f);
+    mat = ChSharedPtr<ChMaterialSurfaceBase>(mat_dvi);
+  }
+
+  // Particle templates, all with the same bounding radius. The particles
+  // created from a template share its shapes and assets.
+  ChVector<> box_hdims(0.6 * radius, 0.5 * radius, 0.4 * radius);
+  ChVector<> ell_hdims(radius, 0.7 * radius, 0.5 * radius);
+  double     cap_rad = 0.5 * radius;
+  double     cap_hlen = 0.5 * radius;
+
+  std::vector<utils::ChBodyTemplate*> templates;
+  templates.push_back(new utils::ChBodyTemplate(mat));
+  templates.back()->AddSphere(radius);
+  if (settings.mixed) {
+    templates.push_back(new utils::ChBodyTemplate(mat));
+    templates.back()->AddBox(box_hdims);
+    templates.push_back(new utils::ChBodyTemplate(mat));
+    templates.back()->AddEllipsoid(ell_hdims);
+    templates.push_back(new utils::ChBodyTemplate(mat));
+    templates.back()->AddCapsule(cap_rad, cap_hlen);
+  }
+
+  // All particle types are equally likely.
+  utils::ChParticleGenerator gen;
+  for (size_t k = 0; k < templates.size(); k++) {
+    templates[k]->SetDensity(density);
+    gen.AddTemplate(templates[k], 1);
+  }
+
+  // Fill the container up to the height at which the particles are created,
+  // the container being at least that tall.
+  double     sep = spacing * radius;
+  ChVector<> hdim = GetContainerHalfDims(num_particles);
+  double     height = GetFillHeight(gen, settings.sampling, sep, hdim, num_particles);
+  hdim.z = std::max(hdim.z, height);
+
+  utils::CreateBoxContainer(system, 0, mat, hdim, hthick);
+  int num_created = gen.FillBoxContainer(system, 1, settings.sampling, sep, hdim, height);
+
+  for (size_t k = 0; k < templates.size(); k++)
+    delete templates[k];
+
+  return num_created;
+}
+
+// Return true if the specified file exists.
+static bool FileExists(const std::string& filename)
+{
+  std::ifstream ifile(filename.c_str());
+  return ifile.good();
+}
+
+// Parse the name of a space-filling curve.
+static bool ParseCurve(const std::string& str, utils::SpaceFillingCurve& curve)
+{
+  if (str == "none")
+    curve = utils::CURVE_NONE;
+  else if (str == "morton")
+    curve = utils::CURVE_MORTON;
+  else if (str == "hilbert")
+    curve = utils::CURVE_HILBERT;
+  else
+    return false;
+  return true;
+}
+
+// Replace all bodies of the system with those in the checkpoint, added in
+// their order along the given curve.
+static void RestoreCheckpoint(ChSystem* system, const std::string& filename, utils::SpaceFillingCurve curve)
+{
+  system->RemoveAllBodies();
+  utils::ReadCheckpoint(system, filename, curve);
+}
+
+// Run the given number of steps, accumulating the step time and its split.
+struct StepTimes {
+  StepTimes() : step(0), broad(0), narrow(0), solver(0), contacts(0) {}
+  double step;
+  double broad;
+  double narrow;
+  double solver;
+  double contacts;
+};
+
+static void RunSteps(ChSystem* system, double step, int num_steps, StepTimes& times)
+{
+  for (int i = 0; i < num_steps; i++) {
+    system->DoStepDynamics(step);
+    times.step += system->GetTimerStep();
+    times.broad += system->GetTimerCollisionBroad();
+    times.narrow += system->GetTimerCollisionNarrow();
+    times.solver += system->GetTimerLcp();
+    times.contacts += system->GetNcontacts();
+  }
+}
+
+// Return the size of the specified file (0 if it does not exist).
+static size_t FileSize(const std::string& filename)
+{
+  std::ifstream ifile(filename.c_str(), std::ios::binary | std::ios::ate);
+  return ifile.good() ? (size_t)ifile.tellg() : 0;
+}
+
+// Record animation frames both as text and as a compact snapshot stream, and
+// compare the decoded last frame with the system state.
+static void RecordAnimation(ChSystem* system, const GranularSettings& settings, const std::string& name,
+                            GranularPoint& point)
+{
+  std::string text_file = out_dir + name + ".csv";
+  std::string snapshot_file = out_dir + name + ".snap";
+
+  size_t text_bytes = 0;
+  size_t snapshot_bytes = 0;
+  {
+    utils::ChSnapshotWriter writer(snapshot_file, snapshot_resolution, snapshot_bits);
+    for (int i = 0; i < settings.anim_frames; i++) {
+      system->DoStepDynamics(settings.step);
+      utils::WriteBodies(system, text_file);
+      text_bytes += FileSize(text_file);
+      writer.WriteFrame(system);
+    }
+    snapshot_bytes = writer.GetNumBytes();
+  }
+
+  utils::ChSnapshotReader reader(snapshot_file);
+  double time;
+  std::vector<ChVector<> > pos;
+  std::vector<ChQuaternion<> > rot;
+  std::vector<ChVector<> > last_pos;
+  std::vector<ChQuaternion<> > last_rot;
+  while (reader.ReadFrame(time, pos, rot)) {
+    last_pos.swap(pos);
+    last_rot.swap(rot);
+  }
+
+  std::vector<ChBody*>& bodies = *system->Get_bodylist();
+  if (last_pos.size() != bodies.size()) {
+    std::cout << "   warning: could not decode " << snapshot_file << std::endl;
+    return;
+  }
+
+  for (size_t i = 0; i < bodies.size(); i++) {
+    ChVector<> dp = last_pos[i] - bodies[i]->GetPos();
+    point.anim_pos_error = std::max(point.anim_pos_error, std::max(std::abs(dp.x), std::max(std::abs(dp.y), std::abs(dp.z))));
+
+    const ChQuaternion<>& q = bodies[i]->GetRot();
+    const ChQuaternion<>& r = last_rot[i];
+    double dot = std::abs(q.e0 * r.e0 + q.e1 * r.e1 + q.e2 * r.e2 + q.e3 * r.e3);
+    point.anim_rot_error = std::max(point.anim_rot_error, 2 * std::acos(std::min(dot, 1.0)));
+  }
+
+  point.anim_compression = (snapshot_bytes > 0) ? (double)text_bytes / snapshot_bytes : 0;
+}
+
+// Settle (or warm start) and measure a bed of (at least) the given number of
+// particles.
+static bool RunGranularPoint(const GranularSettings& settings, int num_particles, GranularPoint& point)
+{
+  point = GranularPoint();
+  point.num_particles = num_particles;
+
+  std::ostringstream checkpoint;
+  checkpoint << out_dir << "checkpoint_" << (settings.dem ? "dem" : "dvi") << "_"
+             << (settings.mixed ? "mixed" : "spheres") << "_" << SamplingName(settings.sampling) << "_"
+             << num_particles << ".dat";
+
+  size_t memory0 = utils::GetResidentMemory();
+
+  ChSystem* system = CreateSystem(settings, num_particles);
+
+  // Warm start from the checkpoint, if available; otherwise create the bed,
+  // let it settle, and save the checkpoint.
+  ChTimer<double> timer;
+  timer.start();
+
+  if (!settings.fresh && FileExists(checkpoint.str())) {
+    utils::ReadCheckpoint(system, checkpoint.str());
+    point.warm_start = true;
+  } else {
+    int num_created = CreateGranularBed(system, settings, num_particles);
+    if (num_created < num_particles) {
+      std::cout << "   could only create " << num_created << " particles" << std::endl;
+      delete system;
+      return false;
+    }
+
+    utils::ChTraceSpan settleSpan("settle", "step");
+    int num_settle_steps = (int)std::ceil(settings.settle_time / settings.step - 1e-6);
+    for (int i = 0; i < num_settle_steps; i++)
+      system->DoStepDynamics(settings.step);
+    settleSpan.End();
+
+    if (!utils::WriteCheckpoint(system, checkpoint.str()))
+      std::cout << "   warning: could not write checkpoint " << checkpoint.str() << std::endl;
+
+    // For a fair comparison with the sorted measurement, both measurements
+    // start from bodies created from the checkpoint.
+    if (settings.curve != utils::CURVE_NONE && FileExists(checkpoint.str()))
+      RestoreCheckpoint(system, checkpoint.str(), utils::CURVE_NONE);
+  }
+
+  timer.stop();
+  point.settle_time = timer();
+
+  // The checkpoint must contain the container and all particles (the
+  // generator creates at least the requested number).
+  if (system->GetNbodies() < num_particles + 1) {
+    std::cout << "   unexpected number of bodies (" << system->GetNbodies() << ") in "
+              << checkpoint.str() << std::endl;
+    delete system;
+    return false;
+  }
+  point.num_particles = system->GetNbodies() - 1;
+
+  // Measurement phase
+  StepTimes times;
+
+  utils::ChTraceSpan batchSpan("DoStepDynamics", "step");
+
+  timer.reset();
+  timer.start();
+  RunSteps(system, settings.step, settings.num_steps, times);
+  timer.stop();
+
+  batchSpan.End();
+
+  size_t memory1 = utils::GetResidentMemory();
+
+  point.steps_per_second = (timer() > 0) ? settings.num_steps / timer() : 0;
+  point.contacts_per_step = times.contacts / settings.num_steps;
+  if (times.step > 0) {
+    point.broad_fraction = times.broad / times.step;
+    point.narrow_fraction = times.narrow / times.step;
+    point.solver_fraction = times.solver / times.step;
+  }
+  point.memory_per_particle = (memory1 > memory0) ? (double)(memory1 - memory0) / point.num_particles : 0;
+
+  // Sorted measurement phase: restart from the settled state, with the bodies
+  // sorted along the curve, and (optionally) re-sort them periodically.
+  if (settings.curve != utils::CURVE_NONE && FileExists(checkpoint.str())) {
+    RestoreCheckpoint(system, checkpoint.str(), settings.curve);
+
+    std::ostringstream resort_file;
+    resort_file << out_dir << "resort_" << (settings.dem ? "dem" : "dvi") << "_"
+                << (settings.mixed ? "mixed" : "spheres") << "_" << SamplingName(settings.sampling) << "_"
+                << num_particles << ".dat";
+
+    StepTimes sorted_times;
+    ChTimer<double> resort_timer;
+    int interval = (settings.resort_steps > 0) ? settings.resort_steps : settings.num_steps;
+
+    utils::ChTraceSpan sortedSpan("DoStepDynamics (sorted)", "step");
+
+    timer.reset();
+    for (int i = 0; i < settings.num_steps; i += interval) {
+      if (i > 0) {
+        resort_timer.start();
+        utils::SortBodies(system, resort_file.str(), settings.curve);
+        resort_timer.stop();
+      }
+      timer.start();
+      RunSteps(system, settings.step, std::min(interval, settings.num_steps - i), sorted_times);
+      timer.stop();
+    }
+
+    sortedSpan.End();
+
+    point.sorted_steps_per_second = (timer() > 0) ? settings.num_steps / timer() : 0;
+    point.resort_time = resort_timer();
+  }
+
+  // Animation output
+  if (settings.anim_frames > 0) {
+    std::ostringstream name;
+    name << "anim_" << (settings.dem ? "dem" : "dvi") << "_" << (settings.mixed ? "mixed" : "spheres") << "_"
+         << SamplingName(settings.sampling) << "_" << num_particles;
+    RecordAnimation(system, settings, name.str(), point);
+  }
+
+  delete system;
+
+  return true;
+}
+
+// =============================================================================
+
+class granular_benchmark : public BaseTest
+{
+public:
+  granular_benchmark(const GranularSettings& settings, const std::vector<int>& sizes)
+  : BaseTest("granular_benchmark", "Chrono::Validation"),
+    m_settings(settings),
+    m_sizes(sizes),
+    m_execTime(-1)
+  {}
+  ~granular_benchmark() {}
+
+  virtual bool execute();
+  virtual double getExecutionTime() const { return m_execTime; }
+
+private:
+  GranularSettings m_settings;
+  std::vector<int> m_sizes;
+  double           m_execTime;
+};
+
+// =============================================================================
+//
+// Run all bed sizes and report the results.
+//
+bool granular_benchmark::execute()
+{
+  ChTimer<double> full;
+  full.start();
+
+  // Create output directories (if they do not already exist)
+  if (ChFileutils::MakeDirectory(val_dir.c_str()) < 0 ||
+      ChFileutils::MakeDirectory(out_dir.c_str()) < 0) {
+    std::cout << "Error creating directory " << out_dir << std::endl;
+    return false;
+  }
+
+  // Collision envelope and margin relative to the particle size (these also
+  // apply to the bodies created from a checkpoint).
+  collision::ChCollisionModel::SetDefaultSuggestedEnvelope(0.1 * radius);
+  collision::ChCollisionModel::SetDefaultSuggestedMargin(0.1 * radius);
+
+  std::string prefix = std::string(m_settings.dem ? "DEM" : "DVI") + "_" +
+                       (m_settings.mixed ? "mixed" : "spheres");
+
+  std::cout << prefix << " (" << SamplingName(m_settings.sampling) << " sampling, step " << m_settings.step << ", " << m_settings.num_steps << " steps)" << std::endl;
+  std::cout << "         N  warm   settle [s]   steps/s   contacts/step   broad   narrow   solver   mem/particle [B]"
+            << "   sorted steps/s   speedup   resort [s]" << std::endl;
+
+  std::vector<double> num_particles, warm_start, settle_time, steps_per_second, contacts_per_step;
+  std::vector<double> broad_fraction, narrow_fraction, solver_fraction, memory_per_particle;
+  std::vector<double> sorted_steps_per_second, sort_speedup, resort_time;
+  std::vector<double> anim_compression, anim_pos_error, anim_rot_error;
+  bool test_passed = true;
+
+  for (size_t k = 0; k < m_sizes.size(); k++) {
+    GranularPoint point;
+    if (!RunGranularPoint(m_settings, m_sizes[k], point)) {
+      test_passed = false;
+      continue;
+    }
+
+    double speedup = (point.steps_per_second > 0) ? point.sorted_steps_per_second / point.steps_per_second : 0;
+
+    char line[200];
+    sprintf(line, "%10d  %4s  %11.3f  %8.1f  %14.1f  %6.3f  %7.3f  %7.3f  %17.0f  %15.1f  %8.3f  %11.3f",
+            point.num_particles, point.warm_start ? "yes" : "no", point.settle_time, point.steps_per_second,
+            point.contacts_per_step, point.broad_fraction, point.narrow_fraction, point.solver_fraction,
+            point.memory_per_particle, point.sorted_steps_per_second, speedup, point.resort_time);
+    std::cout << line << std::endl;
+
+    num_particles.push_back(point.num_particles);
+    warm_start.push_back(point.warm_start ? 1 : 0);
+    settle_time.push_back(point.settle_time);
+    steps_per_second.push_back(point.steps_per_second);
+    contacts_per_step.push_back(point.contacts_per_step);
+    broad_fraction.push_back(point.broad_fraction);
+    narrow_fraction.push_back(point.narrow_fraction);
+    solver_fraction.push_back(point.solver_fraction);
+    memory_per_particle.push_back(point.memory_per_particle);
+    sorted_steps_per_second.push_back(point.sorted_steps_per_second);
+    sort_speedup.push_back(speedup);
+    resort_time.push_back(point.resort_time);
+    anim_compression.push_back(point.anim_compression);
+    anim_pos_error.push_back(point.anim_pos_error);
+    anim_rot_error.push_back(point.anim_rot_error);
+
+    if (m_settings.anim_frames > 0) {
+      sprintf(line, "            animation: %.1fx smaller, position error %.2e, rotation error %.2e",
+              point.anim_compression, point.anim_pos_error, point.anim_rot_error);
+      std::cout << line << std::endl;
+    }
+  }
+
+  addMetric(prefix + "_NumParticles", num_particles);
+  addMetric(prefix + "_WarmStart", warm_start);
+  addMetric(prefix + "_SettleTime", settle_time);
+  addMetric(prefix + "_StepsPerSecond", steps_per_second);
+  addMetric(prefix + "_ContactsPerStep", contacts_per_step);
+  addMetric(prefix + "_BroadphaseFraction", broad_fraction);
+  addMetric(prefix + "_NarrowphaseFraction", narrow_fraction);
+  addMetric(prefix + "_SolverFraction", solver_fraction);
+  addMetric(prefix + "_MemoryPerParticle", memory_per_particle);
+  if (m_settings.curve != utils::CURVE_NONE) {
+    addMetric(prefix + "_SortedStepsPerSecond", sorted_steps_per_second);
+    addMetric(prefix + "_SortSpeedup", sort_speedup);
+    addMetric(prefix + "_ResortTime", resort_time);
+  }
+  if (m_settings.anim_frames > 0) {
+    addMetric(prefix + "_AnimationCompression", anim_compression);
+    addMetric(prefix + "_AnimationPosError", anim_pos_error);
+    addMetric(prefix + "_AnimationRotError", anim_rot_error);
+    addMetric("anim_frames", m_settings.anim_frames);
+    addMetric("snapshot_resolution", snapshot_resolution);
+    addMetric("snapshot_bits", snapshot_bits);
+  }
+
+  addMetric("sampling", std::string(SamplingName(m_settings.sampling)));
+  addMetric("step_size", m_settings.step);
+  addMetric("num_steps", m_settings.num_steps);
+  addMetric("num_threads", m_settings.num_threads);
+  addMetric("ordering", std::string(m_settings.curve == utils::CURVE_MORTON    ? "morton"
+                                    : m_settings.curve == utils::CURVE_HILBERT ? "hilbert"
+                                                                               : "none"));
+  addMetric("resort_steps", m_settings.resort_steps);
+  addMetric("peak_memory", (double)utils::GetPeakResidentMemory());
+
+  full.stop();
+  m_execTime = full();
+  std::cout << "Full Execution Time = " << m_execTime << std::endl;
+
+  return test_passed;
+}
+
+int main(int argc, char* argv[])
+{
+  GranularSettings settings;
+  settings.dem = false;
+  settings.mixed = false;
+  settings.sampling = utils::HCP_PACK;
+  settings.step = 0;
+  settings.settle_time = 0.5;
+  settings.num_steps = 100;
+  settings.num_threads = 1;
+  settings.fresh = false;
+  settings.curve = utils::CURVE_HILBERT;
+  settings.resort_steps = 0;
+  settings.anim_frames = 0;
+
+  std::vector<int> sizes;
+  bool args_ok = utils::ParseSizeList("1000,10000,100000", sizes);
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-m" && i + 1 < argc) {
+      std::string method = argv[++i];
+      settings.dem = (method == "dem");
+      args_ok &= (settings.dem || method == "dvi");
+    } else if (arg == "-shapes" && i + 1 < argc) {
+      std::string shapes = argv[++i];
+      settings.mixed = (shapes == "mixed");
+      args_ok &= (settings.mixed || shapes == "spheres");
+    } else if (arg == "-n" && i + 1 < argc)
+      args_ok &= utils::ParseSizeList(argv[++i], sizes);
+    else if (arg == "-g" && i + 1 < argc)
+      args_ok &= ParseSampling(argv[++i], settings.sampling);
+    else if (arg == "-h" && i + 1 < argc)
+      settings.step = atof(argv[++i]);
+    else if (arg == "-t" && i + 1 < argc)
+      settings.settle_time = atof(argv[++i]);
+    else if (arg == "-s" && i + 1 < argc)
+      settings.num_steps = atoi(argv[++i]);
+    else if (arg == "-j" && i + 1 < argc)
+      settings.num_threads = atoi(argv[++i]);
+    else if (arg == "-o" && i + 1 < argc)
+      args_ok &= ParseCurve(argv[++i], settings.curve);
+    else if (arg == "-r" && i + 1 < argc)
+      settings.resort_steps = atoi(argv[++i]);
+    else if (arg == "-a" && i + 1 < argc)
+      settings.anim_frames = atoi(argv[++i]);
+    else if (arg == "-f")
+      settings.fresh = true;
+    else
+      args_ok = false;
+  }
+
+  if (settings.step <= 0)
+    settings.step = settings.dem ? 1e-4 : 1e-3;
+
+  if (!args_ok || settings.num_steps < 1 || settings.num_threads < 1 || settings.settle_time < 0 ||
+      settings.resort_steps < 0 || settings.anim_frames < 0) {
+    std::cout << "Usage: " << argv[0] << " [-m dvi|dem] [-shapes spheres|mixed] [-n <N1,N2,...>]" << std::endl;
+    std::cout << "       [-g grid|hcp|poisson] [-h <step>] [-t <settle time>] [-s <steps>] [-j <threads>]" << std::endl;
+    std::cout << "       [-o none|morton|hilbert] [-r <resort interval>] [-a <frames>] [-f]" << std::endl;
+    return 1;
+  }
+
+  granular_benchmark t(settings, sizes);
+  t.setArguments(argc, argv);
+  t.print();  // optional
+
+  /* Run and time test */
+  t.run();
+
+  // Return 0 if all tests passed and 1 otherwise
+  return !t.m_passed;
+}
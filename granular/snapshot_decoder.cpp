@@ -0,0 +1,73 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Decoder of compact snapshot streams (see utils/ChUtilsSnapshot.h).
+//
+// Each frame of the stream is written to a CSV file <prefix>_<frame>.csv, in
+// the format of utils::WriteBodies (position and orientation of each body).
+//
+// Usage:
+//   snapshot_decoder <snapshot file> <output prefix> [-d <delimiter>]
+//
+// Defaults: comma delimiter.
+//
+// =============================================================================
+
+#include <iostream>
+#include <string>
+
+#include "utils/ChUtilsSnapshot.h"
+
+using namespace chrono;
+
+
+int main(int argc, char* argv[])
+{
+  std::string delim = ",";
+  bool args_ok = (argc >= 3);
+
+  for (int i = 3; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-d" && i + 1 < argc)
+      delim = argv[++i];
+    else
+      args_ok = false;
+  }
+
+  if (!args_ok) {
+    std::cout << "Usage: " << argv[0] << " <snapshot file> <output prefix> [-d <delimiter>]" << std::endl;
+    return 1;
+  }
+
+  utils::ChSnapshotReader reader(argv[1]);
+  if (!reader.IsOpen()) {
+    std::cout << "Error reading snapshot stream " << argv[1] << std::endl;
+    return 1;
+  }
+
+  std::cout << "Position resolution:    " << reader.GetResolution() << std::endl;
+  std::cout << "Quaternion bits:        " << reader.GetRotationBits() << std::endl;
+  std::cout << "Position error bound:   " << reader.GetPositionErrorBound() << std::endl;
+  std::cout << "Rotation error bound:   " << reader.GetRotationErrorBound() << " rad" << std::endl;
+
+  int num_frames = utils::DecodeSnapshots(argv[1], argv[2], delim);
+  if (num_frames < 0) {
+    std::cout << "Error reading snapshot stream " << argv[1] << std::endl;
+    return 1;
+  }
+
+  std::cout << "Decoded frames:         " << num_frames << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,435 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Test for the mass properties in ChUtilsGeometry
+//
+// The gyration tensors of boxes, cylinders, and capsules (TransformGyration
+// and the Calc*Gyration functions) are compared with analytic tensors, for
+// shapes in their own frame and for offset and rotated shapes. The batch
+// mass properties (CalcMassProperties) of shapes of every supported type, with
+// arbitrary positions and orientations and spanning several chunks, are
+// compared with the scalar volume, bounding radius, and gyration functions.
+// Finally, the composite mass properties (CalcCompositeMassProperties) of
+// bodies made of several shapes are compared with analytic values.
+//
+// =============================================================================
+
+#include <ostream>
+#include <cmath>
+#include <algorithm>
+
+#include "core/ChTimer.h"
+
+#include "utils/ChUtilsGeometry.h"
+
+#include "BaseTest.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local variables
+//
+static const double tolerance = 1e-12;
+
+// =============================================================================
+
+class test_geometry : public BaseTest
+{
+public:
+  test_geometry(const std::string& testName, const std::string& testProjectName)
+  : BaseTest(testName, testProjectName),
+    m_execTime(-1)
+  {}
+  ~test_geometry() {}
+
+  virtual bool execute();
+  virtual double getExecutionTime() const { return m_execTime; }
+
+  bool Report(const std::string& name, double error);
+
+  bool TestGyration();
+  bool TestMassProperties();
+  bool TestCompositeMassProperties();
+
+private:
+  double m_execTime;
+};
+
+// =============================================================================
+//
+// Helpers.
+//
+
+// Largest difference between the elements of J and those of the symmetric
+// tensor with the given diagonal and off-diagonal (xy, xz, yz) elements,
+// relative to the largest element of the latter.
+static double TensorError(const ChMatrix33<>& J, const ChVector<>& diag, const ChVector<>& offdiag)
+{
+  double E[3][3] = {{diag.x, offdiag.x, offdiag.y},
+                    {offdiag.x, diag.y, offdiag.z},
+                    {offdiag.y, offdiag.z, diag.z}};
+  double scale = 0;
+  double error = 0;
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      scale = std::max(scale, std::abs(E[i][j]));
+      error = std::max(error, std::abs(J.GetElement(i, j) - E[i][j]));
+    }
+  }
+  return (scale > 0) ? error / scale : error;
+}
+
+// Same, for the inertia tensor of entry i of the given mass properties.
+static double TensorError(const utils::MassArrays& props, size_t i, const ChVector<>& diag, const ChVector<>& offdiag)
+{
+  ChMatrix33<> J;
+  J.SetElement(0, 0, props.Ixx[i]);
+  J.SetElement(1, 1, props.Iyy[i]);
+  J.SetElement(2, 2, props.Izz[i]);
+  J.SetElement(0, 1, props.Ixy[i]);
+  J.SetElement(1, 0, props.Ixy[i]);
+  J.SetElement(0, 2, props.Ixz[i]);
+  J.SetElement(2, 0, props.Ixz[i]);
+  J.SetElement(1, 2, props.Iyz[i]);
+  J.SetElement(2, 1, props.Iyz[i]);
+  return TensorError(J, diag, offdiag);
+}
+
+// Relative difference between two scalars.
+static double ScalarError(double value, double expected)
+{
+  double diff = std::abs(value - expected);
+  return (expected != 0) ? diff / std::abs(expected) : diff;
+}
+
+// Add the shift of a tensor (per unit mass) to the frame origin, for a
+// centroid at 'pos' (parallel axis theorem).
+static void ShiftTensor(const ChVector<>& pos, double mass, ChVector<>& diag, ChVector<>& offdiag)
+{
+  diag += ChVector<>(pos.y * pos.y + pos.z * pos.z, pos.z * pos.z + pos.x * pos.x, pos.x * pos.x + pos.y * pos.y) * mass;
+  offdiag -= ChVector<>(pos.x * pos.y, pos.x * pos.z, pos.y * pos.z) * mass;
+}
+
+// =============================================================================
+//
+// Main driver function for running the test cases.
+//
+
+bool test_geometry::execute()
+{
+  ChTimer<double> full;
+  std::cout << "test_geometry is being executed..." << std::endl;
+  full.start();
+
+  bool test_passed = true;
+
+  test_passed &= TestGyration();
+  test_passed &= TestMassProperties();
+  test_passed &= TestCompositeMassProperties();
+
+  full.stop();
+  m_execTime = full();
+  std::cout << "Full Execution Time = " << m_execTime << std::endl;
+
+  return test_passed;
+}
+
+// =============================================================================
+//
+// Main function. Creates new test and run it.
+//
+
+int main(int argc, char* argv[])
+{
+  test_geometry t("test_geometry", "Chrono::Validation");
+  t.print();  // optional
+  t.run();
+
+  // Return 0 if all tests passed and 1 otherwise
+  return !t.m_passed;
+}
+
+// =============================================================================
+//
+// Print and record the (relative) error of the named check. Returns true if
+// it is within the tolerance.
+//
+bool test_geometry::Report(const std::string& name, double error)
+{
+  bool check = (error <= tolerance);
+  std::cout << "   " << name << ": error " << error << (check ? "  Passed" : "  Failed") << std::endl;
+  addMetric(name, error);
+  return check;
+}
+
+// =============================================================================
+//
+// Gyration tensors of single shapes. The analytic tensors are written in
+// terms of the full lengths of the shapes; the capsule is a cylinder of
+// length L with two hemispherical caps, each contributing its inertia about
+// its base (that of a sphere) and its offset along the axis.
+//
+bool test_geometry::TestGyration()
+{
+  bool passed = true;
+
+  // Box (sides 2a, 2b, 2c)
+  ChVector<> hdims(0.3, 0.2, 0.1);
+  double Lx = 2 * hdims.x, Ly = 2 * hdims.y, Lz = 2 * hdims.z;
+  ChVector<> box((Ly * Ly + Lz * Lz) / 12, (Lz * Lz + Lx * Lx) / 12, (Lx * Lx + Ly * Ly) / 12);
+  passed &= Report("Gyration_Box", TensorError(utils::CalcBoxGyration(hdims), box, ChVector<>(0, 0, 0)));
+
+  // Cylinder (radius r, length L, axis Y)
+  double r = 0.25;
+  double hlen = 0.4;
+  double L = 2 * hlen;
+  ChVector<> cyl((3 * r * r + L * L) / 12, r * r / 2, (3 * r * r + L * L) / 12);
+  passed &= Report("Gyration_Cylinder", TensorError(utils::CalcCylinderGyration(r, hlen), cyl, ChVector<>(0, 0, 0)));
+
+  // Capsule (radius r, cylinder length L, axis Y)
+  double mc = CH_C_PI * r * r * L;
+  double ms = (4.0 / 3.0) * CH_C_PI * r * r * r;
+  double cap_axial = mc * r * r / 2 + ms * 2 * r * r / 5;
+  double cap_trans = mc * (L * L / 12 + r * r / 4) + ms * (2 * r * r / 5 + L * L / 4 + 3 * L * r / 8);
+  ChVector<> cap(cap_trans, cap_axial, cap_trans);
+  cap *= 1 / (mc + ms);
+  passed &= Report("Gyration_Capsule", TensorError(utils::CalcCapsuleGyration(r, hlen), cap, ChVector<>(0, 0, 0)));
+  passed &= Report("Volume_Capsule", ScalarError(utils::CalcCapsuleVolume(r, hlen), mc + ms));
+  passed &= Report("Gyration_CapsuleSphere",
+                   TensorError(utils::CalcCapsuleGyration(r, 0), ChVector<>(1, 1, 1) * (2 * r * r / 5), ChVector<>(0, 0, 0)));
+
+  // Rotation about Z by an angle t: the gyrations of the X and Y axes mix,
+  //   Jxx = gx c^2 + gy s^2,  Jyy = gx s^2 + gy c^2,  Jxy = (gx - gy) c s
+  double t = CH_C_PI / 6;
+  double c = std::cos(t);
+  double s = std::sin(t);
+  ChQuaternion<> rotZ = Q_from_AngAxis(t, ChVector<>(0, 0, 1));
+  ChVector<> box_rot(box.x * c * c + box.y * s * s, box.x * s * s + box.y * c * c, box.z);
+  ChVector<> box_rot_off((box.x - box.y) * c * s, 0, 0);
+  passed &= Report("Gyration_BoxRotated",
+                   TensorError(utils::CalcBoxGyration(hdims, ChVector<>(0, 0, 0), rotZ), box_rot, box_rot_off));
+
+  // Offset and rotated box: the rotated tensor shifted to the frame origin
+  ChVector<> pos(0.5, -1.0, 2.0);
+  ChVector<> box_shift = box_rot;
+  ChVector<> box_shift_off = box_rot_off;
+  ShiftTensor(pos, 1, box_shift, box_shift_off);
+  passed &= Report("Gyration_BoxOffsetRotated",
+                   TensorError(utils::CalcBoxGyration(hdims, pos, rotZ), box_shift, box_shift_off));
+
+  ChMatrix33<> J;
+  J.SetElement(0, 0, box.x);
+  J.SetElement(1, 1, box.y);
+  J.SetElement(2, 2, box.z);
+  utils::TransformGyration(J, pos, rotZ);
+  passed &= Report("TransformGyration", TensorError(J, box_shift, box_shift_off));
+
+  // Rotation about X by 90 degrees: the cylinder and capsule axes along Z
+  ChQuaternion<> rotX = Q_from_AngAxis(CH_C_PI / 2, ChVector<>(1, 0, 0));
+  ChVector<> cyl_z(cyl.x, cyl.z, cyl.y);
+  ChVector<> cap_z(cap.x, cap.z, cap.y);
+  ChVector<> cyl_off(0, 0, 0);
+  ChVector<> cap_off(0, 0, 0);
+  ShiftTensor(pos, 1, cyl_z, cyl_off);
+  ShiftTensor(pos, 1, cap_z, cap_off);
+  passed &= Report("Gyration_CylinderOffsetRotated",
+                   TensorError(utils::CalcCylinderGyration(r, hlen, pos, rotX), cyl_z, cyl_off));
+  passed &= Report("Gyration_CapsuleOffsetRotated",
+                   TensorError(utils::CalcCapsuleGyration(r, hlen, pos, rotX), cap_z, cap_off));
+
+  return passed;
+}
+
+// =============================================================================
+//
+// Batch mass properties of shapes of every supported type (and one of an
+// unsupported type) with various dimensions, densities, positions, and
+// orientations, over several chunks. Each shape is compared with the scalar
+// functions: volume, bounding radius, centroid (the shape position), and
+// inertia (mass times the gyration of the rotated shape about its centroid).
+//
+bool test_geometry::TestMassProperties()
+{
+  static const collision::ShapeType types[] = {collision::SPHERE, collision::ELLIPSOID, collision::BOX,
+                                               collision::CAPSULE, collision::CYLINDER, collision::CONE};
+  static const int num_types = sizeof(types) / sizeof(types[0]);
+  static const int num_shapes = 1000;
+
+  utils::ShapeArrays shapes;
+  for (int i = 0; i < num_shapes; i++) {
+    ChVector<> dims(0.1 + 0.01 * (i % 7), 0.2 + 0.01 * (i % 5), 0.15 + 0.01 * (i % 3));
+    ChVector<> pos(0.01 * i, -0.02 * (i % 11), 0.5 - 0.003 * i);
+    ChVector<> axis(1 + i % 3, -0.5 * (i % 4), 1);
+    axis.Normalize();
+    ChQuaternion<> rot = Q_from_AngAxis(0.01 * i, axis);
+    shapes.Add(types[i % num_types], dims, 1000 + i, pos, rot);
+  }
+
+  utils::MassArrays props;
+  utils::CalcMassProperties(shapes, props);
+
+  double volume_error = 0;
+  double bradius_error = 0;
+  double com_error = 0;
+  double inertia_error = 0;
+  double unsupported = 0;
+
+  for (int i = 0; i < num_shapes; i++) {
+    ChVector<> dims(shapes.dim_x[i], shapes.dim_y[i], shapes.dim_z[i]);
+    ChQuaternion<> rot(shapes.rot_e0[i], shapes.rot_e1[i], shapes.rot_e2[i], shapes.rot_e3[i]);
+    ChVector<> origin(0, 0, 0);
+
+    double       volume = 0;
+    double       bradius = 0;
+    ChMatrix33<> J;
+    switch (shapes.type[i]) {
+    case collision::SPHERE:
+      volume = utils::CalcSphereVolume(dims.x);
+      bradius = utils::CalcSphereBradius(dims.x);
+      J = utils::CalcSphereGyration(dims.x, origin, rot);
+      break;
+    case collision::ELLIPSOID:
+      volume = utils::CalcEllipsoidVolume(dims);
+      bradius = utils::CalcEllipsoidBradius(dims);
+      J = utils::CalcEllipsoidGyration(dims, origin, rot);
+      break;
+    case collision::BOX:
+      volume = utils::CalcBoxVolume(dims);
+      bradius = utils::CalcBoxBradius(dims);
+      J = utils::CalcBoxGyration(dims, origin, rot);
+      break;
+    case collision::CAPSULE:
+      volume = utils::CalcCapsuleVolume(dims.x, dims.y);
+      bradius = utils::CalcCapsuleBradius(dims.x, dims.y);
+      J = utils::CalcCapsuleGyration(dims.x, dims.y, origin, rot);
+      break;
+    case collision::CYLINDER:
+      volume = utils::CalcCylinderVolume(dims.x, dims.y);
+      bradius = utils::CalcCylinderBradius(dims.x, dims.y);
+      J = utils::CalcCylinderGyration(dims.x, dims.y, origin, rot);
+      break;
+    default:
+      unsupported = std::max(unsupported, std::abs(props.volume[i]) + std::abs(props.mass[i]) +
+                                              std::abs(props.Ixx[i]) + std::abs(props.Iyy[i]) +
+                                              std::abs(props.Izz[i]));
+      continue;
+    }
+
+    double mass = volume * shapes.density[i];
+    ChVector<> com(props.com_x[i], props.com_y[i], props.com_z[i]);
+    ChVector<> pos(shapes.pos_x[i], shapes.pos_y[i], shapes.pos_z[i]);
+
+    volume_error = std::max(volume_error, std::max(ScalarError(props.volume[i], volume), ScalarError(props.mass[i], mass)));
+    bradius_error = std::max(bradius_error, ScalarError(props.bradius[i], bradius));
+    com_error = std::max(com_error, (com - pos).Length());
+
+    ChVector<> diag(J.GetElement(0, 0), J.GetElement(1, 1), J.GetElement(2, 2));
+    ChVector<> offdiag(J.GetElement(0, 1), J.GetElement(0, 2), J.GetElement(1, 2));
+    inertia_error = std::max(inertia_error, TensorError(props, i, diag * mass, offdiag * mass));
+  }
+
+  bool passed = props.Size() == (size_t)num_shapes;
+  passed &= Report("MassProperties_Volume", volume_error);
+  passed &= Report("MassProperties_BoundingRadius", bradius_error);
+  passed &= Report("MassProperties_Centroid", com_error);
+  passed &= Report("MassProperties_Inertia", inertia_error);
+  passed &= Report("MassProperties_Unsupported", unsupported);
+
+  return passed;
+}
+
+// =============================================================================
+//
+// Composite mass properties of three bodies:
+//  - two spheres of different sizes and densities at arbitrary positions; the
+//    centroidal inertia is the sum of the sphere inertias plus that of the
+//    reduced mass m1 m2 / (m1 + m2) at their separation;
+//  - a dumbbell (two equal spheres at the ends of a rod, a cylinder rotated
+//    to the X axis), offset from the body frame origin;
+//  - a body without shapes.
+// A shape with an invalid body index must be ignored.
+//
+bool test_geometry::TestCompositeMassProperties()
+{
+  utils::ShapeArrays shapes;
+  std::vector<int>   body;
+
+  // Two spheres
+  double r1 = 0.1, rho1 = 2000;
+  double r2 = 0.2, rho2 = 500;
+  ChVector<> p1(0.3, -0.2, 0.5);
+  ChVector<> p2(-0.1, 0.4, 0.2);
+  shapes.Add(collision::SPHERE, ChVector<>(r1, 0, 0), rho1, p1);
+  body.push_back(0);
+  shapes.Add(collision::SPHERE, ChVector<>(r2, 0, 0), rho2, p2);
+  body.push_back(0);
+
+  // Shape with an invalid body index (would dominate the first body)
+  shapes.Add(collision::BOX, ChVector<>(1, 1, 1), 1e6, p1);
+  body.push_back(-1);
+
+  // Dumbbell around 'c0': spheres of radius rs at distance d on either side,
+  // rod of radius rr and half-length d along X.
+  double rs = 0.05, rr = 0.01, d = 0.3, rho = 7800;
+  ChVector<> c0(1.0, 2.0, -0.5);
+  ChQuaternion<> rod_rot = Q_from_AngAxis(CH_C_PI / 2, ChVector<>(0, 0, 1));
+  shapes.Add(collision::SPHERE, ChVector<>(rs, 0, 0), rho, c0 + ChVector<>(d, 0, 0));
+  body.push_back(1);
+  shapes.Add(collision::SPHERE, ChVector<>(rs, 0, 0), rho, c0 - ChVector<>(d, 0, 0));
+  body.push_back(1);
+  shapes.Add(collision::CYLINDER, ChVector<>(rr, d, 0), rho, c0, rod_rot);
+  body.push_back(1);
+
+  utils::MassArrays props;
+  utils::CalcCompositeMassProperties(shapes, body, 3, props);
+
+  bool passed = props.Size() == 3;
+
+  // Two spheres
+  double v1 = (4.0 / 3.0) * CH_C_PI * r1 * r1 * r1;
+  double v2 = (4.0 / 3.0) * CH_C_PI * r2 * r2 * r2;
+  double m1 = rho1 * v1;
+  double m2 = rho2 * v2;
+  double m = m1 + m2;
+  ChVector<> com = (p1 * m1 + p2 * m2) / m;
+  ChVector<> diag = ChVector<>(1, 1, 1) * (0.4 * (m1 * r1 * r1 + m2 * r2 * r2));
+  ChVector<> offdiag(0, 0, 0);
+  ShiftTensor(p1 - p2, m1 * m2 / m, diag, offdiag);
+
+  ChVector<> com0(props.com_x[0], props.com_y[0], props.com_z[0]);
+  passed &= Report("Composite_Spheres_Mass",
+                   std::max(ScalarError(props.mass[0], m), ScalarError(props.volume[0], v1 + v2)));
+  passed &= Report("Composite_Spheres_Centroid", (com0 - com).Length());
+  passed &= Report("Composite_Spheres_Inertia", TensorError(props, 0, diag, offdiag));
+  passed &= Report("Composite_Spheres_BoundingRadius",
+                   ScalarError(props.bradius[0], std::max(p1.Length() + r1, p2.Length() + r2)));
+
+  // Dumbbell
+  double ms = rho * (4.0 / 3.0) * CH_C_PI * rs * rs * rs;
+  double mr = rho * CH_C_PI * rr * rr * 2 * d;
+  double Ixx = 2 * 0.4 * ms * rs * rs + 0.5 * mr * rr * rr;
+  double Iyy = 2 * (0.4 * ms * rs * rs + ms * d * d) + mr * (3 * rr * rr + 4 * d * d) / 12;
+
+  ChVector<> com1(props.com_x[1], props.com_y[1], props.com_z[1]);
+  passed &= Report("Composite_Dumbbell_Mass", ScalarError(props.mass[1], 2 * ms + mr));
+  passed &= Report("Composite_Dumbbell_Centroid", (com1 - c0).Length());
+  passed &= Report("Composite_Dumbbell_Inertia", TensorError(props, 1, ChVector<>(Ixx, Iyy, Iyy), ChVector<>(0, 0, 0)));
+
+  // Empty body
+  passed &= Report("Composite_Empty", std::abs(props.mass[2]) + std::abs(props.volume[2]) + std::abs(props.Ixx[2]) +
+                                          std::abs(props.Iyy[2]) + std::abs(props.Izz[2]));
+
+  return passed;
+}
@@ -0,0 +1,256 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Test for the particle generation in ChUtilsCreators
+//
+// Particles are generated in a box with each sampling type, with a single
+// particle size and with a mix of sizes, and with a candidate separation equal
+// to, larger than, and smaller than the largest bounding diameter. For every
+// generated set, the bounding spheres of the particles must lie inside the box
+// and must not overlap. In addition, the candidates of a hexagonal close
+// packing must be 'sep' apart, with 12 neighbors at that distance away from
+// the box boundary (6 for a regular grid), and Poisson-disk candidates must be
+// at least 'sep' apart with a nearest neighbor closer than '2 sep'.
+//
+// =============================================================================
+
+#include <ostream>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include "core/ChTimer.h"
+#include "physics/ChMaterialSurface.h"
+
+#include "utils/ChUtilsCreators.h"
+
+#include "BaseTest.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local variables
+//
+static const double radius = 0.05;
+static const ChVector<> center(0.1, -0.2, 0.3);
+static const ChVector<> hdims(0.4, 0.3, 0.35);
+
+static const char* sampling_names[] = {"Grid", "HCP", "Poisson"};
+
+// =============================================================================
+
+class test_particle_generator : public BaseTest
+{
+public:
+  test_particle_generator(const std::string& testName, const std::string& testProjectName)
+  : BaseTest(testName, testProjectName),
+    m_execTime(-1)
+  {}
+  ~test_particle_generator() {}
+
+  virtual bool execute();
+  virtual double getExecutionTime() const { return m_execTime; }
+
+  bool TestSampling(utils::SamplingType type, double sep);
+  bool TestGenerator(const std::string& name, utils::SamplingType type, double sep, bool mixed);
+
+private:
+  double m_execTime;
+};
+
+// =============================================================================
+//
+// Main driver function for running the test cases.
+//
+
+bool test_particle_generator::execute()
+{
+  ChTimer<double> full;
+  std::cout << "test_particle_generator is being executed..." << std::endl;
+  full.start();
+
+  bool test_passed = true;
+
+  // Candidate positions
+  for (int type = utils::REGULAR_GRID; type <= utils::POISSON_DISK; type++)
+    test_passed &= TestSampling((utils::SamplingType)type, 2 * radius);
+
+  for (int type = utils::REGULAR_GRID; type <= utils::POISSON_DISK; type++) {
+    utils::SamplingType sampling = (utils::SamplingType)type;
+
+    // Single size: candidates touching, spaced apart, and overlapping
+    test_passed &= TestGenerator("Single_Touching", sampling, 2 * radius, false);
+    test_passed &= TestGenerator("Single_Spaced", sampling, 2.5 * radius, false);
+    test_passed &= TestGenerator("Single_Close", sampling, 1.2 * radius, false);
+
+    // Mix of sizes: default separation (largest bounding diameter), and
+    // candidates closer than the largest particles
+    test_passed &= TestGenerator("Mixed_Default", sampling, 0, true);
+    test_passed &= TestGenerator("Mixed_Close", sampling, 1.2 * radius, true);
+  }
+
+  full.stop();
+  m_execTime = full();
+  std::cout << "Full Execution Time = " << m_execTime << std::endl;
+
+  return test_passed;
+}
+
+// =============================================================================
+//
+// Main function. Creates new test and run it.
+//
+
+int main(int argc, char* argv[])
+{
+  test_particle_generator t("test_particle_generator", "Chrono::Validation");
+  t.print();  // optional
+  t.run();
+
+  // Return 0 if all tests passed and 1 otherwise
+  return !t.m_passed;
+}
+
+// =============================================================================
+//
+// Sample candidate positions in the box with the given separation and check
+// their spacing: no two candidates closer than 'sep', and the number of
+// neighbors at distance 'sep' of each lattice candidate at least 'sep' away
+// from the box boundary (12 in a hexagonal close packing, 6 on a regular
+// grid), or the distance to the nearest neighbor of each Poisson-disk candidate
+// (less than '2 sep'). Returns true if all checks pass.
+//
+bool test_particle_generator::TestSampling(utils::SamplingType type, double sep)
+{
+  std::vector<ChVector<> > points;
+  utils::SampleBox(type, sep, center, hdims, points, 7);
+
+  int    expected_neighbors = (type == utils::HCP_PACK) ? 12 : 6;
+  double min_dist = DBL_MAX;
+  double max_nearest = 0;
+  int    num_interior = 0;
+  int    num_bad_interior = 0;
+  int    num_outside = 0;
+
+  for (size_t i = 0; i < points.size(); i++) {
+    const ChVector<>& p = points[i];
+    ChVector<> d = p - center;
+    if (std::abs(d.x) > hdims.x + 1e-12 || std::abs(d.y) > hdims.y + 1e-12 || std::abs(d.z) > hdims.z + 1e-12)
+      num_outside++;
+
+    double nearest = DBL_MAX;
+    int    neighbors = 0;
+    for (size_t j = 0; j < points.size(); j++) {
+      if (j == i)
+        continue;
+      double dist = (points[j] - p).Length();
+      nearest = std::min(nearest, dist);
+      if (std::abs(dist - sep) < 1e-9 * sep)
+        neighbors++;
+    }
+    min_dist = std::min(min_dist, nearest);
+    max_nearest = std::max(max_nearest, nearest);
+
+    bool interior = std::abs(d.x) + sep < hdims.x && std::abs(d.y) + sep < hdims.y && std::abs(d.z) + sep < hdims.z;
+    if (type != utils::POISSON_DISK && interior) {
+      num_interior++;
+      if (neighbors != expected_neighbors)
+        num_bad_interior++;
+    }
+  }
+
+  bool check = !points.empty() && num_outside == 0 && min_dist > sep * (1 - 1e-9);
+  if (type == utils::POISSON_DISK)
+    check &= max_nearest < 2 * sep;
+  else
+    check &= num_interior > 0 && num_bad_interior == 0;
+
+  std::cout << "   sample " << sampling_names[type] << ": " << points.size() << " candidates, "
+            << num_outside << " outside, min distance " << min_dist / sep << " sep, max nearest "
+            << max_nearest / sep << " sep";
+  if (type != utils::POISSON_DISK)
+    std::cout << ", " << num_bad_interior << " of " << num_interior << " interior without "
+              << expected_neighbors << " neighbors";
+  std::cout << (check ? "  Passed" : "  Failed") << std::endl;
+
+  std::string metric = std::string("Sample_") + sampling_names[type];
+  addMetric(metric + "_NumCandidates", (double)points.size());
+  addMetric(metric + "_MinDistance", min_dist / sep);
+  addMetric(metric + "_MaxNearest", max_nearest / sep);
+
+  return check;
+}
+
+// =============================================================================
+//
+// Generate spheres (with 'mixed', spheres of three sizes with different
+// frequencies) in the box with the given sampling type and separation, and
+// check that all bounding spheres are inside the box and that no two of them
+// overlap. Returns true if particles were generated and all checks pass.
+//
+bool test_particle_generator::TestGenerator(const std::string&  name,
+                                            utils::SamplingType type,
+                                            double              sep,
+                                            bool                mixed)
+{
+  ChSharedPtr<ChMaterialSurface> mat_dvi(new ChMaterialSurface);
+  ChSharedPtr<ChMaterialSurfaceBase> mat(mat_dvi);
+
+  utils::ChBodyTemplate large(mat);
+  utils::ChBodyTemplate medium(mat);
+  utils::ChBodyTemplate small(mat);
+  large.AddSphere(radius);
+  medium.AddSphere(0.7 * radius);
+  small.AddSphere(0.4 * radius);
+
+  utils::ChParticleGenerator gen;
+  gen.SetSeed(3);
+  gen.AddTemplate(&large, 1);
+  if (mixed) {
+    gen.AddTemplate(&medium, 2);
+    gen.AddTemplate(&small, 3);
+  }
+  double radii[] = {large.GetBoundingRadius(), medium.GetBoundingRadius(), small.GetBoundingRadius()};
+
+  std::vector<ChVector<> > pos;
+  std::vector<int>         types;
+  int num = gen.GenerateBox(type, sep, center, hdims, pos, types);
+
+  int num_outside = 0;
+  int num_overlaps = 0;
+  for (int i = 0; i < num; i++) {
+    double     r = radii[types[i]];
+    ChVector<> d = pos[i] - center;
+    if (std::abs(d.x) + r > hdims.x + 1e-12 || std::abs(d.y) + r > hdims.y + 1e-12 ||
+        std::abs(d.z) + r > hdims.z + 1e-12)
+      num_outside++;
+    for (int j = i + 1; j < num; j++) {
+      double dist = (pos[j] - pos[i]).Length();
+      if (dist < (r + radii[types[j]]) * (1 - 1e-9))
+        num_overlaps++;
+    }
+  }
+
+  bool check = num > 0 && num == (int)pos.size() && pos.size() == types.size() && num_outside == 0 &&
+               num_overlaps == 0 && num <= gen.GetNumCandidates();
+
+  std::cout << "   generate " << name << " (" << sampling_names[type] << "): " << num << " of "
+            << gen.GetNumCandidates() << " candidates, " << num_outside << " outside, " << num_overlaps
+            << " overlaps" << (check ? "  Passed" : "  Failed") << std::endl;
+
+  addMetric(name + "_" + sampling_names[type] + "_NumParticles", (double)num);
+
+  return check;
+}
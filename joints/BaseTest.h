@@ -13,12 +13,18 @@
 #include <string>
 #include <vector>
 #include <cstdio>
+#include <cstdlib>
+#include <ctime>
 
 #define RAPIDJSON_HAS_STDSTRING 1
-#include "../include/rapidjson/document.h"
 #include "../include/rapidjson/stringbuffer.h"
-#include "../include/rapidjson/prettywriter.h"
-#include "../include/rapidjson/filewritestream.h"
+#include "../include/rapidjson/writer.h"
+
+#include "ChronoValidation_config.h"
+#include "utils/ChUtilsJsonWriter.h"
+#include "utils/ChUtilsPerfHistory.h"
+#include "utils/ChUtilsResults.h"
+#include "utils/ChUtilsTrace.h"
 
 
 
@@ -29,90 +35,114 @@ public:
   bool        m_passed;      ///< Did the test pass or fail?
 
   /// Constructor: Every test has to have a name and an associated project to it.
+  /// The JSON result is streamed to the results directory: metrics are written
+  /// as they are added, so memory use does not grow with the results.
   BaseTest(const std::string& testName, const std::string& testProjectName)
   : m_name(testName),
     m_projectName(testProjectName),
-    m_passed(false)
+    m_passed(false),
+    m_host(chrono::utils::GetHostName()),
+    m_startTime(time(NULL)),
+    m_perfRegression(false),
+    m_failOnRegression(getenv("CHRONO_VALIDATION_FAIL_ON_REGRESSION") != NULL)
   {
-    // Initialize JSON object
-    m_testJson.SetObject();
-    rapidjson::Document::AllocatorType& allocator = m_testJson.GetAllocator(); ///< Allocates space in m_testjson.
- 
-    /// Rapidjson variables to populate and append to json object
-    rapidjson::Value jsonName; 
-    rapidjson::Value jsonProject;
-    m_jsonMetrics.SetObject();
-
-    // Set Values to json elements. Cast c strings to rapidjson proper string type.
-    jsonName.SetString(rapidjson::StringRef(m_name.c_str()));
-    jsonProject.SetString(rapidjson::StringRef(m_projectName.c_str()));
-
-    // Add values to JSON File
-    m_testJson.AddMember("name", jsonName, allocator);
-    m_testJson.AddMember("project_name", jsonProject, allocator);
-
+    std::string resultsDir = getResultsDir();
+    if (!resultsDir.empty() && !m_json.Open(withSeparator(resultsDir) + m_name + ".json"))
+      std::cout << "Error writing test results to " << resultsDir << std::endl;
+
+    // Identify the test and the run: revision, host, and build type.
+    m_json.Member("name", m_name);
+    m_json.Member("project_name", m_projectName);
+    m_json.Member("revision", VALIDATION_GIT_REVISION);
+    m_json.Member("host", m_host);
+    m_json.Member("build_type", VALIDATION_BUILD_TYPE);
+
+    // Metrics are streamed into a nested object until the test is finalized.
+    m_json.StartObject("metrics");
   }
 
   virtual ~BaseTest() {}
 
   /// Main function for running the test
+  /// If the CHRONO_VALIDATION_TRACE environment variable is set, a timeline of
+  /// the run is written to that file in Chrome Trace Event Format.
   void run() {
 
+    if (!chrono::utils::ChTrace::IsEnabled())
+      chrono::utils::ChTrace::EnableFromEnvironment();
+
+    chrono::utils::ChTrace::SetThreadName("main");
+    chrono::utils::ChTraceSpan span(m_name, "test");
+
     m_passed = execute();
+    span.End();
+
     finalizeJson();
+
+    chrono::utils::ChTrace::Write();
+  }
+
+  /// Record the command line arguments of the run (all but the program name).
+  /// Runs of the same test with different arguments (e.g. case selection or
+  /// number of threads) are compared against separate performance baselines.
+  void setArguments(int argc, char* argv[]) {
+
+    m_signature.clear();
+    for (int i = 1; i < argc; i++) {
+      if (i > 1)
+        m_signature += " ";
+      m_signature += argv[i];
+    }
   }
 
   /// Add a test-specific metric (a key-value pair)
   void addMetric(const std::string& metricName,
                  double             metricValue) {
 
-    rapidjson::Document::AllocatorType& allocator = m_testJson.GetAllocator(); ///< Allocates space in m_testjson.   
-    rapidjson::Value metricNameV(metricName, allocator);
-    rapidjson::Value metricValueV(metricValue);
-    m_jsonMetrics.AddMember(metricNameV, metricValueV, allocator);
-
+    m_json.Member(metricName, metricValue);
+    m_scalarMetrics.push_back(std::make_pair(metricName, metricValue));
   }
   
   void addMetric(const std::string& metricName,
                  int                metricValue) {
 
-    rapidjson::Document::AllocatorType& allocator = m_testJson.GetAllocator(); ///< Allocates space in m_testjson.
-    rapidjson::Value metricNameV(metricName, allocator);
-    rapidjson::Value metricValueV(metricValue);
-    m_jsonMetrics.AddMember(metricNameV, metricValueV, allocator);
+    m_json.Member(metricName, metricValue);
+    m_scalarMetrics.push_back(std::make_pair(metricName, (double)metricValue));
   }
 
   void addMetric(const std::string& metricName,
                  uint64_t                metricValue) {
 
-    rapidjson::Document::AllocatorType& allocator = m_testJson.GetAllocator(); ///< Allocates space in m_testjson.
-    rapidjson::Value metricNameV(metricName, allocator);
-    rapidjson::Value metricValueV(metricValue);
-    m_jsonMetrics.AddMember(metricNameV, metricValueV, allocator);
+    m_json.Member(metricName, metricValue);
+    m_scalarMetrics.push_back(std::make_pair(metricName, (double)metricValue));
   }
 
   void addMetric(const std::string& metricName,
                  const std::string& metricValue) {
 
-    rapidjson::Document::AllocatorType& allocator = m_testJson.GetAllocator(); ///< Allocates space in m_testjson.   
-    rapidjson::Value metricNameV(metricName, allocator);
-    rapidjson::Value metricValueV(metricValue, allocator);
-    m_jsonMetrics.AddMember(metricNameV, metricValueV, allocator);
+    m_json.Member(metricName, metricValue);
   }
 
-  void addMetric(const std::string&   metricName,
-                 std::vector<double>& metricValue) {
-    // append to JSON document
-    rapidjson::Document::AllocatorType& allocator = m_testJson.GetAllocator(); ///< Allocates space in m_testjson.   
-    rapidjson::Value jsonMetricValue(rapidjson::kArrayType);
+  void addMetric(const std::string&         metricName,
+                 const std::vector<double>& metricValue) {
 
-    for (std::vector<double>::iterator itr = metricValue.begin(); itr != metricValue.end(); ++itr){
-      jsonMetricValue.PushBack(*itr, allocator);
-    }
+    m_json.Member(metricName, metricValue);
+  }
 
-    rapidjson::Value metricNameV(metricName.c_str(), allocator);
-    m_jsonMetrics.AddMember(metricNameV, jsonMetricValue, allocator);
+  /// Add an array metric whose elements are appended incrementally (e.g. one
+  /// per simulation step) through the returned handle. Several array metrics
+  /// can be grown at the same time; each uses a bounded amount of memory. The
+  /// array is written when closed with closeArrayMetric(), or at the end of
+  /// the test.
+  chrono::utils::ChJsonArrayStream* addArrayMetric(const std::string& metricName) {
 
+    return m_json.OpenArray(metricName);
+  }
+
+  /// Close an array metric obtained from addArrayMetric().
+  void closeArrayMetric(chrono::utils::ChJsonArrayStream* metric) {
+
+    m_json.CloseArray(metric);
   }
   
 
@@ -122,6 +152,47 @@ public:
   /// Return total execution time for this test.
   virtual double getExecutionTime() const = 0;
 
+  /// Directory where the JSON result of each test is written.
+  /// Can be overwritten with the CHRONO_VALIDATION_RESULTS_DIR environment
+  /// variable (with or without a trailing separator). An empty string disables
+  /// writing individual result files.
+  static std::string getResultsDir() {
+    const char* dir = getenv("CHRONO_VALIDATION_RESULTS_DIR");
+    return dir ? std::string(dir) : std::string(VALIDATION_RESULTS_DIR);
+  }
+
+  /// Performance history file (JSON Lines) to which every run is appended.
+  /// Can be overwritten with the CHRONO_VALIDATION_HISTORY_FILE environment
+  /// variable. An empty string disables the performance history.
+  static std::string getHistoryFile() {
+    const char* file = getenv("CHRONO_VALIDATION_HISTORY_FILE");
+    return file ? std::string(file) : std::string(VALIDATION_HISTORY_FILE);
+  }
+
+  /// Suite-wide results file (JSON Lines) to which a summary record of every
+  /// test is appended. Can be overwritten with the CHRONO_VALIDATION_RESULTS_FILE
+  /// environment variable. An empty string disables the aggregated file.
+  /// Appends are atomic, so all tests of a parallel 'ctest -j' run can share
+  /// the same file. Set CHRONO_VALIDATION_FSYNC to flush each record to disk.
+  static std::string getResultsFile() {
+    const char* file = getenv("CHRONO_VALIDATION_RESULTS_FILE");
+    return file ? std::string(file) : std::string(VALIDATION_RESULTS_FILE);
+  }
+
+  /// If enabled, a detected performance regression fails the test (default:
+  /// only if the CHRONO_VALIDATION_FAIL_ON_REGRESSION variable is set).
+  void setFailOnRegression(bool val) { m_failOnRegression = val; }
+
+  /// Was a performance regression detected in the last run?
+  bool hasPerfRegression() const { return m_perfRegression; }
+
+  /// Return the given directory name with a trailing separator.
+  static std::string withSeparator(const std::string& dir) {
+    if (dir.empty() || dir[dir.size() - 1] == '/' || dir[dir.size() - 1] == '\\')
+      return dir;
+    return dir + "/";
+  }
+
   /// Print
   /// TODO: Create a more descriptive print.
   void print() {
@@ -132,45 +203,146 @@ public:
 
 private:
 
+  typedef std::vector<std::pair<std::string, double> > ScalarMetrics;
+  typedef std::vector<chrono::utils::ChPerfComparison> Regressions;
+
   std::string m_name;        ///< Name of test
   std::string m_projectName; ///< Name of the project: e.g: chrono, chronoRender, etc.
+  std::string m_host;        ///< Name of the machine running the test
+  std::string m_signature;   ///< Command line arguments of the run
+  time_t      m_startTime;   ///< Time at which the test was created
+
+  bool        m_perfRegression;   ///< Was a regression detected against the history?
+  bool        m_failOnRegression; ///< Does a performance regression fail the test?
+
+  chrono::utils::ChJsonStreamWriter m_json;          ///< Streamed JSON output of the test
+  ScalarMetrics                     m_scalarMetrics; ///< Numeric scalar metrics (for the history)
+
+  /// Compare all tracked metrics against the performance history.
+  void checkHistory(chrono::utils::ChPerfHistory& history, Regressions& regressions) {
+
+    history.Load(m_name, m_host, VALIDATION_BUILD_TYPE, m_signature);
+
+    // Collect the values to compare: total execution time and numeric metrics.
+    ScalarMetrics values;
+    values.push_back(std::make_pair(std::string("execution_time"), getExecutionTime()));
+    values.insert(values.end(), m_scalarMetrics.begin(), m_scalarMetrics.end());
+
+    for (size_t i = 0; i < values.size(); i++) {
+      if (!chrono::utils::ChPerfHistory::IsTracked(values[i].first))
+        continue;
+
+      chrono::utils::ChPerfComparison result;
+      if (!history.Compare(values[i].first, values[i].second, result) || !result.regression)
+        continue;
+
+      std::cout << "PERF REGRESSION: " << result.metric << " = " << result.value
+                << "  (baseline " << result.mean << " +/- " << result.stddev
+                << ", n = " << result.num_samples << ", p = " << result.p_value << ")" << std::endl;
+
+      regressions.push_back(result);
+    }
 
-  /// Metrics that are being tested (key-value pairs)
-  rapidjson::Value    m_jsonMetrics;
-  rapidjson::Document m_testJson;     ///< JSON output of the test
+    m_perfRegression = !regressions.empty();
+
+    if (m_perfRegression && m_failOnRegression)
+      m_passed = false;
+  }
+
+  /// Write the regressions (an object keyed by metric name) with the specified writer.
+  template <typename Writer>
+  static void writeRegressions(Writer& writer, const Regressions& regressions) {
+
+    writer.StartObject();
+    for (size_t i = 0; i < regressions.size(); i++) {
+      writer.String(regressions[i].metric);
+      writer.StartObject();
+      writer.String("value");            writer.Double(regressions[i].value);
+      writer.String("baseline_mean");    writer.Double(regressions[i].mean);
+      writer.String("baseline_stddev");  writer.Double(regressions[i].stddev);
+      writer.String("baseline_samples"); writer.Uint64(regressions[i].num_samples);
+      writer.String("p_value");          writer.Double(regressions[i].p_value);
+      writer.EndObject();
+    }
+    writer.EndObject();
+  }
+
+  /// Create the (single line) summary record appended to the performance
+  /// history and to the suite results file. Only scalar metrics are recorded,
+  /// so that these files stay small.
+  std::string summaryRecord(const Regressions& regressions) const {
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+
+    writer.StartObject();
+    writer.String("name");            writer.String(m_name);
+    writer.String("project_name");    writer.String(m_projectName);
+    writer.String("revision");        writer.String(VALIDATION_GIT_REVISION);
+    writer.String("host");            writer.String(m_host);
+    writer.String("build_type");      writer.String(VALIDATION_BUILD_TYPE);
+    writer.String("signature");       writer.String(m_signature);
+    writer.String("timestamp");       writer.Uint64((uint64_t)m_startTime);
+    writer.String("passed");          writer.Bool(m_passed);
+    writer.String("execution_time");  writer.Double(getExecutionTime());
+    writer.String("perf_regression"); writer.Bool(m_perfRegression);
+    writer.String("regressions");     writeRegressions(writer, regressions);
+    writer.String("metrics");
+    writer.StartObject();
+    for (size_t i = 0; i < m_scalarMetrics.size(); i++) {
+      writer.String(m_scalarMetrics[i].first);
+      writer.Double(m_scalarMetrics[i].second);
+    }
+    writer.EndObject();
+    writer.EndObject();
+
+    return std::string(buffer.GetString(), buffer.GetSize());
+  }
 
   /// This function finalizaes the json object and writes to a file
   void finalizeJson() {
 
-    rapidjson::Document::AllocatorType& allocator = m_testJson.GetAllocator(); ///< Allocates space in m_testjson.
-
-    /// Add remaining results to json file.
-    rapidjson::Value jsonPassed; ///< Did the test pass?
-    rapidjson::Value jsonExecutionTime; ///< How long did it take the test to run.
+    m_json.EndObject();
 
-    /// Set values to json elements
-    jsonPassed.SetBool(m_passed);
-    jsonExecutionTime.SetDouble(getExecutionTime());
+    /// Compare against the performance history (this may fail the test).
+    std::string historyFile = getHistoryFile();
+    chrono::utils::ChPerfHistory history(historyFile);
+    Regressions regressions;
+    if (!historyFile.empty())
+      checkHistory(history, regressions);
 
-    /// Add to json the values obtained through the test.
-    m_testJson.AddMember("passed", jsonPassed, allocator);
-    m_testJson.AddMember("execution_time", jsonExecutionTime, allocator);
-    m_testJson.AddMember("metrics", m_jsonMetrics, allocator);
+    /// Add remaining results to json file.
+    m_json.Member("signature", m_signature);
+    m_json.Member("passed", m_passed);
+    m_json.Member("execution_time", getExecutionTime());
+    m_json.Member("perf_regression", m_perfRegression);
+    m_json.StartObject("regressions");
+    for (size_t i = 0; i < regressions.size(); i++) {
+      m_json.StartObject(regressions[i].metric);
+      m_json.Member("value", regressions[i].value);
+      m_json.Member("baseline_mean", regressions[i].mean);
+      m_json.Member("baseline_stddev", regressions[i].stddev);
+      m_json.Member("baseline_samples", (uint64_t)regressions[i].num_samples);
+      m_json.Member("p_value", regressions[i].p_value);
+      m_json.EndObject();
+    }
+    m_json.EndObject();
 
-    // Write Json to file
-    /* PATH in buildbotslave:
-     /home/hammad/buildbot/slave/test_results/results
-     */
-    std::string filename =  "/Users/felipegb94/SBEL/results/" + m_name + ".json";
-    char writeBuffer[65536];
-    FILE* fp = fopen(filename.c_str(), "w"); // non-Windows use "w"
+    if (m_json.IsOpen() && !m_json.Close())
+      std::cout << "Error writing test results for " << m_name << std::endl;
 
-    rapidjson::FileWriteStream os(fp, writeBuffer, sizeof(writeBuffer));
-    rapidjson::Writer<rapidjson::FileWriteStream> writer(os);
+    std::string record = summaryRecord(regressions);
 
-    m_testJson.Accept(writer);
+    // Append to the performance history (failed and regressed runs are
+    // recorded as such, and left out of the baselines)
+    if (!historyFile.empty() && !history.Append(record))
+      std::cout << "Error appending to performance history " << historyFile << std::endl;
 
-    fclose(fp);
+    // Append to the suite results file
+    std::string resultsFile = getResultsFile();
+    bool sync = (getenv("CHRONO_VALIDATION_FSYNC") != NULL);
+    if (!resultsFile.empty() && !chrono::utils::AppendJsonLine(resultsFile, record, sync))
+      std::cout << "Error appending to results file " << resultsFile << std::endl;
 
   }
 
@@ -0,0 +1,1694 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Data-driven joint validation cases.
+//
+// =============================================================================
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <set>
+#include <algorithm>
+#include <cstdio>
+#include <cfloat>
+#include <cmath>
+
+#include "core/ChFileutils.h"
+#include "core/ChTimer.h"
+
+#define RAPIDJSON_HAS_STDSTRING 1
+#include "../include/rapidjson/document.h"
+#include "../include/rapidjson/prettywriter.h"
+#include "../include/rapidjson/filewritestream.h"
+
+#include "utils/ChUtilsReferenceStore.h"
+#include "utils/ChUtilsTrace.h"
+
+#include "JointSuite.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local variables
+//
+// There are no units in Chrono, so values must be consistent
+// (MKS is used here, as in the joint tests)
+static const double pend_mass = 1.0;     // mass of pendulum
+static const double pend_length = 4.0;   // length of pendulum
+static const double gravity = 9.80665;   // gravitational acceleration
+
+// Supported joint types, the corresponding data directories, the number of
+// constraints, the available link formulations, and whether the joint allows
+// a rotation of the pendulum about the joint Z axis.
+// The constraint and force element mechanisms are not available through
+// CreateJointLink() (no link formulation); for linactuator, the number of
+// constraints is that of its prismatic joint.
+struct JointTypeInfo {
+  const char* joint;
+  const char* dir;
+  int         num_constraints;
+  bool        lock;    // available as a ChLinkLock?
+  bool        frame;   // available as a frame-based link?
+  bool        rot_z;   // free rotation about the joint Z axis?
+};
+
+static const JointTypeInfo joint_types[] = {
+  {"revolute",     "revolute_joint/",     5, true,  true,  true},
+  {"spherical",    "spherical_joint/",    3, true,  false, true},
+  {"universal",    "universal_joint/",    4, false, true,  false},
+  {"prismatic",    "prismatic_joint/",    5, true,  false, false},
+  {"cylindrical",  "cylindrical_joint/",  4, true,  false, true},
+  {"distance",     "distance_constraint/", 1, false, false, false},
+  {"revsph",       "revsph_constraint/",  2, false, false, false},
+  {"transpring",   "transpring_force/",   0, false, false, false},
+  {"transpringcb", "transpringcb_force/", 0, false, false, false},
+  {"rotspring",    "rotspring_force/",    5, false, false, false},
+  {"linactuator",  "lin_actuator/",       5, false, false, false}
+};
+
+static const size_t num_joint_types = sizeof(joint_types) / sizeof(joint_types[0]);
+
+
+// =============================================================================
+// Solver settings
+//
+JointSolverSettings::JointSolverSettings()
+: integrator(ChSystem::INT_ANITESCU),
+  lcp_solver(ChSystem::LCP_ITERATIVE_SOR),
+  max_iters_speed(100),
+  max_iters_stab(100),
+  tol(1e-6),
+  tol_force(1e-4)
+{
+}
+
+void JointSolverSettings::Apply(ChSystem& system) const
+{
+  system.SetIntegrationType(integrator);
+  system.SetIterLCPmaxItersSpeed(max_iters_speed);
+  system.SetIterLCPmaxItersStab(max_iters_stab); //Tasora stepper uses this, Anitescu does not
+  system.SetLcpSolverType(lcp_solver);
+  system.SetTol(tol);
+  system.SetTolForce(tol_force);
+}
+
+// Names of the integrators and LCP solvers (as used in suite files).
+struct IntegratorInfo {
+  const char*                   name;
+  ChSystem::eCh_integrationType type;
+};
+
+struct LcpSolverInfo {
+  const char*             name;
+  ChSystem::eCh_lcpSolver type;
+};
+
+static const IntegratorInfo integrators[] = {
+  {"ANITESCU", ChSystem::INT_ANITESCU},
+  {"TASORA",   ChSystem::INT_TASORA}
+};
+
+static const LcpSolverInfo lcp_solvers[] = {
+  {"ITERATIVE_SOR",              ChSystem::LCP_ITERATIVE_SOR},
+  {"ITERATIVE_SYMMSOR",          ChSystem::LCP_ITERATIVE_SYMMSOR},
+  {"SIMPLEX",                    ChSystem::LCP_SIMPLEX},
+  {"ITERATIVE_JACOBI",           ChSystem::LCP_ITERATIVE_JACOBI},
+  {"ITERATIVE_SOR_MULTITHREAD",  ChSystem::LCP_ITERATIVE_SOR_MULTITHREAD},
+  {"ITERATIVE_PMINRES",          ChSystem::LCP_ITERATIVE_PMINRES},
+  {"ITERATIVE_BARZILAIBORWEIN",  ChSystem::LCP_ITERATIVE_BARZILAIBORWEIN},
+  {"ITERATIVE_PCG",              ChSystem::LCP_ITERATIVE_PCG},
+  {"ITERATIVE_APGD",             ChSystem::LCP_ITERATIVE_APGD}
+};
+
+static const size_t num_integrators = sizeof(integrators) / sizeof(integrators[0]);
+static const size_t num_lcp_solvers = sizeof(lcp_solvers) / sizeof(lcp_solvers[0]);
+
+bool GetIntegratorType(const std::string& name, ChSystem::eCh_integrationType& type)
+{
+  for (size_t i = 0; i < num_integrators; i++) {
+    if (name == integrators[i].name) {
+      type = integrators[i].type;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool GetLcpSolverType(const std::string& name, ChSystem::eCh_lcpSolver& type)
+{
+  for (size_t i = 0; i < num_lcp_solvers; i++) {
+    if (name == lcp_solvers[i].name) {
+      type = lcp_solvers[i].type;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string GetIntegratorName(ChSystem::eCh_integrationType type)
+{
+  for (size_t i = 0; i < num_integrators; i++) {
+    if (type == integrators[i].type)
+      return integrators[i].name;
+  }
+  return "";
+}
+
+std::string GetLcpSolverName(ChSystem::eCh_lcpSolver type)
+{
+  for (size_t i = 0; i < num_lcp_solvers; i++) {
+    if (type == lcp_solvers[i].type)
+      return lcp_solvers[i].name;
+  }
+  return "";
+}
+
+std::string JointSolverSettings::GetDescription() const
+{
+  std::ostringstream str;
+  str << GetIntegratorName(integrator) << " " << GetLcpSolverName(lcp_solver)
+      << " iters=" << max_iters_speed << "/" << max_iters_stab
+      << " tol=" << tol << " tol_force=" << tol_force;
+  return str.str();
+}
+
+
+// =============================================================================
+// Case description
+//
+JointPendulumParams::JointPendulumParams()
+: mass(pend_mass),
+  inertia_scale(1),
+  angle(0)
+{
+}
+
+JointCase::JointCase()
+: loc(0, 0, 0),
+  rot(QUNIT),
+  sim_step(5e-4),
+  out_step(1e-2),
+  end_time(5),
+  pend_loc(0, 0, 0),
+  pend_pos(0, 0, 0),
+  pend_rot(QUNIT),
+  axis(0, 0, 1),
+  speed(0)
+{
+}
+
+static const JointTypeInfo* FindJointType(const std::string& joint)
+{
+  for (size_t i = 0; i < num_joint_types; i++) {
+    if (joint == joint_types[i].joint)
+      return &joint_types[i];
+  }
+  return NULL;
+}
+
+std::string JointCase::GetDataDir() const
+{
+  const JointTypeInfo* info = FindJointType(joint);
+  return info ? info->dir : "";
+}
+
+std::string JointCase::GetFormulation() const
+{
+  if (!formulation.empty())
+    return formulation;
+
+  const JointTypeInfo* info = FindJointType(joint);
+  if (!info || !(info->lock || info->frame))
+    return "";
+  return info->lock ? "lock" : "frame";
+}
+
+bool HasJointFormulation(const std::string& joint, const std::string& formulation)
+{
+  const JointTypeInfo* info = FindJointType(joint);
+  if (!info)
+    return false;
+  return (formulation == "lock" && info->lock) || (formulation == "frame" && info->frame);
+}
+
+int GetNumJointConstraints(const std::string& joint)
+{
+  const JointTypeInfo* info = FindJointType(joint);
+  return info ? info->num_constraints : 0;
+}
+
+bool CanRotateJointPendulum(const std::string& joint)
+{
+  const JointTypeInfo* info = FindJointType(joint);
+  return info && info->rot_z;
+}
+
+bool HasJointSpring(const std::string& joint)
+{
+  return joint == "transpring" || joint == "transpringcb" || joint == "rotspring";
+}
+
+// Mechanisms with a pendulum attached at a point (distance, revsph, and the
+// translational springs), with its initial frame given in the case.
+static bool IsPointMechanism(const std::string& joint)
+{
+  return joint == "distance" || joint == "revsph" || joint == "transpring" || joint == "transpringcb";
+}
+
+bool IsJointReferenceQuantity(const std::string& what)
+{
+  return what != "Energy" && what.compare(0, 11, "Constraints") != 0;
+}
+
+// -----------------------------------------------------------------------------
+// Pendulum of the joint tests: a slender body of given mass and length, with
+// its CG at half its length. The universal joint test uses a pendulum hanging
+// along the joint Z axis; all other tests use a pendulum along the joint X
+// axis.
+// -----------------------------------------------------------------------------
+static void GetPendulumGeometry(const std::string& joint, ChVector<>& inertiaXX, ChVector<>& cgOffset)
+{
+  if (joint == "universal") {
+    inertiaXX = ChVector<>(0.1, 0.1, 0.04);
+    cgOffset = ChVector<>(0, 0, -0.5 * pend_length);
+  } else {
+    inertiaXX = ChVector<>(0.04, 0.1, 0.1);
+    cgOffset = ChVector<>(0.5 * pend_length, 0, 0);
+  }
+}
+
+ChSharedBodyPtr AddJointPendulum(ChSystem&                  system,
+                                 const std::string&         joint,
+                                 const ChVector<>&          loc,
+                                 const ChQuaternion<>&      rot,
+                                 const JointPendulumParams& params)
+{
+  ChVector<> inertiaXX, cgOffset;
+  GetPendulumGeometry(joint, inertiaXX, cgOffset);
+
+  // Create the pendulum body in an initial configuration at rest, with an
+  // orientation that matches the specified joint orientation (rotated by the
+  // specified angle about the joint Z axis) and a position consistent with
+  // the specified joint location.
+  ChQuaternion<> pendRot = rot;
+  if (params.angle != 0)
+    pendRot = rot % Q_from_AngAxis(params.angle, VECT_Z);
+
+  ChSharedBodyPtr pendulum(new ChBody);
+  system.AddBody(pendulum);
+  pendulum->SetPos(loc + pendRot.Rotate(cgOffset));
+  pendulum->SetRot(pendRot);
+  pendulum->SetMass(params.mass);
+  pendulum->SetInertiaXX(inertiaXX * params.inertia_scale);
+
+  return pendulum;
+}
+
+ChVector<> GetJointPendulumTip(const std::string&    joint,
+                               const ChVector<>&     loc,
+                               const ChQuaternion<>& rot)
+{
+  ChVector<> inertiaXX, cgOffset;
+  GetPendulumGeometry(joint, inertiaXX, cgOffset);
+
+  return loc + rot.Rotate(cgOffset * 2.0);
+}
+
+// -----------------------------------------------------------------------------
+// Create the link of a joint. Lock links are initialized with the pendulum as
+// the 1st body, frame-based links with the pendulum as the 2nd body (as in the
+// joint tests).
+// -----------------------------------------------------------------------------
+ChSharedPtr<ChLink> CreateJointLink(const std::string&   joint,
+                                    const std::string&   formulation,
+                                    ChSharedBodyPtr      ground,
+                                    ChSharedBodyPtr      pendulum,
+                                    const ChFrame<>&     frame)
+{
+  if (!HasJointFormulation(joint, formulation))
+    return ChSharedPtr<ChLink>();
+
+  if (formulation == "lock") {
+    ChSharedPtr<ChLinkLock> link;
+    if (joint == "revolute")
+      link = ChSharedPtr<ChLinkLock>(new ChLinkLockRevolute);
+    else if (joint == "spherical")
+      link = ChSharedPtr<ChLinkLock>(new ChLinkLockSpherical);
+    else if (joint == "prismatic")
+      link = ChSharedPtr<ChLinkLock>(new ChLinkLockPrismatic);
+    else if (joint == "cylindrical")
+      link = ChSharedPtr<ChLinkLock>(new ChLinkLockCylindrical);
+
+    link->Initialize(pendulum, ground, frame.coord);
+    return link;
+  }
+
+  if (joint == "revolute") {
+    ChSharedPtr<ChLinkRevolute> link(new ChLinkRevolute);
+    link->Initialize(ground, pendulum, frame);
+    return link;
+  }
+
+  ChSharedPtr<ChLinkUniversal> link(new ChLinkUniversal);
+  link->Initialize(ground, pendulum, frame);
+  return link;
+}
+
+
+// =============================================================================
+// Pendulum model
+//
+// -----------------------------------------------------------------------------
+// Pendulum of the constraint and force element tests, in the initial frame
+// specified in the case. The revolute-spherical test uses a pendulum along its
+// Y axis; all other tests use a pendulum along its X axis.
+// -----------------------------------------------------------------------------
+static ChSharedBodyPtr AddPointPendulum(ChSystem& system, const JointCase& c)
+{
+  ChVector<> inertiaXX = (c.joint == "revsph") ? ChVector<>(0.1, 0.04, 0.1) : ChVector<>(0.04, 0.1, 0.1);
+
+  ChSharedBodyPtr pendulum(new ChBody);
+  system.AddBody(pendulum);
+  pendulum->SetPos(c.pend_pos);
+  pendulum->SetRot(c.pend_rot);
+  pendulum->SetMass(c.pendulum.mass);
+  pendulum->SetInertiaXX(inertiaXX * c.pendulum.inertia_scale);
+
+  return pendulum;
+}
+
+// -----------------------------------------------------------------------------
+// Spring-damper force of a ChLinkSpringCB (as in the TranSpringCB tests) and
+// stiffness modifier of a rotational spring (as in the RotSpring tests), with
+// the coefficients of the case.
+// -----------------------------------------------------------------------------
+class JointSpringForce : public ChSpringForceCallback
+{
+public:
+  JointSpringForce(const JointSpringParams& params) : m_params(params) {}
+
+  virtual double operator()(double time,         // current time
+                            double rest_length,  // undeformed length
+                            double length,       // current length
+                            double vel)          // current velocity (positive when extending)
+  {
+    double x = length - rest_length;
+    return -m_params.k * x - m_params.k_nonlin * std::fabs(x) * x - m_params.c * vel;
+  }
+
+private:
+  JointSpringParams m_params;
+};
+
+class JointSpringStiffness : public ChFunction
+{
+public:
+  JointSpringStiffness(double k, double k_nonlin) : m_k(k), m_k_nonlin(k_nonlin) {}
+
+  ChFunction* new_Duplicate() { return new JointSpringStiffness(m_k, m_k_nonlin); }
+
+  double Get_y(double x) { return m_k + m_k_nonlin * std::fabs(x); }
+
+private:
+  double m_k;
+  double m_k_nonlin;
+};
+
+// Column headers of the output files (without the time column).
+static const char* pos_headers[] = {"X_Pos", "Y_Pos", "Z_Pos"};
+static const char* vel_headers[] = {"X_Vel", "Y_Vel", "Z_Vel"};
+static const char* acc_headers[] = {"X_Acc", "Y_Acc", "Z_Acc"};
+static const char* quat_headers[] = {"e0", "e1", "e2", "e3"};
+static const char* avel_headers[] = {"X_AngVel", "Y_AngVel", "Z_AngVel"};
+static const char* aacc_headers[] = {"X_AngAcc", "Y_AngAcc", "Z_AngAcc"};
+static const char* force_headers[] = {"X_Force", "Y_Force", "Z_Force"};
+static const char* torque_headers[] = {"X_Torque", "Y_Torque", "Z_Torque"};
+static const char* energy_headers[] = {"Transl_KE", "Rot_KE", "Delta_PE", "KE+PE"};
+
+// The plate of the linear actuator test is driven, so its energy is not
+// conserved (and not output).
+static bool HasEnergyOutput(const std::string& joint)
+{
+  return joint != "linactuator";
+}
+
+JointModel::JointModel(const JointCase& c)
+: m_case(c),
+  m_energyRefZ(0),
+  m_energy0(0),
+  m_springForce(NULL),
+  m_row(0)
+{
+}
+
+JointModel::~JointModel()
+{
+  // The spring force callback is not owned by the spring link.
+  delete m_springForce;
+}
+
+bool JointModel::Build(ChSystem& system)
+{
+  const std::string&    joint = m_case.joint;
+  const ChVector<>&     jointLoc = m_case.loc;
+  const ChQuaternion<>& jointRot = m_case.rot;
+
+  // Create the ground body
+  m_ground = ChSharedBodyPtr(new ChBody);
+  system.AddBody(m_ground);
+  m_ground->SetBodyFixed(true);
+
+  if (IsPointMechanism(joint)) {
+    // Create the pendulum body and the constraint or spring between the
+    // pendulum attachment point and the ground attachment point.
+    m_pendulum = AddPointPendulum(system, m_case);
+    m_energyRefZ = m_case.pend_pos.z;
+
+    if (joint == "distance") {
+      ChSharedPtr<ChLinkDistance> link(new ChLinkDistance);
+      link->Initialize(m_pendulum, m_ground, false, m_case.pend_loc, jointLoc, true);
+      m_link = link;
+    } else if (joint == "revsph") {
+      ChSharedPtr<ChLinkRevoluteSpherical> link(new ChLinkRevoluteSpherical);
+      link->Initialize(m_ground, m_pendulum, false, jointLoc, m_case.axis, m_case.pend_loc, true);
+      m_link = link;
+    } else if (joint == "transpring") {
+      ChSharedPtr<ChLinkSpring> link(new ChLinkSpring);
+      link->Initialize(m_pendulum, m_ground, false, m_case.pend_loc, jointLoc, true);
+      link->Set_SpringK(m_case.spring.k);
+      link->Set_SpringR(m_case.spring.c);
+      m_link = link;
+    } else {
+      m_springForce = new JointSpringForce(m_case.spring);
+      ChSharedPtr<ChLinkSpringCB> link(new ChLinkSpringCB);
+      link->Initialize(m_pendulum, m_ground, false, m_case.pend_loc, jointLoc, true);
+      link->Set_SpringCallback(m_springForce);
+      m_link = link;
+    }
+  } else if (joint == "rotspring") {
+    // Create the pendulum of the revolute joint test and a revolute joint with
+    // a rotational spring-damper about its Z axis.
+    m_pendulum = AddJointPendulum(system, joint, jointLoc, jointRot, m_case.pendulum);
+    m_energyRefZ = jointLoc.z;
+
+    ChLinkForce* force = new ChLinkForce;
+    force->Set_active(1);
+    force->Set_R(m_case.spring.c);
+    if (m_case.spring.k_nonlin == 0) {
+      force->Set_K(m_case.spring.k);
+    } else {
+      force->Set_K(1);
+      force->Set_modul_K(new JointSpringStiffness(m_case.spring.k, m_case.spring.k_nonlin));
+    }
+
+    ChSharedPtr<ChLinkLockRevolute> link(new ChLinkLockRevolute);
+    link->Initialize(m_pendulum, m_ground, ChCoordsys<>(jointLoc, jointRot));
+    link->SetForce_Rz(force);
+    m_link = link;
+  } else if (joint == "linactuator") {
+    // Create a plate moving along the Z axis of a prismatic joint, driven by a
+    // linear actuator at the imposed speed (and with a consistent initial
+    // velocity).
+    ChVector<> axis = jointRot.GetZaxis();
+
+    m_pendulum = ChSharedBodyPtr(new ChBody);
+    system.AddBody(m_pendulum);
+    m_pendulum->SetPos(jointLoc);
+    m_pendulum->SetRot(jointRot);
+    m_pendulum->SetPos_dt(m_case.speed * axis);
+    m_pendulum->SetMass(m_case.pendulum.mass);
+    m_pendulum->SetInertiaXX(ChVector<>(1, 1, 1) * m_case.pendulum.inertia_scale);
+    m_energyRefZ = jointLoc.z;
+
+    ChSharedPtr<ChLinkLockPrismatic> prismatic(new ChLinkLockPrismatic);
+    prismatic->Initialize(m_pendulum, m_ground, ChCoordsys<>(jointLoc, jointRot));
+    m_link = prismatic;
+
+    ChSharedPtr<ChFunction_Ramp> actuator_fun(new ChFunction_Ramp(0.0, m_case.speed));
+    ChSharedPtr<ChLinkLinActuator> actuator(new ChLinkLinActuator);
+    actuator->Initialize(m_ground, m_pendulum, false, ChCoordsys<>(jointLoc, jointRot),
+                         ChCoordsys<>(jointLoc + axis, jointRot));
+    actuator->Set_lin_offset(1);
+    actuator->Set_dist_funct(actuator_fun);
+    m_actuator = actuator;
+  } else {
+    // Create the pendulum body and the joint between pendulum and ground
+    m_pendulum = AddJointPendulum(system, joint, jointLoc, jointRot, m_case.pendulum);
+    m_energyRefZ = jointLoc.z;
+
+    m_link = CreateJointLink(joint, m_case.GetFormulation(), m_ground, m_pendulum,
+                             ChFrame<>(jointLoc, jointRot));
+    if (m_link.IsNull())
+      return false;
+  }
+
+  system.AddLink(m_link);
+  if (!m_actuator.IsNull())
+    system.AddLink(m_actuator);
+
+  SetupOutputs();
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Output quantities of the model: the same files (and columns) as written by
+// the test of its joint type.
+// -----------------------------------------------------------------------------
+void JointModel::AddOutput(const std::string& what, const char* const* headers, int num_headers)
+{
+  OutputInfo info;
+  info.what = what;
+  info.headers.assign(headers, headers + num_headers);
+  m_outputs.push_back(info);
+}
+
+void JointModel::AddConstraintOutput(const std::string& what, int num_constraints)
+{
+  OutputInfo info;
+  info.what = what;
+  for (int i = 0; i < num_constraints; i++) {
+    std::ostringstream header;
+    header << "Cnstr_" << i + 1;
+    info.headers.push_back(header.str());
+  }
+  m_outputs.push_back(info);
+}
+
+void JointModel::SetupOutputs()
+{
+  const std::string& joint = m_case.joint;
+  m_outputs.clear();
+
+  // CM position, velocity, and acceleration; orientation, angular velocity,
+  // and angular acceleration.
+  AddOutput("Pos", pos_headers, 3);
+  AddOutput("Vel", vel_headers, 3);
+  AddOutput("Acc", acc_headers, 3);
+  AddOutput("Quat", quat_headers, 4);
+  AddOutput("Avel", avel_headers, 3);
+  AddOutput("Aacc", aacc_headers, 3);
+
+  // Reaction forces and torques (see GetReactions)
+  if (joint == "linactuator") {
+    AddOutput("RforceP", force_headers, 3);
+    AddOutput("RtorqueP", torque_headers, 3);
+    AddOutput("RforceA", force_headers, 3);
+    AddOutput("RtorqueA", torque_headers, 3);
+  } else {
+    AddOutput("Rforce", force_headers, 3);
+    AddOutput("Rtorque", torque_headers, 3);
+    if (joint == "revsph") {
+      AddOutput("Rforce_Body1", force_headers, 3);
+      AddOutput("Rtorque_Body1", torque_headers, 3);
+      AddOutput("Rforce_Body2", force_headers, 3);
+      AddOutput("Rtorque_Body2", torque_headers, 3);
+    }
+  }
+
+  if (HasEnergyOutput(joint))
+    AddOutput("Energy", energy_headers, 4);
+
+  // Constraint violations (see GetConstraintViolations)
+  int num_constraints = GetNumJointConstraints(joint);
+  if (joint == "linactuator") {
+    AddConstraintOutput("ConstraintsP", num_constraints);
+    AddConstraintOutput("ConstraintsA", 1);
+  } else if (num_constraints > 0) {
+    AddConstraintOutput("Constraints", num_constraints);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Constraint violations of the links of the model.
+// -----------------------------------------------------------------------------
+void JointModel::GetConstraintViolations(std::vector<double>& values) const
+{
+  if (m_link.IsType<ChLinkDistance>()) {
+    values.push_back(m_link.DynamicCastTo<ChLinkDistance>()->GetC());
+    return;
+  }
+
+  int num_constraints = GetNumJointConstraints(m_case.joint);
+  if (num_constraints == 0)
+    return;
+
+  ChMatrix<>* C;
+  if (m_link.IsType<ChLinkLock>())
+    C = m_link.DynamicCastTo<ChLinkLock>()->GetC();
+  else if (m_link.IsType<ChLinkRevolute>())
+    C = m_link.DynamicCastTo<ChLinkRevolute>()->GetC();
+  else if (m_link.IsType<ChLinkRevoluteSpherical>())
+    C = m_link.DynamicCastTo<ChLinkRevoluteSpherical>()->GetC();
+  else
+    C = m_link.DynamicCastTo<ChLinkUniversal>()->GetC();
+
+  for (int i = 0; i < num_constraints; i++)
+    values.push_back(C->GetElement(i, 0));
+
+  if (!m_actuator.IsNull())
+    values.push_back(m_actuator.DynamicCastTo<ChLinkLock>()->GetC()->GetElement(0, 0));
+}
+
+// -----------------------------------------------------------------------------
+// Reaction forces and torques, in the order of the reaction outputs. Unless
+// noted otherwise, these act on the ground body, as applied at the joint
+// location and expressed in the global frame.
+// -----------------------------------------------------------------------------
+void JointModel::GetReactions(std::vector<ChVector<> >& reactions) const
+{
+  const std::string& joint = m_case.joint;
+  reactions.clear();
+
+  ChCoordsys<> linkCoordsys = m_link->GetLinkRelativeCoords();
+  ChVector<> force = m_link->Get_react_force();
+  ChVector<> torque = m_link->Get_react_torque();
+
+  if (joint == "revsph") {
+    // Reactions on the pendulum (2nd body) and on each of the two bodies,
+    // expressed in the joint frame: express them in the global frame.
+    ChSharedPtr<ChLinkRevoluteSpherical> link = m_link.DynamicCastTo<ChLinkRevoluteSpherical>();
+    ChVector<> react[] = {force, torque,
+                          link->Get_react_force_body1(), link->Get_react_torque_body1(),
+                          link->Get_react_force_body2(), link->Get_react_torque_body2()};
+    for (int i = 0; i < 6; i++)
+      reactions.push_back(m_pendulum->TransformDirectionLocalToParent(linkCoordsys.TransformDirectionLocalToParent(react[i])));
+    return;
+  }
+
+  if (joint == "transpring" || joint == "transpringcb") {
+    // The spring force is a scalar: apply it along the spring direction.
+    ChSharedPtr<ChLinkMarkers> markers = m_link.DynamicCastTo<ChLinkMarkers>();
+    ChVector<> springVector = markers->GetEndPoint2Abs() - markers->GetEndPoint1Abs();
+    springVector.Normalize();
+    double springForce = (joint == "transpring") ? m_link.DynamicCastTo<ChLinkSpring>()->Get_SpringReact()
+                                                 : m_link.DynamicCastTo<ChLinkSpringCB>()->Get_SpringReact();
+    reactions.push_back(springForce * springVector);
+    reactions.push_back(linkCoordsys.TransformDirectionLocalToParent(torque));
+    return;
+  }
+
+  if (joint == "rotspring") {
+    // Remove the spring force and torque from the joint reactions.
+    ChSharedPtr<ChLinkLock> link = m_link.DynamicCastTo<ChLinkLock>();
+    force -= link->GetC_force();
+    torque -= link->GetC_torque();
+  }
+
+  force = linkCoordsys.TransformDirectionLocalToParent(force);
+  torque = linkCoordsys.TransformDirectionLocalToParent(torque);
+
+  // For frame-based links, the 2nd body is the pendulum: express the reactions
+  // in the global frame and switch their sign. For all other links, the 2nd
+  // body is the ground, whose frame coincides with the global frame.
+  if (m_link.IsType<ChLinkRevolute>() || m_link.IsType<ChLinkUniversal>()) {
+    force = m_pendulum->TransformDirectionLocalToParent(force);
+    torque = m_pendulum->TransformDirectionLocalToParent(torque);
+    force *= -1.0;
+    torque *= -1.0;
+  }
+
+  reactions.push_back(force);
+  reactions.push_back(torque);
+
+  if (!m_actuator.IsNull()) {
+    // Force required from the actuator to impose its motion: reaction on the
+    // plate (2nd body), expressed in the global frame.
+    ChCoordsys<> actuatorCoordsys = m_actuator->GetLinkRelativeCoords();
+    ChVector<> forceA = actuatorCoordsys.TransformDirectionLocalToParent(m_actuator->Get_react_force());
+    ChVector<> torqueA = actuatorCoordsys.TransformDirectionLocalToParent(m_actuator->Get_react_torque());
+    reactions.push_back(m_pendulum->TransformDirectionLocalToParent(forceA));
+    reactions.push_back(m_pendulum->TransformDirectionLocalToParent(torqueA));
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Translational Kinetic Energy (1/2*m*||v||^2)
+// Rotational Kinetic Energy (1/2 w'*I*w)
+// Delta Potential Energy (m*g*dz)
+// -----------------------------------------------------------------------------
+void JointModel::GetEnergy(double& transKE, double& rotKE, double& deltaPE) const
+{
+  ChMatrix33<> inertia = m_pendulum->GetInertia();
+  ChVector<> angVelLoc = m_pendulum->GetWvel_loc();
+  double mass = m_pendulum->GetMass();
+  transKE = 0.5 * mass * m_pendulum->GetPos_dt().Length2();
+  rotKE = 0.5 * Vdot(angVelLoc, inertia * angVelLoc);
+  deltaPE = mass * gravity * (m_pendulum->GetPos().z - m_energyRefZ);
+}
+
+void JointModel::InitializeOutput(size_t num_rows)
+{
+  double transKE, rotKE, deltaPE;
+  GetEnergy(transKE, rotKE, deltaPE);
+  m_energy0 = transKE + rotKE + deltaPE;
+
+  // Allocate the output tables (time and value columns of each output).
+  m_data.assign(m_outputs.size(), utils::Data());
+  for (size_t i = 0; i < m_outputs.size(); i++)
+    m_data[i].assign(m_outputs[i].headers.size() + 1, utils::DataVector(0.0, num_rows));
+  m_row = 0;
+}
+
+void JointModel::Output(double time)
+{
+  if (m_data.empty() || m_row >= m_data[0][0].size())
+    return;
+
+  // Distribute the values of the output channels over the output tables.
+  GetOutputValues(m_values);
+
+  size_t k = 0;
+  for (size_t i = 0; i < m_outputs.size(); i++) {
+    utils::Data& table = m_data[i];
+    table[0][m_row] = time;
+    for (size_t j = 1; j < table.size(); j++)
+      table[j][m_row] = m_values[k++];
+  }
+
+  m_row++;
+}
+
+void JointModel::GetOutputs(JointOutputs& outputs)
+{
+  outputs.what.resize(m_outputs.size());
+  outputs.headers.resize(m_outputs.size());
+  outputs.data.resize(m_outputs.size());
+
+  for (size_t i = 0; i < m_outputs.size(); i++) {
+    outputs.what[i] = m_outputs[i].what;
+    outputs.headers[i].assign(1, "Time");
+    outputs.headers[i].insert(outputs.headers[i].end(), m_outputs[i].headers.begin(), m_outputs[i].headers.end());
+    outputs.data[i].swap(m_data[i]);
+  }
+
+  m_data.clear();
+  m_row = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Names of the output channels: the column headers of the output files, with
+// headers already used by a previous output prefixed by the output name (e.g.
+// "Rforce_Body1_X_Force").
+// -----------------------------------------------------------------------------
+void JointModel::GetOutputChannels(std::vector<std::string>& names) const
+{
+  std::set<std::string> used;
+  names.clear();
+
+  for (size_t i = 0; i < m_outputs.size(); i++) {
+    for (size_t j = 0; j < m_outputs[i].headers.size(); j++) {
+      std::string name = m_outputs[i].headers[j];
+      if (!used.insert(name).second) {
+        name = m_outputs[i].what + "_" + name;
+        used.insert(name);
+      }
+      names.push_back(name);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Current values of the output channels, in the order of the output files.
+// -----------------------------------------------------------------------------
+static void AppendVector(std::vector<double>& values, const ChVector<>& v)
+{
+  values.push_back(v.x);
+  values.push_back(v.y);
+  values.push_back(v.z);
+}
+
+void JointModel::GetOutputValues(std::vector<double>& values) const
+{
+  values.clear();
+
+  // CM position, velocity, and acceleration (expressed in global frame).
+  AppendVector(values, m_pendulum->GetPos());
+  AppendVector(values, m_pendulum->GetPos_dt());
+  AppendVector(values, m_pendulum->GetPos_dtdt());
+
+  // Orientation, angular velocity, and angular acceleration (expressed in
+  // global frame).
+  const ChQuaternion<>& rot = m_pendulum->GetRot();
+  values.push_back(rot.e0);
+  values.push_back(rot.e1);
+  values.push_back(rot.e2);
+  values.push_back(rot.e3);
+  AppendVector(values, m_pendulum->GetWvel_par());
+  AppendVector(values, m_pendulum->GetWacc_par());
+
+  // Reaction forces and torques, expressed in the global frame.
+  std::vector<ChVector<> > reactions;
+  GetReactions(reactions);
+  for (size_t i = 0; i < reactions.size(); i++)
+    AppendVector(values, reactions[i]);
+
+  // Conservation of energy
+  if (HasEnergyOutput(m_case.joint)) {
+    double transKE, rotKE, deltaPE;
+    GetEnergy(transKE, rotKE, deltaPE);
+    values.push_back(transKE);
+    values.push_back(rotKE);
+    values.push_back(deltaPE);
+    values.push_back(transKE + rotKE + deltaPE - m_energy0);
+  }
+
+  // Constraint violations
+  GetConstraintViolations(values);
+}
+
+// -----------------------------------------------------------------------------
+// Recorded outputs of a case
+// -----------------------------------------------------------------------------
+bool JointOutputs::Find(const std::string&     quantity,
+                        const utils::Headers*& table_headers,
+                        const utils::Data*&    table_data) const
+{
+  for (size_t i = 0; i < what.size(); i++) {
+    if (what[i] == quantity) {
+      table_headers = &headers[i];
+      table_data = &data[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+void WriteJointOutputs(const JointCase& c, const JointOutputs& outputs, const std::string& out_dir)
+{
+  for (size_t i = 0; i < outputs.what.size(); i++) {
+    const utils::Headers& headers = outputs.headers[i];
+    const utils::Data&    data = outputs.data[i];
+
+    // Same format as in the joint tests.
+    utils::CSV_writer out("\t");
+    out.stream().setf(std::ios::scientific | std::ios::showpos);
+    out.stream().precision(6);
+
+    for (size_t j = 0; j < headers.size(); j++)
+      out << headers[j];
+    out << std::endl;
+
+    size_t num_rows = data.empty() ? 0 : data[0].size();
+    for (size_t row = 0; row < num_rows; row++) {
+      for (size_t j = 0; j < data.size(); j++)
+        out << data[j][row];
+      out << std::endl;
+    }
+
+    out.write_to_file(out_dir + c.name + "_CHRONO_" + outputs.what[i] + ".txt", c.name + "\n\n");
+  }
+}
+
+
+// =============================================================================
+// Shared reference data
+//
+std::string JointReferenceData::GetFileName(const JointCase& c, const std::string& what)
+{
+  return utils::GetValidationDataFile(c.GetDataDir() + c.name + "_ADAMS_" + what + ".txt");
+}
+
+void JointReferenceData::Load(const std::vector<JointCase>& cases)
+{
+  // Collect the names of all reference files not loaded yet.
+  std::set<std::string> unique;
+  std::vector<std::string> files;
+
+  for (size_t i = 0; i < cases.size(); i++) {
+    for (size_t j = 0; j < cases[i].tolerances.size(); j++) {
+      const std::string& what = cases[i].tolerances[j].what;
+      if (!IsJointReferenceQuantity(what))
+        continue;
+      std::string filename = GetFileName(cases[i], what);
+      if (m_tables.find(filename) == m_tables.end() && unique.insert(filename).second)
+        files.push_back(filename);
+    }
+  }
+
+  // Group the files by case (bundle file). The first file of a case loads the
+  // whole bundle into the cache; the other files of the case are then cache
+  // hits, so each case is opened and decoded once.
+  std::map<std::string, size_t> bundle_index;
+  std::vector<std::vector<size_t> > bundles;
+
+  for (size_t i = 0; i < files.size(); i++) {
+    std::string bundle = utils::GetReferenceBundleFile(files[i]);
+    std::map<std::string, size_t>::iterator itr = bundle_index.find(bundle);
+    if (itr == bundle_index.end()) {
+      itr = bundle_index.insert(std::make_pair(bundle, bundles.size())).first;
+      bundles.push_back(std::vector<size_t>());
+    }
+    bundles[itr->second].push_back(i);
+  }
+
+  // Get the tables of the cases concurrently, then insert them into the map.
+  std::vector<utils::ChReferenceData> tables(files.size());
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int b = 0; b < (int)bundles.size(); b++) {
+    utils::ChTrace::SetWorkerThreadName();
+    for (size_t k = 0; k < bundles[b].size(); k++)
+      tables[bundles[b][k]] = utils::ChReferenceCache::Get(files[bundles[b][k]]);
+  }
+
+  for (size_t i = 0; i < files.size(); i++)
+    m_tables[files[i]] = tables[i];
+}
+
+bool JointReferenceData::Find(const JointCase&        c,
+                              const std::string&      what,
+                              const utils::Headers*&  headers,
+                              const utils::Data*&     data) const
+{
+  std::map<std::string, utils::ChReferenceData>::const_iterator itr = m_tables.find(GetFileName(c, what));
+  if (itr == m_tables.end() || itr->second.GetHeaders().empty())
+    return false;
+
+  headers = &itr->second.GetHeaders();
+  data = &itr->second.GetData();
+  return true;
+}
+
+JointReferenceData JointReferenceData::Truncated(double end_time) const
+{
+  JointReferenceData refs;
+
+  std::map<std::string, utils::ChReferenceData>::const_iterator itr = m_tables.begin();
+  for (; itr != m_tables.end(); ++itr) {
+    const utils::Data& src = itr->second.GetData();
+    if (src.empty()) {
+      refs.m_tables[itr->first] = itr->second;
+      continue;
+    }
+
+    // Keep the rows up to (and including) the specified time.
+    size_t num_rows = 0;
+    while (num_rows < src[0].size() && src[0][num_rows] <= end_time + 1e-8)
+      num_rows++;
+
+    utils::Data dst(src.size());
+    for (size_t col = 0; col < src.size(); col++)
+      dst[col] = src[col][std::slice(0, num_rows, 1)];
+
+    refs.m_tables[itr->first] = utils::ChReferenceData(itr->second.GetHeaders(), dst);
+  }
+
+  return refs;
+}
+
+
+// =============================================================================
+// Reading the suite file
+//
+static bool ReadVector(const rapidjson::Value& val, ChVector<>& vec)
+{
+  if (!val.IsArray() || val.Size() != 3)
+    return false;
+  for (rapidjson::SizeType i = 0; i < 3; i++) {
+    if (!val[i].IsNumber())
+      return false;
+  }
+
+  vec = ChVector<>(val[0u].GetDouble(), val[1u].GetDouble(), val[2u].GetDouble());
+  return true;
+}
+
+// A rotation is given either as a quaternion [e0, e1, e2, e3] or as an object
+// { "axis": [x, y, z], "angle": <degrees> }.
+static bool ReadRotation(const rapidjson::Value& val, ChQuaternion<>& rot)
+{
+  if (val.IsArray() && val.Size() == 4) {
+    for (rapidjson::SizeType i = 0; i < 4; i++) {
+      if (!val[i].IsNumber())
+        return false;
+    }
+    rot = ChQuaternion<>(val[0u].GetDouble(), val[1u].GetDouble(), val[2u].GetDouble(), val[3u].GetDouble());
+    return true;
+  }
+
+  if (val.IsObject() && val.HasMember("axis") && val.HasMember("angle") && val["angle"].IsNumber()) {
+    ChVector<> axis;
+    if (!ReadVector(val["axis"], axis))
+      return false;
+    rot = Q_from_AngAxis(val["angle"].GetDouble() * CH_C_PI / 180, axis);
+    return true;
+  }
+
+  return false;
+}
+
+static bool ReadNumber(const rapidjson::Value& obj, const char* name, double& val)
+{
+  if (!obj.HasMember(name))
+    return true;
+  if (!obj[name].IsNumber())
+    return false;
+  val = obj[name].GetDouble();
+  return true;
+}
+
+static bool ReadNumber(const rapidjson::Value& obj, const char* name, int& val)
+{
+  if (!obj.HasMember(name))
+    return true;
+  if (!obj[name].IsInt())
+    return false;
+  val = obj[name].GetInt();
+  return true;
+}
+
+static bool ReadSolver(const rapidjson::Value& val, JointSolverSettings& solver)
+{
+  if (!val.IsObject())
+    return false;
+
+  if (val.HasMember("integrator")) {
+    if (!val["integrator"].IsString() || !GetIntegratorType(val["integrator"].GetString(), solver.integrator))
+      return false;
+  }
+  if (val.HasMember("lcp_solver")) {
+    if (!val["lcp_solver"].IsString() || !GetLcpSolverType(val["lcp_solver"].GetString(), solver.lcp_solver))
+      return false;
+  }
+
+  return ReadNumber(val, "max_iters_speed", solver.max_iters_speed) &&
+         ReadNumber(val, "max_iters_stab", solver.max_iters_stab) &&
+         ReadNumber(val, "tol", solver.tol) &&
+         ReadNumber(val, "tol_force", solver.tol_force);
+}
+
+// Read the settings which can be specified both at the top level (defaults)
+// and for each individual case.
+static bool ReadSettings(const rapidjson::Value& val, JointCase& c)
+{
+  if (!ReadNumber(val, "sim_step", c.sim_step) ||
+      !ReadNumber(val, "out_step", c.out_step) ||
+      !ReadNumber(val, "end_time", c.end_time))
+    return false;
+
+  if (val.HasMember("solver") && !ReadSolver(val["solver"], c.solver))
+    return false;
+
+  return true;
+}
+
+static bool ReadCase(const rapidjson::Value& val, JointCase& c)
+{
+  if (!val.IsObject())
+    return false;
+
+  if (!val.HasMember("name") || !val["name"].IsString())
+    return false;
+  c.name = val["name"].GetString();
+
+  if (!val.HasMember("joint") || !val["joint"].IsString())
+    return false;
+  c.joint = val["joint"].GetString();
+  if (c.GetDataDir().empty()) {
+    std::cout << "ERROR: unknown joint type '" << c.joint << "'" << std::endl;
+    return false;
+  }
+
+  if (val.HasMember("formulation")) {
+    if (!val["formulation"].IsString())
+      return false;
+    c.formulation = val["formulation"].GetString();
+    if (!HasJointFormulation(c.joint, c.formulation)) {
+      std::cout << "ERROR: no '" << c.formulation << "' formulation of joint '" << c.joint << "'" << std::endl;
+      return false;
+    }
+  }
+
+  if (val.HasMember("loc") && !ReadVector(val["loc"], c.loc))
+    return false;
+  if (val.HasMember("rot") && !ReadRotation(val["rot"], c.rot))
+    return false;
+
+  // Parameters of the constraint and force element mechanisms
+  if (val.HasMember("pend_loc") && !ReadVector(val["pend_loc"], c.pend_loc))
+    return false;
+  if (val.HasMember("pend_pos") && !ReadVector(val["pend_pos"], c.pend_pos))
+    return false;
+  if (val.HasMember("pend_rot") && !ReadRotation(val["pend_rot"], c.pend_rot))
+    return false;
+  if (val.HasMember("axis") && !ReadVector(val["axis"], c.axis))
+    return false;
+  if (!ReadNumber(val, "speed", c.speed))
+    return false;
+
+  if (val.HasMember("spring")) {
+    const rapidjson::Value& spring = val["spring"];
+    if (!spring.IsObject() ||
+        !ReadNumber(spring, "k", c.spring.k) ||
+        !ReadNumber(spring, "k_nonlin", c.spring.k_nonlin) ||
+        !ReadNumber(spring, "c", c.spring.c))
+      return false;
+  }
+  if (c.joint == "transpring" && c.spring.k_nonlin != 0) {
+    std::cout << "ERROR: no nonlinear spring coefficient for joint '" << c.joint << "'" << std::endl;
+    return false;
+  }
+
+  if (!ReadSettings(val, c))
+    return false;
+
+  if (val.HasMember("tolerances")) {
+    const rapidjson::Value& tols = val["tolerances"];
+    if (!tols.IsObject())
+      return false;
+    for (rapidjson::Value::ConstMemberIterator itr = tols.MemberBegin(); itr != tols.MemberEnd(); ++itr) {
+      if (!itr->value.IsNumber())
+        return false;
+      JointTolerance tol;
+      tol.what = itr->name.GetString();
+      tol.tolerance = itr->value.GetDouble();
+      c.tolerances.push_back(tol);
+    }
+  }
+
+  return true;
+}
+
+bool ReadJointSuite(const std::string& filename, std::vector<JointCase>& cases)
+{
+  std::ifstream ifile(filename.c_str());
+  if (!ifile) {
+    std::cout << "ERROR: cannot open suite file " << filename << std::endl;
+    return false;
+  }
+
+  std::stringstream buffer;
+  buffer << ifile.rdbuf();
+  std::string json = buffer.str();
+
+  rapidjson::Document doc;
+  doc.Parse(json.c_str());
+  if (doc.HasParseError() || !doc.IsObject()) {
+    std::cout << "ERROR: invalid JSON in suite file " << filename
+              << " (offset " << doc.GetErrorOffset() << ")" << std::endl;
+    return false;
+  }
+
+  // Top-level settings are defaults for all cases.
+  JointCase defaults;
+  if (!ReadSettings(doc, defaults)) {
+    std::cout << "ERROR: invalid default settings in suite file " << filename << std::endl;
+    return false;
+  }
+
+  if (!doc.HasMember("cases") || !doc["cases"].IsArray()) {
+    std::cout << "ERROR: no cases in suite file " << filename << std::endl;
+    return false;
+  }
+
+  const rapidjson::Value& list = doc["cases"];
+  for (rapidjson::SizeType i = 0; i < list.Size(); i++) {
+    JointCase c = defaults;
+    if (!ReadCase(list[i], c)) {
+      std::cout << "ERROR: invalid case #" << i + 1 << " in suite file " << filename << std::endl;
+      return false;
+    }
+    cases.push_back(c);
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Writing a suite file: all settings are written explicitly for every case.
+// -----------------------------------------------------------------------------
+template <typename Writer>
+static void WriteVector(Writer& writer, const double* val, int n)
+{
+  writer.StartArray();
+  for (int i = 0; i < n; i++)
+    writer.Double(val[i]);
+  writer.EndArray();
+}
+
+template <typename Writer>
+static void WriteCase(Writer& writer, const JointCase& c)
+{
+  double loc[] = {c.loc.x, c.loc.y, c.loc.z};
+  double rot[] = {c.rot.e0, c.rot.e1, c.rot.e2, c.rot.e3};
+
+  writer.StartObject();
+  writer.String("name");        writer.String(c.name);
+  writer.String("joint");       writer.String(c.joint);
+  if (!c.formulation.empty()) {
+    writer.String("formulation");
+    writer.String(c.formulation);
+  }
+  writer.String("loc");         WriteVector(writer, loc, 3);
+  writer.String("rot");         WriteVector(writer, rot, 4);
+
+  if (IsPointMechanism(c.joint)) {
+    double pend_loc[] = {c.pend_loc.x, c.pend_loc.y, c.pend_loc.z};
+    double pend_pos[] = {c.pend_pos.x, c.pend_pos.y, c.pend_pos.z};
+    double pend_rot[] = {c.pend_rot.e0, c.pend_rot.e1, c.pend_rot.e2, c.pend_rot.e3};
+    writer.String("pend_loc");  WriteVector(writer, pend_loc, 3);
+    writer.String("pend_pos");  WriteVector(writer, pend_pos, 3);
+    writer.String("pend_rot");  WriteVector(writer, pend_rot, 4);
+  }
+  if (c.joint == "revsph") {
+    double axis[] = {c.axis.x, c.axis.y, c.axis.z};
+    writer.String("axis");      WriteVector(writer, axis, 3);
+  }
+  if (HasJointSpring(c.joint)) {
+    writer.String("spring");
+    writer.StartObject();
+    writer.String("k");         writer.Double(c.spring.k);
+    writer.String("k_nonlin");  writer.Double(c.spring.k_nonlin);
+    writer.String("c");         writer.Double(c.spring.c);
+    writer.EndObject();
+  }
+  if (c.joint == "linactuator") {
+    writer.String("speed");     writer.Double(c.speed);
+  }
+
+  writer.String("sim_step");    writer.Double(c.sim_step);
+  writer.String("out_step");    writer.Double(c.out_step);
+  writer.String("end_time");    writer.Double(c.end_time);
+
+  writer.String("solver");
+  writer.StartObject();
+  writer.String("integrator");      writer.String(GetIntegratorName(c.solver.integrator));
+  writer.String("lcp_solver");      writer.String(GetLcpSolverName(c.solver.lcp_solver));
+  writer.String("max_iters_speed"); writer.Int(c.solver.max_iters_speed);
+  writer.String("max_iters_stab");  writer.Int(c.solver.max_iters_stab);
+  writer.String("tol");             writer.Double(c.solver.tol);
+  writer.String("tol_force");       writer.Double(c.solver.tol_force);
+  writer.EndObject();
+
+  writer.String("tolerances");
+  writer.StartObject();
+  for (size_t i = 0; i < c.tolerances.size(); i++) {
+    writer.String(c.tolerances[i].what);
+    writer.Double(c.tolerances[i].tolerance);
+  }
+  writer.EndObject();
+
+  writer.EndObject();
+}
+
+bool WriteJointSuite(const std::string& filename, const std::vector<JointCase>& cases)
+{
+  FILE* file = fopen(filename.c_str(), "w");
+  if (!file) {
+    std::cout << "ERROR: cannot create suite file " << filename << std::endl;
+    return false;
+  }
+
+  char buffer[65536];
+  rapidjson::FileWriteStream os(file, buffer, sizeof(buffer));
+  rapidjson::PrettyWriter<rapidjson::FileWriteStream> writer(os);
+
+  writer.StartObject();
+  writer.String("cases");
+  writer.StartArray();
+  for (size_t i = 0; i < cases.size(); i++)
+    WriteCase(writer, cases[i]);
+  writer.EndArray();
+  writer.EndObject();
+
+  os.Put('\n');
+  os.Flush();
+
+  return fclose(file) == 0;
+}
+
+bool MatchJointCase(const JointCase& c, const std::vector<std::string>& patterns)
+{
+  if (patterns.empty())
+    return true;
+
+  for (size_t i = 0; i < patterns.size(); i++) {
+    if (c.name.compare(0, patterns[i].size(), patterns[i]) == 0)
+      return true;
+  }
+
+  return false;
+}
+
+bool SelectJointCases(const std::string&              filename,
+                      const std::vector<std::string>& patterns,
+                      std::vector<JointCase>&         cases)
+{
+  cases.clear();
+
+  std::vector<JointCase> all_cases;
+  if (!ReadJointSuite(filename, all_cases))
+    return false;
+
+  for (size_t i = 0; i < all_cases.size(); i++) {
+    if (MatchJointCase(all_cases[i], patterns))
+      cases.push_back(all_cases[i]);
+  }
+
+  if (cases.empty()) {
+    std::cout << "No cases selected from " << filename << std::endl;
+    return false;
+  }
+
+  std::cout << "Selected " << cases.size() << " of " << all_cases.size()
+            << " cases from " << filename << std::endl;
+  return true;
+}
+
+
+// =============================================================================
+// Helpers of the suite programs
+//
+
+// -----------------------------------------------------------------------------
+// Create an output directory together with its missing parent directories
+// (every prefix of the path ending in a separator).
+// -----------------------------------------------------------------------------
+bool MakeOutputDirectory(const std::string& dir)
+{
+  std::string path = dir;
+  if (!path.empty() && path[path.size() - 1] != '/')
+    path += "/";
+
+  for (size_t pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos + 1)) {
+    std::string prefix = path.substr(0, pos + 1);
+    if (ChFileutils::MakeDirectory(prefix.c_str()) < 0) {
+      std::cout << "Error creating directory " << prefix << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Least-squares fit of y = a * x^p on a log-log scale.
+// -----------------------------------------------------------------------------
+bool FitPowerLaw(const std::vector<double>& x,
+                 const std::vector<double>& y,
+                 double&                    exponent)
+{
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  int    n = 0;
+
+  for (size_t k = 0; k < x.size() && k < y.size(); k++) {
+    // Skip points that have no logarithm (zero, negative, NaN, or infinite).
+    if (!(x[k] > 0 && x[k] <= DBL_MAX && y[k] > 0 && y[k] <= DBL_MAX))
+      continue;
+    double lx = std::log(x[k]);
+    double ly = std::log(y[k]);
+    sx += lx;
+    sy += ly;
+    sxx += lx * lx;
+    sxy += lx * ly;
+    n++;
+  }
+
+  double det = n * sxx - sx * sx;
+  if (n < 2 || det <= 0)
+    return false;
+
+  exponent = (n * sxy - sx * sy) / det;
+  return true;
+}
+
+
+// =============================================================================
+// Simulation
+//
+// Number of output rows of a case: one per step, from the initial time up to
+// (and including) the final time.
+static size_t GetNumOutputRows(const JointCase& c)
+{
+  size_t num_rows = 0;
+  for (double simTime = 0; simTime <= c.end_time + c.sim_step / 2; simTime += c.sim_step)
+    num_rows++;
+  return num_rows;
+}
+
+bool SimulateJointCase(const JointCase& c, JointOutputs& outputs, JointSimulationStats& stats)
+{
+  std::vector<JointOutputs> batch_outputs;
+  bool ok = SimulateJointCases(std::vector<JointCase>(1, c), batch_outputs, stats);
+  if (ok)
+    std::swap(outputs, batch_outputs[0]);
+  return ok;
+}
+
+bool CanBatchJointCases(const JointCase& a, const JointCase& b)
+{
+  return a.sim_step == b.sim_step && a.end_time == b.end_time &&
+         a.solver.integrator == b.solver.integrator &&
+         a.solver.lcp_solver == b.solver.lcp_solver &&
+         a.solver.max_iters_speed == b.solver.max_iters_speed &&
+         a.solver.max_iters_stab == b.solver.max_iters_stab &&
+         a.solver.tol == b.solver.tol &&
+         a.solver.tol_force == b.solver.tol_force;
+}
+
+// -----------------------------------------------------------------------------
+// Simulate several cases together: the models of all cases are built in the
+// same system (as disjoint subsystems, each with its own ground body) and
+// advanced together, so that the per-step overhead of the system is paid only
+// once. Outputs are recorded per model, in memory, at every step.
+// The execution time covers the creation of the system and the integration
+// steps, but not the recording of the outputs.
+// -----------------------------------------------------------------------------
+bool SimulateJointCases(const std::vector<JointCase>& cases,
+                        std::vector<JointOutputs>&    outputs,
+                        JointSimulationStats&         stats)
+{
+  stats = JointSimulationStats();
+
+  if (cases.empty())
+    return false;
+
+  const JointCase& c = cases[0];
+  for (size_t i = 1; i < cases.size(); i++) {
+    if (!CanBatchJointCases(c, cases[i]))
+      return false;
+  }
+
+  ChTimer<double> setup;
+  setup.start();
+
+  // Create the mechanical system
+  ChSystem my_system;
+  my_system.Set_G_acc(ChVector<>(0.0, 0.0, -gravity));
+  c.solver.Apply(my_system);
+
+  std::vector<JointModel*> models;
+  bool ok = true;
+  for (size_t i = 0; i < cases.size() && ok; i++) {
+    models.push_back(new JointModel(cases[i]));
+    ok = models.back()->Build(my_system);
+  }
+
+  // Perform a system assembly to ensure we have the correct accelerations at
+  // the initial time.
+  if (ok)
+    my_system.DoFullAssembly();
+
+  setup.stop();
+  stats.exec_time = setup();
+
+  if (ok) {
+    size_t num_rows = GetNumOutputRows(c);
+    for (size_t i = 0; i < models.size(); i++)
+      models[i]->InitializeOutput(num_rows);
+
+    // Simulation loop. Outputs are recorded at every step; validation
+    // resamples them onto the time grid of the reference data.
+    double simTime = 0;
+
+    std::string name = (cases.size() == 1) ? c.name : c.name + " (batch)";
+    utils::ChTraceSpan batchSpan(utils::ChTrace::IsEnabled() ? name + " DoStepDynamics" : std::string(), "step");
+
+    for (size_t row = 0; row < num_rows; row++)
+    {
+      batchSpan.End();
+      for (size_t i = 0; i < models.size(); i++)
+        models[i]->Output(simTime);
+      batchSpan.Restart();
+
+      // Advance simulation by one step
+      ChTimer<double> step;
+      step.start();
+      my_system.DoStepDynamics(c.sim_step);
+      step.stop();
+      stats.exec_time += step();
+      stats.num_steps++;
+      stats.step_time += my_system.GetTimerStep();
+      stats.lcp_time += my_system.GetTimerLcp();
+
+      // Increment simulation time
+      simTime += c.sim_step;
+    }
+
+    batchSpan.End();
+
+    outputs.resize(models.size());
+    for (size_t i = 0; i < models.size(); i++)
+      models[i]->GetOutputs(outputs[i]);
+  }
+
+  for (size_t i = 0; i < models.size(); i++)
+    delete models[i];
+
+  return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Simulate a case without recording its outputs: the values of the output
+// channels are passed to the callback at every step (same output times as
+// above, and the callback is not timed either).
+// -----------------------------------------------------------------------------
+bool SimulateJointCase(const JointCase&      c,
+                       JointOutputCallback&  callback,
+                       JointSimulationStats& stats)
+{
+  stats = JointSimulationStats();
+
+  ChTimer<double> setup;
+  setup.start();
+
+  // Create the mechanical system
+  ChSystem my_system;
+  my_system.Set_G_acc(ChVector<>(0.0, 0.0, -gravity));
+  c.solver.Apply(my_system);
+
+  JointModel model(c);
+  if (!model.Build(my_system))
+    return false;
+
+  // Perform a system assembly to ensure we have the correct accelerations at
+  // the initial time.
+  my_system.DoFullAssembly();
+
+  setup.stop();
+  stats.exec_time = setup();
+
+  model.InitializeOutput(0);
+
+  std::vector<std::string> channels;
+  model.GetOutputChannels(channels);
+  callback.OnStart(channels);
+
+  // Simulation loop
+  std::vector<double> values;
+  size_t num_rows = GetNumOutputRows(c);
+  double simTime = 0;
+
+  for (size_t row = 0; row < num_rows; row++)
+  {
+    model.GetOutputValues(values);
+    callback.OnOutput((int)row, simTime, values);
+
+    // Advance simulation by one step
+    ChTimer<double> step;
+    step.start();
+    my_system.DoStepDynamics(c.sim_step);
+    step.stop();
+    stats.exec_time += step();
+    stats.num_steps++;
+    stats.step_time += my_system.GetTimerStep();
+    stats.lcp_time += my_system.GetTimerLcp();
+
+    // Increment simulation time
+    simTime += c.sim_step;
+  }
+
+  return true;
+}
+
+
+// =============================================================================
+// Validation
+//
+bool ValidateJointCase(const JointCase&          c,
+                       const JointOutputs&       outputs,
+                       const JointReferenceData& refs,
+                       JointCaseResult&          result,
+                       std::ostream&             log)
+{
+  result.name = c.name;
+  result.passed = true;
+  result.norms.clear();
+
+  for (size_t i = 0; i < c.tolerances.size(); i++) {
+    const std::string& what = c.tolerances[i].what;
+    double tolerance = c.tolerances[i].tolerance;
+    utils::DataVector norms;
+    bool check;
+
+    const utils::Headers* sim_headers;
+    const utils::Data*    sim_data;
+    const utils::Headers* headers;
+    const utils::Data*    data;
+
+    if (!outputs.Find(what, sim_headers, sim_data)) {
+      log << "   missing output " << what << std::endl;
+      check = false;
+    } else if (what == "Energy") {
+      // Only the change in total energy (last column) is checked.
+      utils::Validate(*sim_headers, *sim_data, utils::RMS_NORM, tolerance, norms);
+      check = norms.size() > 0 && norms[norms.size() - 1] <= tolerance;
+      if (norms.size() > 0) {
+        double last = norms[norms.size() - 1];
+        norms.resize(1);
+        norms[0] = last;
+      }
+    } else if (!IsJointReferenceQuantity(what)) {
+      // Constraint violations are checked against zero.
+      check = utils::Validate(*sim_headers, *sim_data, utils::RMS_NORM, tolerance, norms);
+    } else if (refs.Find(c, what, headers, data)) {
+      // The outputs are recorded at every step: resample them onto the time
+      // grid of the reference data.
+      check = utils::Validate(*sim_headers, *sim_data, *headers, *data, utils::RMS_NORM, tolerance, norms,
+                              utils::INTERP_LINEAR);
+    } else {
+      log << "   missing reference data " << JointReferenceData::GetFileName(c, what) << std::endl;
+      check = false;
+    }
+
+    log << "   validate " << what << (check ? ": Passed" : ": Failed") << "  [  ";
+    for (size_t col = 0; col < norms.size(); col++)
+      log << norms[col] << "  ";
+    log << "  ]" << std::endl;
+
+    result.norms.push_back(std::make_pair(what, norms.size() > 0 ? norms.max() : 0.0));
+    result.passed &= check;
+  }
+
+  return result.passed;
+}
+
+double GetJointCaseMargin(const JointCase& c, const JointCaseResult& result)
+{
+  if (result.norms.size() != c.tolerances.size())
+    return -DBL_MAX;
+
+  double margin = DBL_MAX;
+  for (size_t i = 0; i < c.tolerances.size(); i++) {
+    double norm = result.norms[i].second;
+    if (!(norm == norm) || c.tolerances[i].tolerance <= 0)
+      return -DBL_MAX;
+    margin = std::min(margin, 1 - norm / c.tolerances[i].tolerance);
+  }
+
+  return margin;
+}
@@ -0,0 +1,452 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Data-driven joint validation cases.
+//
+// A validation case (joint type, joint location and orientation, step sizes,
+// solver settings, and validation tolerances per quantity) is described in a
+// JSON suite file, so that any number of cases can be run by a single program.
+// The mechanism is the one used by the individual joint tests: a pendulum
+// connected to the ground through the specified joint.
+//
+// Supported joint types: revolute, spherical, universal, prismatic,
+// cylindrical.
+//
+// The mechanisms of the constraint and force element tests are also supported:
+// distance (distance constraint), revsph (revolute-spherical constraint),
+// transpring (ChLinkSpring), transpringcb (ChLinkSpringCB), rotspring
+// (revolute joint with a rotational spring-damper), and linactuator (plate
+// driven along a prismatic joint by a linear actuator).
+//
+// =============================================================================
+
+#ifndef JOINT_SUITE_H
+#define JOINT_SUITE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+
+#include "core/ChVector.h"
+#include "core/ChQuaternion.h"
+#include "physics/ChSystem.h"
+#include "physics/ChBody.h"
+#include "physics/ChLinkSpringCB.h"
+
+#include "utils/ChUtilsInputOutput.h"
+#include "utils/ChUtilsValidation.h"
+
+
+///
+/// Solver settings for a validation case.
+/// The default values are the ones used by the joint tests.
+///
+struct JointSolverSettings {
+  JointSolverSettings();
+
+  /// Apply these settings to the given system.
+  void Apply(chrono::ChSystem& system) const;
+
+  /// Return a one-line description of these settings.
+  std::string GetDescription() const;
+
+  chrono::ChSystem::eCh_integrationType integrator;
+  chrono::ChSystem::eCh_lcpSolver       lcp_solver;
+  int                                   max_iters_speed;
+  int                                   max_iters_stab;
+  double                                tol;
+  double                                tol_force;
+};
+
+/// Validation tolerance for one simulation quantity.
+/// The quantity is one of the reference quantities ("Pos", "Vel", ...), or
+/// "Energy", or a constraint quantity ("Constraints", or e.g. "ConstraintsP"
+/// for mechanisms with more than one link).
+struct JointTolerance {
+  std::string what;
+  double      tolerance;
+};
+
+///
+/// Physical parameters of the pendulum of a case.
+/// The default values are the ones used by the joint tests.
+///
+struct JointPendulumParams {
+  JointPendulumParams();
+
+  double mass;           ///< pendulum mass
+  double inertia_scale;  ///< scale factor of the pendulum moments of inertia
+  double angle;          ///< initial rotation of the pendulum about the joint Z axis (radians)
+};
+
+///
+/// Parameters of the spring-damper of a force element case. The spring force
+/// (or torque) is -k*x - k_nonlin*|x|*x - c*v, with x the spring deformation
+/// and v its rate.
+///
+struct JointSpringParams {
+  JointSpringParams() : k(0), k_nonlin(0), c(0) {}
+
+  double k;         ///< linear spring coefficient
+  double k_nonlin;  ///< nonlinear spring coefficient (not available for transpring)
+  double c;         ///< damping coefficient
+};
+
+///
+/// Description of one validation case.
+///
+/// For the joint types and rotspring, 'loc' and 'rot' specify the joint frame.
+/// For the point constraints and translational springs (distance, revsph,
+/// transpring, transpringcb), 'loc' is the ground attachment point, 'pend_loc'
+/// the pendulum attachment point, and 'pend_pos' and 'pend_rot' the initial
+/// pendulum frame. For linactuator, 'loc' and 'rot' specify the prismatic
+/// joint frame (translation along its Z axis).
+///
+struct JointCase {
+  JointCase();
+
+  /// Name of the directory (for both outputs and reference data) of this
+  /// joint type, e.g. "revolute_joint/".
+  std::string GetDataDir() const;
+
+  /// Return the link formulation of this case: the specified one, or else
+  /// "lock" if available for the joint type, and "frame" otherwise.
+  std::string GetFormulation() const;
+
+  std::string                 name;        ///< case name, e.g. "Revolute_Case01"
+  std::string                 joint;       ///< joint type, e.g. "revolute"
+  std::string                 formulation; ///< link formulation ("lock", "frame"; empty for default)
+  chrono::ChVector<>          loc;         ///< absolute location of the joint
+  chrono::ChQuaternion<>      rot;         ///< orientation of the joint
+  double                      sim_step;    ///< simulation step size
+  double                      out_step;    ///< output step size of the reference data
+  double                      end_time;    ///< simulation length
+  JointSolverSettings         solver;      ///< solver settings
+  std::vector<JointTolerance> tolerances;  ///< validation tolerances
+  JointPendulumParams         pendulum;    ///< pendulum parameters (not read from suite files)
+
+  chrono::ChVector<>          pend_loc;    ///< absolute location of the pendulum attachment point
+  chrono::ChVector<>          pend_pos;    ///< initial location of the pendulum CG
+  chrono::ChQuaternion<>      pend_rot;    ///< initial orientation of the pendulum
+  chrono::ChVector<>          axis;        ///< revolute axis (revsph)
+  JointSpringParams           spring;      ///< spring-damper (transpring, transpringcb, rotspring)
+  double                      speed;       ///< imposed translation speed (linactuator)
+};
+
+/// Timing statistics of one simulation.
+struct JointSimulationStats {
+  JointSimulationStats() : num_steps(0), exec_time(0), step_time(0), lcp_time(0) {}
+
+  int    num_steps;   ///< number of integration steps
+  double exec_time;   ///< total simulation time, excluding output (wall clock, seconds)
+  double step_time;   ///< time spent in DoStepDynamics (seconds)
+  double lcp_time;    ///< time spent in the LCP solver (seconds)
+};
+
+/// Results of validating one case.
+struct JointCaseResult {
+  JointCaseResult() : passed(false), exec_time(0) {}
+
+  std::string name;        ///< case name
+  bool        passed;      ///< did all validations pass?
+  double      exec_time;   ///< simulation time (wall clock, seconds)
+  std::vector<std::pair<std::string, double> > norms;  ///< max RMS norm per quantity
+};
+
+///
+/// Outputs of a simulated case, recorded in memory at every step: one table per
+/// output quantity (e.g. "Pos"), with the columns of the output files of the
+/// joint tests (the time first).
+///
+struct JointOutputs {
+  std::vector<std::string>            what;     ///< output quantities
+  std::vector<chrono::utils::Headers> headers;  ///< column headers, per quantity
+  std::vector<chrono::utils::Data>    data;     ///< columns, per quantity
+
+  /// Return the table of the given output quantity.
+  /// Returns false if the quantity was not recorded.
+  bool Find(const std::string&             what,
+            const chrono::utils::Headers*& headers,
+            const chrono::utils::Data*&    data) const;
+};
+
+///
+/// Pendulum model of a validation case: a ground body and a pendulum connected
+/// through the joint (or constraint, or force element) of the case. The model
+/// records its outputs in memory (one row per call to Output()), one table per
+/// output quantity.
+///
+class JointModel
+{
+public:
+
+  JointModel(const JointCase& c);
+  ~JointModel();
+
+  /// Create the bodies and the links of this model in the given system.
+  /// Returns false if the joint type is not supported.
+  bool Build(chrono::ChSystem& system);
+
+  /// Record the initial total energy of the pendulum and allocate the given
+  /// number of output rows. Must be called after the system assembly and
+  /// before the first call to Output().
+  void InitializeOutput(size_t num_rows);
+
+  /// Record one output row at the specified time (ignored once all rows
+  /// allocated by InitializeOutput() are recorded).
+  void Output(double time);
+
+  /// Move the recorded outputs to 'outputs'.
+  void GetOutputs(JointOutputs& outputs);
+
+  /// Return the names of the scalar output channels of this model (the column
+  /// headers of the output files, without the time columns).
+  void GetOutputChannels(std::vector<std::string>& names) const;
+
+  /// Return the current values of the output channels, in the order of
+  /// GetOutputChannels(). Must be called after InitializeOutput().
+  void GetOutputValues(std::vector<double>& values) const;
+
+  /// Return the pendulum body (the plate, for linactuator).
+  chrono::ChSharedBodyPtr GetPendulum() const { return m_pendulum; }
+
+private:
+
+  // Output quantity: name (as used in the output file names) and column
+  // headers (without the time column).
+  struct OutputInfo {
+    std::string              what;
+    std::vector<std::string> headers;
+  };
+
+  JointModel(const JointModel&);
+  JointModel& operator=(const JointModel&);
+
+  void AddOutput(const std::string& what, const char* const* headers, int num_headers);
+  void AddConstraintOutput(const std::string& what, int num_constraints);
+  void SetupOutputs();
+
+  void GetReactions(std::vector<chrono::ChVector<> >& reactions) const;
+  void GetConstraintViolations(std::vector<double>& values) const;
+  void GetEnergy(double& transKE, double& rotKE, double& deltaPE) const;
+
+  JointCase                              m_case;
+  double                                 m_energyRefZ;
+  double                                 m_energy0;
+
+  chrono::ChSharedBodyPtr                m_ground;
+  chrono::ChSharedBodyPtr                m_pendulum;
+  chrono::ChSharedPtr<chrono::ChLink>    m_link;
+  chrono::ChSharedPtr<chrono::ChLink>    m_actuator;
+  chrono::ChSpringForceCallback*         m_springForce;
+
+  std::vector<OutputInfo>                m_outputs;
+  std::vector<chrono::utils::Data>       m_data;
+  size_t                                 m_row;
+  std::vector<double>                    m_values;
+};
+
+///
+/// Receiver of the outputs of a simulation run without output files.
+///
+class JointOutputCallback
+{
+public:
+  virtual ~JointOutputCallback() {}
+
+  /// Called once before the first output, with the names of the output
+  /// channels of the model.
+  virtual void OnStart(const std::vector<std::string>&) {}
+
+  /// Called at every simulation step, with the values of all output channels.
+  virtual void OnOutput(int frame, double time, const std::vector<double>& values) = 0;
+};
+
+///
+/// Reference data shared by all validation cases run in one process.
+/// Every reference file is read only once, no matter how many cases (or
+/// repeated runs of a case) use it.
+///
+class JointReferenceData
+{
+public:
+
+  /// Load the reference data for all quantities validated by the given cases.
+  /// Files not already loaded are obtained from the process-wide reference
+  /// data cache, concurrently for different cases. The files of a case are
+  /// obtained together, so that its bundle file is opened and decoded once.
+  void Load(const std::vector<JointCase>& cases);
+
+  /// Return the reference data for the given quantity of a case.
+  /// Returns false if the data is not available.
+  bool Find(const JointCase&                  c,
+            const std::string&                what,
+            const chrono::utils::Headers*&    headers,
+            const chrono::utils::Data*&       data) const;
+
+  /// Return a copy of this reference data restricted to the rows with time
+  /// values up to the specified end time.
+  JointReferenceData Truncated(double end_time) const;
+
+  /// Return the (complete) name of the reference file for the given quantity.
+  static std::string GetFileName(const JointCase& c, const std::string& what);
+
+private:
+
+  std::map<std::string, chrono::utils::ChReferenceData> m_tables;
+};
+
+// -----------------------------------------------------------------------------
+// Free function declarations
+// -----------------------------------------------------------------------------
+
+/// Return true if the given joint type is available with the given link
+/// formulation: "lock" (ChLinkLock) or "frame" (frame-based link, e.g.
+/// ChLinkRevolute, ChLinkUniversal).
+bool HasJointFormulation(const std::string& joint, const std::string& formulation);
+
+/// Return the number of constraints of the given joint type.
+int GetNumJointConstraints(const std::string& joint);
+
+/// Return true if the given joint type includes a spring-damper (see
+/// JointSpringParams).
+bool HasJointSpring(const std::string& joint);
+
+/// Return true if the given quantity is validated against reference data
+/// (i.e. it is not "Energy" or a constraint quantity).
+bool IsJointReferenceQuantity(const std::string& what);
+
+/// Return true if the joint of the given type allows a rotation of the
+/// pendulum about the joint Z axis (see JointPendulumParams::angle).
+bool CanRotateJointPendulum(const std::string& joint);
+
+/// Add to the given system the pendulum body used by the tests of the given
+/// joint type, at rest and in the initial configuration for a joint at the
+/// specified location and orientation. A non-zero initial rotation of the
+/// pendulum must only be specified if CanRotateJointPendulum() is true.
+chrono::ChSharedBodyPtr AddJointPendulum(chrono::ChSystem&             system,
+                                         const std::string&            joint,
+                                         const chrono::ChVector<>&     loc,
+                                         const chrono::ChQuaternion<>& rot,
+                                         const JointPendulumParams&    params = JointPendulumParams());
+
+/// Return the absolute location of the free end of the pendulum created by
+/// AddJointPendulum() for the same arguments (e.g. to attach another pendulum
+/// to it).
+chrono::ChVector<> GetJointPendulumTip(const std::string&            joint,
+                                       const chrono::ChVector<>&     loc,
+                                       const chrono::ChQuaternion<>& rot);
+
+/// Create the link of the given joint type and formulation between the ground
+/// and pendulum bodies, with the joint frame specified in absolute coordinates.
+/// Returns an empty pointer if the joint type or formulation is not available
+/// (in particular, for the constraint and force element mechanisms).
+chrono::ChSharedPtr<chrono::ChLink> CreateJointLink(const std::string&      joint,
+                                                    const std::string&      formulation,
+                                                    chrono::ChSharedBodyPtr ground,
+                                                    chrono::ChSharedBodyPtr pendulum,
+                                                    const chrono::ChFrame<>& frame);
+
+/// Return the integrator with the given name ("ANITESCU", "TASORA").
+/// Returns false if the name is not recognized.
+bool GetIntegratorType(const std::string& name, chrono::ChSystem::eCh_integrationType& type);
+
+/// Return the LCP solver with the given name (e.g. "ITERATIVE_SOR", without
+/// the "LCP_" prefix). Returns false if the name is not recognized.
+bool GetLcpSolverType(const std::string& name, chrono::ChSystem::eCh_lcpSolver& type);
+
+/// Return the name of the given integrator (empty if not supported).
+std::string GetIntegratorName(chrono::ChSystem::eCh_integrationType type);
+
+/// Return the name of the given LCP solver (empty if not supported).
+std::string GetLcpSolverName(chrono::ChSystem::eCh_lcpSolver type);
+
+/// Read the validation cases from the specified JSON suite file. Step sizes,
+/// simulation length, and solver settings specified at the top level of the
+/// file are defaults for all cases. Returns false on error.
+bool ReadJointSuite(const std::string& filename, std::vector<JointCase>& cases);
+
+/// Write the given cases to a JSON suite file (all settings explicitly, for
+/// every case). Returns false on error.
+bool WriteJointSuite(const std::string& filename, const std::vector<JointCase>& cases);
+
+/// Return true if the case name matches one of the given patterns (a pattern
+/// matches a case name which starts with it). An empty list matches all cases.
+bool MatchJointCase(const JointCase& c, const std::vector<std::string>& patterns);
+
+/// Read a suite file and return the cases matching the given patterns (see
+/// MatchJointCase), in suite order. Returns false (with a message) if the file
+/// cannot be read or no case is selected.
+bool SelectJointCases(const std::string&              filename,
+                      const std::vector<std::string>& patterns,
+                      std::vector<JointCase>&         cases);
+
+/// Create the given output directory and any missing parent directories.
+/// Returns false (with a message) on error.
+bool MakeOutputDirectory(const std::string& dir);
+
+/// Least-squares slope of log(y) vs. log(x), i.e. the exponent p of a fit
+/// y = a * x^p. Points with a zero, negative, or non-finite value are skipped.
+/// Returns false if fewer than two distinct points remain.
+bool FitPowerLaw(const std::vector<double>& x,
+                 const std::vector<double>& y,
+                 double&                    exponent);
+
+/// Simulate the given case, recording its outputs in memory at every step.
+/// On return, 'stats' contains the timing statistics of the simulation (the
+/// recording of the outputs is not timed).
+bool SimulateJointCase(const JointCase& c, JointOutputs& outputs, JointSimulationStats& stats);
+
+/// Simulate the given case and pass its outputs to the given callback (at
+/// every simulation step) instead of recording them. On return,
+/// 'stats' contains the timing statistics of the simulation.
+bool SimulateJointCase(const JointCase&      c,
+                       JointOutputCallback&  callback,
+                       JointSimulationStats& stats);
+
+/// Return true if the given cases can be simulated together in one system:
+/// they must have the same step size, simulation length, and solver settings.
+bool CanBatchJointCases(const JointCase& a, const JointCase& b);
+
+/// Simulate the given cases together, as disjoint subsystems of a single
+/// system, and record the outputs of each case in memory at every step.
+/// All cases must be batchable (see CanBatchJointCases). On return, 'stats'
+/// contains the timing statistics of the whole batch.
+/// Note that the solver tolerances apply to the batch as a whole, so results
+/// may differ slightly from those of separate simulations.
+bool SimulateJointCases(const std::vector<JointCase>& cases,
+                        std::vector<JointOutputs>&    outputs,
+                        JointSimulationStats&         stats);
+
+/// Write the recorded outputs of the given case to files in the specified
+/// directory (same files as written by the test of its joint type).
+void WriteJointOutputs(const JointCase& c, const JointOutputs& outputs, const std::string& out_dir);
+
+/// Validate the recorded outputs of the given case against the shared
+/// reference data, onto whose time grid they are interpolated. A report is
+/// written to 'log'.
+bool ValidateJointCase(const JointCase&          c,
+                       const JointOutputs&       outputs,
+                       const JointReferenceData& refs,
+                       JointCaseResult&          result,
+                       std::ostream&             log);
+
+/// Return the worst-case validation margin of a case: the minimum over all
+/// validated quantities of 1 - norm / tolerance (positive if all validations
+/// passed). Returns -DBL_MAX if a norm is missing or not a number.
+double GetJointCaseMargin(const JointCase& c, const JointCaseResult& result);
+
+
+#endif
@@ -0,0 +1,360 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Scaling benchmark: chains and trees of N pendulums.
+//
+// For every selected case of a suite file, a mechanism of N copies of the
+// pendulum of the joint tests is built, with each pendulum connected to the
+// free end of its parent (or to the ground, for the first one) through the
+// joint of the case, at the orientation of the case. In a chain, the parent of
+// pendulum i is pendulum i-1; in a (binary) tree, it is pendulum (i-1)/2.
+// The mechanism is simulated for a fixed number of steps with the step size
+// and solver settings of the case.
+//
+// For each N, the benchmark reports the build time, the number of steps per
+// second, the step time per body, the fraction of the step spent in the LCP
+// solver, the average number of LCP solver iterations per step, and the growth
+// of the process resident memory (per body). The exponent of the step time vs.
+// N (least-squares slope in log-log scale) summarizes the scaling.
+//
+// Usage:
+//   chain_scaling [-t chain|tree] [-n <N1,N2,...>] [-s <steps>] [-j <threads>]
+//                 <suite.json> [case ...]
+//
+// Defaults: chain topology, N = 10,100,1000,10000,100000, 100 steps, 1 solver
+// thread (the thread count applies to the multithreaded solvers). Without
+// case arguments, the first case of each joint type in the suite file is used.
+// The results are recorded as metrics of the test JSON output.
+//
+// =============================================================================
+
+#include <ostream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+#include "core/ChTimer.h"
+#include "lcp/ChLcpIterativeSolver.h"
+
+#include "ChronoValidation_config.h"
+#include "utils/ChUtilsMemory.h"
+#include "utils/ChUtilsTrace.h"
+
+#include "BaseTest.h"
+#include "JointSuite.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local functions
+//
+
+// Build a chain or tree of pendulums connected through the joint of the case.
+static bool BuildPendulums(ChSystem& system, const JointCase& c, int num_bodies, bool tree)
+{
+  ChSharedBodyPtr ground(new ChBody);
+  system.AddBody(ground);
+  ground->SetBodyFixed(true);
+
+  std::string formulation = c.GetFormulation();
+  std::vector<ChSharedBodyPtr> bodies(num_bodies);
+  std::vector<ChVector<> >     tips(num_bodies);
+
+  for (int i = 0; i < num_bodies; i++) {
+    ChSharedBodyPtr parent = ground;
+    ChVector<> loc = c.loc;
+    if (i > 0) {
+      int p = tree ? (i - 1) / 2 : i - 1;
+      parent = bodies[p];
+      loc = tips[p];
+    }
+
+    bodies[i] = AddJointPendulum(system, c.joint, loc, c.rot);
+    tips[i] = GetJointPendulumTip(c.joint, loc, c.rot);
+
+    ChSharedPtr<ChLink> link = CreateJointLink(c.joint, formulation, parent, bodies[i], ChFrame<>(loc, c.rot));
+    if (link.IsNull())
+      return false;
+    system.AddLink(link);
+  }
+
+  return true;
+}
+
+// Results for one mechanism size.
+struct ScalingPoint {
+  ScalingPoint() : num_bodies(0), build_time(0), steps_per_second(0), step_time_per_body(0),
+                   lcp_fraction(0), solver_iters(0), memory_per_body(0) {}
+
+  int    num_bodies;
+  double build_time;          // mechanism construction and assembly (seconds)
+  double steps_per_second;
+  double step_time_per_body;  // seconds
+  double lcp_fraction;        // fraction of the step time spent in the LCP solver
+  double solver_iters;        // average LCP solver iterations per step
+  double memory_per_body;     // resident memory growth per body (bytes)
+};
+
+// Simulate a mechanism of the given size for the given number of steps.
+static bool RunScalingPoint(const JointCase& c,
+                            int              num_bodies,
+                            bool             tree,
+                            int              num_steps,
+                            int              num_threads,
+                            ScalingPoint&    point)
+{
+  point = ScalingPoint();
+  point.num_bodies = num_bodies;
+
+  size_t memory0 = utils::GetResidentMemory();
+
+  ChTimer<double> timer;
+  timer.start();
+
+  ChSystem my_system;
+  my_system.Set_G_acc(ChVector<>(0, 0, -9.80665));
+  c.solver.Apply(my_system);
+  my_system.SetParallelThreadNumber(num_threads);
+
+  if (!BuildPendulums(my_system, c, num_bodies, tree))
+    return false;
+  my_system.DoFullAssembly();
+
+  timer.stop();
+  point.build_time = timer();
+
+  // Record the iterations of the (speed) LCP solver, if iterative
+  ChLcpIterativeSolver* solver = dynamic_cast<ChLcpIterativeSolver*>(my_system.GetLcpSolverSpeed());
+  if (solver)
+    solver->SetRecordViolation(true);
+
+  double step_time = 0;
+  double lcp_time = 0;
+  long   iters = 0;
+
+  utils::ChTraceSpan batchSpan(utils::ChTrace::IsEnabled() ? c.name + " DoStepDynamics" : std::string(), "step");
+
+  timer.reset();
+  timer.start();
+  for (int i = 0; i < num_steps; i++) {
+    if (solver)
+      solver->GetViolationHistory().clear();
+    my_system.DoStepDynamics(c.sim_step);
+    step_time += my_system.GetTimerStep();
+    lcp_time += my_system.GetTimerLcp();
+    if (solver)
+      iters += (long)solver->GetViolationHistory().size();
+  }
+  timer.stop();
+
+  batchSpan.End();
+
+  size_t memory1 = utils::GetResidentMemory();
+
+  point.steps_per_second = (timer() > 0) ? num_steps / timer() : 0;
+  point.step_time_per_body = step_time / num_steps / num_bodies;
+  point.lcp_fraction = (step_time > 0) ? lcp_time / step_time : 0;
+  point.solver_iters = (double)iters / num_steps;
+  point.memory_per_body = (memory1 > memory0) ? (double)(memory1 - memory0) / num_bodies : 0;
+
+  return true;
+}
+
+// =============================================================================
+
+class chain_scaling : public BaseTest
+{
+public:
+  chain_scaling(const std::string&              suiteFile,
+                const std::vector<std::string>& selection,
+                const std::vector<int>&         sizes,
+                bool                            tree,
+                int                             numSteps,
+                int                             numThreads)
+  : BaseTest("chain_scaling", "Chrono::Validation"),
+    m_suiteFile(suiteFile),
+    m_selection(selection),
+    m_sizes(sizes),
+    m_tree(tree),
+    m_numSteps(numSteps),
+    m_numThreads(numThreads),
+    m_execTime(-1)
+  {}
+  ~chain_scaling() {}
+
+  virtual bool execute();
+  virtual double getExecutionTime() const { return m_execTime; }
+
+private:
+  std::string              m_suiteFile;
+  std::vector<std::string> m_selection;
+  std::vector<int>         m_sizes;
+  bool                     m_tree;
+  int                      m_numSteps;
+  int                      m_numThreads;
+  double                   m_execTime;
+};
+
+// =============================================================================
+//
+// Run all mechanism sizes for all selected cases and report the results.
+//
+bool chain_scaling::execute()
+{
+  ChTimer<double> full;
+  full.start();
+
+  // Read the suite file and select the cases (by default, the first case of
+  // each joint type)
+  std::vector<JointCase> selected;
+  if (!SelectJointCases(m_suiteFile, m_selection, selected))
+    return false;
+
+  std::vector<JointCase> cases;
+  std::vector<std::string> joints;
+  for (size_t i = 0; i < selected.size(); i++) {
+    const JointCase& c = selected[i];
+    // Chains can only be built from joints (not from the constraint and force
+    // element mechanisms).
+    if (c.GetFormulation().empty())
+      continue;
+    if (m_selection.empty()) {
+      if (std::find(joints.begin(), joints.end(), c.joint) != joints.end())
+        continue;
+      joints.push_back(c.joint);
+    }
+    cases.push_back(c);
+  }
+
+  if (cases.empty()) {
+    std::cout << "No cases selected from " << m_suiteFile << std::endl;
+    return false;
+  }
+
+  std::string topology = m_tree ? "tree" : "chain";
+  bool test_passed = true;
+
+  for (size_t i = 0; i < cases.size(); i++) {
+    const JointCase& c = cases[i];
+    std::string prefix = c.name + "_" + topology;
+
+    std::cout << c.name << " (" << c.joint << ", " << c.GetFormulation() << " link, "
+              << topology << ")" << std::endl;
+    std::cout << "         N   build [s]   steps/s   step/body [us]   LCP frac   iters/step   mem/body [B]" << std::endl;
+
+    std::vector<double> num_bodies, build_time, steps_per_second, step_time_per_body;
+    std::vector<double> lcp_fraction, solver_iters, memory_per_body;
+
+    for (size_t k = 0; k < m_sizes.size(); k++) {
+      ScalingPoint point;
+      if (!RunScalingPoint(c, m_sizes[k], m_tree, m_numSteps, m_numThreads, point)) {
+        std::cout << "   failed to build mechanism with " << m_sizes[k] << " bodies" << std::endl;
+        test_passed = false;
+        break;
+      }
+
+      char line[160];
+      sprintf(line, "%10d  %10.3f  %8.1f  %15.3f  %9.3f  %11.1f  %13.0f", point.num_bodies,
+              point.build_time, point.steps_per_second, 1e6 * point.step_time_per_body,
+              point.lcp_fraction, point.solver_iters, point.memory_per_body);
+      std::cout << line << std::endl;
+
+      num_bodies.push_back(point.num_bodies);
+      build_time.push_back(point.build_time);
+      steps_per_second.push_back(point.steps_per_second);
+      step_time_per_body.push_back(point.step_time_per_body);
+      lcp_fraction.push_back(point.lcp_fraction);
+      solver_iters.push_back(point.solver_iters);
+      memory_per_body.push_back(point.memory_per_body);
+    }
+
+    addMetric(prefix + "_NumBodies", num_bodies);
+    addMetric(prefix + "_BuildTime", build_time);
+    addMetric(prefix + "_StepsPerSecond", steps_per_second);
+    addMetric(prefix + "_StepTimePerBody", step_time_per_body);
+    addMetric(prefix + "_LcpFraction", lcp_fraction);
+    addMetric(prefix + "_SolverIters", solver_iters);
+    addMetric(prefix + "_MemoryPerBody", memory_per_body);
+
+    // Exponent of the step time (per step, for the whole mechanism) vs. N
+    std::vector<double> step_time(num_bodies.size());
+    for (size_t k = 0; k < num_bodies.size(); k++)
+      step_time[k] = step_time_per_body[k] * num_bodies[k];
+
+    double exponent;
+    if (FitPowerLaw(num_bodies, step_time, exponent)) {
+      addMetric(prefix + "_StepTimeExponent", exponent);
+      std::cout << "   step time ~ N^" << exponent << std::endl;
+    }
+  }
+
+  addMetric("num_cases", (int)cases.size());
+  addMetric("num_steps", m_numSteps);
+  addMetric("num_threads", m_numThreads);
+  addMetric("peak_memory", (double)utils::GetPeakResidentMemory());
+
+  full.stop();
+  m_execTime = full();
+  std::cout << "Full Execution Time = " << m_execTime << std::endl;
+
+  return test_passed;
+}
+
+int main(int argc, char* argv[])
+{
+  std::string suite_file;
+  std::vector<std::string> selection;
+  std::vector<int> sizes;
+  bool tree = false;
+  int num_steps = 100;
+  int num_threads = 1;
+  bool args_ok = utils::ParseSizeList("10,100,1000,10000,100000", sizes);
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-t" && i + 1 < argc) {
+      std::string topology = argv[++i];
+      tree = (topology == "tree");
+      args_ok &= (tree || topology == "chain");
+    } else if (arg == "-n" && i + 1 < argc)
+      args_ok &= utils::ParseSizeList(argv[++i], sizes);
+    else if (arg == "-s" && i + 1 < argc)
+      num_steps = atoi(argv[++i]);
+    else if (arg == "-j" && i + 1 < argc)
+      num_threads = atoi(argv[++i]);
+    else if (suite_file.empty())
+      suite_file = arg;
+    else
+      selection.push_back(arg);
+  }
+
+  if (suite_file.empty() || !args_ok || num_steps < 1 || num_threads < 1) {
+    std::cout << "Usage: " << argv[0]
+              << " [-t chain|tree] [-n <N1,N2,...>] [-s <steps>] [-j <threads>] <suite.json> [case ...]" << std::endl;
+    return 1;
+  }
+
+  chain_scaling t(suite_file, selection, sizes, tree, num_steps, num_threads);
+  t.setArguments(argc, argv);
+  t.print();  // optional
+
+  /* Run and time test */
+  t.run();
+
+  // Return 0 if all tests passed and 1 otherwise
+  return !t.m_passed;
+}
@@ -0,0 +1,336 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Step-size convergence study for the joint validation cases.
+//
+// Every selected case of a suite file is run at a geometric ladder of step
+// sizes h_k = h_0 / r^k (all runs are distributed over a pool of OpenMP
+// threads) and validated against the reference data. For each case, the study
+// reports the RMS norms at every step size, the empirical convergence order of
+// each reference quantity (least-squares slope of log(norm) vs. log(h)), and
+// the largest step size that passes all validation tolerances of the case,
+// together with all smaller step sizes of the ladder.
+//
+// The outputs are recorded at every step and interpolated onto the time grid
+// of the reference data, so the step sizes need not divide the output step.
+// With -t, all runs are shortened to the given length (a multiple of the
+// output step) and validated against the reference data up to that time.
+//
+// Usage:
+//   convergence_study [-j <threads>] [-l <levels>] [-r <ratio>] [-s <h0>]
+//                     [-t <length>] <suite.json> [case ...]
+//
+// Defaults: 8 levels, ratio 2, h0 equal to the output step of the case, full
+// simulation length. The results are recorded as metrics of the test JSON
+// output.
+//
+// =============================================================================
+
+#include <ostream>
+#include <sstream>
+#include <cstdlib>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "core/ChTimer.h"
+
+#include "ChronoValidation_config.h"
+#include "utils/ChUtilsValidation.h"
+#include "utils/ChUtilsTrace.h"
+
+#include "BaseTest.h"
+#include "JointSuite.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local variables
+//
+
+// =============================================================================
+// Local functions
+//
+
+// Return true if the given value is neither NaN nor infinite.
+static bool IsFinite(double val)
+{
+  return val == val && std::fabs(val) <= DBL_MAX;
+}
+
+// One simulation of the study: a case at one level of its step ladder.
+struct StudyRun {
+  size_t          case_index;
+  int             level;
+  JointCase       c;
+  JointCaseResult result;
+};
+
+// Runs with smaller steps are more expensive; start them first.
+static bool MoreExpensive(const StudyRun& a, const StudyRun& b)
+{
+  return a.c.sim_step < b.c.sim_step;
+}
+
+// =============================================================================
+
+class convergence_study : public BaseTest
+{
+public:
+  convergence_study(const std::string&              suiteFile,
+                    const std::vector<std::string>& selection,
+                    int                             numThreads,
+                    int                             numLevels,
+                    int                             ratio,
+                    double                          coarsestStep,
+                    double                          length)
+  : BaseTest("convergence_study", "Chrono::Validation"),
+    m_suiteFile(suiteFile),
+    m_selection(selection),
+    m_numThreads(numThreads),
+    m_numLevels(numLevels),
+    m_ratio(ratio),
+    m_coarsestStep(coarsestStep),
+    m_length(length),
+    m_execTime(-1)
+  {}
+  ~convergence_study() {}
+
+  virtual bool execute();
+  virtual double getExecutionTime() const { return m_execTime; }
+
+private:
+  std::string              m_suiteFile;
+  std::vector<std::string> m_selection;
+  int                      m_numThreads;
+  int                      m_numLevels;
+  int                      m_ratio;
+  double                   m_coarsestStep;
+  double                   m_length;
+  double                   m_execTime;
+};
+
+// =============================================================================
+//
+// Run the step ladders of all selected cases and report the results.
+//
+bool convergence_study::execute()
+{
+  ChTimer<double> full;
+  full.start();
+
+  // Set the path to the Chrono data folder
+  SetChronoDataPath(CHRONO_DATA_DIR);
+
+  // Read the suite file and select the cases to study
+  std::vector<JointCase> cases;
+  if (!SelectJointCases(m_suiteFile, m_selection, cases))
+    return false;
+
+  // Create the step ladders: h_k = h0 / ratio^k.
+  std::vector<StudyRun> runs;
+
+  for (size_t i = 0; i < cases.size(); i++) {
+    const JointCase& c = cases[i];
+    double h0 = (m_coarsestStep > 0) ? m_coarsestStep : c.out_step;
+
+    double divisor = 1;
+    for (int k = 0; k < m_numLevels; k++) {
+      StudyRun run;
+      run.case_index = i;
+      run.level = k;
+      run.c = c;
+      run.c.sim_step = h0 / divisor;
+      if (m_length > 0)
+        run.c.end_time = m_length;
+      runs.push_back(run);
+      divisor *= m_ratio;
+    }
+  }
+
+  std::cout << "Running " << cases.size() << " cases at " << m_numLevels
+            << " step sizes each (" << runs.size() << " runs)" << std::endl;
+
+  // Load all reference data once (truncated to the length of the runs)
+  JointReferenceData refs;
+  refs.Load(cases);
+  if (m_length > 0)
+    refs = refs.Truncated(m_length);
+
+  // Run all simulations on the thread pool
+  std::stable_sort(runs.begin(), runs.end(), MoreExpensive);
+
+#ifdef _OPENMP
+  if (m_numThreads > 0)
+    omp_set_num_threads(m_numThreads);
+#endif
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int i = 0; i < (int)runs.size(); i++) {
+    utils::ChTrace::SetWorkerThreadName();
+
+    StudyRun& run = runs[i];
+    std::ostringstream log;
+
+    std::ostringstream name;
+    if (utils::ChTrace::IsEnabled())
+      name << run.c.name << "_L" << run.level;
+    utils::ChTraceSpan runSpan(name.str(), "case");
+
+    JointSimulationStats stats;
+    JointOutputs outputs;
+    if (SimulateJointCase(run.c, outputs, stats)) {
+      ValidateJointCase(run.c, outputs, refs, run.result, log);
+    } else {
+      run.result.name = run.c.name;
+      run.result.passed = false;
+    }
+    run.result.exec_time = stats.exec_time;
+
+    runSpan.End();
+
+#pragma omp critical(convergence_study_log)
+    std::cout << "   " << run.c.name << "  h = " << run.c.sim_step
+              << (run.result.passed ? "  Passed" : "  Failed")
+              << "  (" << run.result.exec_time << " s)" << std::endl;
+  }
+
+  // Collect the results per case, ordered by decreasing step size
+  bool test_passed = true;
+
+  for (size_t i = 0; i < cases.size(); i++) {
+    const JointCase& c = cases[i];
+
+    std::vector<const StudyRun*> ladder(m_numLevels, (const StudyRun*)NULL);
+    for (size_t j = 0; j < runs.size(); j++) {
+      if (runs[j].case_index == i)
+        ladder[runs[j].level] = &runs[j];
+    }
+
+    std::vector<double> steps(m_numLevels);
+    std::vector<double> times(m_numLevels);
+    std::vector<double> passed(m_numLevels);
+    for (int k = 0; k < m_numLevels; k++) {
+      const StudyRun& run = *ladder[k];
+      steps[k] = run.c.sim_step;
+      times[k] = run.result.exec_time;
+      passed[k] = run.result.passed ? 1 : 0;
+    }
+
+    // Largest step size such that it and all smaller ones pass (a coarse level
+    // that passes by chance above a failing finer level does not count).
+    double max_passing_step = 0;
+    for (int k = m_numLevels - 1; k >= 0 && passed[k] > 0; k--)
+      max_passing_step = steps[k];
+
+    addMetric(c.name + "_Steps", steps);
+    addMetric(c.name + "_ExecTime", times);
+    addMetric(c.name + "_Passed", passed);
+
+    std::cout << c.name << std::endl;
+
+    // Norms and convergence order of each validated quantity. Norms of
+    // diverged runs are recorded as -1.
+    for (size_t q = 0; q < c.tolerances.size(); q++) {
+      const std::string& what = c.tolerances[q].what;
+      std::vector<double> norms(m_numLevels, -1.0);
+
+      for (int k = 0; k < m_numLevels; k++) {
+        const JointCaseResult& r = ladder[k]->result;
+        if (q < r.norms.size() && IsFinite(r.norms[q].second))
+          norms[k] = r.norms[q].second;
+      }
+
+      addMetric(c.name + "_" + what + "_RMSmax", norms);
+
+      double order;
+      if (IsJointReferenceQuantity(what) && FitPowerLaw(steps, norms, order)) {
+        addMetric(c.name + "_" + what + "_Order", order);
+        std::cout << "   " << what << " convergence order: " << order << std::endl;
+      }
+    }
+
+    addMetric(c.name + "_MaxPassingStep", max_passing_step);
+
+    if (max_passing_step > 0) {
+      addMetric(c.name + "_StepSpeedup", max_passing_step / c.sim_step);
+      std::cout << "   largest passing step: " << max_passing_step
+                << " (current " << c.sim_step << ")" << std::endl;
+    } else {
+      std::cout << "   no step size passed all tolerances" << std::endl;
+      test_passed = false;
+    }
+  }
+
+  addMetric("num_cases", (int)cases.size());
+  addMetric("num_levels", m_numLevels);
+  addMetric("ratio", m_ratio);
+
+  full.stop();
+  m_execTime = full();
+  std::cout << "Full Execution Time = " << m_execTime << std::endl;
+
+  return test_passed;
+}
+
+int main(int argc, char* argv[])
+{
+  std::string suite_file;
+  std::vector<std::string> selection;
+  int num_threads = 0;
+  int num_levels = 8;
+  int ratio = 2;
+  double coarsest_step = 0;
+  double length = 0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc)
+      num_threads = atoi(argv[++i]);
+    else if (arg == "-l" && i + 1 < argc)
+      num_levels = atoi(argv[++i]);
+    else if (arg == "-r" && i + 1 < argc)
+      ratio = atoi(argv[++i]);
+    else if (arg == "-s" && i + 1 < argc)
+      coarsest_step = atof(argv[++i]);
+    else if (arg == "-t" && i + 1 < argc)
+      length = atof(argv[++i]);
+    else if (suite_file.empty())
+      suite_file = arg;
+    else
+      selection.push_back(arg);
+  }
+
+  if (suite_file.empty() || num_levels < 2 || ratio < 2) {
+    std::cout << "Usage: " << argv[0]
+              << " [-j <threads>] [-l <levels>] [-r <ratio>] [-s <h0>] [-t <length>] <suite.json> [case ...]" << std::endl;
+    std::cout << "  (at least 2 levels; integer ratio of at least 2)" << std::endl;
+    return 1;
+  }
+
+  convergence_study t(suite_file, selection, num_threads, num_levels, ratio, coarsest_step, length);
+  t.setArguments(argc, argv);
+  t.print();  // optional
+
+  /* Run and time test */
+  t.run();
+
+  // Return 0 if all tests passed and 1 otherwise
+  return !t.m_passed;
+}
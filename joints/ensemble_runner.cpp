@@ -0,0 +1,704 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Monte-Carlo ensembles of the pendulum models of the validation suite.
+//
+// Every selected case of a suite file is simulated many times, each time with
+// a pendulum whose mass, moments of inertia, and initial rotation about the
+// joint Z axis (and, for the spring-damper cases, the spring and damping
+// coefficients) are sampled from the specified distributions. The samples are
+// independent simulations, distributed dynamically over a pool of OpenMP
+// threads (an idle thread picks the next pending sample).
+//
+// Statistics of every output channel of the model (CM position, velocity and
+// acceleration, orientation, angular velocity and acceleration, reaction force
+// and torque, energy, constraint violations) are accumulated online, per
+// output time: mean and standard deviation (Welford's algorithm) and the 5%,
+// 50% and 95% quantiles (P-square estimators, Jain & Chlamtac 1985). Only one
+// trajectory per thread is kept in memory at any time. The statistics are
+// written to one file per statistic in RESULTS/ensemble_runner/<case>/.
+//
+// A parameter distribution is specified as:
+//   -p <name>=<value>                 fixed value
+//   -p <name>=normal:<mean>:<std>     normal distribution
+//   -p <name>=uniform:<min>:<max>     uniform distribution
+// with <name> one of "mass" (pendulum mass), "inertia" (scale factor of the
+// moments of inertia), "angle" (initial rotation, in degrees), "spring" (scale
+// factor of the linear and nonlinear spring coefficients), "damping" (scale
+// factor of the damping coefficient). Mass, inertia, spring and damping
+// samples are redrawn until positive. The initial rotation is only applied to
+// joints that allow a rotation about the joint Z axis (revolute, spherical,
+// cylindrical); the spring and damping factors only to the spring-damper
+// cases (transpring, transpringcb, rotspring). Samples are reproducible: each
+// sample has its own random sequence, determined by the seed, the case, and
+// the sample index. Note that the accumulation order of the samples depends on
+// the thread schedule, so the quantile estimates (and the round-off of the
+// moments) may vary slightly between runs.
+//
+// Usage:
+//   ensemble_runner [-j <threads>] [-n <samples>] [-seed <seed>]
+//                   [-p <name>=<distribution> ...] <suite.json> [case ...]
+//
+// Defaults: all available threads, 1000 samples per case, seed 1,
+// mass=normal:1:0.05, inertia=normal:1:0.05, angle=normal:0:2,
+// spring=normal:1:0.05, damping=normal:1:0.05.
+//
+// =============================================================================
+
+#include <ostream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "core/ChTimer.h"
+
+#include "ChronoValidation_config.h"
+#include "utils/ChUtilsInputOutput.h"
+#include "utils/ChUtilsTrace.h"
+
+#include "BaseTest.h"
+#include "JointSuite.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local variables
+//
+static const std::string val_dir = "../RESULTS/";
+static const std::string out_dir = val_dir + "ensemble_runner/";
+
+// Quantiles estimated for every output channel and output time
+static const double quantiles[] = {0.05, 0.5, 0.95};
+static const char*  quantile_names[] = {"P05", "P50", "P95"};
+static const int    num_quantiles = 3;
+
+// =============================================================================
+// Local functions
+//
+
+// Random number generator of one sample (SplitMix64): cheap to seed, so that
+// every sample can have its own sequence, independent of the thread running it.
+class SampleRandom
+{
+public:
+  SampleRandom(unsigned int seed, int c, int sample)
+  : m_state(((uint64_t)seed << 40) ^ ((uint64_t)c << 24) ^ (uint64_t)sample)
+  {
+    Next();
+  }
+
+  // Uniform in [0, 1)
+  double Uniform() { return (Next() >> 11) * (1.0 / 9007199254740992.0); }
+
+  // Standard normal (Box-Muller)
+  double Normal()
+  {
+    double u1 = 1.0 - Uniform();
+    double u2 = Uniform();
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * CH_C_PI * u2);
+  }
+
+private:
+  uint64_t Next()
+  {
+    uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  uint64_t m_state;
+};
+
+// Distribution of one model parameter.
+struct ParamDistribution {
+  enum Type { FIXED, NORMAL, UNIFORM };
+
+  ParamDistribution(Type t = FIXED, double a_ = 0, double b_ = 0) : type(t), a(a_), b(b_) {}
+
+  // Parse "<value>", "normal:<mean>:<std>" or "uniform:<min>:<max>".
+  bool Parse(const std::string& str)
+  {
+    std::vector<std::string> items;
+    std::istringstream iss(str);
+    std::string item;
+    while (std::getline(iss, item, ':'))
+      items.push_back(item);
+
+    if (items.size() == 1) {
+      type = FIXED;
+      a = atof(items[0].c_str());
+      return true;
+    }
+    if (items.size() != 3)
+      return false;
+
+    a = atof(items[1].c_str());
+    b = atof(items[2].c_str());
+    if (items[0] == "normal") {
+      type = NORMAL;
+      return b >= 0;
+    }
+    if (items[0] == "uniform") {
+      type = UNIFORM;
+      return b >= a;
+    }
+    return false;
+  }
+
+  bool IsFixed() const { return type == FIXED || a == b || (type == NORMAL && b == 0); }
+
+  double Sample(SampleRandom& rng) const
+  {
+    switch (type) {
+      case NORMAL:  return a + b * rng.Normal();
+      case UNIFORM: return a + (b - a) * rng.Uniform();
+      default:      return a;
+    }
+  }
+
+  // Sample a positive value (redraw until positive; at most 100 attempts).
+  double SamplePositive(SampleRandom& rng) const
+  {
+    double value = Sample(rng);
+    for (int k = 0; k < 100 && value <= 0; k++)
+      value = Sample(rng);
+    return value;
+  }
+
+  std::string GetDescription() const
+  {
+    std::ostringstream oss;
+    switch (type) {
+      case NORMAL:  oss << "normal(" << a << ", " << b << ")"; break;
+      case UNIFORM: oss << "uniform(" << a << ", " << b << ")"; break;
+      default:      oss << a; break;
+    }
+    return oss.str();
+  }
+
+  Type   type;
+  double a;
+  double b;
+};
+
+// Online estimate of one quantile of a sequence of values, without storing
+// the values (P-square algorithm, Jain & Chlamtac 1985): five markers track
+// the minimum, the p/2, p and (1+p)/2 quantiles, and the maximum, and are
+// adjusted with a piecewise-parabolic prediction after every value.
+class P2Quantile
+{
+public:
+  P2Quantile() : m_p(0.5), m_count(0) {}
+
+  void SetQuantile(double p)
+  {
+    m_p = p;
+    m_count = 0;
+  }
+
+  void Add(double x)
+  {
+    // Store the first five values, then initialize the markers.
+    if (m_count < 5) {
+      m_q[m_count++] = x;
+      if (m_count == 5) {
+        std::sort(m_q, m_q + 5);
+        for (int i = 0; i < 5; i++)
+          m_n[i] = i;
+        m_np[0] = 0;
+        m_np[1] = 2 * m_p;
+        m_np[2] = 4 * m_p;
+        m_np[3] = 2 + 2 * m_p;
+        m_np[4] = 4;
+        m_dn[0] = 0;
+        m_dn[1] = m_p / 2;
+        m_dn[2] = m_p;
+        m_dn[3] = (1 + m_p) / 2;
+        m_dn[4] = 1;
+      }
+      return;
+    }
+    m_count++;
+
+    // Find the cell of the new value, and update the extreme markers.
+    int k;
+    if (x < m_q[0]) {
+      m_q[0] = x;
+      k = 0;
+    } else if (x >= m_q[4]) {
+      m_q[4] = x;
+      k = 3;
+    } else {
+      k = 0;
+      while (k < 3 && x >= m_q[k + 1])
+        k++;
+    }
+
+    for (int i = k + 1; i < 5; i++)
+      m_n[i]++;
+    for (int i = 0; i < 5; i++)
+      m_np[i] += m_dn[i];
+
+    // Adjust the heights of the middle markers if necessary.
+    for (int i = 1; i < 4; i++) {
+      double d = m_np[i] - m_n[i];
+      if ((d >= 1 && m_n[i + 1] - m_n[i] > 1) || (d <= -1 && m_n[i - 1] - m_n[i] < -1)) {
+        int s = (d > 0) ? 1 : -1;
+        double q = Parabolic(i, s);
+        if (m_q[i - 1] < q && q < m_q[i + 1])
+          m_q[i] = q;
+        else
+          m_q[i] += s * (m_q[i + s] - m_q[i]) / (m_n[i + s] - m_n[i]);
+        m_n[i] += s;
+      }
+    }
+  }
+
+  double Get() const
+  {
+    if (m_count == 0)
+      return 0;
+    if (m_count < 5) {
+      // Too few values for the markers: nearest rank of the sorted values.
+      double v[5];
+      std::copy(m_q, m_q + m_count, v);
+      std::sort(v, v + m_count);
+      int r = (int)std::floor(m_p * (m_count - 1) + 0.5);
+      return v[r];
+    }
+    return m_q[2];
+  }
+
+private:
+  double Parabolic(int i, int s) const
+  {
+    return m_q[i] + s / (m_n[i + 1] - m_n[i - 1]) *
+                        ((m_n[i] - m_n[i - 1] + s) * (m_q[i + 1] - m_q[i]) / (m_n[i + 1] - m_n[i]) +
+                         (m_n[i + 1] - m_n[i] - s) * (m_q[i] - m_q[i - 1]) / (m_n[i] - m_n[i - 1]));
+  }
+
+  double m_p;
+  int    m_count;
+  double m_q[5];    // marker heights
+  double m_n[5];    // marker positions
+  double m_np[5];   // desired marker positions
+  double m_dn[5];   // increments of the desired positions
+};
+
+// Online statistics of one output channel at one output time.
+struct ChannelStats {
+  ChannelStats() : count(0), mean(0), m2(0)
+  {
+    for (int q = 0; q < num_quantiles; q++)
+      quantile[q].SetQuantile(quantiles[q]);
+  }
+
+  void Add(double x)
+  {
+    // Welford's update of the mean and the sum of squared deviations
+    count++;
+    double delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+
+    for (int q = 0; q < num_quantiles; q++)
+      quantile[q].Add(x);
+  }
+
+  double GetStdDev() const { return (count > 1) ? std::sqrt(m2 / (count - 1)) : 0; }
+
+  int        count;
+  double     mean;
+  double     m2;
+  P2Quantile quantile[num_quantiles];
+};
+
+// Recorder of the trajectory of one sample: the output rows of a single
+// simulation, merged into the ensemble statistics once the sample completes.
+// The simulation reports every step; only the rows at the output times of the
+// case are kept.
+class SampleRecorder : public JointOutputCallback
+{
+public:
+  SampleRecorder(const JointCase& c) : m_simStep(c.sim_step), m_outStep(c.out_step), m_outTime(0) {}
+
+  virtual void OnStart(const std::vector<std::string>& channels)
+  {
+    m_channels = channels;
+  }
+
+  virtual void OnOutput(int, double time, const std::vector<double>& values)
+  {
+    if (time < m_outTime - m_simStep / 2)
+      return;
+
+    m_times.push_back(time);
+    m_rows.push_back(values);
+    m_outTime += m_outStep;
+  }
+
+  double                            m_simStep;
+  double                            m_outStep;
+  double                            m_outTime;
+  std::vector<std::string>          m_channels;
+  std::vector<double>               m_times;
+  std::vector<std::vector<double> > m_rows;
+};
+
+// Ensemble of one case: sampled parameters and online statistics per output
+// channel and output time.
+struct CaseEnsemble {
+  CaseEnsemble() : num_samples(0), num_failed(0), sample_time(0) {}
+
+  // Merge the trajectory of one sample (not thread-safe).
+  void Add(const SampleRecorder& rec)
+  {
+    if (num_samples == 0) {
+      channels = rec.m_channels;
+      times = rec.m_times;
+      stats.resize(times.size() * channels.size());
+    }
+
+    size_t num_frames = std::min(times.size(), rec.m_rows.size());
+    for (size_t f = 0; f < num_frames; f++) {
+      const std::vector<double>& row = rec.m_rows[f];
+      for (size_t k = 0; k < channels.size() && k < row.size(); k++)
+        stats[f * channels.size() + k].Add(row[k]);
+    }
+
+    num_samples++;
+  }
+
+  const ChannelStats& Get(size_t frame, size_t channel) const
+  {
+    return stats[frame * channels.size() + channel];
+  }
+
+  JointCase                 c;
+  bool                      rotate;
+  bool                      spring;
+  int                       num_samples;   // completed samples
+  int                       num_failed;    // failed simulations
+  double                    sample_time;   // total simulation time of all samples
+  std::vector<std::string>  channels;
+  std::vector<double>       times;
+  std::vector<ChannelStats> stats;
+};
+
+// Write one statistic of all channels of an ensemble, one row per output time
+// ('which' is "Mean", "StdDev", or a quantile index).
+static void WriteEnsembleStat(const CaseEnsemble& e,
+                              const std::string&  dir,
+                              const std::string&  which,
+                              int                 q)
+{
+  utils::CSV_writer csv("\t");
+  csv.stream().setf(std::ios::scientific | std::ios::showpos);
+  csv.stream().precision(6);
+
+  csv << "Time";
+  for (size_t k = 0; k < e.channels.size(); k++)
+    csv << e.channels[k];
+  csv << std::endl;
+
+  for (size_t f = 0; f < e.times.size(); f++) {
+    csv << e.times[f];
+    for (size_t k = 0; k < e.channels.size(); k++) {
+      const ChannelStats& s = e.Get(f, k);
+      if (which == "Mean")
+        csv << s.mean;
+      else if (which == "StdDev")
+        csv << s.GetStdDev();
+      else
+        csv << s.quantile[q].Get();
+    }
+    csv << std::endl;
+  }
+
+  const std::string& name = e.c.name;
+  csv.write_to_file(dir + name + "_ENSEMBLE_" + which + ".txt", name + "\n\n");
+}
+
+// =============================================================================
+
+class ensemble_runner : public BaseTest
+{
+public:
+  ensemble_runner(const std::string&              suiteFile,
+                  const std::vector<std::string>& selection,
+                  int                             numThreads,
+                  int                             numSamples,
+                  unsigned int                    seed,
+                  const ParamDistribution&        mass,
+                  const ParamDistribution&        inertia,
+                  const ParamDistribution&        angle,
+                  const ParamDistribution&        spring,
+                  const ParamDistribution&        damping)
+  : BaseTest("ensemble_runner", "Chrono::Validation"),
+    m_suiteFile(suiteFile),
+    m_selection(selection),
+    m_numThreads(numThreads),
+    m_numSamples(numSamples),
+    m_seed(seed),
+    m_mass(mass),
+    m_inertia(inertia),
+    m_angle(angle),
+    m_spring(spring),
+    m_damping(damping),
+    m_execTime(-1)
+  {}
+  ~ensemble_runner() {}
+
+  virtual bool execute();
+  virtual double getExecutionTime() const { return m_execTime; }
+
+private:
+  std::string              m_suiteFile;
+  std::vector<std::string> m_selection;
+  int                      m_numThreads;
+  int                      m_numSamples;
+  unsigned int             m_seed;
+  ParamDistribution        m_mass;
+  ParamDistribution        m_inertia;
+  ParamDistribution        m_angle;
+  ParamDistribution        m_spring;
+  ParamDistribution        m_damping;
+  double                   m_execTime;
+};
+
+// =============================================================================
+//
+// Run all samples of all selected cases and record the ensemble statistics.
+//
+bool ensemble_runner::execute()
+{
+  ChTimer<double> full;
+  full.start();
+
+  // Set the path to the Chrono data folder
+  SetChronoDataPath(CHRONO_DATA_DIR);
+
+  // Read the suite file and select the cases
+  std::vector<JointCase> cases;
+  if (!SelectJointCases(m_suiteFile, m_selection, cases))
+    return false;
+
+  std::vector<CaseEnsemble> ensembles;
+  for (size_t i = 0; i < cases.size(); i++) {
+    CaseEnsemble e;
+    e.c = cases[i];
+    e.rotate = CanRotateJointPendulum(e.c.joint);
+    if (!e.rotate && !(m_angle.IsFixed() && m_angle.a == 0))
+      std::cout << "Note: no initial rotation for " << e.c.name << " (joint '" << e.c.joint << "')" << std::endl;
+    e.spring = HasJointSpring(e.c.joint);
+    if (!e.spring && !(m_spring.IsFixed() && m_spring.a == 1 && m_damping.IsFixed() && m_damping.a == 1))
+      std::cout << "Note: no spring-damper for " << e.c.name << " (joint '" << e.c.joint << "')" << std::endl;
+    ensembles.push_back(e);
+  }
+
+  std::cout << "Parameters: mass = " << m_mass.GetDescription()
+            << ", inertia scale = " << m_inertia.GetDescription()
+            << ", angle [deg] = " << m_angle.GetDescription()
+            << ", spring scale = " << m_spring.GetDescription()
+            << ", damping scale = " << m_damping.GetDescription() << std::endl;
+  std::cout << "Running " << ensembles.size() << " cases x " << m_numSamples << " samples" << std::endl;
+
+  // Create output directories (if they do not already exist)
+  for (size_t i = 0; i < ensembles.size(); i++) {
+    if (!MakeOutputDirectory(out_dir + ensembles[i].c.name))
+      return false;
+  }
+
+  // Run all samples of all cases on the thread pool. Each sample is recorded
+  // by the thread running it and merged into the statistics of its case.
+#ifdef _OPENMP
+  if (m_numThreads > 0)
+    omp_set_num_threads(m_numThreads);
+#endif
+
+  int num_runs = (int)ensembles.size() * m_numSamples;
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int i = 0; i < num_runs; i++) {
+    utils::ChTrace::SetWorkerThreadName();
+
+    int ci = i / m_numSamples;
+    int sample = i % m_numSamples;
+    CaseEnsemble& e = ensembles[ci];
+
+    // Sample the pendulum parameters. The spring and damping factors are drawn
+    // last (and for all cases), so that the other samples do not depend on
+    // them.
+    SampleRandom rng(m_seed, ci, sample);
+    JointCase c = e.c;
+    c.pendulum.mass = m_mass.SamplePositive(rng);
+    c.pendulum.inertia_scale = m_inertia.SamplePositive(rng);
+    double angle = m_angle.Sample(rng);
+    if (e.rotate)
+      c.pendulum.angle = angle * CH_C_PI / 180;
+    double spring_scale = m_spring.SamplePositive(rng);
+    double damping_scale = m_damping.SamplePositive(rng);
+    if (e.spring) {
+      c.spring.k *= spring_scale;
+      c.spring.k_nonlin *= spring_scale;
+      c.spring.c *= damping_scale;
+    }
+
+    SampleRecorder rec(c);
+    JointSimulationStats stats;
+    bool ok = c.pendulum.mass > 0 && c.pendulum.inertia_scale > 0 &&
+              spring_scale > 0 && damping_scale > 0 &&
+              SimulateJointCase(c, rec, stats);
+
+#pragma omp critical(ensemble_runner_stats)
+    {
+      if (ok)
+        e.Add(rec);
+      else
+        e.num_failed++;
+      e.sample_time += stats.exec_time;
+    }
+  }
+
+  // Write the statistics and collect the results
+  bool test_passed = true;
+
+  std::cout << std::endl;
+  std::cout << "Case                     Samples  Failed   Time/sample [s]" << std::endl;
+
+  for (size_t i = 0; i < ensembles.size(); i++) {
+    const CaseEnsemble& e = ensembles[i];
+    const std::string& name = e.c.name;
+    std::string dir = out_dir + name + "/";
+
+    if (e.num_samples > 0) {
+      WriteEnsembleStat(e, dir, "Mean", 0);
+      WriteEnsembleStat(e, dir, "StdDev", 0);
+      for (int q = 0; q < num_quantiles; q++)
+        WriteEnsembleStat(e, dir, quantile_names[q], q);
+    }
+
+    double sample_time = e.sample_time / std::max(e.num_samples + e.num_failed, 1);
+
+    addMetric(name + "_NumSamples", e.num_samples);
+    addMetric(name + "_FailedSamples", e.num_failed);
+    addMetric(name + "_SampleTime", sample_time);
+
+    // Spread of every channel: final standard deviation and quantile range,
+    // and the largest standard deviation over time.
+    if (e.num_samples > 0 && !e.times.empty()) {
+      size_t last = e.times.size() - 1;
+      for (size_t k = 0; k < e.channels.size(); k++) {
+        double max_std = 0;
+        for (size_t f = 0; f < e.times.size(); f++)
+          max_std = std::max(max_std, e.Get(f, k).GetStdDev());
+        const ChannelStats& s = e.Get(last, k);
+        std::string prefix = name + "_" + e.channels[k];
+        addMetric(prefix + "_FinalMean", s.mean);
+        addMetric(prefix + "_FinalStdDev", s.GetStdDev());
+        addMetric(prefix + "_FinalRange", s.quantile[num_quantiles - 1].Get() - s.quantile[0].Get());
+        addMetric(prefix + "_MaxStdDev", max_std);
+      }
+    }
+
+    char line[128];
+    sprintf(line, "%-24s %7d %7d %17.4f", name.c_str(), e.num_samples, e.num_failed, sample_time);
+    std::cout << line << std::endl;
+
+    test_passed &= (e.num_samples > 0 && e.num_failed == 0);
+  }
+
+  addMetric("num_cases", (int)ensembles.size());
+  addMetric("samples_per_case", m_numSamples);
+  addMetric("seed", (int)m_seed);
+
+  full.stop();
+  m_execTime = full();
+  addMetric("samples_per_second", m_execTime > 0 ? num_runs / m_execTime : 0.0);
+  std::cout << "Full Execution Time = " << m_execTime << std::endl;
+
+  return test_passed;
+}
+
+int main(int argc, char* argv[])
+{
+  std::string suite_file;
+  std::vector<std::string> selection;
+  int num_threads = 0;
+  int num_samples = 1000;
+  unsigned int seed = 1;
+  ParamDistribution mass(ParamDistribution::NORMAL, 1, 0.05);
+  ParamDistribution inertia(ParamDistribution::NORMAL, 1, 0.05);
+  ParamDistribution angle(ParamDistribution::NORMAL, 0, 2);
+  ParamDistribution spring(ParamDistribution::NORMAL, 1, 0.05);
+  ParamDistribution damping(ParamDistribution::NORMAL, 1, 0.05);
+  bool args_ok = true;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc)
+      num_threads = atoi(argv[++i]);
+    else if (arg == "-n" && i + 1 < argc)
+      num_samples = atoi(argv[++i]);
+    else if (arg == "-seed" && i + 1 < argc)
+      seed = (unsigned int)atoi(argv[++i]);
+    else if (arg == "-p" && i + 1 < argc) {
+      std::string spec = argv[++i];
+      size_t eq = spec.find('=');
+      std::string name = spec.substr(0, eq);
+      ParamDistribution* dist = NULL;
+      if (name == "mass")
+        dist = &mass;
+      else if (name == "inertia")
+        dist = &inertia;
+      else if (name == "angle")
+        dist = &angle;
+      else if (name == "spring")
+        dist = &spring;
+      else if (name == "damping")
+        dist = &damping;
+      args_ok &= (eq != std::string::npos && dist && dist->Parse(spec.substr(eq + 1)));
+    } else if (suite_file.empty())
+      suite_file = arg;
+    else
+      selection.push_back(arg);
+  }
+
+  if (suite_file.empty() || !args_ok || num_samples < 1) {
+    std::cout << "Usage: " << argv[0] << " [-j <threads>] [-n <samples>] [-seed <seed>]"
+              << " [-p <name>=<distribution> ...] <suite.json> [case ...]" << std::endl;
+    std::cout << "  name: mass, inertia, angle (degrees), spring, damping" << std::endl;
+    std::cout << "  distribution: <value>, normal:<mean>:<std>, uniform:<min>:<max>" << std::endl;
+    return 1;
+  }
+
+  ensemble_runner t(suite_file, selection, num_threads, num_samples, seed, mass, inertia, angle, spring, damping);
+  t.setArguments(argc, argv);
+  t.print();  // optional
+
+  /* Run and time test */
+  t.run();
+
+  // Return 0 if all tests passed and 1 otherwise
+  return !t.m_passed;
+}
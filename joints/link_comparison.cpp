@@ -0,0 +1,313 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Comparison of the lock (ChLinkLock) and frame-based (e.g. ChLinkRevolute)
+// formulations of the joints for which both are available.
+//
+// Every selected case of a suite file is run once with each formulation and
+// validated against the reference data. For each case and formulation, the
+// comparison reports the cost per integration step (total and LCP solver), the
+// RMS norms of all validated quantities (in particular the constraint drift
+// and the reaction force and torque errors with respect to the ADAMS
+// reference), and whether all validations passed. Cases whose joint type is
+// available with only one formulation are skipped.
+//
+// The memory footprint of one link of each formulation is estimated from the
+// growth of the process resident memory when adding a large number of links
+// to a scratch system.
+//
+// Usage:
+//   link_comparison [-j <threads>] [-m <links>] <suite.json> [case ...]
+//
+// Defaults: 1 thread (so that step costs are not affected by concurrent
+// runs), 10000 links for the memory estimate (0 to skip it).
+//
+// =============================================================================
+
+#include <ostream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "core/ChTimer.h"
+
+#include "ChronoValidation_config.h"
+#include "utils/ChUtilsValidation.h"
+#include "utils/ChUtilsMemory.h"
+#include "utils/ChUtilsTrace.h"
+
+#include "BaseTest.h"
+#include "JointSuite.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local variables
+//
+
+static const char* formulations[] = {"lock", "frame"};
+static const int   num_formulations = 2;
+
+// =============================================================================
+// Local functions
+//
+
+// One simulation of the comparison: a case with one link formulation.
+struct ComparisonRun {
+  JointCase            c;
+  JointSimulationStats stats;
+  JointCaseResult      result;
+};
+
+// Estimate the memory footprint (in bytes) of one link of the given joint type
+// and formulation, from the growth of the resident memory when adding the
+// specified number of links to a scratch system. The bodies are created
+// before the first measurement, so that only the links are accounted for.
+static double MeasureLinkMemory(const std::string& joint,
+                                const std::string& formulation,
+                                int                num_links)
+{
+  ChSystem system;
+
+  std::vector<ChSharedBodyPtr> bodies(2 * num_links);
+  for (int i = 0; i < num_links; i++) {
+    bodies[2 * i] = ChSharedBodyPtr(new ChBody);
+    bodies[2 * i]->SetBodyFixed(true);
+    bodies[2 * i + 1] = ChSharedBodyPtr(new ChBody);
+    bodies[2 * i + 1]->SetPos(ChVector<>(1, 0, 0));
+    system.AddBody(bodies[2 * i]);
+    system.AddBody(bodies[2 * i + 1]);
+  }
+
+  size_t before = utils::GetResidentMemory();
+
+  for (int i = 0; i < num_links; i++) {
+    ChSharedPtr<ChLink> link = CreateJointLink(joint, formulation, bodies[2 * i], bodies[2 * i + 1],
+                                               ChFrame<>(ChVector<>(0, 0, 0), QUNIT));
+    system.AddLink(link);
+  }
+
+  size_t after = utils::GetResidentMemory();
+
+  if (before == 0 || after < before)
+    return 0;
+
+  return (double)(after - before) / num_links;
+}
+
+// =============================================================================
+
+class link_comparison : public BaseTest
+{
+public:
+  link_comparison(const std::string&              suiteFile,
+                  const std::vector<std::string>& selection,
+                  int                             numThreads,
+                  int                             numLinks)
+  : BaseTest("link_comparison", "Chrono::Validation"),
+    m_suiteFile(suiteFile),
+    m_selection(selection),
+    m_numThreads(numThreads),
+    m_numLinks(numLinks),
+    m_execTime(-1)
+  {}
+  ~link_comparison() {}
+
+  virtual bool execute();
+  virtual double getExecutionTime() const { return m_execTime; }
+
+private:
+  std::string              m_suiteFile;
+  std::vector<std::string> m_selection;
+  int                      m_numThreads;
+  int                      m_numLinks;
+  double                   m_execTime;
+};
+
+// =============================================================================
+//
+// Run all selected cases with both formulations and report the results.
+//
+bool link_comparison::execute()
+{
+  ChTimer<double> full;
+  full.start();
+
+  // Set the path to the Chrono data folder
+  SetChronoDataPath(CHRONO_DATA_DIR);
+
+  // Read the suite file and select the cases to compare
+  std::vector<JointCase> selected;
+  if (!SelectJointCases(m_suiteFile, m_selection, selected))
+    return false;
+
+  std::vector<JointCase> cases;
+  for (size_t i = 0; i < selected.size(); i++) {
+    if (!HasJointFormulation(selected[i].joint, "lock") || !HasJointFormulation(selected[i].joint, "frame")) {
+      std::cout << "Skipping " << selected[i].name << " (single formulation of joint '"
+                << selected[i].joint << "')" << std::endl;
+      continue;
+    }
+    cases.push_back(selected[i]);
+  }
+
+  if (cases.empty()) {
+    std::cout << "No cases with both link formulations selected from " << m_suiteFile << std::endl;
+    return false;
+  }
+
+  // Create one run per case and formulation
+  std::vector<ComparisonRun> runs;
+  for (size_t i = 0; i < cases.size(); i++) {
+    for (int f = 0; f < num_formulations; f++) {
+      ComparisonRun run;
+      run.c = cases[i];
+      run.c.formulation = formulations[f];
+      runs.push_back(run);
+    }
+  }
+
+  std::cout << "Comparing " << cases.size() << " cases (" << runs.size() << " runs)" << std::endl;
+
+  // Load all reference data once
+  JointReferenceData refs;
+  refs.Load(cases);
+
+  // Run all simulations
+#ifdef _OPENMP
+  omp_set_num_threads(m_numThreads);
+#endif
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int i = 0; i < (int)runs.size(); i++) {
+    utils::ChTrace::SetWorkerThreadName();
+
+    ComparisonRun& run = runs[i];
+    std::ostringstream log;
+
+    utils::ChTraceSpan runSpan(utils::ChTrace::IsEnabled() ? run.c.name + "_" + run.c.formulation : std::string(),
+                               "case");
+
+    log << "TEST: " << run.c.name << " (" << run.c.formulation << ")" << std::endl;
+    JointOutputs outputs;
+    if (SimulateJointCase(run.c, outputs, run.stats)) {
+      ValidateJointCase(run.c, outputs, refs, run.result, log);
+    } else {
+      log << "   simulation failed" << std::endl;
+      run.result.name = run.c.name;
+      run.result.passed = false;
+    }
+    run.result.exec_time = run.stats.exec_time;
+
+    runSpan.End();
+
+#pragma omp critical(link_comparison_log)
+    std::cout << log.str();
+  }
+
+  // Collect the results (in case order, lock before frame)
+  bool test_passed = true;
+
+  std::cout << std::endl;
+  std::cout << "Case                     Link    Step time [us]   LCP time [us]   Passed" << std::endl;
+
+  for (size_t i = 0; i < runs.size(); i++) {
+    const ComparisonRun& run = runs[i];
+    std::string prefix = run.c.name + "_" + run.c.formulation;
+    int num_steps = std::max(run.stats.num_steps, 1);
+    double step_time = run.stats.step_time / num_steps;
+    double lcp_time = run.stats.lcp_time / num_steps;
+
+    addMetric(prefix + "_StepTime", step_time);
+    addMetric(prefix + "_LcpTime", lcp_time);
+    addMetric(prefix + "_Passed", run.result.passed ? 1 : 0);
+    for (size_t j = 0; j < run.result.norms.size(); j++)
+      addMetric(prefix + "_" + run.result.norms[j].first + "_RMSmax", run.result.norms[j].second);
+
+    char line[128];
+    sprintf(line, "%-24s %-7s %14.3f %15.3f   %s", run.c.name.c_str(), run.c.formulation.c_str(),
+            1e6 * step_time, 1e6 * lcp_time, run.result.passed ? "yes" : "no");
+    std::cout << line << std::endl;
+
+    test_passed &= run.result.passed;
+  }
+
+  // Memory footprint of one link, per joint type and formulation
+  if (m_numLinks > 0) {
+    std::vector<std::string> joints;
+    for (size_t i = 0; i < cases.size(); i++) {
+      if (std::find(joints.begin(), joints.end(), cases[i].joint) == joints.end())
+        joints.push_back(cases[i].joint);
+    }
+
+    std::cout << std::endl;
+    for (size_t i = 0; i < joints.size(); i++) {
+      for (int f = 0; f < num_formulations; f++) {
+        double bytes = MeasureLinkMemory(joints[i], formulations[f], m_numLinks);
+        addMetric(joints[i] + "_" + formulations[f] + "_LinkMemory", bytes);
+        std::cout << "Memory per " << joints[i] << " link (" << formulations[f] << "): "
+                  << bytes << " bytes" << std::endl;
+      }
+    }
+  }
+
+  addMetric("num_cases", (int)cases.size());
+
+  full.stop();
+  m_execTime = full();
+  std::cout << "Full Execution Time = " << m_execTime << std::endl;
+
+  return test_passed;
+}
+
+int main(int argc, char* argv[])
+{
+  std::string suite_file;
+  std::vector<std::string> selection;
+  int num_threads = 1;
+  int num_links = 10000;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc)
+      num_threads = atoi(argv[++i]);
+    else if (arg == "-m" && i + 1 < argc)
+      num_links = atoi(argv[++i]);
+    else if (suite_file.empty())
+      suite_file = arg;
+    else
+      selection.push_back(arg);
+  }
+
+  if (suite_file.empty() || num_threads < 1 || num_links < 0) {
+    std::cout << "Usage: " << argv[0] << " [-j <threads>] [-m <links>] <suite.json> [case ...]" << std::endl;
+    return 1;
+  }
+
+  link_comparison t(suite_file, selection, num_threads, num_links);
+  t.setArguments(argc, argv);
+  t.print();  // optional
+
+  /* Run and time test */
+  t.run();
+
+  // Return 0 if all tests passed and 1 otherwise
+  return !t.m_passed;
+}
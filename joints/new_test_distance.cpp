@@ -27,16 +27,24 @@
 #include "physics/ChSystem.h"
 #include "physics/ChBody.h"
 
-#include "unit_IRRLICHT/ChIrrApp.h"
+#include "assets/ChBoxShape.h"
+#include "assets/ChSphereShape.h"
 
 #include "ChronoValidation_config.h"
+
+#if IRRLICHT_ENABLED
+#include "unit_IRRLICHT/ChIrrApp.h"
+#endif
+
 #include "utils/ChUtilsInputOutput.h"
 #include "utils/ChUtilsValidation.h"
 
 #include "BaseTest.h"
 
 using namespace chrono;
+#if IRRLICHT_ENABLED
 using namespace irr;
+#endif
 
 
 // =============================================================================
@@ -117,6 +125,7 @@ bool new_test_distance::execute()
   // Case 1 - Pendulum CG at Y = 2 with a distance contraint between the CG and ground.
 
   test_name = "Distance_Case01";
+  utils::ChTraceSpan caseSpan(test_name, "case");
   timer.start();
   TestDistance(ChVector<>(0, 0, 0),ChVector<>(0, 2, 0), ChCoordsys<>(ChVector<>(0, 2, 0),QUNIT), sim_step, out_step, test_name, animate, save);
   timer.stop();
@@ -137,6 +146,7 @@ bool new_test_distance::execute()
   // Case 2 - Pendulum inital position is perpendicular to the distance constraint between ground
 
   test_name = "Distance_Case02";
+  caseSpan.Restart(test_name);
   timer.start();
   TestDistance(ChVector<>(1, 2, 3),ChVector<>(1, 4, 3), ChCoordsys<>(ChVector<>(-1, 4, 3),QUNIT), sim_step, out_step, test_name, animate, save);
   timer.stop();
@@ -157,6 +167,7 @@ bool new_test_distance::execute()
   // Case 3 - Pendulum inital position is streched out along the Y axis with the distance constraint on the end of the pendulum to ground (Double Pendulum).
 
   test_name = "Distance_Case03";
+  caseSpan.Restart(test_name);
   timer.start();
   TestDistance(ChVector<>(0, 0, 0),ChVector<>(0, 2, 0), ChCoordsys<>(ChVector<>(0, 4, 0),Q_from_AngZ(-CH_C_PI_2)), sim_step, out_step, test_name, animate, save);
   timer.stop();
@@ -176,6 +187,8 @@ bool new_test_distance::execute()
 
 
 
+  caseSpan.End();
+
   full.stop();
   m_execTime = full();
   std::cout << "Full Execution Time = " << m_execTime << std::endl;
@@ -191,7 +204,11 @@ bool new_test_distance::execute()
 
 int main(int argc, char* argv[])
 {
+#if IRRLICHT_ENABLED
   bool animate = (argc > 1);
+#else
+  bool animate = false;
+#endif
   bool save = (argc > 2);
   new_test_distance t("new_test_distance", "Chrono::Validation", animate, save);
   t.print();  // optional
@@ -291,6 +308,7 @@ bool new_test_distance::TestDistance(const ChVector<>&     jointLocGnd,      //
   // Perform the simulation (animation with Irrlicht option)
   // -------------------------------------------------------
 
+#if IRRLICHT_ENABLED
   if (animate)
   {
     // Create the Irrlicht application for visualization
@@ -350,6 +368,7 @@ bool new_test_distance::TestDistance(const ChVector<>&     jointLocGnd,      //
 
     return true;
   }
+#endif
 
   // Perform the simulation (record results option)
   // ------------------------------------------------
@@ -402,11 +421,15 @@ bool new_test_distance::TestDistance(const ChVector<>&     jointLocGnd,      //
   double simTime = 0;
   double outTime = 0;
 
+  // Trace the batches of steps between output frames
+  utils::ChTraceSpan batchSpan(utils::ChTrace::IsEnabled() ? testName + " DoStepDynamics" : std::string(), "step");
+
   while (simTime <= timeRecord + simTimeStep / 2)
   {
     // Ensure that the final data point is recorded.
     if (simTime >= outTime - simTimeStep / 2)
     {
+      batchSpan.End();
 
       // CM position, velocity, and acceleration (expressed in global frame).
       const ChVector<>& position = pendulum->GetPos();
@@ -450,6 +473,8 @@ bool new_test_distance::TestDistance(const ChVector<>&     jointLocGnd,      //
 
       // Increment output time
       outTime += outTimeStep;
+
+      batchSpan.Restart();
     }
 
     // Advance simulation by one step
@@ -459,6 +484,8 @@ bool new_test_distance::TestDistance(const ChVector<>&     jointLocGnd,      //
     simTime += simTimeStep;
   }
 
+  batchSpan.End();
+
   // Write output files
   out_pos.write_to_file(out_dir + testName + "_CHRONO_Pos.txt", testName + "\n\n");
   out_vel.write_to_file(out_dir + testName + "_CHRONO_Vel.txt", testName + "\n\n");
@@ -27,16 +27,23 @@
 #include "physics/ChSystem.h"
 #include "physics/ChBody.h"
 
-#include "unit_IRRLICHT/ChIrrApp.h"
+#include "assets/ChCylinderShape.h"
 
 #include "ChronoValidation_config.h"
+
+#if IRRLICHT_ENABLED
+#include "unit_IRRLICHT/ChIrrApp.h"
+#endif
+
 #include "utils/ChUtilsInputOutput.h"
 #include "utils/ChUtilsValidation.h"
 
 #include "BaseTest.h"
 
 using namespace chrono;
+#if IRRLICHT_ENABLED
 using namespace irr;
+#endif
 
 
 // =============================================================================
@@ -117,6 +124,7 @@ bool new_test_revolute::execute()
   // must be rotated -pi/2 about the global X-axis.
 
   test_name = "Revolute_Case01";
+  utils::ChTraceSpan caseSpan(test_name, "case");
   /* Run and Time Revolute_Case01 */
   timer.start();
   TestRevolute(ChVector<>(0, 0, 0), Q_from_AngX(-CH_C_PI_2), sim_step, out_step, test_name, animate, save);
@@ -140,6 +148,7 @@ bool new_test_revolute::execute()
   // In this case, the joint must be rotated -pi/4 about the global X-axis.
 
   test_name = "Revolute_Case02";
+  caseSpan.Restart(test_name);
   timer.start();
   TestRevolute(ChVector<>(1, 2, 3), Q_from_AngX(-CH_C_PI_4), sim_step, out_step, test_name, animate, save);
   timer.stop(); 
@@ -157,6 +166,8 @@ bool new_test_revolute::execute()
     test_passed &= ValidateConstraints(test_name, 1e-5);
   }
 
+  caseSpan.End();
+
   full.stop();
   m_execTime = full();
   std::cout << "Full Execution Time = " << m_execTime << std::endl;
@@ -167,7 +178,11 @@ bool new_test_revolute::execute()
 
 int main(int argc, char* argv[])
 {
+#if IRRLICHT_ENABLED
   bool animate = (argc > 1);
+#else
+  bool animate = false;
+#endif
   bool save = (argc > 2);
   new_test_revolute t("new_test_revolute", "Chrono::Validation", animate, save);
   t.print();  // optional
@@ -271,6 +286,7 @@ bool new_test_revolute::TestRevolute(const ChVector<>&     jointLoc,         //
   // Perform the simulation (animation with Irrlicht option)
   // -------------------------------------------------------
 
+#if IRRLICHT_ENABLED
   if (animate)
   {
     // Create the Irrlicht application for visualization
@@ -323,6 +339,7 @@ bool new_test_revolute::TestRevolute(const ChVector<>&     jointLoc,         //
 
     return true;
   }
+#endif
 
   // Perform the simulation (record results option)
   // ------------------------------------------------
@@ -375,11 +392,15 @@ bool new_test_revolute::TestRevolute(const ChVector<>&     jointLoc,         //
   double simTime = 0;
   double outTime = 0;
 
+  // Trace the batches of steps between output frames
+  utils::ChTraceSpan batchSpan(utils::ChTrace::IsEnabled() ? testName + " DoStepDynamics" : std::string(), "step");
+
   while (simTime <= timeRecord + simTimeStep / 2)
   {
     // Ensure that the final data point is recorded.
     if (simTime >= outTime - simTimeStep / 2)
     {
+      batchSpan.End();
 
       // CM position, velocity, and acceleration (expressed in global frame).
       const ChVector<>& position = pendulum->GetPos();
@@ -441,6 +462,8 @@ bool new_test_revolute::TestRevolute(const ChVector<>&     jointLoc,         //
 
       // Increment output time
       outTime += outTimeStep;
+
+      batchSpan.Restart();
     }
 
     // Advance simulation by one step
@@ -450,6 +473,8 @@ bool new_test_revolute::TestRevolute(const ChVector<>&     jointLoc,         //
     simTime += simTimeStep;
   }
 
+  batchSpan.End();
+
   // Write output files
   out_pos.write_to_file(out_dir + testName + "_CHRONO_Pos.txt", testName + "\n\n");
   out_vel.write_to_file(out_dir + testName + "_CHRONO_Vel.txt", testName + "\n\n");
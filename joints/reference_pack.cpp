@@ -0,0 +1,337 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Tool for packed reference data stores (see utils/ChUtilsReferenceStore.h).
+//
+//  - pack:   write the given data files into a store file,
+//  - bundle: write the given data files into one bundle file per case, next
+//            to the data files or in the given output directory
+//            (<case>_ADAMS.refpack for <case>_ADAMS_<channel>.txt), and
+//            optionally list the bundle files written in a list file,
+//  - unpack: regenerate the text files of a store in a directory,
+//  - verify: check that every entry of the given stores (and of the stores
+//            named in the given list file) decodes to the same values as the
+//            data file of the same name in the directory of the store, or in
+//            the given data directory (and regenerates the same text), and
+//            report the size reduction and the decoding throughput.
+//
+// Usage:
+//   reference_pack pack <store file> <data file> [<data file> ...]
+//   reference_pack bundle [-o <output directory>] [-l <list file>]
+//                         <data file> [<data file> ...]
+//   reference_pack unpack <store file> <output directory>
+//   reference_pack verify [<store file> ...] [-l <list file>]
+//                         [-d <data directory>] [-r <repeats>]
+//
+// Defaults: data files next to the store, 10 decoding repetitions.
+// The store of the files in data/<joint>/ is data/<joint>/<joint>.refpack, e.g.
+//   reference_pack pack data/revolute_joint/revolute_joint.refpack
+//                       data/revolute_joint/*.txt
+// and the bundle of Revolute_Case01_ADAMS_*.txt is
+//   Revolute_Case01_ADAMS.refpack.
+//
+// =============================================================================
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <map>
+
+#include "core/ChTimer.h"
+
+#include "utils/ChUtilsReferenceStore.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local functions
+//
+
+static bool ReadFile(const std::string& filename, std::string& contents)
+{
+  std::ifstream ifile(filename.c_str(), std::ios::binary);
+  if (!ifile.is_open())
+    return false;
+
+  std::stringstream buf;
+  buf << ifile.rdbuf();
+  contents = buf.str();
+  return true;
+}
+
+static long long FileSize(const std::string& filename)
+{
+  std::ifstream ifile(filename.c_str(), std::ios::binary | std::ios::ate);
+  return ifile.is_open() ? (long long)ifile.tellg() : 0;
+}
+
+static std::string GetDirectory(const std::string& filename)
+{
+  size_t pos = filename.find_last_of("/\\");
+  return (pos == std::string::npos) ? "." : filename.substr(0, pos);
+}
+
+static bool SameData(const utils::Data& a, const utils::Data& b)
+{
+  if (a.size() != b.size())
+    return false;
+  for (size_t col = 0; col < a.size(); col++) {
+    if (a[col].size() != b[col].size())
+      return false;
+    if (a[col].size() > 0 && memcmp(&a[col][0], &b[col][0], a[col].size() * sizeof(double)) != 0)
+      return false;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+
+static int Pack(const std::string& store_file, const std::vector<std::string>& files)
+{
+  if (!utils::WriteReferenceStore(files, store_file)) {
+    std::cout << "Error writing store " << store_file << std::endl;
+    return 1;
+  }
+
+  long long text_bytes = 0;
+  for (size_t i = 0; i < files.size(); i++)
+    text_bytes += FileSize(files[i]);
+  long long store_bytes = FileSize(store_file);
+
+  std::cout << "Files:       " << files.size() << std::endl;
+  std::cout << "Text size:   " << text_bytes << " bytes" << std::endl;
+  std::cout << "Store size:  " << store_bytes << " bytes" << std::endl;
+  std::cout << "Ratio:       " << (double)text_bytes / store_bytes << std::endl;
+
+  return 0;
+}
+
+static int Bundle(const std::string& out_dir, const std::string& list_file, const std::vector<std::string>& files)
+{
+  // Group the data files by bundle file.
+  std::map<std::string, std::vector<std::string> > bundles;
+  for (size_t i = 0; i < files.size(); i++) {
+    std::string bundle = utils::GetReferenceBundleFile(files[i]);
+    if (!out_dir.empty())
+      bundle = out_dir + "/" + bundle.substr(bundle.find_last_of("/\\") + 1);
+    bundles[bundle].push_back(files[i]);
+  }
+
+  std::ostringstream list;
+  std::map<std::string, std::vector<std::string> >::const_iterator itr;
+  for (itr = bundles.begin(); itr != bundles.end(); ++itr) {
+    std::cout << itr->first << " (" << itr->second.size() << " files)" << std::endl;
+    if (!utils::WriteReferenceStore(itr->second, itr->first)) {
+      std::cout << "Error writing bundle " << itr->first << std::endl;
+      return 1;
+    }
+    list << itr->first << std::endl;
+  }
+
+  // The list is written last, so that it exists only if all bundles do.
+  if (!list_file.empty()) {
+    std::ofstream ofile(list_file.c_str());
+    if (!ofile.is_open()) {
+      std::cout << "Error writing bundle list " << list_file << std::endl;
+      return 1;
+    }
+    ofile << list.str();
+  }
+
+  return 0;
+}
+
+// Append the (non-empty) lines of a list file to the given names.
+static bool ReadList(const std::string& list_file, std::vector<std::string>& names)
+{
+  std::ifstream ifile(list_file.c_str());
+  if (!ifile.is_open()) {
+    std::cout << "Error reading list " << list_file << std::endl;
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(ifile, line)) {
+    if (!line.empty())
+      names.push_back(line);
+  }
+  return true;
+}
+
+static int Unpack(const std::string& store_file, const std::string& out_dir)
+{
+  utils::ChReferenceStore store;
+  if (!store.Open(store_file)) {
+    std::cout << "Error reading store " << store_file << std::endl;
+    return 1;
+  }
+
+  for (size_t i = 0; i < store.GetNumEntries(); i++) {
+    std::string text;
+    std::string filename = out_dir + "/" + store.GetName(i);
+    std::ofstream ofile(filename.c_str(), std::ios::binary);
+    if (!store.ReadText(store.GetName(i), text) || !ofile.is_open()) {
+      std::cout << "Error unpacking " << store.GetName(i) << std::endl;
+      return 1;
+    }
+    ofile << text;
+  }
+
+  std::cout << "Unpacked " << store.GetNumEntries() << " files to " << out_dir << std::endl;
+
+  return 0;
+}
+
+static int Verify(const std::string& store_file, const std::string& data_dir, int repeats)
+{
+  utils::ChReferenceStore store;
+  if (!store.Open(store_file)) {
+    std::cout << "Error reading store " << store_file << std::endl;
+    return 1;
+  }
+
+  std::cout << "Store:       " << store_file << std::endl;
+
+  std::string dir = data_dir.empty() ? GetDirectory(store_file) : data_dir;
+  bool        passed = true;
+  long long   text_bytes = 0;
+  size_t      num_values = 0;
+
+  for (size_t i = 0; i < store.GetNumEntries(); i++) {
+    const std::string& name = store.GetName(i);
+    std::string        filename = dir + "/" + name;
+
+    utils::Headers headers, store_headers;
+    utils::Data    data, store_data;
+    utils::ChValidation::ReadDataFile(filename, '\t', headers, data);
+    bool values_ok = store.Read(name, store_headers, store_data) &&
+                     headers == store_headers && SameData(data, store_data);
+
+    std::string text, store_text;
+    bool text_ok = ReadFile(filename, text) && store.ReadText(name, store_text) && text == store_text;
+
+    if (!values_ok || !text_ok) {
+      std::cout << "   " << name << ": " << (values_ok ? "" : "values differ ") << (text_ok ? "" : "text differs")
+                << std::endl;
+      passed = false;
+    }
+
+    text_bytes += text.size();
+    for (size_t col = 0; col < store_data.size(); col++)
+      num_values += store_data[col].size();
+  }
+
+  // Decoding throughput (doubles produced per second).
+  ChTimer<double> timer;
+  timer.start();
+  for (int r = 0; r < repeats; r++) {
+    for (size_t i = 0; i < store.GetNumEntries(); i++) {
+      utils::Headers headers;
+      utils::Data    data;
+      store.Read(store.GetName(i), headers, data);
+    }
+  }
+  timer.stop();
+
+  long long store_bytes = FileSize(store_file);
+  double    rate = timer() > 0 ? repeats * num_values * sizeof(double) / timer() : 0;
+
+  std::cout << "Bundles:     " << store.GetNumBundles() << std::endl;
+  std::cout << "Entries:     " << store.GetNumEntries() << std::endl;
+  std::cout << "Values:      " << num_values << std::endl;
+  std::cout << "Text size:   " << text_bytes << " bytes" << std::endl;
+  std::cout << "Store size:  " << store_bytes << " bytes" << std::endl;
+  std::cout << "Ratio:       " << (double)text_bytes / store_bytes << std::endl;
+  std::cout << "Decoding:    " << rate / 1e9 << " GB/s" << std::endl;
+  std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+
+  return passed ? 0 : 1;
+}
+
+
+// =============================================================================
+//
+int main(int argc, char* argv[])
+{
+  std::string cmd = argc >= 3 ? argv[1] : "";
+
+  if (cmd == "pack" && argc >= 4) {
+    std::vector<std::string> files(argv + 3, argv + argc);
+    return Pack(argv[2], files);
+  }
+
+  if (cmd == "bundle") {
+    std::vector<std::string> files;
+    std::string out_dir;
+    std::string list_file;
+    bool        ok = true;
+    for (int i = 2; i < argc && ok; i++) {
+      std::string arg = argv[i];
+      if (arg != "-o" && arg != "-l")
+        files.push_back(arg);
+      else if (i + 1 >= argc)
+        ok = false;
+      else if (arg == "-o")
+        out_dir = argv[++i];
+      else
+        list_file = argv[++i];
+    }
+    if (ok && !files.empty())
+      return Bundle(out_dir, list_file, files);
+  }
+
+  if (cmd == "unpack" && argc == 4)
+    return Unpack(argv[2], argv[3]);
+
+  if (cmd == "verify") {
+    std::vector<std::string> stores;
+    std::string data_dir;
+    int         repeats = 10;
+    bool        ok = true;
+    for (int i = 2; i < argc && ok; i++) {
+      std::string arg = argv[i];
+      if (arg != "-d" && arg != "-r" && arg != "-l")
+        stores.push_back(arg);
+      else if (i + 1 >= argc)
+        ok = false;
+      else if (arg == "-d")
+        data_dir = argv[++i];
+      else if (arg == "-l")
+        ok = ReadList(argv[++i], stores);
+      else
+        repeats = std::max(1, atoi(argv[++i]));
+    }
+    if (ok && !stores.empty()) {
+      int failed = 0;
+      for (size_t i = 0; i < stores.size(); i++)
+        failed += Verify(stores[i], data_dir, repeats);
+      if (stores.size() > 1)
+        std::cout << stores.size() - failed << " of " << stores.size() << " stores verified" << std::endl;
+      return failed ? 1 : 0;
+    }
+  }
+
+  std::cout << "Usage: " << argv[0] << " pack <store file> <data file> [<data file> ...]" << std::endl;
+  std::cout << "       " << argv[0] << " bundle [-o <output directory>] [-l <list file>] <data file> [<data file> ...]" << std::endl;
+  std::cout << "       " << argv[0] << " unpack <store file> <output directory>" << std::endl;
+  std::cout << "       " << argv[0] << " verify [<store file> ...] [-l <list file>] [-d <data directory>] [-r <repeats>]" << std::endl;
+
+  return 1;
+}
@@ -0,0 +1,374 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Integrator and LCP solver benchmark matrix for the joint validation cases
+// (joints as well as the constraint and force element mechanisms).
+//
+// Every selected case of a suite file is run with every integration type and
+// every iterative LCP solver (all other solver settings as in the suite file).
+// For each combination, the benchmark records the integration steps per second
+// (time spent in DoStepDynamics), the fraction of that time spent in the LCP
+// solver, the max RMS norm of every validated quantity against the reference
+// data, and the worst-case validation margin (1 - norm / tolerance).
+//
+// The full matrix is written as a CSV file (one line per case and combination)
+// and a summary per combination (over all cases) is printed as a table and
+// recorded as metrics of the test JSON output.
+//
+// By default the runs are sequential, so that the timings are not affected by
+// concurrent runs; use '-j' to run several combinations at once.
+//
+// Usage:
+//   solver_matrix [-j <threads>] [-o <matrix.csv>] <suite.json> [case ...]
+//
+// =============================================================================
+
+#include <ostream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cfloat>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "core/ChTimer.h"
+
+#include "ChronoValidation_config.h"
+#include "utils/ChUtilsInputOutput.h"
+#include "utils/ChUtilsValidation.h"
+#include "utils/ChUtilsTrace.h"
+
+#include "BaseTest.h"
+#include "JointSuite.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local variables
+//
+static const std::string val_dir = "../RESULTS/";
+
+// Integration types and iterative LCP solvers of the matrix.
+static const ChSystem::eCh_integrationType matrix_integrators[] = {
+  ChSystem::INT_ANITESCU,
+  ChSystem::INT_TASORA
+};
+
+static const ChSystem::eCh_lcpSolver matrix_solvers[] = {
+  ChSystem::LCP_ITERATIVE_SOR,
+  ChSystem::LCP_ITERATIVE_SYMMSOR,
+  ChSystem::LCP_ITERATIVE_JACOBI,
+  ChSystem::LCP_ITERATIVE_SOR_MULTITHREAD,
+  ChSystem::LCP_ITERATIVE_PMINRES,
+  ChSystem::LCP_ITERATIVE_BARZILAIBORWEIN,
+  ChSystem::LCP_ITERATIVE_PCG,
+  ChSystem::LCP_ITERATIVE_APGD
+};
+
+static const size_t num_matrix_integrators = sizeof(matrix_integrators) / sizeof(matrix_integrators[0]);
+static const size_t num_matrix_solvers = sizeof(matrix_solvers) / sizeof(matrix_solvers[0]);
+
+// =============================================================================
+// Local functions
+//
+
+// One cell of the matrix: a case run with one combination.
+struct MatrixEntry {
+  size_t               case_index;
+  size_t               combination;
+  JointCase            c;
+  JointSimulationStats stats;
+  JointCaseResult      result;
+  double               margin;
+};
+
+static double StepsPerSecond(const JointSimulationStats& stats)
+{
+  return stats.step_time > 0 ? stats.num_steps / stats.step_time : 0;
+}
+
+static double LcpFraction(const JointSimulationStats& stats)
+{
+  return stats.step_time > 0 ? stats.lcp_time / stats.step_time : 0;
+}
+
+static std::string GetCombinationName(const JointSolverSettings& solver)
+{
+  return GetIntegratorName(solver.integrator) + "_" + GetLcpSolverName(solver.lcp_solver);
+}
+
+// =============================================================================
+
+class solver_matrix : public BaseTest
+{
+public:
+  solver_matrix(const std::string&              suiteFile,
+                const std::vector<std::string>& selection,
+                const std::string&              outFile,
+                int                             numThreads)
+  : BaseTest("solver_matrix", "Chrono::Validation"),
+    m_suiteFile(suiteFile),
+    m_selection(selection),
+    m_outFile(outFile),
+    m_numThreads(numThreads),
+    m_execTime(-1)
+  {}
+  ~solver_matrix() {}
+
+  virtual bool execute();
+  virtual double getExecutionTime() const { return m_execTime; }
+
+private:
+  void WriteMatrix(const std::vector<MatrixEntry>& entries) const;
+
+  std::string              m_suiteFile;
+  std::vector<std::string> m_selection;
+  std::string              m_outFile;
+  int                      m_numThreads;
+  double                   m_execTime;
+};
+
+// =============================================================================
+//
+// Write the full matrix as a CSV file. The RMS norms of all quantities
+// validated by any of the cases are written in separate columns (empty if a
+// case does not validate that quantity).
+//
+void solver_matrix::WriteMatrix(const std::vector<MatrixEntry>& entries) const
+{
+  std::vector<std::string> quantities;
+  for (size_t i = 0; i < entries.size(); i++) {
+    const std::vector<JointTolerance>& tols = entries[i].c.tolerances;
+    for (size_t j = 0; j < tols.size(); j++) {
+      if (std::find(quantities.begin(), quantities.end(), tols[j].what) == quantities.end())
+        quantities.push_back(tols[j].what);
+    }
+  }
+
+  utils::CSV_writer csv(",");
+
+  csv << "Case" << "Joint" << "Integrator" << "LcpSolver" << "Passed" << "Margin"
+      << "NumSteps" << "StepsPerSecond" << "LcpFraction" << "ExecTime";
+  for (size_t q = 0; q < quantities.size(); q++)
+    csv << quantities[q] + "_RMS";
+  csv << std::endl;
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    const MatrixEntry& e = entries[i];
+
+    csv << e.c.name << e.c.joint
+        << GetIntegratorName(e.c.solver.integrator) << GetLcpSolverName(e.c.solver.lcp_solver)
+        << (e.result.passed ? 1 : 0) << e.margin
+        << e.stats.num_steps << StepsPerSecond(e.stats) << LcpFraction(e.stats) << e.stats.exec_time;
+
+    for (size_t q = 0; q < quantities.size(); q++) {
+      std::string value;
+      for (size_t j = 0; j < e.result.norms.size(); j++) {
+        if (e.result.norms[j].first == quantities[q]) {
+          std::ostringstream str;
+          str << e.result.norms[j].second;
+          value = str.str();
+        }
+      }
+      csv << value;
+    }
+    csv << std::endl;
+  }
+
+  csv.write_to_file(m_outFile);
+}
+
+// =============================================================================
+//
+// Run all cases with all combinations of integrator and LCP solver.
+//
+bool solver_matrix::execute()
+{
+  ChTimer<double> full;
+  full.start();
+
+  // Set the path to the Chrono data folder
+  SetChronoDataPath(CHRONO_DATA_DIR);
+
+  // Read the suite file and select the cases to run
+  std::vector<JointCase> cases;
+  if (!SelectJointCases(m_suiteFile, m_selection, cases))
+    return false;
+
+  // Create the matrix entries
+  size_t num_combinations = num_matrix_integrators * num_matrix_solvers;
+  std::vector<MatrixEntry> entries;
+
+  for (size_t i = 0; i < cases.size(); i++) {
+    for (size_t k = 0; k < num_combinations; k++) {
+      MatrixEntry e;
+      e.case_index = i;
+      e.combination = k;
+      e.c = cases[i];
+      e.c.solver.integrator = matrix_integrators[k / num_matrix_solvers];
+      e.c.solver.lcp_solver = matrix_solvers[k % num_matrix_solvers];
+      e.margin = -DBL_MAX;
+      entries.push_back(e);
+    }
+  }
+
+  std::cout << "Running " << cases.size() << " cases with " << num_combinations
+            << " solver combinations (" << entries.size() << " runs)" << std::endl;
+
+  // Create output directory (if it does not already exist)
+  if (!MakeOutputDirectory(val_dir))
+    return false;
+
+  // Load all reference data once
+  JointReferenceData refs;
+  refs.Load(cases);
+
+  // Run the matrix
+#ifdef _OPENMP
+  omp_set_num_threads(m_numThreads);
+#endif
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int i = 0; i < (int)entries.size(); i++) {
+    utils::ChTrace::SetWorkerThreadName();
+
+    MatrixEntry& e = entries[i];
+    std::ostringstream log;
+
+    utils::ChTraceSpan runSpan(utils::ChTrace::IsEnabled() ? e.c.name + "_" + GetCombinationName(e.c.solver)
+                                                           : std::string(),
+                               "case");
+
+    JointOutputs outputs;
+    if (SimulateJointCase(e.c, outputs, e.stats)) {
+      ValidateJointCase(e.c, outputs, refs, e.result, log);
+      e.margin = GetJointCaseMargin(e.c, e.result);
+    } else {
+      e.result.name = e.c.name;
+      e.result.passed = false;
+    }
+    e.result.exec_time = e.stats.exec_time;
+
+    runSpan.End();
+
+#pragma omp critical(solver_matrix_log)
+    std::cout << "   " << e.c.name << "  " << GetCombinationName(e.c.solver)
+              << (e.result.passed ? "  Passed" : "  Failed") << std::endl;
+  }
+
+  // Write the full matrix
+  WriteMatrix(entries);
+  std::cout << "Matrix written to " << m_outFile << std::endl;
+
+  // Summary per combination: number of passing cases, mean steps per second,
+  // mean LCP time fraction, and worst margin over all cases.
+  std::cout << std::endl;
+  std::cout << std::left << std::setw(40) << "Integrator / LCP solver"
+            << std::right << std::setw(8) << "Passed"
+            << std::setw(14) << "Steps/s"
+            << std::setw(10) << "LCP %"
+            << std::setw(14) << "Worst margin" << std::endl;
+
+  for (size_t k = 0; k < num_combinations; k++) {
+    int    num_passed = 0;
+    double steps_per_sec = 0;
+    double lcp_fraction = 0;
+    double worst_margin = DBL_MAX;
+    std::string name;
+
+    for (size_t i = 0; i < entries.size(); i++) {
+      const MatrixEntry& e = entries[i];
+      if (e.combination != k)
+        continue;
+      name = GetCombinationName(e.c.solver);
+      num_passed += e.result.passed ? 1 : 0;
+      steps_per_sec += StepsPerSecond(e.stats) / cases.size();
+      lcp_fraction += LcpFraction(e.stats) / cases.size();
+      worst_margin = std::min(worst_margin, e.margin);
+    }
+
+    addMetric(name + "_NumPassed", num_passed);
+    addMetric(name + "_StepsPerSecond", steps_per_sec);
+    addMetric(name + "_LcpFraction", lcp_fraction);
+    addMetric(name + "_WorstMargin", worst_margin);
+
+    std::ostringstream passed;
+    passed << num_passed << "/" << cases.size();
+
+    std::cout << std::left << std::setw(40) << name
+              << std::right << std::setw(8) << passed.str()
+              << std::setw(14) << std::fixed << std::setprecision(1) << steps_per_sec
+              << std::setw(10) << std::setprecision(1) << 100 * lcp_fraction
+              << std::setw(14) << std::scientific << std::setprecision(3) << worst_margin
+              << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+  }
+
+  addMetric("num_cases", (int)cases.size());
+  addMetric("num_combinations", (int)num_combinations);
+
+  full.stop();
+  m_execTime = full();
+  std::cout << std::endl << "Full Execution Time = " << m_execTime << std::endl;
+
+  // The benchmark passes if the suite settings pass for all cases.
+  bool test_passed = true;
+  for (size_t i = 0; i < entries.size(); i++) {
+    const MatrixEntry& e = entries[i];
+    const JointSolverSettings& s = cases[e.case_index].solver;
+    if (e.c.solver.integrator == s.integrator && e.c.solver.lcp_solver == s.lcp_solver)
+      test_passed &= e.result.passed;
+  }
+
+  return test_passed;
+}
+
+int main(int argc, char* argv[])
+{
+  std::string suite_file;
+  std::string out_file = val_dir + "solver_matrix.csv";
+  std::vector<std::string> selection;
+  int num_threads = 1;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc)
+      num_threads = atoi(argv[++i]);
+    else if (arg == "-o" && i + 1 < argc)
+      out_file = argv[++i];
+    else if (suite_file.empty())
+      suite_file = arg;
+    else
+      selection.push_back(arg);
+  }
+
+  if (suite_file.empty() || num_threads < 1) {
+    std::cout << "Usage: " << argv[0] << " [-j <threads>] [-o <matrix.csv>] <suite.json> [case ...]" << std::endl;
+    return 1;
+  }
+
+  solver_matrix t(suite_file, selection, out_file, num_threads);
+  t.setArguments(argc, argv);
+  t.print();  // optional
+
+  /* Run and time test */
+  t.run();
+
+  // Return 0 if all tests passed and 1 otherwise
+  return !t.m_passed;
+}
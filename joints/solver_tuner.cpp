@@ -0,0 +1,501 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Solver settings auto-tuner for the joint validation cases.
+//
+// For every selected case of a suite file, a random sample of solver settings
+// (integrator, LCP solver, iteration caps, tolerances) is searched with
+// successive halving: all candidates are run over a short simulation length,
+// the best 1/eta of them (passing candidates ranked by wall time, failing ones
+// by validation margin) are run again over an eta times longer length, and so
+// on until the survivors are run over the full length of the case. The current
+// settings of the case are always run over the full length, for comparison.
+//
+// For every case, the tuner reports the Pareto front of wall time vs.
+// worst-case validation margin (1 - norm / tolerance, over all validated
+// quantities) and the fastest settings which pass all validations. A copy of
+// the suite file with these settings is written to the output file.
+//
+// The candidates of the shorter stages are run concurrently (on '-j' threads),
+// since they only need to be ranked roughly. The final, full-length stage runs
+// sequentially, so that the reported wall times, the Pareto front, and the
+// choice of the fastest settings are not affected by concurrent runs.
+//
+// Usage:
+//   solver_tuner [-j <threads>] [-n <candidates>] [-e <eta>] [-seed <seed>]
+//                [-o <tuned_suite.json>] <suite.json> [case ...]
+//
+// Defaults: 27 candidates per case, eta = 3, output ../RESULTS/tuned_suite.json
+//
+// =============================================================================
+
+#include <ostream>
+#include <sstream>
+#include <cstdlib>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "core/ChTimer.h"
+
+#include "ChronoValidation_config.h"
+#include "utils/ChUtilsValidation.h"
+#include "utils/ChUtilsTrace.h"
+
+#include "BaseTest.h"
+#include "JointSuite.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local variables
+//
+static const std::string val_dir = "../RESULTS/";
+
+// Search space. The multithreaded SOR solver is not included, since its
+// threads would compete with the concurrently running candidates.
+static const ChSystem::eCh_integrationType tuner_integrators[] = {
+  ChSystem::INT_ANITESCU,
+  ChSystem::INT_TASORA
+};
+
+static const ChSystem::eCh_lcpSolver tuner_solvers[] = {
+  ChSystem::LCP_ITERATIVE_SOR,
+  ChSystem::LCP_ITERATIVE_SYMMSOR,
+  ChSystem::LCP_ITERATIVE_JACOBI,
+  ChSystem::LCP_ITERATIVE_PMINRES,
+  ChSystem::LCP_ITERATIVE_BARZILAIBORWEIN,
+  ChSystem::LCP_ITERATIVE_PCG,
+  ChSystem::LCP_ITERATIVE_APGD
+};
+
+static const int    tuner_iters[] = {25, 50, 100, 200};
+static const double tuner_tols[] = {1e-4, 1e-6, 1e-8};
+static const double tuner_tol_forces[] = {1e-3, 1e-4, 1e-5};
+
+#define TUNER_COUNT(a) (sizeof(a) / sizeof(a[0]))
+
+// =============================================================================
+// Local functions
+//
+
+// One candidate: solver settings for one case.
+struct TunerCandidate {
+  size_t              case_index;
+  JointSolverSettings solver;
+  bool                baseline;  // current settings of the case?
+  bool                active;    // still in the search?
+  JointCaseResult     result;    // results of the last run
+  double              margin;    // worst-case validation margin of the last run
+};
+
+// Return the settings with the given index in the search space.
+static JointSolverSettings GetSettings(size_t index)
+{
+  JointSolverSettings solver;
+
+  solver.tol_force = tuner_tol_forces[index % TUNER_COUNT(tuner_tol_forces)];
+  index /= TUNER_COUNT(tuner_tol_forces);
+  solver.tol = tuner_tols[index % TUNER_COUNT(tuner_tols)];
+  index /= TUNER_COUNT(tuner_tols);
+  solver.max_iters_speed = tuner_iters[index % TUNER_COUNT(tuner_iters)];
+  solver.max_iters_stab = solver.max_iters_speed;
+  index /= TUNER_COUNT(tuner_iters);
+  solver.lcp_solver = tuner_solvers[index % TUNER_COUNT(tuner_solvers)];
+  index /= TUNER_COUNT(tuner_solvers);
+  solver.integrator = tuner_integrators[index];
+
+  return solver;
+}
+
+static bool SameSettings(const JointSolverSettings& a, const JointSolverSettings& b)
+{
+  return a.integrator == b.integrator && a.lcp_solver == b.lcp_solver &&
+         a.max_iters_speed == b.max_iters_speed && a.max_iters_stab == b.max_iters_stab &&
+         a.tol == b.tol && a.tol_force == b.tol_force;
+}
+
+// Ranking of candidates: passing before failing; passing candidates by wall
+// time, failing candidates by validation margin.
+static bool BetterCandidate(const TunerCandidate* a, const TunerCandidate* b)
+{
+  if (a->result.passed != b->result.passed)
+    return a->result.passed;
+  if (a->result.passed)
+    return a->result.exec_time < b->result.exec_time;
+  return a->margin > b->margin;
+}
+
+static bool FasterCandidate(const TunerCandidate* a, const TunerCandidate* b)
+{
+  return a->result.exec_time < b->result.exec_time;
+}
+
+// Return the candidates (sorted by wall time) not dominated by any other
+// candidate in wall time (smaller is better) and margin (larger is better).
+static std::vector<const TunerCandidate*> ParetoFront(std::vector<const TunerCandidate*> list)
+{
+  std::sort(list.begin(), list.end(), FasterCandidate);
+
+  std::vector<const TunerCandidate*> front;
+  double best_margin = -DBL_MAX;
+  for (size_t i = 0; i < list.size(); i++) {
+    if (front.empty() || list[i]->margin > best_margin) {
+      front.push_back(list[i]);
+      best_margin = list[i]->margin;
+    }
+  }
+
+  return front;
+}
+
+// =============================================================================
+
+class solver_tuner : public BaseTest
+{
+public:
+  solver_tuner(const std::string&              suiteFile,
+               const std::vector<std::string>& selection,
+               const std::string&              outFile,
+               int                             numThreads,
+               int                             numCandidates,
+               int                             eta,
+               unsigned int                    seed)
+  : BaseTest("solver_tuner", "Chrono::Validation"),
+    m_suiteFile(suiteFile),
+    m_selection(selection),
+    m_outFile(outFile),
+    m_numThreads(numThreads),
+    m_numCandidates(numCandidates),
+    m_eta(eta),
+    m_seed(seed),
+    m_execTime(-1)
+  {}
+  ~solver_tuner() {}
+
+  virtual bool execute();
+  virtual double getExecutionTime() const { return m_execTime; }
+
+private:
+  void RunStage(std::vector<TunerCandidate>&   candidates,
+                const std::vector<JointCase>&  cases,
+                const JointReferenceData&      refs,
+                int                            stage,
+                double                         length);
+
+  std::string              m_suiteFile;
+  std::vector<std::string> m_selection;
+  std::string              m_outFile;
+  int                      m_numThreads;
+  int                      m_numCandidates;
+  int                      m_eta;
+  unsigned int             m_seed;
+  double                   m_execTime;
+};
+
+// =============================================================================
+//
+// Run all active candidates over the specified simulation length (in parallel).
+// A length of 0 runs the full length of each case, one candidate at a time.
+//
+void solver_tuner::RunStage(std::vector<TunerCandidate>&   candidates,
+                            const std::vector<JointCase>&  cases,
+                            const JointReferenceData&      refs,
+                            int                            stage,
+                            double                         length)
+{
+  std::vector<int> active;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    if (candidates[i].active)
+      active.push_back((int)i);
+  }
+
+  std::cout << "Stage " << stage << ": " << active.size() << " candidates, length ";
+  if (length > 0)
+    std::cout << length << std::endl;
+  else
+    std::cout << "full" << std::endl;
+
+#pragma omp parallel for schedule(dynamic, 1) if (length > 0)
+  for (int i = 0; i < (int)active.size(); i++) {
+    utils::ChTrace::SetWorkerThreadName();
+
+    TunerCandidate& cand = candidates[active[i]];
+    JointCase c = cases[cand.case_index];
+    c.solver = cand.solver;
+    if (length > 0)
+      c.end_time = length;
+
+    std::ostringstream log;
+
+    std::ostringstream name;
+    if (utils::ChTrace::IsEnabled())
+      name << c.name << "_C" << active[i];
+    utils::ChTraceSpan runSpan(name.str(), "case");
+
+    JointSimulationStats stats;
+    JointOutputs outputs;
+    if (SimulateJointCase(c, outputs, stats)) {
+      ValidateJointCase(c, outputs, refs, cand.result, log);
+      cand.margin = GetJointCaseMargin(c, cand.result);
+    } else {
+      cand.result.name = c.name;
+      cand.result.passed = false;
+      cand.margin = -DBL_MAX;
+    }
+    cand.result.exec_time = stats.exec_time;
+  }
+}
+
+// =============================================================================
+//
+// Search the solver settings of all selected cases.
+//
+bool solver_tuner::execute()
+{
+  ChTimer<double> full;
+  full.start();
+
+  // Set the path to the Chrono data folder
+  SetChronoDataPath(CHRONO_DATA_DIR);
+
+  // Read the suite file and select the cases to tune
+  std::vector<JointCase> cases;
+  if (!SelectJointCases(m_suiteFile, m_selection, cases))
+    return false;
+
+  // Sample the candidates of each case (without replacement) and add the
+  // current settings of the case.
+  size_t space_size = TUNER_COUNT(tuner_integrators) * TUNER_COUNT(tuner_solvers) *
+                      TUNER_COUNT(tuner_iters) * TUNER_COUNT(tuner_tols) * TUNER_COUNT(tuner_tol_forces);
+  size_t num_samples = std::min((size_t)m_numCandidates, space_size);
+
+  std::vector<TunerCandidate> candidates;
+  srand(m_seed);
+
+  for (size_t i = 0; i < cases.size(); i++) {
+    TunerCandidate cand;
+    cand.case_index = i;
+    cand.solver = cases[i].solver;
+    cand.baseline = true;
+    cand.active = true;
+    cand.margin = -DBL_MAX;
+    candidates.push_back(cand);
+
+    std::vector<size_t> indices(space_size);
+    for (size_t j = 0; j < space_size; j++)
+      indices[j] = j;
+
+    size_t num_added = 0;
+    for (size_t j = 0; j < space_size && num_added < num_samples; j++) {
+      size_t k = j + (size_t)(rand() % (int)(space_size - j));
+      std::swap(indices[j], indices[k]);
+      cand.solver = GetSettings(indices[j]);
+      if (SameSettings(cand.solver, cases[i].solver))
+        continue;
+      cand.baseline = false;
+      candidates.push_back(cand);
+      num_added++;
+    }
+  }
+
+  // Number of stages: the last stage has at least one survivor per case.
+  int num_stages = 1;
+  for (size_t n = num_samples + 1; n >= (size_t)m_eta; n /= m_eta)
+    num_stages++;
+
+  std::cout << "Tuning " << cases.size() << " cases, " << num_samples + 1
+            << " candidates each, " << num_stages << " stages" << std::endl;
+
+  // Create output directory (if it does not already exist)
+  if (!MakeOutputDirectory(val_dir))
+    return false;
+
+  // Load all reference data once
+  JointReferenceData refs;
+  refs.Load(cases);
+
+#ifdef _OPENMP
+  if (m_numThreads > 0)
+    omp_set_num_threads(m_numThreads);
+#endif
+
+  // Successive halving. The simulation length of a stage is a multiple of the
+  // output step, and the last stage runs the full length.
+  double fraction = 1;
+  for (int stage = 1; stage < num_stages; stage++)
+    fraction /= m_eta;
+
+  for (int stage = 0; stage < num_stages; stage++, fraction *= m_eta) {
+    // The last stage runs the full length of the cases. The current settings
+    // are always run over the full length.
+    if (stage == num_stages - 1) {
+      for (size_t i = 0; i < candidates.size(); i++)
+        candidates[i].active |= candidates[i].baseline;
+      RunStage(candidates, cases, refs, stage, 0);
+      break;
+    }
+
+    // Shorter runs use the same length for all cases (which all have the same
+    // output step in the suite files) with the reference data truncated.
+    double out_step = cases[0].out_step;
+    double end_time = 0;
+    for (size_t i = 0; i < cases.size(); i++)
+      end_time = std::max(end_time, cases[i].end_time);
+    double length = std::max(out_step, std::floor(fraction * end_time / out_step + 0.5) * out_step);
+
+    JointReferenceData stage_refs = refs.Truncated(length);
+    RunStage(candidates, cases, stage_refs, stage, length);
+
+    // Keep the best 1/eta candidates of each case.
+    for (size_t i = 0; i < cases.size(); i++) {
+      std::vector<TunerCandidate*> list;
+      for (size_t j = 0; j < candidates.size(); j++) {
+        if (candidates[j].case_index == i && candidates[j].active)
+          list.push_back(&candidates[j]);
+      }
+      std::stable_sort(list.begin(), list.end(), BetterCandidate);
+
+      size_t keep = std::max((size_t)1, list.size() / m_eta);
+      for (size_t j = keep; j < list.size(); j++)
+        list[j]->active = false;
+    }
+  }
+
+  // Report the results of the last stage
+  std::vector<JointCase> tuned = cases;
+  bool test_passed = true;
+
+  for (size_t i = 0; i < cases.size(); i++) {
+    const JointCase& c = cases[i];
+    const TunerCandidate* baseline = NULL;
+    const TunerCandidate* fastest = NULL;
+    std::vector<const TunerCandidate*> list;
+
+    for (size_t j = 0; j < candidates.size(); j++) {
+      const TunerCandidate& cand = candidates[j];
+      if (cand.case_index != i || !cand.active)
+        continue;
+      list.push_back(&cand);
+      if (cand.baseline)
+        baseline = &cand;
+      if (cand.result.passed && (!fastest || cand.result.exec_time < fastest->result.exec_time))
+        fastest = &cand;
+    }
+
+    std::cout << c.name << std::endl;
+    std::cout << "   current: " << baseline->solver.GetDescription() << "  time = "
+              << baseline->result.exec_time << "  margin = " << baseline->margin << std::endl;
+
+    addMetric(c.name + "_Baseline_ExecTime", baseline->result.exec_time);
+    addMetric(c.name + "_Baseline_Margin", baseline->margin);
+
+    std::vector<const TunerCandidate*> front = ParetoFront(list);
+    std::vector<double> front_times;
+    std::vector<double> front_margins;
+    for (size_t j = 0; j < front.size(); j++) {
+      std::ostringstream name;
+      name << c.name << "_Pareto" << j << "_Settings";
+      addMetric(name.str(), front[j]->solver.GetDescription());
+      front_times.push_back(front[j]->result.exec_time);
+      front_margins.push_back(front[j]->margin);
+      std::cout << "   pareto:  " << front[j]->solver.GetDescription() << "  time = "
+                << front[j]->result.exec_time << "  margin = " << front[j]->margin << std::endl;
+    }
+    addMetric(c.name + "_Pareto_ExecTime", front_times);
+    addMetric(c.name + "_Pareto_Margin", front_margins);
+
+    if (fastest) {
+      tuned[i].solver = fastest->solver;
+      addMetric(c.name + "_Tuned_Settings", fastest->solver.GetDescription());
+      addMetric(c.name + "_Tuned_ExecTime", fastest->result.exec_time);
+      addMetric(c.name + "_Tuned_Margin", fastest->margin);
+      if (fastest->result.exec_time > 0)
+        addMetric(c.name + "_Speedup", baseline->result.exec_time / fastest->result.exec_time);
+      std::cout << "   fastest: " << fastest->solver.GetDescription() << "  time = "
+                << fastest->result.exec_time << std::endl;
+    } else {
+      std::cout << "   no settings passed all validations" << std::endl;
+      test_passed = false;
+    }
+  }
+
+  addMetric("num_cases", (int)cases.size());
+  addMetric("num_candidates", (int)num_samples + 1);
+  addMetric("num_stages", num_stages);
+  addMetric("eta", m_eta);
+
+  // Write the suite with the fastest passing settings of every case
+  if (WriteJointSuite(m_outFile, tuned))
+    std::cout << "Tuned suite written to " << m_outFile << std::endl;
+  else
+    test_passed = false;
+
+  full.stop();
+  m_execTime = full();
+  std::cout << "Full Execution Time = " << m_execTime << std::endl;
+
+  return test_passed;
+}
+
+int main(int argc, char* argv[])
+{
+  std::string suite_file;
+  std::string out_file = val_dir + "tuned_suite.json";
+  std::vector<std::string> selection;
+  int num_threads = 0;
+  int num_candidates = 27;
+  int eta = 3;
+  unsigned int seed = 1;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc)
+      num_threads = atoi(argv[++i]);
+    else if (arg == "-n" && i + 1 < argc)
+      num_candidates = atoi(argv[++i]);
+    else if (arg == "-e" && i + 1 < argc)
+      eta = atoi(argv[++i]);
+    else if (arg == "-seed" && i + 1 < argc)
+      seed = (unsigned int)atoi(argv[++i]);
+    else if (arg == "-o" && i + 1 < argc)
+      out_file = argv[++i];
+    else if (suite_file.empty())
+      suite_file = arg;
+    else
+      selection.push_back(arg);
+  }
+
+  if (suite_file.empty() || num_candidates < 1 || eta < 2) {
+    std::cout << "Usage: " << argv[0]
+              << " [-j <threads>] [-n <candidates>] [-e <eta>] [-seed <seed>] [-o <tuned_suite.json>]"
+              << " <suite.json> [case ...]" << std::endl;
+    return 1;
+  }
+
+  solver_tuner t(suite_file, selection, out_file, num_threads, num_candidates, eta, seed);
+  t.setArguments(argc, argv);
+  t.print();  // optional
+
+  /* Run and time test */
+  t.run();
+
+  // Return 0 if all tests passed and 1 otherwise
+  return !t.m_passed;
+}
@@ -0,0 +1,215 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Test for the resampling of simulation data in ChValidation
+//
+// The reference data is an analytic trajectory on the output grid of the
+// validation tests (1e-2). Recordings of the same trajectory at every step of
+// a simulation (on a grid that does not contain the reference times) and at a
+// coarser output rate are validated against it with linear and cubic Hermite
+// interpolation. A recording that does not cover the time span of the
+// reference data, and a recording on a different time grid validated without
+// interpolation, must both be rejected.
+//
+// =============================================================================
+
+#include <ostream>
+#include <fstream>
+#include <math.h>
+
+#include "core/ChFileutils.h"
+#include "core/ChTimer.h"
+
+#include "utils/ChUtilsValidation.h"
+
+#include "BaseTest.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local variables
+//
+static const std::string val_dir = "../RESULTS/";
+static const std::string out_dir = val_dir + "interpolation/";
+
+static const double ref_step = 1e-2;
+static const double end_time = 1;
+
+// =============================================================================
+
+class test_interpolation : public BaseTest
+{
+public:
+  test_interpolation(const std::string& testName, const std::string& testProjectName)
+  : BaseTest(testName, testProjectName),
+    m_execTime(-1)
+  {}
+  ~test_interpolation() {}
+
+  virtual bool execute();
+  virtual double getExecutionTime() const { return m_execTime; }
+
+  bool TestRecording(const std::string& name, double step, double length,
+                     utils::ChInterpolation interp, double tolerance, bool expected);
+
+private:
+  utils::Headers m_headers;
+  utils::Data    m_data;
+  double         m_execTime;
+};
+
+// =============================================================================
+//
+// Analytic trajectory (position and velocity of a harmonic oscillator).
+//
+
+static void Trajectory(double t, double& x, double& v)
+{
+  double omega = 2 * CH_C_PI;
+  x = sin(omega * t);
+  v = omega * cos(omega * t);
+}
+
+// =============================================================================
+//
+// Main driver function for running the test cases.
+//
+
+bool test_interpolation::execute()
+{
+  ChTimer<double> full;
+  std::cout << "test_interpolation is being executed..." << std::endl;
+  full.start();
+
+  // Create output directory (if it does not already exist)
+  if (ChFileutils::MakeDirectory(val_dir.c_str()) < 0) {
+    std::cout << "Error creating directory " << val_dir << std::endl;
+    return false;
+  }
+  if (ChFileutils::MakeDirectory(out_dir.c_str()) < 0) {
+    std::cout << "Error creating directory " << out_dir << std::endl;
+    return false;
+  }
+
+  // Reference data on the output grid of the validation tests.
+  size_t num_ref = (size_t)floor(end_time / ref_step + 0.5) + 1;
+  m_headers.push_back("Time");
+  m_headers.push_back("X");
+  m_headers.push_back("V");
+  m_data.resize(3, utils::DataVector(num_ref));
+  for (size_t i = 0; i < num_ref; i++) {
+    m_data[0][i] = i * ref_step;
+    Trajectory(m_data[0][i], m_data[1][i], m_data[2][i]);
+  }
+
+  bool test_passed = true;
+
+  // Same grid as the reference: no interpolation needed.
+  test_passed &= TestRecording("Output", ref_step, end_time, utils::INTERP_NONE, 1e-10, true);
+
+  // Native rate of the simulation loop (every step).
+  test_passed &= TestRecording("Native", 3e-4, end_time, utils::INTERP_NONE, 1e-5, false);
+  test_passed &= TestRecording("Native", 3e-4, end_time, utils::INTERP_LINEAR, 1e-5, true);
+  test_passed &= TestRecording("Native", 3e-4, end_time, utils::INTERP_HERMITE, 1e-5, true);
+
+  // Coarser output rate than the reference.
+  test_passed &= TestRecording("Coarse", 2.5e-2, end_time, utils::INTERP_LINEAR, 2e-2, true);
+  test_passed &= TestRecording("Coarse", 2.5e-2, end_time, utils::INTERP_HERMITE, 2e-3, true);
+
+  // Recordings that stop early do not cover the reference data.
+  test_passed &= TestRecording("Short", 3e-4, end_time / 2, utils::INTERP_LINEAR, 1e-5, false);
+  test_passed &= TestRecording("Short", 3e-4, end_time / 2, utils::INTERP_HERMITE, 1e-5, false);
+
+  full.stop();
+  m_execTime = full();
+  std::cout << "Full Execution Time = " << m_execTime << std::endl;
+
+  return test_passed;
+}
+
+// =============================================================================
+//
+// Main function. Creates new test and run it.
+//
+
+int main(int argc, char* argv[])
+{
+  test_interpolation t("test_interpolation", "Chrono::Validation");
+  t.print();  // optional
+  t.run();
+
+  // Return 0 if all tests passed and 1 otherwise
+  return !t.m_passed;
+}
+
+// =============================================================================
+//
+// Write a recording of the analytic trajectory with the given step size, up to
+// (at least) the given length, and validate it against the reference data with
+// the given interpolation, both from the output file and in memory. Returns
+// true if the outcome of both validations is the expected one and their norms
+// agree.
+//
+bool test_interpolation::TestRecording(const std::string&     name,
+                                       double                 step,
+                                       double                 length,
+                                       utils::ChInterpolation interp,
+                                       double                 tolerance,
+                                       bool                   expected)
+{
+  static const char* interp_names[] = {"None", "Linear", "Hermite"};
+
+  std::string sim_file = out_dir + name + "_" + interp_names[interp] + ".txt";
+
+  std::ofstream ofile(sim_file.c_str());
+  ofile << "Interpolation test" << std::endl;
+  ofile << "Recording step " << step << std::endl;
+  ofile << "Time\tX\tV" << std::endl;
+  ofile.precision(17);
+
+  size_t num_steps = (size_t)ceil(length / step - 1e-6);
+  utils::Data sim_data(3, utils::DataVector(num_steps + 1));
+  for (size_t k = 0; k <= num_steps; k++) {
+    double t = k * step;
+    double x, v;
+    Trajectory(t, x, v);
+    ofile << t << "\t" << x << "\t" << v << std::endl;
+    sim_data[0][k] = t;
+    sim_data[1][k] = x;
+    sim_data[2][k] = v;
+  }
+  ofile.close();
+
+  utils::DataVector norms;
+  bool check = utils::Validate(sim_file, m_headers, m_data, utils::RMS_NORM, tolerance, norms, interp);
+
+  utils::DataVector mem_norms;
+  bool mem_check = utils::Validate(m_headers, sim_data, m_headers, m_data, utils::RMS_NORM, tolerance, mem_norms, interp);
+  bool agree = (mem_check == check) && (mem_norms.size() == norms.size());
+  for (size_t col = 0; agree && col < norms.size(); col++)
+    agree = fabs(mem_norms[col] - norms[col]) <= 1e-12 * (1 + fabs(norms[col]));
+
+  std::cout << "   validate " << name << " (" << interp_names[interp] << ")"
+            << (check ? ": Passed" : ": Failed") << "  [  ";
+  for (size_t col = 0; col < norms.size(); col++)
+    std::cout << norms[col] << "  ";
+  std::cout << "  ]" << (check == expected ? "" : "  UNEXPECTED")
+            << (agree ? "" : "  IN-MEMORY MISMATCH") << std::endl;
+
+  for (size_t col = 0; col < norms.size(); col++)
+    addMetric(name + "_" + interp_names[interp] + "_" + m_headers[col + 1], norms[col]);
+
+  return check == expected && agree;
+}
@@ -27,14 +27,23 @@
 #include "physics/ChSystem.h"
 #include "physics/ChBody.h"
 
-#include "unit_IRRLICHT/ChIrrApp.h"
+#include "assets/ChBoxShape.h"
+#include "assets/ChColorAsset.h"
 
 #include "ChronoValidation_config.h"
+
+#if IRRLICHT_ENABLED
+#include "unit_IRRLICHT/ChIrrApp.h"
+#endif
+
 #include "utils/ChUtilsInputOutput.h"
 #include "utils/ChUtilsValidation.h"
+#include "utils/ChUtilsTrace.h"
 
 using namespace chrono;
+#if IRRLICHT_ENABLED
 using namespace irr;
+#endif
 
 
 // =============================================================================
@@ -60,11 +69,19 @@ utils::CSV_writer OutStream();
 //
 int main(int argc, char* argv[])
 {
+#if IRRLICHT_ENABLED
   bool animate = (argc > 1);
+#else
+  bool animate = false;
+#endif
 
   // Set the path to the Chrono data folder
   SetChronoDataPath(CHRONO_DATA_DIR);
 
+  // Record a timeline of the run if CHRONO_VALIDATION_TRACE is set
+  utils::ChTrace::EnableFromEnvironment();
+  utils::ChTrace::SetThreadName("main");
+
   // Create output directory (if it does not already exist)
   if (ChFileutils::MakeDirectory(val_dir.c_str()) < 0) {
     std::cout << "Error creating directory " << val_dir << std::endl;
@@ -85,6 +102,7 @@ int main(int argc, char* argv[])
   // Case 1 - Translation axis vertical, imposed speed 1 m/s
 
   test_name = "LinActuator_Case01";
+  utils::ChTraceSpan caseSpan(test_name, "case");
   TestLinActuator(QUNIT, 1, sim_step, out_step, test_name, animate);
   if (!animate) {
     test_passed &= ValidateReference(test_name, "Pos", 2e-3);
@@ -104,6 +122,7 @@ int main(int argc, char* argv[])
   // Case 2 - Translation axis along X = Z, imposed speed 0.5 m/s
 
   test_name = "LinActuator_Case02";
+  caseSpan.Restart(test_name);
   TestLinActuator(Q_from_AngY(CH_C_PI / 4), 0.5, sim_step, out_step, test_name, animate);
   if (!animate) {
     test_passed &= ValidateReference(test_name, "Pos", 2e-3);
@@ -121,6 +140,9 @@ int main(int argc, char* argv[])
   }
 
 
+  caseSpan.End();
+  utils::ChTrace::Write();
+
   // Return 0 if all tests passed and 1 otherwise
   return !test_passed;
 }
@@ -230,6 +252,7 @@ bool TestLinActuator(const ChQuaternion<>& rot,              // translation alon
   // Perform the simulation (animation with Irrlicht)
   // ------------------------------------------------
 
+#if IRRLICHT_ENABLED
   if (animate)
   {
     // Create the Irrlicht application for visualization
@@ -263,6 +286,7 @@ bool TestLinActuator(const ChQuaternion<>& rot,              // translation alon
 
     return true;
   }
+#endif
 
   // Perform the simulation (record results)
   // ------------------------------------------------
@@ -309,11 +333,15 @@ bool TestLinActuator(const ChQuaternion<>& rot,              // translation alon
   double simTime = 0;
   double outTime = 0;
 
+  // Trace the batches of steps between output frames
+  utils::ChTraceSpan batchSpan(utils::ChTrace::IsEnabled() ? testName + " DoStepDynamics" : std::string(), "step");
+
   while (simTime <= timeRecord + simTimeStep / 2)
   {
     // Ensure that the final data point is recorded.
     if (simTime >= outTime - simTimeStep / 2)
     {
+      batchSpan.End();
 
       // CM position, velocity, and acceleration (expressed in global frame).
       const ChVector<>& position = plate->GetPos();
@@ -374,6 +402,8 @@ bool TestLinActuator(const ChQuaternion<>& rot,              // translation alon
 
       // Increment output time
       outTime += outTimeStep;
+
+      batchSpan.Restart();
     }
 
     // Advance simulation by one step
@@ -383,6 +413,8 @@ bool TestLinActuator(const ChQuaternion<>& rot,              // translation alon
     simTime += simTimeStep;
   }
 
+  batchSpan.End();
+
   // Write output files
   out_pos.write_to_file(out_dir + testName + "_CHRONO_Pos.txt", testName + "\n\n");
   out_vel.write_to_file(out_dir + testName + "_CHRONO_Vel.txt", testName + "\n\n");
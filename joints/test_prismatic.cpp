@@ -27,14 +27,23 @@
 #include "physics/ChSystem.h"
 #include "physics/ChBody.h"
 
-#include "unit_IRRLICHT/ChIrrApp.h"
+#include "assets/ChBoxShape.h"
+#include "assets/ChColorAsset.h"
 
 #include "ChronoValidation_config.h"
+
+#if IRRLICHT_ENABLED
+#include "unit_IRRLICHT/ChIrrApp.h"
+#endif
+
 #include "utils/ChUtilsInputOutput.h"
 #include "utils/ChUtilsValidation.h"
+#include "utils/ChUtilsTrace.h"
 
 using namespace chrono;
+#if IRRLICHT_ENABLED
 using namespace irr;
+#endif
 
 
 // =============================================================================
@@ -61,12 +70,20 @@ utils::CSV_writer OutStream();
 //
 int main(int argc, char* argv[])
 {
+#if IRRLICHT_ENABLED
   bool animate = (argc > 1);
+#else
+  bool animate = false;
+#endif
   bool save = (argc > 2);
 
   // Set the path to the Chrono data folder
   SetChronoDataPath(CHRONO_DATA_DIR);
 
+  // Record a timeline of the run if CHRONO_VALIDATION_TRACE is set
+  utils::ChTrace::EnableFromEnvironment();
+  utils::ChTrace::SetThreadName("main");
+
   // Create output directory (if it does not already exist)
   if (ChFileutils::MakeDirectory(val_dir.c_str()) < 0) {
     std::cout << "Error creating directory " << val_dir << std::endl;
@@ -88,6 +105,7 @@ int main(int argc, char* argv[])
   // Pendulum Falls due to gravity.
 
   test_name = "Prismatic_Case01";
+  utils::ChTraceSpan caseSpan(test_name, "case");
   TestPrismatic(ChVector<>(0, 0, 0), QUNIT, sim_step, out_step, test_name, animate, save);
   if (!animate) {
     test_passed &= ValidateReference(test_name, "Pos", 1e-2);
@@ -106,6 +124,7 @@ int main(int argc, char* argv[])
   // In this case, the joint must be rotated -pi/4 about the global X-axis.
 
   test_name = "Prismatic_Case02";
+  caseSpan.Restart(test_name);
   TestPrismatic(ChVector<>(1, 2, 3), Q_from_AngX(-CH_C_PI_4), sim_step, out_step, test_name, animate, save);
   if (!animate) {
     test_passed &= ValidateReference(test_name, "Pos", 1e-2);
@@ -125,6 +144,7 @@ int main(int argc, char* argv[])
   // X-axis.  This is a statics test of the joint (no motion)
 
   test_name = "Prismatic_Case03";
+  caseSpan.Restart(test_name);
   TestPrismatic(ChVector<>(1, 2, 3), Q_from_AngX(-CH_C_PI_2), sim_step, out_step, test_name, animate, save);
   if (!animate) {
     test_passed &= ValidateReference(test_name, "Pos", 1e-5);
@@ -140,6 +160,9 @@ int main(int argc, char* argv[])
   }
 
 
+  caseSpan.End();
+  utils::ChTrace::Write();
+
   // Return 0 if all tests passed and 1 otherwise
   return !test_passed;
 }
@@ -233,6 +256,7 @@ bool TestPrismatic(const ChVector<>&     jointLoc,         // absolute location
   // Perform the simulation (animation with Irrlicht option)
   // -------------------------------------------------------
 
+#if IRRLICHT_ENABLED
   if (animate)
   {
     // Create the Irrlicht application for visualization
@@ -285,6 +309,7 @@ bool TestPrismatic(const ChVector<>&     jointLoc,         // absolute location
 
     return true;
   }
+#endif
 
   // Perform the simulation (record results option)
   // ------------------------------------------------
@@ -337,11 +362,15 @@ bool TestPrismatic(const ChVector<>&     jointLoc,         // absolute location
   double simTime = 0;
   double outTime = 0;
 
+  // Trace the batches of steps between output frames
+  utils::ChTraceSpan batchSpan(utils::ChTrace::IsEnabled() ? testName + " DoStepDynamics" : std::string(), "step");
+
   while (simTime <= timeRecord + simTimeStep / 2)
   {
     // Ensure that the final data point is recorded.
     if (simTime >= outTime - simTimeStep / 2)
     {
+      batchSpan.End();
 
       // CM position, velocity, and acceleration (expressed in global frame).
       const ChVector<>& position = pendulum->GetPos();
@@ -391,6 +420,8 @@ bool TestPrismatic(const ChVector<>&     jointLoc,         // absolute location
 
       // Increment output time
       outTime += outTimeStep;
+
+      batchSpan.Restart();
     }
 
     // Advance simulation by one step
@@ -400,6 +431,8 @@ bool TestPrismatic(const ChVector<>&     jointLoc,         // absolute location
     simTime += simTimeStep;
   }
 
+  batchSpan.End();
+
   // Write output files
   out_pos.write_to_file(out_dir + testName + "_CHRONO_Pos.txt", testName + "\n\n");
   out_vel.write_to_file(out_dir + testName + "_CHRONO_Vel.txt", testName + "\n\n");
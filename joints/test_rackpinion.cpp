@@ -28,14 +28,24 @@
 #include "physics/ChBody.h"
 #include "physics/ChLinkRackpinion.h"
 
-#include "unit_IRRLICHT/ChIrrApp.h"
+#include "assets/ChBoxShape.h"
+#include "assets/ChColorAsset.h"
+#include "assets/ChCylinderShape.h"
 
 #include "ChronoValidation_config.h"
+
+#if IRRLICHT_ENABLED
+#include "unit_IRRLICHT/ChIrrApp.h"
+#endif
+
 #include "utils/ChUtilsInputOutput.h"
 #include "utils/ChUtilsValidation.h"
+#include "utils/ChUtilsTrace.h"
 
 using namespace chrono;
+#if IRRLICHT_ENABLED
 using namespace irr;
+#endif
 
 
 // =============================================================================
@@ -62,12 +72,20 @@ utils::CSV_writer OutStream();
 //
 int main(int argc, char* argv[])
 {
+#if IRRLICHT_ENABLED
   bool animate = (argc > 1);
+#else
+  bool animate = false;
+#endif
   bool save = (argc > 2);
 
   // Set the path to the Chrono data folder
   SetChronoDataPath(CHRONO_DATA_DIR);
 
+  // Record a timeline of the run if CHRONO_VALIDATION_TRACE is set
+  utils::ChTrace::EnableFromEnvironment();
+  utils::ChTrace::SetThreadName("main");
+
   // Create output directory (if it does not already exist)
   if (ChFileutils::MakeDirectory(val_dir.c_str()) < 0) {
     std::cout << "Error creating directory " << val_dir << std::endl;
@@ -89,6 +107,7 @@ int main(int argc, char* argv[])
   // Pendulum Falls due to gravity.
 
   test_name = "RackPinion_Case01";
+  utils::ChTraceSpan caseSpan(test_name, "case");
   TestRackPinion(ChVector<>(0, 0, 0), QUNIT, sim_step, out_step, test_name, animate, save);
   if (!animate) {
     //test_passed &= ValidateReference(test_name, "Pinion_Pos", 2e-3);
@@ -109,6 +128,9 @@ int main(int argc, char* argv[])
 
 
 
+  caseSpan.End();
+  utils::ChTrace::Write();
+
   // Return 0 if all tests passed and 1 otherwise
   return !test_passed;
 }
@@ -230,6 +252,7 @@ bool TestRackPinion(const ChVector<>&     jointLoc,         // absolute location
   // Perform the simulation (animation with Irrlicht option)
   // -------------------------------------------------------
 
+#if IRRLICHT_ENABLED
   if (animate)
   {
     // Create the Irrlicht application for visualization
@@ -283,6 +306,7 @@ bool TestRackPinion(const ChVector<>&     jointLoc,         // absolute location
 
     return true;
   }
+#endif
 
   // Perform the simulation (record results option)
   // ------------------------------------------------
@@ -343,11 +367,15 @@ bool TestRackPinion(const ChVector<>&     jointLoc,         // absolute location
   double simTime = 0;
   double outTime = 0;
 
+  // Trace the batches of steps between output frames
+  utils::ChTraceSpan batchSpan(utils::ChTrace::IsEnabled() ? testName + " DoStepDynamics" : std::string(), "step");
+
   while (simTime <= timeRecord + simTimeStep / 2)
   {
     // Ensure that the final data point is recorded.
     if (simTime >= outTime - simTimeStep / 2)
     {
+      batchSpan.End();
 
       // CM position, velocity, and acceleration (expressed in global frame).
       const ChVector<>& positionPinion = pinion->GetPos();
@@ -389,6 +417,8 @@ bool TestRackPinion(const ChVector<>&     jointLoc,         // absolute location
 
       // Increment output time
       outTime += outTimeStep;
+
+      batchSpan.Restart();
     }
 
     // Advance simulation by one step
@@ -398,6 +428,8 @@ bool TestRackPinion(const ChVector<>&     jointLoc,         // absolute location
     simTime += simTimeStep;
   }
 
+  batchSpan.End();
+
   // Write output files
   out_posPinion.write_to_file(out_dir + testName + "_CHRONO_Pinion_Pos.txt", testName + "\n\n");
   out_velPinion.write_to_file(out_dir + testName + "_CHRONO_Pinion_Vel.txt", testName + "\n\n");
@@ -27,14 +27,24 @@
 #include "physics/ChSystem.h"
 #include "physics/ChBody.h"
 
-#include "unit_IRRLICHT/ChIrrApp.h"
+#include "assets/ChBoxShape.h"
+#include "assets/ChCylinderShape.h"
+#include "assets/ChSphereShape.h"
 
 #include "ChronoValidation_config.h"
+
+#if IRRLICHT_ENABLED
+#include "unit_IRRLICHT/ChIrrApp.h"
+#endif
+
 #include "utils/ChUtilsInputOutput.h"
 #include "utils/ChUtilsValidation.h"
+#include "utils/ChUtilsTrace.h"
 
 using namespace chrono;
+#if IRRLICHT_ENABLED
 using namespace irr;
+#endif
 
 
 // =============================================================================
@@ -64,12 +74,20 @@ utils::CSV_writer OutStream();
 //
 int main(int argc, char* argv[])
 {
+#if IRRLICHT_ENABLED
   bool animate = (argc > 1);
+#else
+  bool animate = false;
+#endif
   bool save = (argc > 2);
 
   // Set the path to the Chrono data folder
   SetChronoDataPath(CHRONO_DATA_DIR);
 
+  // Record a timeline of the run if CHRONO_VALIDATION_TRACE is set
+  utils::ChTrace::EnableFromEnvironment();
+  utils::ChTrace::SetThreadName("main");
+
   // Create output directory (if it does not already exist)
   if (ChFileutils::MakeDirectory(val_dir.c_str()) < 0) {
     std::cout << "Error creating directory " << val_dir << std::endl;
@@ -91,6 +109,7 @@ int main(int argc, char* argv[])
   //   Spherical joint at one end of a horizontal pendulum (2,0,0) with CG at (2,2,0)
 
   test_name = "RevSpherical_Case01";
+  utils::ChTraceSpan caseSpan(test_name, "case");
   TestRevSpherical(ChVector<>(0, 0, 0), ChVector<>(0, 0, 1), ChVector<>(2, 0, 0), ChCoordsys<>(ChVector<>(2, 2, 0),QUNIT), sim_step, out_step, test_name, animate, save);
   if (!animate) {
     test_passed &= ValidateReference(test_name, "Pos", 1e-4);
@@ -111,6 +130,7 @@ int main(int argc, char* argv[])
   //   Spherical joint at one end of a horizontal pendulum (3,2,3) with CG at (3,4,3)
 
   test_name = "RevSpherical_Case02";
+  caseSpan.Restart(test_name);
   TestRevSpherical(ChVector<>(1, 2, 3), ChVector<>(0, 1, 1), ChVector<>(3, 2, 3), ChCoordsys<>(ChVector<>(3, 4, 3),QUNIT), sim_step, out_step, test_name, animate, save);
   if (!animate) {
     test_passed &= ValidateReference(test_name, "Pos", 1e-4);
@@ -129,6 +149,9 @@ int main(int argc, char* argv[])
 
 
 
+  caseSpan.End();
+  utils::ChTrace::Write();
+
   // Return 0 if all tests passed and 1 otherwise
   return !test_passed;
 }
@@ -223,6 +246,7 @@ bool TestRevSpherical(const ChVector<>&     jointLocGnd,      // absolute locati
   // Perform the simulation (animation with Irrlicht option)
   // -------------------------------------------------------
 
+#if IRRLICHT_ENABLED
   if (animate)
   {
     // Create the Irrlicht application for visualization
@@ -282,6 +306,7 @@ bool TestRevSpherical(const ChVector<>&     jointLocGnd,      // absolute locati
 
     return true;
   }
+#endif
 
   // Perform the simulation (record results option)
   // ------------------------------------------------
@@ -346,11 +371,15 @@ bool TestRevSpherical(const ChVector<>&     jointLocGnd,      // absolute locati
   double outTime = 0;
 
   //timeRecord = .0001;
+  // Trace the batches of steps between output frames
+  utils::ChTraceSpan batchSpan(utils::ChTrace::IsEnabled() ? testName + " DoStepDynamics" : std::string(), "step");
+
   while (simTime <= timeRecord + simTimeStep / 2)
   {
     // Ensure that the final data point is recorded.
     if (simTime >= outTime - simTimeStep / 2)
     {
+      batchSpan.End();
 
       // CM position, velocity, and acceleration (expressed in global frame).
       const ChVector<>& position = pendulum->GetPos();
@@ -432,6 +461,8 @@ bool TestRevSpherical(const ChVector<>&     jointLocGnd,      // absolute locati
 
       // Increment output time
       outTime += outTimeStep;
+
+      batchSpan.Restart();
     }
 
     // Advance simulation by one step
@@ -441,6 +472,8 @@ bool TestRevSpherical(const ChVector<>&     jointLocGnd,      // absolute locati
     simTime += simTimeStep;
   }
 
+  batchSpan.End();
+
   // Write output files
   out_pos.write_to_file(out_dir + testName + "_CHRONO_Pos.txt", testName + "\n\n");
   out_vel.write_to_file(out_dir + testName + "_CHRONO_Vel.txt", testName + "\n\n");
@@ -27,14 +27,23 @@
 #include "physics/ChSystem.h"
 #include "physics/ChBody.h"
 
-#include "unit_IRRLICHT/ChIrrApp.h"
+#include "assets/ChCylinderShape.h"
+#include "assets/ChSphereShape.h"
 
 #include "ChronoValidation_config.h"
+
+#if IRRLICHT_ENABLED
+#include "unit_IRRLICHT/ChIrrApp.h"
+#endif
+
 #include "utils/ChUtilsInputOutput.h"
 #include "utils/ChUtilsValidation.h"
+#include "utils/ChUtilsTrace.h"
 
 using namespace chrono;
+#if IRRLICHT_ENABLED
 using namespace irr;
+#endif
 
 
 // =============================================================================
@@ -61,11 +70,19 @@ utils::CSV_writer OutStream();
 //
 int main(int argc, char* argv[])
 {
+#if IRRLICHT_ENABLED
   bool animate = (argc > 1);
+#else
+  bool animate = false;
+#endif
 
   // Set the path to the Chrono data folder
   SetChronoDataPath(CHRONO_DATA_DIR);
 
+  // Record a timeline of the run if CHRONO_VALIDATION_TRACE is set
+  utils::ChTrace::EnableFromEnvironment();
+  utils::ChTrace::SetThreadName("main");
+
   // Create output directory (if it does not already exist)
   if (ChFileutils::MakeDirectory(val_dir.c_str()) < 0) {
     std::cout << "Error creating directory " << val_dir << std::endl;
@@ -86,6 +103,7 @@ int main(int argc, char* argv[])
   // Case 1 - Joint at the origin and aligned with the global frame.
 
   test_name = "Spherical_Case01";
+  utils::ChTraceSpan caseSpan(test_name, "case");
   TestSpherical(ChVector<>(0, 0, 0), QUNIT, sim_step, out_step, test_name, animate);
   if (!animate) {
     test_passed &= ValidateReference(test_name, "Pos", 2e-3);
@@ -104,6 +122,7 @@ int main(int argc, char* argv[])
   // In this case, the joint must be rotated -pi/4 about the global X-axis.
 
   test_name = "Spherical_Case02";
+  caseSpan.Restart(test_name);
   TestSpherical(ChVector<>(1, 2, 3), Q_from_AngX(-CH_C_PI_4), sim_step, out_step, test_name, animate);
   if (!animate) {
     test_passed &= ValidateReference(test_name, "Pos", 2e-3);
@@ -118,6 +137,9 @@ int main(int argc, char* argv[])
     test_passed &= ValidateConstraints(test_name, 1e-5);
   }
 
+  caseSpan.End();
+  utils::ChTrace::Write();
+
   // Return 0 if all tests passed and 1 otherwise
   return !test_passed;
 }
@@ -211,6 +233,7 @@ bool TestSpherical(const ChVector<>&     jointLoc,         // absolute location
   // Perform the simulation (animation with Irrlicht option)
   // -------------------------------------------------------
 
+#if IRRLICHT_ENABLED
   if (animate)
   {
     // Create the Irrlicht application for visualization
@@ -246,6 +269,7 @@ bool TestSpherical(const ChVector<>&     jointLoc,         // absolute location
 
     return true;
   }
+#endif
 
   // Perform the simulation (record results option)
   // ------------------------------------------------
@@ -298,11 +322,15 @@ bool TestSpherical(const ChVector<>&     jointLoc,         // absolute location
   double simTime = 0;
   double outTime = 0;
 
+  // Trace the batches of steps between output frames
+  utils::ChTraceSpan batchSpan(utils::ChTrace::IsEnabled() ? testName + " DoStepDynamics" : std::string(), "step");
+
   while (simTime <= timeRecord + simTimeStep / 2)
   {
     // Ensure that the final data point is recorded.
     if (simTime >= outTime - simTimeStep / 2)
     {
+      batchSpan.End();
 
       // CM position, velocity, and acceleration (expressed in global frame).
       const ChVector<>& position = pendulum->GetPos();
@@ -350,6 +378,8 @@ bool TestSpherical(const ChVector<>&     jointLoc,         // absolute location
 
       // Increment output time
       outTime += outTimeStep;
+
+      batchSpan.Restart();
     }
 
     // Advance simulation by one step
@@ -359,6 +389,8 @@ bool TestSpherical(const ChVector<>&     jointLoc,         // absolute location
     simTime += simTimeStep;
   }
 
+  batchSpan.End();
+
   // Write output files
   out_pos.write_to_file(out_dir + testName + "_CHRONO_Pos.txt", testName + "\n\n");
   out_vel.write_to_file(out_dir + testName + "_CHRONO_Vel.txt", testName + "\n\n");
@@ -28,14 +28,23 @@
 #include "physics/ChSystem.h"
 #include "physics/ChBody.h"
 
-#include "unit_IRRLICHT/ChIrrApp.h"
+#include "assets/ChBoxShape.h"
+#include "assets/ChSphereShape.h"
 
 #include "ChronoValidation_config.h"
+
+#if IRRLICHT_ENABLED
+#include "unit_IRRLICHT/ChIrrApp.h"
+#endif
+
 #include "utils/ChUtilsInputOutput.h"
 #include "utils/ChUtilsValidation.h"
+#include "utils/ChUtilsTrace.h"
 
 using namespace chrono;
+#if IRRLICHT_ENABLED
 using namespace irr;
+#endif
 
 
 // =============================================================================
@@ -67,12 +76,20 @@ utils::CSV_writer OutStream();
 //
 int main(int argc, char* argv[])
 {
+#if IRRLICHT_ENABLED
   bool animate = (argc > 1);
+#else
+  bool animate = false;
+#endif
   bool save = (argc > 2);
 
   // Set the path to the Chrono data folder
   SetChronoDataPath(CHRONO_DATA_DIR);
 
+  // Record a timeline of the run if CHRONO_VALIDATION_TRACE is set
+  utils::ChTrace::EnableFromEnvironment();
+  utils::ChTrace::SetThreadName("main");
+
   // Create output directory (if it does not already exist)
   if (ChFileutils::MakeDirectory(val_dir.c_str()) < 0) {
     std::cout << "Error creating directory " << val_dir << std::endl;
@@ -95,6 +112,7 @@ int main(int argc, char* argv[])
   // Case 1 - Pendulum dropped from the origin with a spring connected between the CG and ground.
 
   test_name = "TranSpring_Case01";
+  utils::ChTraceSpan caseSpan(test_name, "case");
   TestTranSpring(ChVector<>(0, 0, 0),ChVector<>(0, 0, 0), ChCoordsys<>(ChVector<>(0, 0, 0),QUNIT), 10, 0.5, sim_step, out_step, test_name, animate, save);
   if (!animate) {
     test_passed &= ValidateReference(test_name, "Pos", 1e-3);
@@ -110,6 +128,7 @@ int main(int argc, char* argv[])
   // Case 2 - Pendulum CG at Y = 2 with the spring connected between the CG and ground.
 
   test_name = "TranSpring_Case02";
+  caseSpan.Restart(test_name);
   TestTranSpring(ChVector<>(0, 0, 0),ChVector<>(0, 2, 0), ChCoordsys<>(ChVector<>(0, 2, 0),QUNIT), 100, 5, sim_step, out_step, test_name, animate, save);
   if (!animate) {
     test_passed &= ValidateReference(test_name, "Pos", 1e-3);
@@ -121,6 +140,9 @@ int main(int argc, char* argv[])
     test_passed &= ValidateReference(test_name, "Rforce", 5e-3);
   }
 
+  caseSpan.End();
+  utils::ChTrace::Write();
+
   // Return 0 if all tests passed and 1 otherwise
   return !test_passed;
 }
@@ -219,6 +241,7 @@ bool TestTranSpring(const ChVector<>&     jointLocGnd,      // absolute location
   // Perform the simulation (animation with Irrlicht option)
   // -------------------------------------------------------
 
+#if IRRLICHT_ENABLED
   if (animate)
   {
     // Create the Irrlicht application for visualization
@@ -277,6 +300,7 @@ bool TestTranSpring(const ChVector<>&     jointLocGnd,      // absolute location
 
     return true;
   }
+#endif
 
   // Perform the simulation (record results option)
   // ------------------------------------------------
@@ -327,11 +351,15 @@ bool TestTranSpring(const ChVector<>&     jointLocGnd,      // absolute location
   double simTime = 0;
   double outTime = 0;
 
+  // Trace the batches of steps between output frames
+  utils::ChTraceSpan batchSpan(utils::ChTrace::IsEnabled() ? testName + " DoStepDynamics" : std::string(), "step");
+
   while (simTime <= timeRecord + simTimeStep / 2)
   {
     // Ensure that the final data point is recorded.
     if (simTime >= outTime - simTimeStep / 2)
     {
+      batchSpan.End();
 
       // CM position, velocity, and acceleration (expressed in global frame).
       const ChVector<>& position = pendulum->GetPos();
@@ -375,6 +403,8 @@ bool TestTranSpring(const ChVector<>&     jointLocGnd,      // absolute location
 
       // Increment output time
       outTime += outTimeStep;
+
+      batchSpan.Restart();
     }
 
     // Advance simulation by one step
@@ -384,6 +414,8 @@ bool TestTranSpring(const ChVector<>&     jointLocGnd,      // absolute location
     simTime += simTimeStep;
   }
 
+  batchSpan.End();
+
   // Write output files
   out_pos.write_to_file(out_dir + testName + "_CHRONO_Pos.txt", testName + "\n\n");
   out_vel.write_to_file(out_dir + testName + "_CHRONO_Vel.txt", testName + "\n\n");
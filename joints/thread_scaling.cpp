@@ -0,0 +1,413 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Thread-count scaling sweep.
+//
+// Runs a benchmark program (any of the validation or benchmark programs, e.g.
+// validation_suite, chain_scaling, or granular_benchmark) with 1, 2, 4, ...
+// threads, up to the number of hardware threads. For every run, the OpenMP
+// thread count (OMP_NUM_THREADS) is set, and every occurrence of "{threads}"
+// in the benchmark arguments is replaced by the thread count (so that the
+// Chrono parallel settings of the benchmark can be passed on its command
+// line, e.g. "-j {threads}").
+//
+// The time of a run is the execution time recorded in the JSON output of the
+// benchmark (written to a scratch results directory), or the wall clock time
+// of the process if not available. The best of several repetitions is used.
+// The sweep reports the speedup and parallel efficiency at every thread count,
+// the knee of the speedup curve (the point of maximum distance from the chord
+// of the normalized curve, in log2 thread count), and the largest thread count
+// with a parallel efficiency above a threshold.
+//
+// Usage:
+//   thread_scaling [-t <T1,T2,...>] [-r <repeats>] [-e <efficiency>]
+//                  <program> [args ...]
+//
+// Defaults: powers of 2 up to (and including) the number of hardware threads,
+// 1 repetition, efficiency threshold 0.7.
+// The child runs do not write to the performance history or the suite-wide
+// results file. Note: this is not intended to work on Windows!
+//
+// =============================================================================
+
+#include <ostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "core/ChFileutils.h"
+#include "core/ChTimer.h"
+
+#include "ChronoValidation_config.h"
+
+// BaseTest.h defines RAPIDJSON_HAS_STDSTRING, so it must precede all other
+// rapidjson headers.
+#include "BaseTest.h"
+#include "../include/rapidjson/document.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local variables
+//
+static const std::string val_dir = "../RESULTS/";
+static const std::string out_dir = val_dir + "thread_scaling/";
+
+// =============================================================================
+// Local functions
+//
+
+// Parse a comma-separated list of positive integers.
+static bool ParseCounts(const std::string& str, std::vector<int>& counts)
+{
+  counts.clear();
+  std::istringstream iss(str);
+  std::string item;
+  while (std::getline(iss, item, ',')) {
+    int n = atoi(item.c_str());
+    if (n <= 0)
+      return false;
+    counts.push_back(n);
+  }
+  return !counts.empty();
+}
+
+// Number of hardware threads.
+static int GetNumHardwareThreads()
+{
+#ifdef _OPENMP
+  return omp_get_num_procs();
+#else
+  return 1;
+#endif
+}
+
+// Set an environment variable (inherited by the benchmark processes).
+static void SetEnvironment(const std::string& name, const std::string& value)
+{
+#ifdef _WIN32
+  _putenv_s(name.c_str(), value.c_str());
+#else
+  setenv(name.c_str(), value.c_str(), 1);
+#endif
+}
+
+// Environment variables set for the benchmark processes. Their original values
+// are restored at the end of the sweep (the JSON output of the sweep itself
+// depends on them).
+static const char* child_variables[] = {
+  "CHRONO_VALIDATION_RESULTS_DIR",
+  "CHRONO_VALIDATION_HISTORY_FILE",
+  "CHRONO_VALIDATION_RESULTS_FILE",
+  "OMP_NUM_THREADS"
+};
+static const int num_child_variables = sizeof(child_variables) / sizeof(child_variables[0]);
+
+struct SavedVariable {
+  bool        set;
+  std::string value;
+};
+
+static void RestoreEnvironment(const std::vector<SavedVariable>& saved)
+{
+  for (int i = 0; i < num_child_variables; i++) {
+    if (saved[i].set)
+      SetEnvironment(child_variables[i], saved[i].value);
+    else {
+#ifdef _WIN32
+      _putenv_s(child_variables[i], "");
+#else
+      unsetenv(child_variables[i]);
+#endif
+    }
+  }
+}
+
+// Replace all occurrences of 'pattern' in 'str' with 'value'.
+static std::string Substitute(std::string str, const std::string& pattern, const std::string& value)
+{
+  size_t pos = 0;
+  while ((pos = str.find(pattern, pos)) != std::string::npos) {
+    str.replace(pos, pattern.size(), value);
+    pos += value.size();
+  }
+  return str;
+}
+
+// Return the file name of a path (without directories and extension).
+static std::string GetBaseName(const std::string& path)
+{
+  size_t start = path.find_last_of("/\\");
+  start = (start == std::string::npos) ? 0 : start + 1;
+  size_t end = path.find_last_of('.');
+  if (end == std::string::npos || end < start)
+    end = path.size();
+  return path.substr(start, end - start);
+}
+
+// Read the execution time from the JSON output of a test. Returns false if the
+// file does not exist or does not contain an execution time.
+static bool ReadExecutionTime(const std::string& filename, double& exec_time)
+{
+  std::ifstream ifile(filename.c_str());
+  if (!ifile)
+    return false;
+
+  std::stringstream buffer;
+  buffer << ifile.rdbuf();
+  std::string json = buffer.str();
+
+  rapidjson::Document doc;
+  doc.Parse(json.c_str());
+  if (doc.HasParseError() || !doc.IsObject())
+    return false;
+  if (!doc.HasMember("execution_time") || !doc["execution_time"].IsNumber())
+    return false;
+
+  exec_time = doc["execution_time"].GetDouble();
+  return exec_time > 0;
+}
+
+// Knee of the speedup curve: the point of maximum distance above the chord
+// of the curve normalized to the unit square, with the thread counts in log2
+// scale. Returns the index of the last point if the curve has no knee (e.g.
+// linear speedup).
+static size_t FindKnee(const std::vector<int>& threads, const std::vector<double>& speedup)
+{
+  size_t n = threads.size();
+  if (n < 3)
+    return n - 1;
+
+  double x0 = std::log((double)threads[0]);
+  double x1 = std::log((double)threads[n - 1]);
+  double y0 = *std::min_element(speedup.begin(), speedup.end());
+  double y1 = *std::max_element(speedup.begin(), speedup.end());
+  if (x1 <= x0 || y1 <= y0)
+    return n - 1;
+
+  size_t knee = n - 1;
+  double max_diff = 0;
+  for (size_t k = 0; k < n; k++) {
+    double x = (std::log((double)threads[k]) - x0) / (x1 - x0);
+    double y = (speedup[k] - y0) / (y1 - y0);
+    if (y - x > max_diff) {
+      max_diff = y - x;
+      knee = k;
+    }
+  }
+
+  return knee;
+}
+
+// =============================================================================
+
+class thread_scaling : public BaseTest
+{
+public:
+  thread_scaling(const std::vector<std::string>& command,
+                 const std::vector<int>&         threads,
+                 int                             numRepeats,
+                 double                          minEfficiency)
+  : BaseTest("thread_scaling", "Chrono::Validation"),
+    m_command(command),
+    m_threads(threads),
+    m_numRepeats(numRepeats),
+    m_minEfficiency(minEfficiency),
+    m_execTime(-1)
+  {}
+  ~thread_scaling() {}
+
+  virtual bool execute();
+  virtual double getExecutionTime() const { return m_execTime; }
+
+private:
+  std::vector<std::string> m_command;
+  std::vector<int>         m_threads;
+  int                      m_numRepeats;
+  double                   m_minEfficiency;
+  double                   m_execTime;
+};
+
+// =============================================================================
+//
+// Run the benchmark at all thread counts and report the scaling.
+//
+bool thread_scaling::execute()
+{
+  ChTimer<double> full;
+  full.start();
+
+  // Create output directories (if they do not already exist)
+  if (ChFileutils::MakeDirectory(val_dir.c_str()) < 0 ||
+      ChFileutils::MakeDirectory(out_dir.c_str()) < 0) {
+    std::cout << "Error creating directory " << out_dir << std::endl;
+    return false;
+  }
+
+  std::string program = GetBaseName(m_command[0]);
+  std::string results_file = out_dir + program + ".json";
+
+  std::vector<SavedVariable> saved(num_child_variables);
+  for (int i = 0; i < num_child_variables; i++) {
+    const char* value = getenv(child_variables[i]);
+    saved[i].set = (value != NULL);
+    saved[i].value = value ? value : "";
+  }
+
+  // The benchmark runs write their JSON output to the scratch directory only.
+  SetEnvironment("CHRONO_VALIDATION_RESULTS_DIR", out_dir);
+  SetEnvironment("CHRONO_VALIDATION_HISTORY_FILE", "");
+  SetEnvironment("CHRONO_VALIDATION_RESULTS_FILE", "");
+
+  std::cout << "Benchmark: " << program << " (" << GetNumHardwareThreads() << " hardware threads)" << std::endl;
+
+  bool test_passed = true;
+  std::vector<double> times(m_threads.size(), 0.0);
+
+  for (size_t k = 0; k < m_threads.size(); k++) {
+    std::ostringstream count;
+    count << m_threads[k];
+    SetEnvironment("OMP_NUM_THREADS", count.str());
+
+    std::string cmd;
+    for (size_t i = 0; i < m_command.size(); i++)
+      cmd += (i > 0 ? " \"" : "\"") + Substitute(m_command[i], "{threads}", count.str()) + "\"";
+
+    for (int r = 0; r < m_numRepeats; r++) {
+      std::remove(results_file.c_str());
+
+      ChTimer<double> timer;
+      timer.start();
+      int status = std::system(cmd.c_str());
+      timer.stop();
+
+      if (status != 0) {
+        std::cout << "   warning: " << program << " returned " << status
+                  << " with " << m_threads[k] << " threads" << std::endl;
+        test_passed = false;
+      }
+
+      double time;
+      if (!ReadExecutionTime(results_file, time))
+        time = timer();
+
+      if (r == 0 || time < times[k])
+        times[k] = time;
+    }
+  }
+
+  RestoreEnvironment(saved);
+
+  // Speedup and parallel efficiency, relative to the smallest thread count
+  std::vector<double> threads(m_threads.size());
+  std::vector<double> speedup(m_threads.size());
+  std::vector<double> efficiency(m_threads.size());
+  int max_efficient = m_threads[0];
+
+  std::cout << std::endl;
+  std::cout << "  threads      time [s]   speedup   efficiency" << std::endl;
+
+  for (size_t k = 0; k < m_threads.size(); k++) {
+    threads[k] = m_threads[k];
+    speedup[k] = (times[k] > 0) ? times[0] / times[k] : 0;
+    efficiency[k] = speedup[k] * m_threads[0] / m_threads[k];
+    if (efficiency[k] >= m_minEfficiency)
+      max_efficient = std::max(max_efficient, m_threads[k]);
+
+    char line[80];
+    sprintf(line, "%9d  %12.4f  %8.2f  %11.2f", m_threads[k], times[k], speedup[k], efficiency[k]);
+    std::cout << line << std::endl;
+  }
+
+  int knee = m_threads[FindKnee(m_threads, speedup)];
+
+  std::cout << "Knee of the speedup curve: " << knee << " threads" << std::endl;
+  std::cout << "Largest thread count with efficiency >= " << m_minEfficiency << ": " << max_efficient << std::endl;
+
+  addMetric("benchmark", program);
+  addMetric("hardware_threads", GetNumHardwareThreads());
+  addMetric("Threads", threads);
+  addMetric("Time", times);
+  addMetric("Speedup", speedup);
+  addMetric("Efficiency", efficiency);
+  addMetric("Knee", knee);
+  addMetric("MaxEfficientThreads", max_efficient);
+  addMetric("MinEfficiency", m_minEfficiency);
+
+  full.stop();
+  m_execTime = full();
+  std::cout << "Full Execution Time = " << m_execTime << std::endl;
+
+  return test_passed;
+}
+
+int main(int argc, char* argv[])
+{
+  std::vector<std::string> command;
+  std::vector<int> threads;
+  int num_repeats = 1;
+  double min_efficiency = 0.7;
+  bool args_ok = true;
+
+  // Default thread counts: powers of 2 up to the number of hardware threads,
+  // and the number of hardware threads itself.
+  int num_hw = GetNumHardwareThreads();
+  for (int t = 1; t < num_hw; t *= 2)
+    threads.push_back(t);
+  threads.push_back(num_hw);
+
+  // Options of the sweep come first; the first other argument is the program.
+  int i = 1;
+  for (; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-t" && i + 1 < argc)
+      args_ok &= ParseCounts(argv[++i], threads);
+    else if (arg == "-r" && i + 1 < argc)
+      num_repeats = atoi(argv[++i]);
+    else if (arg == "-e" && i + 1 < argc)
+      min_efficiency = atof(argv[++i]);
+    else
+      break;
+  }
+  for (; i < argc; i++)
+    command.push_back(argv[i]);
+
+  if (command.empty() || !args_ok || num_repeats < 1) {
+    std::cout << "Usage: " << argv[0]
+              << " [-t <T1,T2,...>] [-r <repeats>] [-e <efficiency>] <program> [args ...]" << std::endl;
+    std::cout << "  (\"{threads}\" in the program arguments is replaced by the thread count)" << std::endl;
+    return 1;
+  }
+
+  std::sort(threads.begin(), threads.end());
+  threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+
+  thread_scaling t(command, threads, num_repeats, min_efficiency);
+  t.setArguments(argc, argv);
+  t.print();  // optional
+
+  /* Run and time test */
+  t.run();
+
+  // Return 0 if all tests passed and 1 otherwise
+  return !t.m_passed;
+}
@@ -0,0 +1,254 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Data-driven joint validation suite.
+//
+// Runs any subset of the validation cases described in a JSON suite file in a
+// single process: the reference data is loaded once and shared by all cases,
+// and the cases are distributed over a pool of OpenMP threads.
+//
+// Usage:
+//   validation_suite [-j <threads>] [-b <batch size>] [-w]
+//                    <suite.json> [case ...]
+//
+// A case argument selects all cases whose name starts with it (for example,
+// "Revolute" selects all revolute joint cases). Without case arguments, all
+// cases in the suite file are run.
+//
+// The outputs of each case are recorded in memory at every step and validated
+// against the reference data without going through text files. With -w, they
+// are also written to ../RESULTS/<joint>/ (after the simulation, outside of
+// the timed region).
+//
+// With a batch size larger than 1, up to that many cases with the same step
+// size, simulation length, and solver settings are simulated together in a
+// single system (as disjoint subsystems), which amortizes the per-step
+// overhead of the system over several small cases. The outputs of each case
+// are still recorded and validated separately; the execution time of a batch
+// is split evenly among its cases.
+//
+// =============================================================================
+
+#include <ostream>
+#include <sstream>
+#include <cstdlib>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "core/ChTimer.h"
+
+#include "ChronoValidation_config.h"
+#include "utils/ChUtilsValidation.h"
+#include "utils/ChUtilsTrace.h"
+
+#include "BaseTest.h"
+#include "JointSuite.h"
+
+using namespace chrono;
+
+
+// =============================================================================
+// Local variables
+//
+static const std::string val_dir = "../RESULTS/";
+
+// =============================================================================
+
+class validation_suite : public BaseTest
+{
+public:
+  validation_suite(const std::string&              suiteFile,
+                   const std::vector<std::string>& selection,
+                   int                             numThreads,
+                   int                             batchSize,
+                   bool                            writeOutputs)
+  : BaseTest("validation_suite", "Chrono::Validation"),
+    m_suiteFile(suiteFile),
+    m_selection(selection),
+    m_numThreads(numThreads),
+    m_batchSize(batchSize),
+    m_writeOutputs(writeOutputs),
+    m_execTime(-1)
+  {}
+  ~validation_suite() {}
+
+  virtual bool execute();
+  virtual double getExecutionTime() const { return m_execTime; }
+
+private:
+  std::string              m_suiteFile;
+  std::vector<std::string> m_selection;
+  int                      m_numThreads;
+  int                      m_batchSize;
+  bool                     m_writeOutputs;
+  double                   m_execTime;
+};
+
+// =============================================================================
+//
+// Run and validate the selected cases.
+//
+bool validation_suite::execute()
+{
+  ChTimer<double> full;
+  full.start();
+
+  // Set the path to the Chrono data folder
+  SetChronoDataPath(CHRONO_DATA_DIR);
+
+  // Read the suite file and select the cases to run
+  std::vector<JointCase> cases;
+  if (!SelectJointCases(m_suiteFile, m_selection, cases))
+    return false;
+
+  // Create output directories (if they do not already exist)
+  if (m_writeOutputs) {
+    for (size_t i = 0; i < cases.size(); i++) {
+      if (!MakeOutputDirectory(val_dir + cases[i].GetDataDir()))
+        return false;
+    }
+  }
+
+  // Load all reference data once
+  JointReferenceData refs;
+  refs.Load(cases);
+
+  // Group the cases in batches (of one case each, unless batching is enabled)
+  std::vector<std::vector<int> > batches;
+  for (int i = 0; i < (int)cases.size(); i++) {
+    size_t b = 0;
+    for (; b < batches.size(); b++) {
+      if ((int)batches[b].size() < m_batchSize && CanBatchJointCases(cases[batches[b][0]], cases[i]))
+        break;
+    }
+    if (b == batches.size())
+      batches.push_back(std::vector<int>());
+    batches[b].push_back(i);
+  }
+
+  if (m_batchSize > 1)
+    std::cout << "Simulating in " << batches.size() << " batches" << std::endl;
+
+  // Run the batches on the thread pool
+  std::vector<JointCaseResult> results(cases.size());
+
+#ifdef _OPENMP
+  if (m_numThreads > 0)
+    omp_set_num_threads(m_numThreads);
+#endif
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int b = 0; b < (int)batches.size(); b++) {
+    utils::ChTrace::SetWorkerThreadName();
+
+    const std::vector<int>& batch = batches[b];
+    std::vector<JointCase> batch_cases;
+    for (size_t k = 0; k < batch.size(); k++)
+      batch_cases.push_back(cases[batch[k]]);
+    std::ostringstream log;
+
+    utils::ChTraceSpan caseSpan(batch_cases[0].name, "case");
+
+    JointSimulationStats stats;
+    std::vector<JointOutputs> outputs;
+    bool simulated = SimulateJointCases(batch_cases, outputs, stats);
+
+    for (size_t k = 0; k < batch.size(); k++) {
+      const JointCase& c = batch_cases[k];
+      JointCaseResult& result = results[batch[k]];
+      log << "TEST: " << c.name << std::endl;
+      if (simulated) {
+        ValidateJointCase(c, outputs[k], refs, result, log);
+        if (m_writeOutputs)
+          WriteJointOutputs(c, outputs[k], val_dir + c.GetDataDir());
+      } else {
+        log << "   simulation failed" << std::endl;
+        result.name = c.name;
+        result.passed = false;
+      }
+      result.exec_time = stats.exec_time / batch.size();
+    }
+
+    caseSpan.End();
+
+#pragma omp critical(validation_suite_log)
+    std::cout << log.str();
+  }
+
+  // Collect metrics (in case order)
+  bool test_passed = true;
+  int  num_failed = 0;
+
+  for (size_t i = 0; i < results.size(); i++) {
+    const JointCaseResult& r = results[i];
+    addMetric(r.name + "_ExecTime", r.exec_time);
+    for (size_t j = 0; j < r.norms.size(); j++)
+      addMetric(r.name + "_" + r.norms[j].first + "_RMSmax", r.norms[j].second);
+    test_passed &= r.passed;
+    if (!r.passed)
+      num_failed++;
+  }
+
+  addMetric("num_cases", (int)results.size());
+  addMetric("num_failed", num_failed);
+  addMetric("num_batches", (int)batches.size());
+
+  full.stop();
+  m_execTime = full();
+  std::cout << "Full Execution Time = " << m_execTime << std::endl;
+  if (num_failed > 0)
+    std::cout << num_failed << " of " << results.size() << " cases failed" << std::endl;
+
+  return test_passed;
+}
+
+int main(int argc, char* argv[])
+{
+  std::string suite_file;
+  std::vector<std::string> selection;
+  int num_threads = 0;
+  int batch_size = 1;
+  bool write_outputs = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc)
+      num_threads = atoi(argv[++i]);
+    else if (arg == "-b" && i + 1 < argc)
+      batch_size = atoi(argv[++i]);
+    else if (arg == "-w")
+      write_outputs = true;
+    else if (suite_file.empty())
+      suite_file = arg;
+    else
+      selection.push_back(arg);
+  }
+
+  if (suite_file.empty() || batch_size < 1) {
+    std::cout << "Usage: " << argv[0] << " [-j <threads>] [-b <batch size>] [-w] <suite.json> [case ...]" << std::endl;
+    return 1;
+  }
+
+  validation_suite t(suite_file, selection, num_threads, batch_size, write_outputs);
+  t.setArguments(argc, argv);
+  t.print();  // optional
+
+  /* Run and time test */
+  t.run();
+
+  // Return 0 if all tests passed and 1 otherwise
+  return !t.m_passed;
+}
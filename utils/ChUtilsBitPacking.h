@@ -0,0 +1,241 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Integer coding helpers shared by the compact binary formats (snapshot
+// streams, packed reference data): zigzag coding of signed integers, varints,
+// little-endian fixed-size integers, and bit packing of unsigned integers in
+// blocks of 128 values, each block prefixed with its bit width (one byte).
+//
+// These are internal helpers (inline, not exported from the library).
+//
+// =============================================================================
+
+#ifndef CH_UTILS_BIT_PACKING_H
+#define CH_UTILS_BIT_PACKING_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <stdint.h>
+
+
+namespace chrono {
+namespace utils {
+
+/// Number of values per bit-packed block.
+static const int bitpack_block_size = 128;
+
+inline uint64_t ZigZag(int64_t v)
+{
+  return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+inline int64_t UnZigZag(uint64_t u)
+{
+  return (int64_t)((u >> 1) ^ (~(u & 1) + 1));
+}
+
+/// Number of bits needed to represent v.
+inline int BitWidth(uint64_t v)
+{
+  int w = 0;
+  while (w < 64 && (v >> w) != 0)
+    w++;
+  return w;
+}
+
+inline void PutFixed(std::vector<uint8_t>& buf, uint64_t v, int num_bytes)
+{
+  for (int i = 0; i < num_bytes; i++)
+    buf.push_back((uint8_t)(v >> (8 * i)));
+}
+
+inline void PutVarint(std::vector<uint8_t>& buf, uint64_t v)
+{
+  while (v >= 0x80) {
+    buf.push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  buf.push_back((uint8_t)v);
+}
+
+inline void PutString(std::vector<uint8_t>& buf, const std::string& str)
+{
+  PutVarint(buf, str.size());
+  buf.insert(buf.end(), str.begin(), str.end());
+}
+
+inline uint64_t DoubleBits(double d)
+{
+  uint64_t u;
+  memcpy(&u, &d, sizeof(u));
+  return u;
+}
+
+inline double BitsDouble(uint64_t u)
+{
+  double d;
+  memcpy(&d, &u, sizeof(d));
+  return d;
+}
+
+/// Append the given values, bit-packed in blocks.
+inline void PutBlocks(std::vector<uint8_t>& buf, const uint64_t* values, size_t n)
+{
+  for (size_t start = 0; start < n; start += bitpack_block_size) {
+    size_t end = std::min(n, start + bitpack_block_size);
+
+    uint64_t all = 0;
+    for (size_t i = start; i < end; i++)
+      all |= values[i];
+    int width = BitWidth(all);
+    buf.push_back((uint8_t)width);
+    if (width == 0)
+      continue;
+
+    uint64_t acc = 0;
+    int      num_bits = 0;
+    for (size_t i = start; i < end; i++) {
+      uint64_t v = values[i];
+      int      w = width;
+      while (w > 0) {
+        int k = std::min(w, 32);
+        acc |= (v & ((1ULL << k) - 1)) << num_bits;
+        num_bits += k;
+        v >>= k;
+        w -= k;
+        while (num_bits >= 8) {
+          buf.push_back((uint8_t)acc);
+          acc >>= 8;
+          num_bits -= 8;
+        }
+      }
+    }
+    if (num_bits > 0)
+      buf.push_back((uint8_t)acc);
+  }
+}
+
+///
+/// Sequential reader of a buffer written with the functions above, with
+/// bounds checking (on error, 'ok' is set to false and zeros are returned).
+///
+struct ByteReader {
+  ByteReader(const uint8_t* data, size_t size) : p(data), end(data + size), ok(true) {}
+
+  uint8_t Byte()
+  {
+    if (p >= end) {
+      ok = false;
+      return 0;
+    }
+    return *p++;
+  }
+
+  uint64_t Fixed(int num_bytes)
+  {
+    uint64_t v = 0;
+    for (int i = 0; i < num_bytes; i++)
+      v |= (uint64_t)Byte() << (8 * i);
+    return v;
+  }
+
+  uint64_t Varint()
+  {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t b = Byte();
+      v |= (uint64_t)(b & 0x7F) << shift;
+      if (!(b & 0x80))
+        return v;
+    }
+    ok = false;
+    return 0;
+  }
+
+  std::string String()
+  {
+    size_t len = (size_t)Varint();
+    if (!ok || len > (size_t)(end - p)) {
+      ok = false;
+      return std::string();
+    }
+    std::string str((const char*)p, len);
+    p += len;
+    return str;
+  }
+
+  /// Read n values bit-packed in blocks.
+  void Blocks(uint64_t* values, size_t n)
+  {
+    for (size_t start = 0; start < n && ok; start += bitpack_block_size) {
+      size_t count = std::min(n - start, (size_t)bitpack_block_size);
+      int    width = Byte();
+      size_t num_bytes = (count * width + 7) / 8;
+      if (width > 64 || num_bytes > (size_t)(end - p)) {
+        ok = false;
+        return;
+      }
+
+      uint64_t* out = values + start;
+      if (width == 0) {
+        std::fill(out, out + count, (uint64_t)0);
+      } else if (width <= 56 && num_bytes + 8 <= (size_t)(end - p)) {
+        // Fast path: one unaligned 64-bit load per value (little-endian hosts).
+        uint64_t mask = (1ULL << width) - 1;
+        for (size_t i = 0; i < count; i++) {
+          size_t   bit = i * width;
+          uint64_t word;
+          memcpy(&word, p + (bit >> 3), sizeof(word));
+          out[i] = (word >> (bit & 7)) & mask;
+        }
+      } else {
+        uint64_t acc = 0;
+        int      num_bits = 0;
+        const uint8_t* q = p;
+        for (size_t i = 0; i < count; i++) {
+          uint64_t v = 0;
+          int      shift = 0;
+          int      w = width;
+          while (w > 0) {
+            int k = std::min(w, 32);
+            while (num_bits < k) {
+              acc |= (uint64_t)(*q++) << num_bits;
+              num_bits += 8;
+            }
+            v |= (acc & ((1ULL << k) - 1)) << shift;
+            acc >>= k;
+            num_bits -= k;
+            shift += k;
+            w -= k;
+          }
+          out[i] = v;
+        }
+      }
+      p += num_bytes;
+    }
+  }
+
+  const uint8_t* p;
+  const uint8_t* end;
+  bool           ok;
+};
+
+
+} // namespace utils
+} // namespace chrono
+
+
+#endif
@@ -18,6 +18,10 @@
 // =============================================================================
 
 
+#include <cfloat>
+#include <algorithm>
+#include <stdint.h>
+
 #include "utils/ChUtilsCreators.h"
 
 namespace chrono {
@@ -68,5 +72,518 @@ void CreateBoxContainer(ChSystem*                           system,
 }
 
 
+// -----------------------------------------------------------------------------
+// ChBodyTemplate
+//
+// The template keeps a prototype body (never added to a system) which owns the
+// collision shapes and the assets. Bodies created from the template copy the
+// prototype collision model, which shares its shapes, and reference the same
+// asset objects.
+// -----------------------------------------------------------------------------
+ChBodyTemplate::ChBodyTemplate(ChSharedPtr<ChMaterialSurfaceBase> mat)
+: m_mat(mat),
+  m_built(false),
+  m_bradius(0),
+  m_mass(1),
+  m_inertiaXX(1, 1, 1),
+  m_inertiaXY(0, 0, 0),
+  m_collide(true)
+{
+  m_contactMethod = mat.IsType<ChMaterialSurface>() ? ChBody::DVI : ChBody::DEM;
+  m_proto = ChSharedPtr<ChBody>(new ChBody(m_contactMethod));
+  m_proto->GetCollisionModel()->ClearModel();
+}
+
+void ChBodyTemplate::AddShape(collision::ShapeType  type,
+                              const ChVector<>&     dims,
+                              const ChVector<>&     pos,
+                              const ChQuaternion<>& rot)
+{
+  m_shapes.Add(type, dims, 1.0, pos, rot);
+
+  MassArrays props;
+  CalcCompositeMassProperties(m_shapes, std::vector<int>(m_shapes.Size(), 0), 1, props);
+  m_bradius = props.bradius[0];
+}
+
+void ChBodyTemplate::AddSphere(double radius, const ChVector<>& pos, const ChQuaternion<>& rot)
+{
+  AddSphereGeometry(m_proto.get_ptr(), radius, pos, rot);
+  AddShape(collision::SPHERE, ChVector<>(radius, radius, radius), pos, rot);
+}
+
+void ChBodyTemplate::AddEllipsoid(const ChVector<>& size, const ChVector<>& pos, const ChQuaternion<>& rot)
+{
+  AddEllipsoidGeometry(m_proto.get_ptr(), size, pos, rot);
+  AddShape(collision::ELLIPSOID, size, pos, rot);
+}
+
+void ChBodyTemplate::AddBox(const ChVector<>& size, const ChVector<>& pos, const ChQuaternion<>& rot)
+{
+  AddBoxGeometry(m_proto.get_ptr(), size, pos, rot);
+  AddShape(collision::BOX, size, pos, rot);
+}
+
+void ChBodyTemplate::AddCapsule(double radius, double hlen, const ChVector<>& pos, const ChQuaternion<>& rot)
+{
+  AddCapsuleGeometry(m_proto.get_ptr(), radius, hlen, pos, rot);
+  AddShape(collision::CAPSULE, ChVector<>(radius, hlen, radius), pos, rot);
+}
+
+void ChBodyTemplate::AddCylinder(double radius, double hlen, const ChVector<>& pos, const ChQuaternion<>& rot)
+{
+  AddCylinderGeometry(m_proto.get_ptr(), radius, hlen, pos, rot);
+  AddShape(collision::CYLINDER, ChVector<>(radius, hlen, radius), pos, rot);
+}
+
+void ChBodyTemplate::SetDensity(double density)
+{
+  MassArrays props;
+  CalcCompositeMassProperties(m_shapes, std::vector<int>(m_shapes.Size(), 0), 1, props);
+
+  m_mass = density * props.mass[0];
+  m_inertiaXX = ChVector<>(props.Ixx[0], props.Iyy[0], props.Izz[0]) * density;
+  m_inertiaXY = ChVector<>(props.Ixy[0], props.Ixz[0], props.Iyz[0]) * density;
+}
+
+ChSharedPtr<ChBody> ChBodyTemplate::CreateBody(int                   id,
+                                               const ChVector<>&     pos,
+                                               const ChQuaternion<>& rot)
+{
+  // Build the prototype collision model once, before the first copy.
+  if (!m_built) {
+    m_proto->GetCollisionModel()->BuildModel();
+    m_built = true;
+  }
+
+  ChSharedPtr<ChBody> body(new ChBody(m_contactMethod));
+
+  body->SetMaterialSurface(m_mat);
+
+  body->SetIdentifier(id);
+  body->SetMass(m_mass);
+  body->SetInertiaXX(m_inertiaXX);
+  body->SetInertiaXY(m_inertiaXY);
+  body->SetPos(pos);
+  body->SetRot(rot);
+  body->SetCollide(m_collide);
+
+  // Share the collision shapes and the assets of the prototype.
+  body->GetCollisionModel()->ClearModel();
+  body->GetCollisionModel()->AddCopyOfAnotherModel(m_proto->GetCollisionModel());
+  body->GetCollisionModel()->BuildModel();
+
+  const std::vector<ChSharedPtr<ChAsset> >& assets = m_proto->GetAssets();
+  body->GetAssets().assign(assets.begin(), assets.end());
+
+  return body;
+}
+
+void ChBodyTemplate::CreateBodies(ChSystem*                          system,
+                                  int                                first_id,
+                                  const std::vector<ChVector<> >&    pos,
+                                  const ChQuaternion<>&              rot,
+                                  std::vector<ChSharedPtr<ChBody> >* bodies)
+{
+  if (bodies)
+    bodies->reserve(bodies->size() + pos.size());
+
+  for (size_t i = 0; i < pos.size(); i++) {
+    ChSharedPtr<ChBody> body = CreateBody(first_id + (int)i, pos[i], rot);
+    system->AddBody(body);
+    if (bodies)
+      bodies->push_back(body);
+  }
+}
+
+
+// -----------------------------------------------------------------------------
+// Particle generation: random numbers and spatial hash grid
+// -----------------------------------------------------------------------------
+
+// Random number generator (SplitMix64), so that the generated particles depend
+// only on the seed.
+class GeneratorRandom
+{
+public:
+  GeneratorRandom(uint64_t seed) : m_state(seed) {}
+
+  // Uniform in [0, 1)
+  double Uniform()
+  {
+    uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return ((z ^ (z >> 31)) >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+private:
+  uint64_t m_state;
+};
+
+// Spatial hash grid of points in a box: each point is inserted in the bucket of
+// its cell, with cells hashed to their linear index in the box (a perfect hash,
+// which keeps neighboring cells close in memory). Buckets are singly-linked
+// lists stored in two index arrays, so there is no allocation per point.
+class SpatialHash
+{
+public:
+  SpatialHash(const ChVector<>& lo, const ChVector<>& hi, double cell, size_t capacity)
+  : m_lo(lo), m_invCell(1 / cell)
+  {
+    m_nx = (int)std::floor((hi.x - lo.x) * m_invCell) + 1;
+    m_ny = (int)std::floor((hi.y - lo.y) * m_invCell) + 1;
+    m_nz = (int)std::floor((hi.z - lo.z) * m_invCell) + 1;
+    m_head.assign((size_t)m_nx * m_ny * m_nz, -1);
+    m_next.reserve(capacity);
+  }
+
+  // Insert the point with the given index (indices must be inserted in order).
+  void Insert(int index, const ChVector<>& p)
+  {
+    size_t h = Hash(Cell(p.x - m_lo.x, m_nx), Cell(p.y - m_lo.y, m_ny), Cell(p.z - m_lo.z, m_nz));
+    m_next.push_back(m_head[h]);
+    m_head[h] = index;
+  }
+
+  // Return true if a point of 'points' is closer to 'p' than 'dist' (plus its
+  // own radius, if 'radii' is not NULL, with 'max_radius' the largest radius).
+  // Only the neighboring cells within reach are searched; the reach must not
+  // exceed the cell size.
+  bool Overlaps(const ChVector<>&               p,
+                double                          dist,
+                double                          max_radius,
+                const std::vector<ChVector<> >& points,
+                const std::vector<double>*      radii) const
+  {
+    int ix = Cell(p.x - m_lo.x, m_nx);
+    int iy = Cell(p.y - m_lo.y, m_ny);
+    int iz = Cell(p.z - m_lo.z, m_nz);
+
+    // Squared distances from p to the lower, own, and upper neighbor cells
+    double reach2 = (dist + max_radius) * (dist + max_radius);
+    double ox[3], oy[3], oz[3];
+    CellOffsets(p.x - m_lo.x, ix, ox);
+    CellOffsets(p.y - m_lo.y, iy, oy);
+    CellOffsets(p.z - m_lo.z, iz, oz);
+
+    for (int k = std::max(iz - 1, 0); k <= std::min(iz + 1, m_nz - 1); k++) {
+      for (int j = std::max(iy - 1, 0); j <= std::min(iy + 1, m_ny - 1); j++) {
+        double dyz = oz[k - iz + 1] + oy[j - iy + 1];
+        if (dyz >= reach2)
+          continue;
+        for (int i = std::max(ix - 1, 0); i <= std::min(ix + 1, m_nx - 1); i++) {
+          if (dyz + ox[i - ix + 1] >= reach2)
+            continue;
+          for (int q = m_head[Hash(i, j, k)]; q >= 0; q = m_next[q]) {
+            double d = dist + (radii ? (*radii)[q] : 0);
+            if ((points[q] - p).Length2() < d * d)
+              return true;
+          }
+        }
+      }
+    }
+
+    return false;
+  }
+
+private:
+  int Cell(double x, int n) const
+  {
+    int i = (int)std::floor(x * m_invCell);
+    return std::min(std::max(i, 0), n - 1);
+  }
+
+  size_t Hash(int i, int j, int k) const { return ((size_t)k * m_ny + j) * m_nx + i; }
+
+  // Squared distances from coordinate x (in cell i) to cells i-1, i, i+1
+  void CellOffsets(double x, int i, double* o) const
+  {
+    double cell = 1 / m_invCell;
+    double below = x - i * cell;
+    double above = (i + 1) * cell - x;
+    o[0] = below * below;
+    o[1] = 0;
+    o[2] = above * above;
+  }
+
+  ChVector<>       m_lo;
+  double           m_invCell;
+  int              m_nx, m_ny, m_nz;
+  std::vector<int> m_head;
+  std::vector<int> m_next;
+};
+
+// -----------------------------------------------------------------------------
+// SampleBox
+// -----------------------------------------------------------------------------
+
+// Bridson's algorithm: new samples are drawn in the spherical shell
+// [sep, 2*sep] around an active sample, and accepted if at least 'sep' away
+// from all samples; an active sample is retired after 'max_attempts' failed
+// draws.
+static void SamplePoissonDisk(double                    sep,
+                              const ChVector<>&         center,
+                              const ChVector<>&         hdims,
+                              std::vector<ChVector<> >& points,
+                              unsigned int              seed)
+{
+  static const int max_attempts = 30;
+
+  ChVector<> lo = center - hdims;
+  size_t capacity = (size_t)(8 * hdims.x * hdims.y * hdims.z / (sep * sep * sep)) + 1;
+
+  GeneratorRandom rng(seed);
+  SpatialHash hash(lo, center + hdims, sep, capacity);
+  std::vector<int> active;
+
+  ChVector<> p0(lo.x + 2 * hdims.x * rng.Uniform(),
+                lo.y + 2 * hdims.y * rng.Uniform(),
+                lo.z + 2 * hdims.z * rng.Uniform());
+  hash.Insert(0, p0);
+  points.push_back(p0);
+  active.push_back(0);
+
+  while (!active.empty()) {
+    // Grow from the most recent active sample, so that consecutive samples
+    // (and their hash cells) are close in memory.
+    size_t a = active.size() - 1;
+    ChVector<> p = points[active[a]];
+    bool found = false;
+
+    for (int t = 0; t < max_attempts && !found; t++) {
+      // Uniform direction, and radius uniform in the volume of the shell
+      double z = 2 * rng.Uniform() - 1;
+      double phi = 2 * CH_C_PI * rng.Uniform();
+      double rxy = std::sqrt(1 - z * z);
+      double r = sep * std::pow(1 + 7 * rng.Uniform(), 1.0 / 3.0);
+      ChVector<> q = p + ChVector<>(rxy * std::cos(phi), rxy * std::sin(phi), z) * r;
+
+      if (std::abs(q.x - center.x) > hdims.x || std::abs(q.y - center.y) > hdims.y ||
+          std::abs(q.z - center.z) > hdims.z)
+        continue;
+      if (hash.Overlaps(q, sep, 0, points, NULL))
+        continue;
+
+      hash.Insert((int)points.size(), q);
+      active.push_back((int)points.size());
+      points.push_back(q);
+      found = true;
+    }
+
+    if (!found)
+      active.pop_back();
+  }
+}
+
+void SampleBox(SamplingType               type,
+               double                     sep,
+               const ChVector<>&          center,
+               const ChVector<>&          hdims,
+               std::vector<ChVector<> >&  points,
+               unsigned int               seed)
+{
+  points.clear();
+  if (sep <= 0 || hdims.x < 0 || hdims.y < 0 || hdims.z < 0)
+    return;
+
+  if (type == POISSON_DISK) {
+    SamplePoissonDisk(sep, center, hdims, points, seed);
+    return;
+  }
+
+  // Lattices: spacing along X, between rows (Y), and between layers (Z). In a
+  // hexagonal close packing, every other row is shifted by half a spacing, and
+  // every other layer is shifted over the holes of the layer below it.
+  double dx = sep;
+  double dy = (type == HCP_PACK) ? sep * std::sqrt(3.0) / 2 : sep;
+  double dz = (type == HCP_PACK) ? sep * std::sqrt(2.0 / 3.0) : sep;
+
+  int nx = (int)std::floor(2 * hdims.x / dx + 1e-9) + 1;
+  int ny = (int)std::floor(2 * hdims.y / dy + 1e-9) + 1;
+  int nz = (int)std::floor(2 * hdims.z / dz + 1e-9) + 1;
+
+  ChVector<> lo = center - hdims;
+  ChVector<> hi = center + hdims;
+  points.reserve((size_t)nx * ny * nz);
+
+  for (int k = 0; k < nz; k++) {
+    double z = lo.z + k * dz;
+    for (int j = 0; j < ny; j++) {
+      double y = lo.y + j * dy;
+      double x0 = lo.x;
+      if (type == HCP_PACK) {
+        y += (k % 2) * dy / 3;
+        x0 += ((j + k) % 2) * dx / 2;
+      }
+      if (y > hi.y + 1e-9 * dy)
+        continue;
+      for (int i = 0; i < nx; i++) {
+        double x = x0 + i * dx;
+        if (x > hi.x + 1e-9 * dx)
+          break;
+        points.push_back(ChVector<>(x, y, z));
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// ChParticleGenerator
+// -----------------------------------------------------------------------------
+ChParticleGenerator::ChParticleGenerator()
+: m_seed(1),
+  m_curve(CURVE_NONE),
+  m_numCandidates(0)
+{
+}
+
+void ChParticleGenerator::AddTemplate(ChBodyTemplate* tmpl, double ratio)
+{
+  m_templates.push_back(tmpl);
+  m_ratios.push_back(ratio);
+}
+
+int ChParticleGenerator::GenerateBox(SamplingType               type,
+                                     double                     sep,
+                                     const ChVector<>&          center,
+                                     const ChVector<>&          hdims,
+                                     std::vector<ChVector<> >&  pos,
+                                     std::vector<int>&          types)
+{
+  pos.clear();
+  types.clear();
+  m_numCandidates = 0;
+
+  // Bounding radii and cumulative frequencies of the particle types
+  int num_types = (int)m_templates.size();
+  std::vector<double> radius(num_types);
+  std::vector<double> cumulative(num_types);
+  double rmin = DBL_MAX;
+  double rmax = 0;
+  double total = 0;
+  for (int t = 0; t < num_types; t++) {
+    radius[t] = m_templates[t]->GetBoundingRadius();
+    rmin = std::min(rmin, radius[t]);
+    rmax = std::max(rmax, radius[t]);
+    total += std::max(m_ratios[t], 0.0);
+    cumulative[t] = total;
+  }
+  if (num_types == 0 || rmax <= 0 || total <= 0)
+    return 0;
+
+  if (sep <= 0)
+    sep = 2 * rmax;
+
+  // Sample the candidates in the region reachable by the smallest particles.
+  ChVector<> inner = hdims - ChVector<>(rmin, rmin, rmin);
+  std::vector<ChVector<> > candidates;
+  SampleBox(type, sep, center, inner, candidates, m_seed);
+  m_numCandidates = (int)candidates.size();
+
+  // Overlaps are only possible if the candidates are closer than the largest
+  // bounding diameter.
+  bool check_overlaps = (sep < 2 * rmax);
+  SpatialHash hash(center - hdims, center + hdims, check_overlaps ? 2 * rmax : 2 * std::max(hdims.x, std::max(hdims.y, hdims.z)) + 1,
+                   check_overlaps ? candidates.size() : 0);
+  std::vector<double> radii;
+
+  GeneratorRandom rng(((uint64_t)m_seed << 32) ^ 0x5DEECE66DULL);
+  pos.reserve(candidates.size());
+  types.reserve(candidates.size());
+  if (check_overlaps)
+    radii.reserve(candidates.size());
+
+  for (size_t i = 0; i < candidates.size(); i++) {
+    const ChVector<>& p = candidates[i];
+
+    double u = total * rng.Uniform();
+    int t = (int)(std::upper_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin());
+    t = std::min(t, num_types - 1);
+    double r = radius[t];
+
+    if (std::abs(p.x - center.x) + r > hdims.x || std::abs(p.y - center.y) + r > hdims.y ||
+        std::abs(p.z - center.z) + r > hdims.z)
+      continue;
+
+    if (check_overlaps) {
+      if (hash.Overlaps(p, r, rmax, pos, &radii))
+        continue;
+      hash.Insert((int)pos.size(), p);
+      radii.push_back(r);
+    }
+
+    pos.push_back(p);
+    types.push_back(t);
+  }
+
+  // Reorder the particles along the space-filling curve.
+  if (m_curve != CURVE_NONE) {
+    std::vector<int> order;
+    SortAlongCurve(pos, m_curve, order);
+
+    std::vector<ChVector<> > sorted_pos(pos.size());
+    std::vector<int>         sorted_types(types.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      sorted_pos[i] = pos[order[i]];
+      sorted_types[i] = types[order[i]];
+    }
+    pos.swap(sorted_pos);
+    types.swap(sorted_types);
+  }
+
+  return (int)pos.size();
+}
+
+int ChParticleGenerator::CreateObjectsBox(ChSystem*          system,
+                                          int                first_id,
+                                          SamplingType       type,
+                                          double             sep,
+                                          const ChVector<>&  center,
+                                          const ChVector<>&  hdims)
+{
+  std::vector<ChVector<> > pos;
+  std::vector<int>         types;
+  GenerateBox(type, sep, center, hdims, pos, types);
+
+  // Keep the ordering along the curve, creating the particles one at a time
+  if (m_curve != CURVE_NONE) {
+    for (size_t i = 0; i < pos.size(); i++)
+      system->AddBody(m_templates[types[i]]->CreateBody(first_id + (int)i, pos[i]));
+    return (int)pos.size();
+  }
+
+  // Create the particles of each type in one batch
+  int id = first_id;
+  for (size_t t = 0; t < m_templates.size(); t++) {
+    std::vector<ChVector<> > batch;
+    for (size_t i = 0; i < pos.size(); i++) {
+      if (types[i] == (int)t)
+        batch.push_back(pos[i]);
+    }
+    m_templates[t]->CreateBodies(system, id, batch);
+    id += (int)batch.size();
+  }
+
+  return id - first_id;
+}
+
+int ChParticleGenerator::FillBoxContainer(ChSystem*          system,
+                                          int                first_id,
+                                          SamplingType       type,
+                                          double             sep,
+                                          const ChVector<>&  hdim,
+                                          double             height,
+                                          const ChVector<>&  pos)
+{
+  // The inside of the container spans [-hdim.x, hdim.x] x [-hdim.y, hdim.y]
+  // horizontally, above its floor at the container position.
+  ChVector<> center = pos + ChVector<>(0, 0, 0.5 * height);
+  ChVector<> hdims(hdim.x, hdim.y, 0.5 * height);
+
+  return CreateObjectsBox(system, first_id, type, sep, center, hdims);
+}
+
+
 }  // namespace utils
 }  // namespace chrono
\ No newline at end of file
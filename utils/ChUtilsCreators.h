@@ -47,6 +47,7 @@
 #include "assets/ChRoundedCylinderShape.h"
 
 #include "utils/ChApiUtils.h"
+#include "utils/ChUtilsGeometry.h"
 
 namespace chrono {
 namespace utils {
@@ -247,6 +248,197 @@ void CreateBoxContainer(ChSystem*                           system,
                         bool                                collide = true);
 
 
+// -----------------------------------------------------------------------------
+// ChBodyTemplate
+//
+// Description of a body (contact and asset geometry, contact material, mass
+// properties) from which any number of identical bodies can be created. All
+// bodies created from a template share its collision shapes, visual assets,
+// and contact material by reference; each body only owns its state (pose and
+// velocities) and its collision model object. This avoids one allocation of
+// every shape and asset per body when creating large numbers of identical
+// bodies (e.g. the grains of a granular material).
+//
+// Shapes are added with the same conventions as the Add*Geometry functions.
+// The shared shapes and assets must not be modified once bodies have been
+// created from the template.
+// -----------------------------------------------------------------------------
+class CH_UTILS_API ChBodyTemplate
+{
+public:
+  /// Create an empty template with the given contact material. The contact
+  /// method of the bodies (DVI or DEM) is inferred from the material type.
+  ChBodyTemplate(ChSharedPtr<ChMaterialSurfaceBase> mat);
+  ~ChBodyTemplate() {}
+
+  /// Add contact and asset geometry shapes.
+  void AddSphere(double                radius,
+                 const ChVector<>&     pos = ChVector<>(0,0,0),
+                 const ChQuaternion<>& rot = ChQuaternion<>(1,0,0,0));
+  void AddEllipsoid(const ChVector<>&     size,
+                    const ChVector<>&     pos = ChVector<>(0,0,0),
+                    const ChQuaternion<>& rot = ChQuaternion<>(1,0,0,0));
+  void AddBox(const ChVector<>&     size,
+              const ChVector<>&     pos = ChVector<>(0,0,0),
+              const ChQuaternion<>& rot = ChQuaternion<>(1,0,0,0));
+  void AddCapsule(double                radius,
+                  double                hlen,
+                  const ChVector<>&     pos = ChVector<>(0,0,0),
+                  const ChQuaternion<>& rot = ChQuaternion<>(1,0,0,0));
+  void AddCylinder(double                radius,
+                   double                hlen,
+                   const ChVector<>&     pos = ChVector<>(0,0,0),
+                   const ChQuaternion<>& rot = ChQuaternion<>(1,0,0,0));
+
+  /// Set the mass properties of the bodies explicitly.
+  void SetMass(double mass)                        { m_mass = mass; }
+  void SetInertiaXX(const ChVector<>& inertiaXX)   { m_inertiaXX = inertiaXX; }
+  void SetInertiaXY(const ChVector<>& inertiaXY)   { m_inertiaXY = inertiaXY; }
+
+  /// Set the mass properties of the bodies from the shapes added so far, for
+  /// the given uniform density. The inertia is taken about the centroid of the
+  /// shapes, which should be at the body origin.
+  void SetDensity(double density);
+
+  /// Enable or disable contact for the bodies (default: enabled).
+  void SetCollide(bool collide)                    { m_collide = collide; }
+
+  double            GetMass() const      { return m_mass; }
+  const ChVector<>& GetInertiaXX() const { return m_inertiaXX; }
+  const ChVector<>& GetInertiaXY() const { return m_inertiaXY; }
+
+  /// Return the radius of a sphere, centered at the body origin, that bounds
+  /// all shapes of the template.
+  double GetBoundingRadius() const       { return m_bradius; }
+
+  /// Create one body from this template, at rest at the specified pose. The
+  /// body is not added to any system.
+  ChSharedPtr<ChBody> CreateBody(int                   id,
+                                 const ChVector<>&     pos,
+                                 const ChQuaternion<>& rot = ChQuaternion<>(1,0,0,0));
+
+  /// Create bodies from this template at the specified positions (all with the
+  /// same orientation), with consecutive identifiers starting at 'first_id',
+  /// and add them to the given system. If 'bodies' is not NULL, the created
+  /// bodies are appended to it.
+  void CreateBodies(ChSystem*                             system,
+                    int                                   first_id,
+                    const std::vector<ChVector<> >&       pos,
+                    const ChQuaternion<>&                 rot = ChQuaternion<>(1,0,0,0),
+                    std::vector<ChSharedPtr<ChBody> >*    bodies = NULL);
+
+private:
+  void AddShape(collision::ShapeType type, const ChVector<>& dims,
+                const ChVector<>& pos, const ChQuaternion<>& rot);
+
+  ChSharedPtr<ChMaterialSurfaceBase> m_mat;
+  ChBody::ContactMethod              m_contactMethod;
+  ChSharedPtr<ChBody>                m_proto;      ///< owner of the shared shapes and assets
+  bool                               m_built;      ///< is the prototype collision model built?
+  ShapeArrays                        m_shapes;     ///< shapes, for the mass properties
+  double                             m_bradius;
+  double                             m_mass;
+  ChVector<>                         m_inertiaXX;
+  ChVector<>                         m_inertiaXY;
+  bool                               m_collide;
+};
+
+
+// -----------------------------------------------------------------------------
+// Particle generation
+//
+// Candidate particle positions are sampled in a box volume on a regular grid,
+// in a hexagonal close packing, or with a Poisson-disk distribution (Bridson's
+// algorithm: random positions at least a given distance apart). Candidates are
+// then assigned a particle type (body template) at random, with the specified
+// relative frequencies, and rejected if the bounding sphere of the particle
+// leaves the volume or overlaps the bounding sphere of an accepted particle.
+// Overlaps are detected with a spatial hash grid (cells of the size of the
+// largest bounding diameter), in time linear in the number of candidates.
+// Accepted particles are created in batches through their body templates.
+// -----------------------------------------------------------------------------
+enum SamplingType {
+  REGULAR_GRID,
+  HCP_PACK,
+  POISSON_DISK
+};
+
+/// Generate candidate positions in the box with the given center and half
+/// dimensions. Positions are 'sep' apart (at least 'sep' apart for
+/// POISSON_DISK, which uses the given seed).
+CH_UTILS_API
+void SampleBox(SamplingType               type,
+               double                     sep,
+               const ChVector<>&          center,
+               const ChVector<>&          hdims,
+               std::vector<ChVector<> >&  points,
+               unsigned int               seed = 1);
+
+class CH_UTILS_API ChParticleGenerator
+{
+public:
+  ChParticleGenerator();
+  ~ChParticleGenerator() {}
+
+  /// Add a particle type, created from the given template (not owned by the
+  /// generator) with the given relative frequency. A size distribution is
+  /// described by templates of different sizes.
+  void AddTemplate(ChBodyTemplate* tmpl, double ratio);
+
+  /// Set the seed of the random choices (particle types, Poisson-disk samples).
+  void SetSeed(unsigned int seed) { m_seed = seed; }
+
+  /// Order the generated particles along the given space-filling curve (by
+  /// default, CURVE_NONE, in sampling order). Bodies are then also created,
+  /// and added to the system, in this order.
+  void SetOrdering(SpaceFillingCurve curve) { m_curve = curve; }
+
+  /// Generate particles in the box with the given center and half dimensions,
+  /// from candidates with separation 'sep' (if not positive, twice the largest
+  /// bounding radius of the templates). Returns the number of particles; their
+  /// positions and template indices (in order of AddTemplate) are returned in
+  /// 'pos' and 'types'. No bodies are created.
+  int GenerateBox(SamplingType               type,
+                  double                     sep,
+                  const ChVector<>&          center,
+                  const ChVector<>&          hdims,
+                  std::vector<ChVector<> >&  pos,
+                  std::vector<int>&          types);
+
+  /// Generate particles in the given box and create them in the given system,
+  /// with consecutive identifiers starting at 'first_id'. Without ordering,
+  /// the particles of each type are created in one batch. Returns the number
+  /// of bodies created.
+  int CreateObjectsBox(ChSystem*          system,
+                       int                first_id,
+                       SamplingType       type,
+                       double             sep,
+                       const ChVector<>&  center,
+                       const ChVector<>&  hdims);
+
+  /// Fill the container created by CreateBoxContainer with the given half
+  /// dimensions and position (Z up) up to the specified height above its floor.
+  /// Returns the number of bodies created.
+  int FillBoxContainer(ChSystem*          system,
+                       int                first_id,
+                       SamplingType       type,
+                       double             sep,
+                       const ChVector<>&  hdim,
+                       double             height,
+                       const ChVector<>&  pos = ChVector<>(0,0,0));
+
+  /// Return the number of candidate positions sampled by the last call.
+  int GetNumCandidates() const { return m_numCandidates; }
+
+private:
+  std::vector<ChBodyTemplate*> m_templates;
+  std::vector<double>          m_ratios;
+  unsigned int                 m_seed;
+  SpaceFillingCurve            m_curve;
+  int                          m_numCandidates;
+};
+
+
 } // end namespace utils
 } // end namespace chrono
 
@@ -0,0 +1,445 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Batch calculation of the mass properties of shapes given as
+// structure-of-arrays.
+//
+// Also, the ordering of points along space-filling curves.
+//
+// Shapes are processed in chunks: a first (scalar) pass over a chunk selects
+// the volume and principal gyration radii per shape type; a second pass, free
+// of branches and with unit-stride accesses only, rotates and scales the
+// gyration tensors, and is vectorized by the compiler. Chunks are distributed
+// over the OpenMP threads.
+//
+// =============================================================================
+
+#include <algorithm>
+#include <cfloat>
+#include <stdint.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "utils/ChUtilsGeometry.h"
+
+// Request vectorization of a loop (OpenMP 4.0 and later); the loops below are
+// written so that compilers also vectorize them without this hint.
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+#define CH_UTILS_SIMD_LOOP _Pragma("omp simd")
+#else
+#define CH_UTILS_SIMD_LOOP
+#endif
+
+namespace chrono {
+namespace utils {
+
+// Number of shapes per chunk (the temporaries of a chunk fit in L1 cache)
+static const int chunk_size = 256;
+
+// -----------------------------------------------------------------------------
+// Structure-of-arrays containers
+// -----------------------------------------------------------------------------
+void ShapeArrays::Resize(size_t n)
+{
+  type.resize(n, collision::SPHERE);
+  dim_x.resize(n, 1.0);
+  dim_y.resize(n, 1.0);
+  dim_z.resize(n, 1.0);
+  density.resize(n, 1.0);
+  pos_x.resize(n, 0.0);
+  pos_y.resize(n, 0.0);
+  pos_z.resize(n, 0.0);
+  rot_e0.resize(n, 1.0);
+  rot_e1.resize(n, 0.0);
+  rot_e2.resize(n, 0.0);
+  rot_e3.resize(n, 0.0);
+}
+
+void ShapeArrays::Add(collision::ShapeType   shape_type,
+                      const ChVector<>&      dims,
+                      double                 shape_density,
+                      const ChVector<>&      pos,
+                      const ChQuaternion<>&  rot)
+{
+  type.push_back(shape_type);
+  dim_x.push_back(dims.x);
+  dim_y.push_back(dims.y);
+  dim_z.push_back(dims.z);
+  density.push_back(shape_density);
+  pos_x.push_back(pos.x);
+  pos_y.push_back(pos.y);
+  pos_z.push_back(pos.z);
+  rot_e0.push_back(rot.e0);
+  rot_e1.push_back(rot.e1);
+  rot_e2.push_back(rot.e2);
+  rot_e3.push_back(rot.e3);
+}
+
+void MassArrays::Resize(size_t n)
+{
+  volume.resize(n);
+  mass.resize(n);
+  bradius.resize(n);
+  com_x.resize(n);
+  com_y.resize(n);
+  com_z.resize(n);
+  Ixx.resize(n);
+  Iyy.resize(n);
+  Izz.resize(n);
+  Ixy.resize(n);
+  Ixz.resize(n);
+  Iyz.resize(n);
+}
+
+// -----------------------------------------------------------------------------
+// Volume, bounding radius, and principal gyration radii (squared) of a shape
+// in its own frame. Same formulas as the scalar Calc* functions.
+// -----------------------------------------------------------------------------
+static void CalcShapeProperties(int     type,
+                                double  dx,
+                                double  dy,
+                                double  dz,
+                                double& volume,
+                                double& bradius,
+                                double& gx,
+                                double& gy,
+                                double& gz)
+{
+  switch (type) {
+  case collision::SPHERE:
+    volume = CalcSphereVolume(dx);
+    bradius = CalcSphereBradius(dx);
+    gx = gy = gz = (2.0/5.0) * dx * dx;
+    return;
+  case collision::ELLIPSOID: {
+    ChVector<> hdims(dx, dy, dz);
+    volume = CalcEllipsoidVolume(hdims);
+    bradius = CalcEllipsoidBradius(hdims);
+    gx = (1.0/5.0) * (dy * dy + dz * dz);
+    gy = (1.0/5.0) * (dz * dz + dx * dx);
+    gz = (1.0/5.0) * (dx * dx + dy * dy);
+    return;
+  }
+  case collision::BOX: {
+    ChVector<> hdims(dx, dy, dz);
+    volume = CalcBoxVolume(hdims);
+    bradius = CalcBoxBradius(hdims);
+    gx = (1.0/3.0) * (dy * dy + dz * dz);
+    gy = (1.0/3.0) * (dz * dz + dx * dx);
+    gz = (1.0/3.0) * (dx * dx + dy * dy);
+    return;
+  }
+  case collision::CAPSULE: {
+    volume = CalcCapsuleVolume(dx, dy);
+    bradius = CalcCapsuleBradius(dx, dy);
+    double vc = 2 * dy;
+    double vs = (4.0/3.0) * dx;
+    gx = gz = (vc * (1.0/12.0) * (3 * dx * dx + 4 * dy * dy) +
+               vs * ((2.0/5.0) * dx * dx + dy * dy + (3.0/4.0) * dy * dx)) / (vc + vs);
+    gy = (vc * (1.0/2.0) * dx * dx + vs * (2.0/5.0) * dx * dx) / (vc + vs);
+    return;
+  }
+  case collision::CYLINDER:
+    volume = CalcCylinderVolume(dx, dy);
+    bradius = CalcCylinderBradius(dx, dy);
+    gx = gz = (1.0/12.0) * (3 * dx * dx + 4 * dy * dy);
+    gy = (1.0/2.0) * (dx * dx);
+    return;
+  default:
+    volume = bradius = gx = gy = gz = 0;
+    return;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Mass properties of the shapes [start, end) into 'props' (same indices).
+// -----------------------------------------------------------------------------
+static void CalcChunk(const ShapeArrays& shapes, MassArrays& props, int start, int end)
+{
+  int n = end - start;
+  double gx[chunk_size];
+  double gy[chunk_size];
+  double gz[chunk_size];
+
+  // Per-type pass: volume, mass, bounding radius, principal gyration radii
+  for (int k = 0; k < n; k++) {
+    int i = start + k;
+    double volume, bradius;
+    CalcShapeProperties(shapes.type[i], shapes.dim_x[i], shapes.dim_y[i], shapes.dim_z[i],
+                        volume, bradius, gx[k], gy[k], gz[k]);
+    props.volume[i] = volume;
+    props.mass[i] = volume * shapes.density[i];
+    props.bradius[i] = bradius;
+  }
+
+  // Branch-free pass: I = m * A * diag(g) * A^T, with A the rotation matrix of
+  // the shape orientation.
+  const double* e0 = &shapes.rot_e0[start];
+  const double* e1 = &shapes.rot_e1[start];
+  const double* e2 = &shapes.rot_e2[start];
+  const double* e3 = &shapes.rot_e3[start];
+  const double* px = &shapes.pos_x[start];
+  const double* py = &shapes.pos_y[start];
+  const double* pz = &shapes.pos_z[start];
+  const double* m = &props.mass[start];
+  double* cx = &props.com_x[start];
+  double* cy = &props.com_y[start];
+  double* cz = &props.com_z[start];
+  double* Ixx = &props.Ixx[start];
+  double* Iyy = &props.Iyy[start];
+  double* Izz = &props.Izz[start];
+  double* Ixy = &props.Ixy[start];
+  double* Ixz = &props.Ixz[start];
+  double* Iyz = &props.Iyz[start];
+
+  CH_UTILS_SIMD_LOOP
+  for (int k = 0; k < n; k++) {
+    double a00 = 2 * (e0[k] * e0[k] + e1[k] * e1[k]) - 1;
+    double a01 = 2 * (e1[k] * e2[k] - e0[k] * e3[k]);
+    double a02 = 2 * (e1[k] * e3[k] + e0[k] * e2[k]);
+    double a10 = 2 * (e1[k] * e2[k] + e0[k] * e3[k]);
+    double a11 = 2 * (e0[k] * e0[k] + e2[k] * e2[k]) - 1;
+    double a12 = 2 * (e2[k] * e3[k] - e0[k] * e1[k]);
+    double a20 = 2 * (e1[k] * e3[k] - e0[k] * e2[k]);
+    double a21 = 2 * (e2[k] * e3[k] + e0[k] * e1[k]);
+    double a22 = 2 * (e0[k] * e0[k] + e3[k] * e3[k]) - 1;
+
+    double mgx = m[k] * gx[k];
+    double mgy = m[k] * gy[k];
+    double mgz = m[k] * gz[k];
+
+    Ixx[k] = a00 * a00 * mgx + a01 * a01 * mgy + a02 * a02 * mgz;
+    Iyy[k] = a10 * a10 * mgx + a11 * a11 * mgy + a12 * a12 * mgz;
+    Izz[k] = a20 * a20 * mgx + a21 * a21 * mgy + a22 * a22 * mgz;
+    Ixy[k] = a00 * a10 * mgx + a01 * a11 * mgy + a02 * a12 * mgz;
+    Ixz[k] = a00 * a20 * mgx + a01 * a21 * mgy + a02 * a22 * mgz;
+    Iyz[k] = a10 * a20 * mgx + a11 * a21 * mgy + a12 * a22 * mgz;
+
+    cx[k] = px[k];
+    cy[k] = py[k];
+    cz[k] = pz[k];
+  }
+}
+
+// -----------------------------------------------------------------------------
+// CalcMassProperties
+// -----------------------------------------------------------------------------
+void CalcMassProperties(const ShapeArrays& shapes,
+                        MassArrays&        props)
+{
+  int num_shapes = (int)shapes.Size();
+  int num_chunks = (num_shapes + chunk_size - 1) / chunk_size;
+
+  props.Resize(num_shapes);
+
+#pragma omp parallel for schedule(static)
+  for (int c = 0; c < num_chunks; c++) {
+    int start = c * chunk_size;
+    int end = std::min(start + chunk_size, num_shapes);
+    CalcChunk(shapes, props, start, end);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// CalcCompositeMassProperties
+//
+// The centroidal inertia of each body is the sum of the centroidal inertias of
+// its shapes, shifted to the body centroid with the parallel axis theorem:
+//   I = sum_i (I_i + m_i * (|d_i|^2 * 1 - d_i * d_i^T)),  d_i = c_i - c
+// which is accumulated as sum_i (I_i + m_i * (|c_i|^2 * 1 - c_i * c_i^T)) minus
+// the same term for the total mass at the body centroid.
+// -----------------------------------------------------------------------------
+void CalcCompositeMassProperties(const ShapeArrays&      shapes,
+                                 const std::vector<int>& body,
+                                 int                     num_bodies,
+                                 MassArrays&             props)
+{
+  MassArrays parts;
+  CalcMassProperties(shapes, parts);
+
+  props.volume.assign(num_bodies, 0.0);
+  props.mass.assign(num_bodies, 0.0);
+  props.bradius.assign(num_bodies, 0.0);
+  props.com_x.assign(num_bodies, 0.0);
+  props.com_y.assign(num_bodies, 0.0);
+  props.com_z.assign(num_bodies, 0.0);
+  props.Ixx.assign(num_bodies, 0.0);
+  props.Iyy.assign(num_bodies, 0.0);
+  props.Izz.assign(num_bodies, 0.0);
+  props.Ixy.assign(num_bodies, 0.0);
+  props.Ixz.assign(num_bodies, 0.0);
+  props.Iyz.assign(num_bodies, 0.0);
+
+  // Accumulate per body: mass, first moments, and inertia about the body frame
+  // origin. Shapes with an invalid body index are ignored.
+  size_t num_shapes = std::min(parts.Size(), body.size());
+  for (size_t i = 0; i < num_shapes; i++) {
+    int b = body[i];
+    if (b < 0 || b >= num_bodies)
+      continue;
+
+    double m = parts.mass[i];
+    double x = parts.com_x[i];
+    double y = parts.com_y[i];
+    double z = parts.com_z[i];
+
+    props.volume[b] += parts.volume[i];
+    props.mass[b] += m;
+    props.com_x[b] += m * x;
+    props.com_y[b] += m * y;
+    props.com_z[b] += m * z;
+    props.Ixx[b] += parts.Ixx[i] + m * (y * y + z * z);
+    props.Iyy[b] += parts.Iyy[i] + m * (z * z + x * x);
+    props.Izz[b] += parts.Izz[i] + m * (x * x + y * y);
+    props.Ixy[b] += parts.Ixy[i] - m * x * y;
+    props.Ixz[b] += parts.Ixz[i] - m * x * z;
+    props.Iyz[b] += parts.Iyz[i] - m * y * z;
+
+    double r = std::sqrt(x * x + y * y + z * z) + parts.bradius[i];
+    props.bradius[b] = std::max(props.bradius[b], r);
+  }
+
+  // Centroids, and inertias shifted from the body frame origin to the centroid
+  for (int b = 0; b < num_bodies; b++) {
+    double m = props.mass[b];
+    if (m <= 0)
+      continue;
+
+    double x = props.com_x[b] / m;
+    double y = props.com_y[b] / m;
+    double z = props.com_z[b] / m;
+
+    props.com_x[b] = x;
+    props.com_y[b] = y;
+    props.com_z[b] = z;
+    props.Ixx[b] -= m * (y * y + z * z);
+    props.Iyy[b] -= m * (z * z + x * x);
+    props.Izz[b] -= m * (x * x + y * y);
+    props.Ixy[b] += m * x * y;
+    props.Ixz[b] += m * x * z;
+    props.Iyz[b] += m * y * z;
+  }
+}
+
+
+// -----------------------------------------------------------------------------
+// Space-filling curve keys of points with 21-bit integer coordinates.
+// -----------------------------------------------------------------------------
+static const int curve_bits = 21;
+
+// Spread the 21 low bits of x so that there are two zero bits between them.
+static uint64_t SpreadBits(uint64_t x)
+{
+  x &= 0x1FFFFF;
+  x = (x | (x << 32)) & 0x1F00000000FFFFULL;
+  x = (x | (x << 16)) & 0x1F0000FF0000FFULL;
+  x = (x | (x << 8))  & 0x100F00F00F00F00FULL;
+  x = (x | (x << 4))  & 0x10C30C30C30C30C3ULL;
+  x = (x | (x << 2))  & 0x1249249249249249ULL;
+  return x;
+}
+
+static uint64_t MortonKey(unsigned int x, unsigned int y, unsigned int z)
+{
+  return (SpreadBits(x) << 2) | (SpreadBits(y) << 1) | SpreadBits(z);
+}
+
+// Hilbert key: the coordinates are transformed in place to the "transposed"
+// Hilbert index (Skilling, 2004), whose bits are then interleaved.
+static uint64_t HilbertKey(unsigned int x, unsigned int y, unsigned int z)
+{
+  unsigned int X[3] = {x, y, z};
+  unsigned int M = 1u << (curve_bits - 1);
+
+  // Inverse undo
+  for (unsigned int Q = M; Q > 1; Q >>= 1) {
+    unsigned int P = Q - 1;
+    for (int i = 0; i < 3; i++) {
+      if (X[i] & Q) {
+        X[0] ^= P;
+      } else {
+        unsigned int t = (X[0] ^ X[i]) & P;
+        X[0] ^= t;
+        X[i] ^= t;
+      }
+    }
+  }
+
+  // Gray encode
+  X[1] ^= X[0];
+  X[2] ^= X[1];
+  unsigned int t = 0;
+  for (unsigned int Q = M; Q > 1; Q >>= 1) {
+    if (X[2] & Q)
+      t ^= Q - 1;
+  }
+  for (int i = 0; i < 3; i++)
+    X[i] ^= t;
+
+  return MortonKey(X[0], X[1], X[2]);
+}
+
+// -----------------------------------------------------------------------------
+// SortAlongCurve
+// -----------------------------------------------------------------------------
+void SortAlongCurve(const std::vector<ChVector<> >& points,
+                    SpaceFillingCurve               curve,
+                    std::vector<int>&               order)
+{
+  int n = (int)points.size();
+  order.resize(n);
+  for (int i = 0; i < n; i++)
+    order[i] = i;
+
+  if (curve == CURVE_NONE || n < 2)
+    return;
+
+  // Bounding box of the points
+  ChVector<> lo(DBL_MAX, DBL_MAX, DBL_MAX);
+  ChVector<> hi(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+  for (int i = 0; i < n; i++) {
+    const ChVector<>& p = points[i];
+    lo = ChVector<>(std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z));
+    hi = ChVector<>(std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z));
+  }
+
+  // Quantize with the same scale on all axes, so that the curve cells are
+  // cubes.
+  double size = std::max(hi.x - lo.x, std::max(hi.y - lo.y, hi.z - lo.z));
+  double scale = (size > 0) ? ((1 << curve_bits) - 1) / size : 0;
+
+  std::vector<std::pair<uint64_t, int> > keys(n);
+
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < n; i++) {
+    const ChVector<>& p = points[i];
+    unsigned int x = (unsigned int)((p.x - lo.x) * scale);
+    unsigned int y = (unsigned int)((p.y - lo.y) * scale);
+    unsigned int z = (unsigned int)((p.z - lo.z) * scale);
+    uint64_t key = (curve == CURVE_HILBERT) ? HilbertKey(x, y, z) : MortonKey(x, y, z);
+    keys[i] = std::make_pair(key, i);
+  }
+
+  // Ties keep the original order (the index is the second sort key).
+  std::sort(keys.begin(), keys.end());
+
+  for (int i = 0; i < n; i++)
+    order[i] = keys[i].second;
+}
+
+
+}  // namespace utils
+}  // namespace chrono
@@ -20,6 +20,7 @@
 #define CH_UTILS_GEOMETRY_H
 
 #include <cmath>
+#include <vector>
 
 #include "core/ChSmartpointers.h"
 #include "core/ChVector.h"
@@ -144,9 +145,23 @@ void TransformGyration(ChMatrix33<>&         J,
                        const ChVector<>&     pos,
                        const ChQuaternion<>& rot)
 {
-  ////
-  ////  TODO
-  ////
+  // Rotate to the axes of the parent frame: J' = A * J * A^T
+  ChMatrix33<> A;
+  A.Set_A_quaternion(rot);
+  ChMatrix33<> AJ;
+  AJ.MatrMultiply(A, J);
+  J.MatrMultiplyT(AJ, A);
+
+  // Translate to the origin of the parent frame (parallel axis theorem, per
+  // unit mass): J' += (pos.pos) * I - pos * pos^T
+  double p[3] = {pos.x, pos.y, pos.z};
+  double p2 = pos.Length2();
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      double shift = (i == j ? p2 : 0) - p[i] * p[j];
+      J.SetElement(i, j, J.GetElement(i, j) + shift);
+    }
+  }
 }
 
 // -----------------------------------------------------------------------------
@@ -196,9 +211,9 @@ ChMatrix33<> CalcBoxGyration(
 {
   ChMatrix33<> J;
 
-  J.SetElement(0, 0, (1.0/12.0) * (hdims.y * hdims.y + hdims.z * hdims.z));
-  J.SetElement(1, 1, (1.0/12.0) * (hdims.z * hdims.z + hdims.x * hdims.x));
-  J.SetElement(2, 2, (1.0/12.0) * (hdims.x * hdims.x + hdims.y * hdims.y));
+  J.SetElement(0, 0, (1.0/3.0) * (hdims.y * hdims.y + hdims.z * hdims.z));
+  J.SetElement(1, 1, (1.0/3.0) * (hdims.z * hdims.z + hdims.x * hdims.x));
+  J.SetElement(2, 2, (1.0/3.0) * (hdims.x * hdims.x + hdims.y * hdims.y));
 
   TransformGyration(J, pos, rot);
 
@@ -214,12 +229,19 @@ ChMatrix33<> CalcCapsuleGyration(
 {
   ChMatrix33<> J;
 
-  //// TODO: for now, use the gyration of the circumscibed cylinder
-  double hlen1 = hlen + radius;
+  // Cylinder and two hemispherical caps, weighted by their volumes (per unit
+  // pi*r^2). About the transverse axes, each cap (centroid 3r/8 from its base)
+  // contributes its inertia about its base plus its offset along the axis.
+  double r2 = radius * radius;
+  double vc = 2 * hlen;
+  double vs = (4.0/3.0) * radius;
+  double Jxx = (vc * (1.0/12.0) * (3 * r2 + 4 * hlen * hlen) +
+                vs * ((2.0/5.0) * r2 + hlen * hlen + (3.0/4.0) * hlen * radius)) / (vc + vs);
+  double Jyy = (vc * (1.0/2.0) * r2 + vs * (2.0/5.0) * r2) / (vc + vs);
 
-  J.SetElement(0, 0, (1.0/12.0) * (3 * radius * radius + hlen1 * hlen1));
-  J.SetElement(1, 1, (1.0/12.0) * (radius * radius));
-  J.SetElement(2, 2, (1.0/12.0) * (3 * radius * radius + hlen1 * hlen1));
+  J.SetElement(0, 0, Jxx);
+  J.SetElement(1, 1, Jyy);
+  J.SetElement(2, 2, Jxx);
 
   TransformGyration(J, pos, rot);
 
@@ -235,9 +257,9 @@ ChMatrix33<> CalcCylinderGyration(
 {
   ChMatrix33<> J;
 
-  J.SetElement(0, 0, (1.0/12.0) * (3 * radius * radius + hlen * hlen));
-  J.SetElement(1, 1, (1.0/12.0) * (radius * radius));
-  J.SetElement(2, 2, (1.0/12.0) * (3 * radius * radius + hlen * hlen));
+  J.SetElement(0, 0, (1.0/12.0) * (3 * radius * radius + 4 * hlen * hlen));
+  J.SetElement(1, 1, (1.0/2.0) * (radius * radius));
+  J.SetElement(2, 2, (1.0/12.0) * (3 * radius * radius + 4 * hlen * hlen));
 
   TransformGyration(J, pos, rot);
 
@@ -255,9 +277,9 @@ ChMatrix33<> CalcRoundedCylinderGyration(
   ChMatrix33<> J;
 
   //// TODO: for now, use the gyration of the skeleton cylinder
-  J.SetElement(0, 0, (1.0/12.0) * (3 * radius * radius + hlen * hlen));
-  J.SetElement(1, 1, (1.0/12.0) * (radius * radius));
-  J.SetElement(2, 2, (1.0/12.0) * (3 * radius * radius + hlen * hlen));
+  J.SetElement(0, 0, (1.0/12.0) * (3 * radius * radius + 4 * hlen * hlen));
+  J.SetElement(1, 1, (1.0/2.0) * (radius * radius));
+  J.SetElement(2, 2, (1.0/12.0) * (3 * radius * radius + 4 * hlen * hlen));
 
   TransformGyration(J, pos, rot);
 
@@ -274,9 +296,9 @@ ChMatrix33<> CalcRoundedBoxGyration(
   ChMatrix33<> J;
 
   //// TODO: for now, use the gyration of the skeleton box
-  J.SetElement(0, 0, (1.0/12.0) * (hdims.y * hdims.y + hdims.z * hdims.z));
-  J.SetElement(1, 1, (1.0/12.0) * (hdims.z * hdims.z + hdims.x * hdims.x));
-  J.SetElement(2, 2, (1.0/12.0) * (hdims.x * hdims.x + hdims.y * hdims.y));
+  J.SetElement(0, 0, (1.0/3.0) * (hdims.y * hdims.y + hdims.z * hdims.z));
+  J.SetElement(1, 1, (1.0/3.0) * (hdims.z * hdims.z + hdims.x * hdims.x));
+  J.SetElement(2, 2, (1.0/3.0) * (hdims.x * hdims.x + hdims.y * hdims.y));
 
   TransformGyration(J, pos, rot);
 
@@ -284,6 +306,102 @@ ChMatrix33<> CalcRoundedBoxGyration(
 }
 
 
+// -----------------------------------------------------------------------------
+// Batch mass properties.
+//
+// The shapes are given as structure-of-arrays (one array per component), so
+// that the mass properties of millions of shapes (e.g. the particles of a
+// granular bed) are computed in vectorizable loops over chunks of shapes,
+// which are distributed over the available OpenMP threads.
+//
+// Supported shape types and dimensions (as in ChUtilsCreators):
+//   SPHERE     dim_x = radius
+//   ELLIPSOID  dim_x, dim_y, dim_z = semi-axes
+//   BOX        dim_x, dim_y, dim_z = half-lengths
+//   CAPSULE    dim_x = radius, dim_y = half-length (along Y)
+//   CYLINDER   dim_x = radius, dim_y = half-length (along Y)
+// Shapes of other types get zero volume and mass.
+// -----------------------------------------------------------------------------
+struct CH_UTILS_API ShapeArrays {
+  /// Resize all arrays to the given number of shapes. New shapes are unit
+  /// spheres at the origin of their parent frame, with unit density.
+  void Resize(size_t n);
+
+  /// Append one shape (position and orientation relative to its parent frame).
+  void Add(collision::ShapeType   type,
+           const ChVector<>&      dims,
+           double                 density,
+           const ChVector<>&      pos = ChVector<>(0, 0, 0),
+           const ChQuaternion<>&  rot = ChQuaternion<>(1, 0, 0, 0));
+
+  size_t Size() const { return type.size(); }
+
+  std::vector<int>    type;                      ///< shape type (collision::ShapeType)
+  std::vector<double> dim_x, dim_y, dim_z;       ///< shape dimensions (see above)
+  std::vector<double> density;                   ///< density
+  std::vector<double> pos_x, pos_y, pos_z;       ///< position in the parent frame
+  std::vector<double> rot_e0, rot_e1, rot_e2, rot_e3;  ///< orientation in the parent frame
+};
+
+///
+/// Mass properties, as structure-of-arrays. The inertia tensors are taken with
+/// respect to the centroid, and expressed in the axes of the parent frame.
+///
+struct CH_UTILS_API MassArrays {
+  void Resize(size_t n);
+
+  size_t Size() const { return mass.size(); }
+
+  std::vector<double> volume;                         ///< volume
+  std::vector<double> mass;                           ///< mass
+  std::vector<double> bradius;                        ///< bounding radius (about the shape frame origin)
+  std::vector<double> com_x, com_y, com_z;            ///< centroid, in the parent frame
+  std::vector<double> Ixx, Iyy, Izz, Ixy, Ixz, Iyz;   ///< centroidal inertia tensor
+};
+
+/// Calculate the mass properties of every shape. On return, 'props' has one
+/// entry per shape (in the same order), with the centroid of each shape at
+/// its position and its inertia tensor rotated to the parent frame axes.
+CH_UTILS_API
+void CalcMassProperties(const ShapeArrays& shapes,
+                        MassArrays&        props);
+
+/// Calculate the mass properties of composite bodies: shape i belongs to body
+/// 'body[i]' (in [0, num_bodies)), and shape positions and orientations are
+/// relative to the body frame. On return, 'props' has one entry per body: the
+/// total mass and volume, the centroid of the body in the body frame, and
+/// the inertia tensor of the body about its centroid. The bounding radius of
+/// a body is about the body frame origin.
+CH_UTILS_API
+void CalcCompositeMassProperties(const ShapeArrays&      shapes,
+                                 const std::vector<int>& body,
+                                 int                     num_bodies,
+                                 MassArrays&             props);
+
+
+// -----------------------------------------------------------------------------
+// Space-filling curves.
+//
+// Ordering objects (e.g. the bodies of a system) along a space-filling curve
+// through their positions keeps objects which are close in space close in
+// memory. The Hilbert curve preserves locality better than the Morton (Z-order)
+// curve, at a slightly higher cost per key.
+// -----------------------------------------------------------------------------
+enum SpaceFillingCurve {
+  CURVE_NONE,
+  CURVE_MORTON,
+  CURVE_HILBERT
+};
+
+/// Return in 'order' the indices of the given points, sorted along the
+/// specified curve through their bounding box (quantized to 2^21 cells per
+/// axis). With CURVE_NONE, the original order is returned.
+CH_UTILS_API
+void SortAlongCurve(const std::vector<ChVector<> >& points,
+                    SpaceFillingCurve               curve,
+                    std::vector<int>&               order);
+
+
 } // end namespace utils
 } // end namespace chrono
 
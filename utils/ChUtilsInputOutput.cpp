@@ -16,6 +16,9 @@
 //
 // =============================================================================
 
+#include <algorithm>
+#include <cstdlib>
+
 #include "assets/ChColorAsset.h"
 
 #include "utils/ChUtilsInputOutput.h"
@@ -29,26 +32,48 @@ namespace utils {
 //
 // Write to a CSV file pody position, orientation, and (optionally) linear and
 // angular velocity. Optionally, only active bodies are processed.
+//
+// The body list is split in chunks of consecutive bodies, each formatted into
+// its own buffer (in parallel, if OpenMP is available); the buffers are then
+// written in order, so that the file does not depend on the number of threads.
 // -----------------------------------------------------------------------------
+static const int write_chunk_size = 4096;   // bodies per formatting chunk
+
 void WriteBodies(ChSystem*          system,
                  const std::string& filename,
                  bool               active_only,
                  bool               dump_vel,
                  const std::string& delim)
 {
-  CSV_writer csv(delim);
+  std::vector<ChBody*>& bodies = *system->Get_bodylist();
+  int num_bodies = (int)bodies.size();
+  int num_chunks = (num_bodies + write_chunk_size - 1) / write_chunk_size;
 
-  for (int i = 0; i < system->Get_bodylist()->size(); i++) {
-    ChBody* body = system->Get_bodylist()->at(i);
-    if (active_only && !body->IsActive())
-      continue;
-    csv << body->GetPos() << body->GetRot();
-    if (dump_vel)
-      csv << body->GetPos_dt() << body->GetWvel_loc();
-    csv << std::endl;
+  std::vector<std::string> buffers(num_chunks);
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int k = 0; k < num_chunks; k++) {
+    CSV_writer csv(delim);
+
+    int end = std::min(num_bodies, (k + 1) * write_chunk_size);
+    for (int i = k * write_chunk_size; i < end; i++) {
+      ChBody* body = bodies[i];
+      if (active_only && !body->IsActive())
+        continue;
+      csv << body->GetPos() << body->GetRot();
+      if (dump_vel)
+        csv << body->GetPos_dt() << body->GetWvel_loc();
+      csv << std::endl;
+    }
+
+    buffers[k] = csv.stream().str();
   }
 
-  csv.write_to_file(filename);
+  ChTraceSpan span(ChTrace::IsEnabled() ? "write_to_file " + filename : std::string(), "io");
+  std::ofstream ofile(filename.c_str());
+  for (int k = 0; k < num_chunks; k++)
+    ofile.write(buffers[k].data(), buffers[k].size());
+  ofile.close();
 }
 
 
@@ -181,12 +206,18 @@ bool WriteCheckpoint(ChSystem*          system,
 //
 // -----------------------------------------------------------------------------
 void ReadCheckpoint(ChSystem*          system,
-                    const std::string& filename)
+                    const std::string& filename,
+                    SpaceFillingCurve  curve)
 {
   // Open input file stream
   std::ifstream      ifile(filename.c_str());
   std::string        line;
 
+  // Bodies are collected first and added to the system at the end, in the
+  // requested order.
+  std::vector<ChBody*>    bodies;
+  std::vector<ChVector<> > positions;
+
   while (std::getline(ifile, line)) {
     std::istringstream iss1(line);
 
@@ -325,9 +356,39 @@ void ReadCheckpoint(ChSystem*          system,
 
     body->GetCollisionModel()->BuildModel();
 
-    // Attach the body to the system.
-    system->AddBody(ChSharedPtr<ChBody>(body));
+    bodies.push_back(body);
+    positions.push_back(bpos);
   }
+
+  // Attach the bodies to the system.
+  std::vector<int> order;
+  SortAlongCurve(positions, curve, order);
+
+  for (size_t i = 0; i < order.size(); i++)
+    system->AddBody(ChSharedPtr<ChBody>(bodies[order[i]]));
+}
+
+
+// -----------------------------------------------------------------------------
+// SortBodies
+//
+// Write a checkpoint, remove all bodies from the system, and read them back in
+// their order along the space-filling curve.
+// -----------------------------------------------------------------------------
+bool SortBodies(ChSystem*          system,
+                const std::string& filename,
+                SpaceFillingCurve  curve)
+{
+  if (system->GetNlinks() > 0)
+    return false;
+
+  if (!WriteCheckpoint(system, filename))
+    return false;
+
+  system->RemoveAllBodies();
+  ReadCheckpoint(system, filename, curve);
+
+  return true;
 }
 
 
@@ -600,6 +661,23 @@ void WriteMeshPovray(const std::string&    obj_filename,
   ofile << "}" << std::endl;
 }
 
+// -----------------------------------------------------------------------------
+// ParseSizeList
+// -----------------------------------------------------------------------------
+bool ParseSizeList(const std::string& str, std::vector<int>& sizes)
+{
+  sizes.clear();
+  std::istringstream iss(str);
+  std::string item;
+  while (std::getline(iss, item, ',')) {
+    int n = atoi(item.c_str());
+    if (n <= 0)
+      return false;
+    sizes.push_back(n);
+  }
+  return !sizes.empty();
+}
+
 
 }  // namespace utils
 }  // namespace chrono
@@ -23,12 +23,14 @@
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <vector>
 
 #include "physics/ChSystem.h"
 #include "assets/ChColor.h"
 
 #include "utils/ChApiUtils.h"
 #include "utils/ChUtilsCreators.h"
+#include "utils/ChUtilsTrace.h"
 
 
 namespace chrono {
@@ -56,6 +58,7 @@ public:
   void write_to_file(const std::string& filename,
                      const std::string& header = "")
   {
+    ChTraceSpan span(ChTrace::IsEnabled() ? "write_to_file " + filename : std::string(), "io");
     std::ofstream ofile(filename.c_str());
     ofile << header;
     ofile << m_ss.str();
@@ -115,9 +118,22 @@ bool WriteCheckpoint(ChSystem*          system,
                      const std::string& filename);
 
 // Read a CSV file with a checkpoint...
+// Optionally, the bodies are added to the system in their order along the
+// specified space-filling curve through their positions (instead of the order
+// in the file), so that bodies close in space are also close in the body list.
 CH_UTILS_API
 void ReadCheckpoint(ChSystem*          system,
-                    const std::string& filename);
+                    const std::string& filename,
+                    SpaceFillingCurve  curve = CURVE_NONE);
+
+// Re-sort the bodies of a system along the specified space-filling curve,
+// through a checkpoint round-trip via the given file. Only systems without
+// links can be sorted this way (links would refer to the removed bodies).
+// Returns false if the system has links or the checkpoint cannot be written.
+CH_UTILS_API
+bool SortBodies(ChSystem*          system,
+                const std::string& filename,
+                SpaceFillingCurve  curve);
 
 // Write CSV output file for PovRay.
 // Each line contains information about one visualization asset shape, as
@@ -142,6 +158,14 @@ void WriteMeshPovray(const std::string&    obj_filename,
                      const ChVector<>&     pos = ChVector<>(0, 0, 0),
                      const ChQuaternion<>& rot = ChQuaternion<>(1, 0, 0, 0));
 
+// ParseSizeList
+//
+// Parse a comma-separated list of positive integers (e.g. the problem sizes of
+// a benchmark given on the command line as "10,100,1000"). Returns false if
+// the list is empty or contains an entry that is not a positive integer.
+CH_UTILS_API
+bool ParseSizeList(const std::string& str, std::vector<int>& sizes);
+
 
 } // namespace utils
 } // namespace chrono
@@ -0,0 +1,307 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Streaming (SAX-style) JSON writer for test results.
+//
+// =============================================================================
+
+#include "utils/ChUtilsJsonWriter.h"
+
+namespace chrono {
+namespace utils {
+
+
+// -----------------------------------------------------------------------------
+// ChJsonSpillStream
+// -----------------------------------------------------------------------------
+ChJsonSpillStream::ChJsonSpillStream(size_t capacity)
+: m_buffer(capacity > 0 ? capacity : 1),
+  m_size(0),
+  m_spilled(0),
+  m_file(NULL),
+  m_failed(false)
+{
+}
+
+ChJsonSpillStream::~ChJsonSpillStream()
+{
+  if (m_file)
+    fclose(m_file);
+}
+
+void ChJsonSpillStream::Spill()
+{
+  if (!m_file)
+    m_file = tmpfile();
+
+  // Without a temporary file, keep all data in memory.
+  if (!m_file) {
+    m_buffer.resize(2 * m_buffer.size());
+    return;
+  }
+
+  if (fwrite(&m_buffer[0], 1, m_size, m_file) != m_size)
+    m_failed = true;
+
+  m_spilled += m_size;
+  m_size = 0;
+}
+
+
+// -----------------------------------------------------------------------------
+// ChJsonArrayStream
+// -----------------------------------------------------------------------------
+ChJsonArrayStream::ChJsonArrayStream(const std::string& name, size_t capacity)
+: m_name(name),
+  m_count(0),
+  m_stream(capacity),
+  m_writer(m_stream)
+{
+  m_writer.StartArray();
+}
+
+
+// -----------------------------------------------------------------------------
+// ChJsonStreamWriter
+// -----------------------------------------------------------------------------
+ChJsonStreamWriter::ChJsonStreamWriter()
+: m_file(NULL),
+  m_buffer(65536),
+  m_stream(NULL),
+  m_writer(NULL),
+  m_level(0),
+  m_failed(false)
+{
+}
+
+ChJsonStreamWriter::~ChJsonStreamWriter()
+{
+  Discard();
+}
+
+bool ChJsonStreamWriter::Open(const std::string& filename)
+{
+  Discard();
+
+  m_filename = filename;
+  m_partname = filename + ".part";
+  m_file = fopen(m_partname.c_str(), "wb");
+  if (!m_file)
+    return false;
+
+  m_stream = new rapidjson::FileWriteStream(m_file, &m_buffer[0], m_buffer.size());
+  m_writer = new rapidjson::Writer<rapidjson::FileWriteStream>(*m_stream);
+  m_writer->StartObject();
+  m_level = 1;
+  m_failed = false;
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Scalar members. All are silently ignored if the output is not open, so that
+// callers need not check whether results are being recorded.
+// -----------------------------------------------------------------------------
+void ChJsonStreamWriter::Member(const std::string& key, double val)
+{
+  if (!m_file)
+    return;
+  m_writer->String(key);
+  m_writer->Double(val);
+}
+
+void ChJsonStreamWriter::Member(const std::string& key, int val)
+{
+  if (!m_file)
+    return;
+  m_writer->String(key);
+  m_writer->Int(val);
+}
+
+void ChJsonStreamWriter::Member(const std::string& key, uint64_t val)
+{
+  if (!m_file)
+    return;
+  m_writer->String(key);
+  m_writer->Uint64(val);
+}
+
+void ChJsonStreamWriter::Member(const std::string& key, bool val)
+{
+  if (!m_file)
+    return;
+  m_writer->String(key);
+  m_writer->Bool(val);
+}
+
+void ChJsonStreamWriter::Member(const std::string& key, const char* val)
+{
+  if (!m_file)
+    return;
+  m_writer->String(key);
+  m_writer->String(val);
+}
+
+void ChJsonStreamWriter::Member(const std::string& key, const std::string& val)
+{
+  if (!m_file)
+    return;
+  m_writer->String(key);
+  m_writer->String(val);
+}
+
+void ChJsonStreamWriter::Member(const std::string& key, const std::vector<double>& val)
+{
+  if (!m_file)
+    return;
+  m_writer->String(key);
+  m_writer->StartArray();
+  for (size_t i = 0; i < val.size(); i++)
+    m_writer->Double(val[i]);
+  m_writer->EndArray();
+}
+
+// -----------------------------------------------------------------------------
+// Nested objects
+// -----------------------------------------------------------------------------
+void ChJsonStreamWriter::StartObject(const std::string& key)
+{
+  if (!m_file)
+    return;
+  m_writer->String(key);
+  m_writer->StartObject();
+  m_level++;
+}
+
+void ChJsonStreamWriter::EndObject()
+{
+  if (!m_file || m_level <= 1)
+    return;
+
+  // Close any arrays opened at this level.
+  for (size_t i = m_arrays.size(); i > 0; i--) {
+    if (m_arrays[i - 1].second == m_level)
+      CloseArray(m_arrays[i - 1].first);
+  }
+
+  m_writer->EndObject();
+  m_level--;
+}
+
+// -----------------------------------------------------------------------------
+// Incremental arrays
+// The elements of an open array are formatted (by its own rapidjson writer)
+// into a spill stream, starting with the opening bracket. When the array is
+// closed, the main writer emits the key and the brackets (taking care of the
+// separators) and the formatted elements are copied in between.
+// -----------------------------------------------------------------------------
+ChJsonArrayStream* ChJsonStreamWriter::OpenArray(const std::string& key, size_t capacity)
+{
+  ChJsonArrayStream* arr = new ChJsonArrayStream(key, capacity);
+  m_arrays.push_back(std::make_pair(arr, m_level));
+  return arr;
+}
+
+bool ChJsonStreamWriter::CloseArray(ChJsonArrayStream* arr)
+{
+  for (size_t i = 0; i < m_arrays.size(); i++) {
+    if (m_arrays[i].first != arr)
+      continue;
+
+    // The array must be written in the object it was opened in.
+    if (m_file && m_arrays[i].second != m_level)
+      return false;
+
+    if (m_file) {
+      m_writer->String(arr->m_name);
+      m_writer->StartArray();
+      arr->m_stream.CopyTo(*m_stream, 1, arr->m_stream.GetLength());
+      m_writer->EndArray();
+      m_failed |= arr->m_stream.Failed();
+    }
+
+    delete arr;
+    m_arrays.erase(m_arrays.begin() + i);
+    return true;
+  }
+
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Finish the output and move it to the final location.
+// -----------------------------------------------------------------------------
+bool ChJsonStreamWriter::Close()
+{
+  if (!m_file)
+    return false;
+
+  while (m_level > 1)
+    EndObject();
+
+  while (!m_arrays.empty()) {
+    if (!CloseArray(m_arrays.back().first)) {
+      delete m_arrays.back().first;
+      m_arrays.pop_back();
+      m_failed = true;
+    }
+  }
+
+  m_writer->EndObject();
+  m_stream->Flush();
+
+  bool ok = !m_failed && (ferror(m_file) == 0);
+  ok &= (fclose(m_file) == 0);
+  m_file = NULL;
+
+  delete m_writer;
+  delete m_stream;
+  m_writer = NULL;
+  m_stream = NULL;
+  m_level = 0;
+
+  if (ok) {
+    remove(m_filename.c_str());
+    ok = (rename(m_partname.c_str(), m_filename.c_str()) == 0);
+  }
+  if (!ok)
+    remove(m_partname.c_str());
+
+  return ok;
+}
+
+void ChJsonStreamWriter::Discard()
+{
+  while (!m_arrays.empty()) {
+    delete m_arrays.back().first;
+    m_arrays.pop_back();
+  }
+
+  if (!m_file)
+    return;
+
+  fclose(m_file);
+  m_file = NULL;
+  remove(m_partname.c_str());
+
+  delete m_writer;
+  delete m_stream;
+  m_writer = NULL;
+  m_stream = NULL;
+  m_level = 0;
+}
+
+
+}  // namespace utils
+}  // namespace chrono
@@ -0,0 +1,215 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Streaming (SAX-style) JSON writer for test results.
+//
+// Members are written to the output file as soon as they are added, so memory
+// use does not grow with the number or size of the results. Array members can
+// be grown incrementally and several of them can be open at the same time:
+// each open array is formatted into a bounded in-memory buffer which spills to
+// a temporary file, and is copied into the output when it is closed.
+//
+// =============================================================================
+
+#ifndef CH_UTILS_JSON_WRITER_H
+#define CH_UTILS_JSON_WRITER_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "utils/ChApiUtils.h"
+
+#define RAPIDJSON_HAS_STDSTRING 1
+#include "../include/rapidjson/writer.h"
+#include "../include/rapidjson/filewritestream.h"
+
+
+namespace chrono {
+namespace utils {
+
+///
+/// Output stream (rapidjson OutputStream concept) which keeps data in a fixed
+/// size buffer and spills to an anonymous temporary file when the buffer is
+/// full. If no temporary file can be created, the buffer grows instead.
+///
+class CH_UTILS_API ChJsonSpillStream
+{
+public:
+  typedef char Ch;
+
+  ChJsonSpillStream(size_t capacity = 65536);
+  ~ChJsonSpillStream();
+
+  void Put(char c)
+  {
+    if (m_size == m_buffer.size())
+      Spill();
+    m_buffer[m_size++] = c;
+  }
+  void Flush() {}
+
+  /// Total number of characters written so far.
+  size_t GetLength() const { return m_spilled + m_size; }
+
+  /// Return true if spilled data could not be written to (or read back from)
+  /// the temporary file.
+  bool Failed() const { return m_failed; }
+
+  /// Copy the characters in the range [begin, end) to the given stream.
+  template <typename OutputStream>
+  void CopyTo(OutputStream& os, size_t begin, size_t end);
+
+private:
+  void Spill();
+
+  std::vector<char> m_buffer;
+  size_t            m_size;
+  size_t            m_spilled;
+  FILE*             m_file;
+  bool              m_failed;
+};
+
+class ChJsonStreamWriter;
+
+///
+/// Array member of a ChJsonStreamWriter, grown one element at a time.
+/// Obtained from ChJsonStreamWriter::OpenArray() and owned by the writer.
+///
+class CH_UTILS_API ChJsonArrayStream
+{
+public:
+  void Append(double val)             { m_writer.Double(val); m_count++; }
+  void Append(int val)                { m_writer.Int(val); m_count++; }
+  void Append(uint64_t val)           { m_writer.Uint64(val); m_count++; }
+  void Append(const std::string& val) { m_writer.String(val); m_count++; }
+
+  /// Number of elements appended so far.
+  size_t GetSize() const { return m_count; }
+
+  /// Name of this array member.
+  const std::string& GetName() const { return m_name; }
+
+private:
+  ChJsonArrayStream(const std::string& name, size_t capacity);
+
+  std::string                          m_name;
+  size_t                               m_count;
+  ChJsonSpillStream                    m_stream;
+  rapidjson::Writer<ChJsonSpillStream> m_writer;
+
+  friend class ChJsonStreamWriter;
+};
+
+///
+/// Streaming JSON writer.
+/// The output is a single JSON object; nested objects can be opened with
+/// StartObject() and closed with EndObject(). The data is written to a
+/// temporary file ("<filename>.part") which is renamed to the final name only
+/// when Close() succeeds, so that failed runs never leave partial results.
+///
+class CH_UTILS_API ChJsonStreamWriter
+{
+public:
+
+  ChJsonStreamWriter();
+  /// Destructor. Discards the output if Close() was not called.
+  ~ChJsonStreamWriter();
+
+  /// Open the output file and start the root object.
+  bool Open(const std::string& filename);
+
+  /// Return true if the output file is open.
+  bool IsOpen() const { return m_file != NULL; }
+
+  /// Add a member to the current object.
+  void Member(const std::string& key, double val);
+  void Member(const std::string& key, int val);
+  void Member(const std::string& key, uint64_t val);
+  void Member(const std::string& key, bool val);
+  void Member(const std::string& key, const char* val);
+  void Member(const std::string& key, const std::string& val);
+  void Member(const std::string& key, const std::vector<double>& val);
+
+  /// Start a nested object member.
+  void StartObject(const std::string& key);
+  /// Close the current nested object.
+  /// Arrays opened in this object and still open are closed first.
+  void EndObject();
+
+  /// Open an array member in the current object. Elements can be appended to
+  /// the returned array at any later time, interleaved with other members,
+  /// until the array (or the enclosing object) is closed. Memory use per open
+  /// array is bounded by the specified buffer capacity.
+  ChJsonArrayStream* OpenArray(const std::string& key, size_t capacity = 65536);
+  /// Close the specified array: its elements are written to the output at the
+  /// current position in the current object. Returns false, and leaves the
+  /// array open, if it was opened in a different object than the current one
+  /// (it is then closed together with the object it was opened in).
+  bool CloseArray(ChJsonArrayStream* arr);
+
+  /// Close all open objects and arrays, finish the output, and move it to its
+  /// final location. Returns false if the output could not be written
+  /// (including the elements of any array).
+  bool Close();
+
+private:
+  void Discard();
+
+  std::string                                    m_filename;
+  std::string                                    m_partname;
+  FILE*                                          m_file;
+  std::vector<char>                              m_buffer;
+  rapidjson::FileWriteStream*                    m_stream;
+  rapidjson::Writer<rapidjson::FileWriteStream>* m_writer;
+  int                                            m_level;
+  bool                                           m_failed;
+  std::vector<std::pair<ChJsonArrayStream*, int> > m_arrays;
+};
+
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+template <typename OutputStream>
+void ChJsonSpillStream::CopyTo(OutputStream& os, size_t begin, size_t end)
+{
+  size_t pos = 0;
+
+  if (m_file) {
+    rewind(m_file);
+    char chunk[4096];
+    size_t n;
+    while (pos < m_spilled && (n = fread(chunk, 1, sizeof(chunk), m_file)) > 0) {
+      for (size_t i = 0; i < n; i++, pos++) {
+        if (pos >= begin && pos < end)
+          os.Put(chunk[i]);
+      }
+    }
+    if (pos < m_spilled)
+      m_failed = true;
+    fseek(m_file, 0, SEEK_END);
+  }
+
+  for (size_t i = 0; i < m_size; i++, pos++) {
+    if (pos >= begin && pos < end)
+      os.Put(m_buffer[i]);
+  }
+}
+
+
+} // namespace utils
+} // namespace chrono
+
+
+#endif
@@ -0,0 +1,89 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Process memory queries, for memory-use benchmarks.
+//
+// =============================================================================
+
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#else
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+#include "utils/ChUtilsMemory.h"
+
+namespace chrono {
+namespace utils {
+
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+size_t GetResidentMemory()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return 0;
+  return counters.WorkingSetSize;
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+    return 0;
+  return info.resident_size;
+#else
+  // The second field of /proc/self/statm is the resident set size, in pages.
+  FILE* file = fopen("/proc/self/statm", "r");
+  if (!file)
+    return 0;
+  long size = 0;
+  long resident = 0;
+  int num_read = fscanf(file, "%ld %ld", &size, &resident);
+  fclose(file);
+  if (num_read != 2)
+    return 0;
+  return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+size_t GetPeakResidentMemory()
+{
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return 0;
+  return counters.PeakWorkingSetSize;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#if defined(__APPLE__)
+  return (size_t)usage.ru_maxrss;           // bytes
+#else
+  return (size_t)usage.ru_maxrss * 1024;    // kilobytes
+#endif
+#endif
+}
+
+
+}  // namespace utils
+}  // namespace chrono
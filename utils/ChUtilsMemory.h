@@ -0,0 +1,45 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Process memory queries, for memory-use benchmarks.
+//
+// =============================================================================
+
+#ifndef CH_UTILS_MEMORY_H
+#define CH_UTILS_MEMORY_H
+
+#include <cstddef>
+
+#include "utils/ChApiUtils.h"
+
+
+namespace chrono {
+namespace utils {
+
+/// Return the current resident memory (working set) of this process, in bytes.
+/// Returns 0 if not available on this platform.
+CH_UTILS_API
+size_t GetResidentMemory();
+
+/// Return the peak resident memory of this process so far, in bytes.
+/// Returns 0 if not available on this platform.
+CH_UTILS_API
+size_t GetPeakResidentMemory();
+
+
+} // namespace utils
+} // namespace chrono
+
+
+#endif
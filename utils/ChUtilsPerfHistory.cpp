@@ -0,0 +1,275 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Local performance history store with regression detection.
+//
+// =============================================================================
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#else
+#include <unistd.h>
+#endif
+
+#include "utils/ChUtilsPerfHistory.h"
+#include "utils/ChUtilsResults.h"
+
+namespace chrono {
+namespace utils {
+
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+ChPerfHistory::ChPerfHistory(const std::string& filename)
+: m_filename(filename),
+  m_window(10),
+  m_min_samples(3),
+  m_alpha(0.01),
+  m_min_increase(0.05)
+{
+}
+
+// -----------------------------------------------------------------------------
+// Load the baseline records.
+// Lines that cannot be parsed (e.g. left over from an interrupted run) are
+// skipped by the reader. Failed and regressed runs stay in the history file
+// but are not part of any baseline, so they cannot drag it along.
+// -----------------------------------------------------------------------------
+size_t ChPerfHistory::Load(const std::string& name,
+                           const std::string& host,
+                           const std::string& build_type,
+                           const std::string& signature)
+{
+  m_records.clear();
+
+  ChResultsReader reader;
+  reader.Load(m_filename);
+
+  const std::vector<size_t>& found = reader.Find(name);
+
+  for (size_t i = 0; i < found.size(); i++) {
+    const ChResultRecord& result = reader.GetRecord(found[i]);
+    if (result.host != host || result.build_type != build_type || result.signature != signature)
+      continue;
+    if (!result.passed || result.perf_regression)
+      continue;
+
+    Record record(result.metrics);
+    record["execution_time"] = result.execution_time;
+
+    m_records.push_back(record);
+    if (m_records.size() > m_window)
+      m_records.pop_front();
+  }
+
+  return m_records.size();
+}
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+bool ChPerfHistory::IsTracked(const std::string& metric)
+{
+  return metric == "execution_time" ||
+         metric.find("Time") != std::string::npos ||
+         metric.find("RMS") != std::string::npos;
+}
+
+// -----------------------------------------------------------------------------
+// Compare a value against the baseline.
+// The current value is treated as a new observation from the baseline
+// distribution; the test statistic accounts for the uncertainty in both the
+// baseline mean and the new observation:
+//    t = (x - mean) / (s * sqrt(1 + 1/n)),   with n-1 degrees of freedom.
+// A baseline with zero spread (e.g. deterministic RMS norms) flags any increase
+// larger than the minimum relative threshold.
+// -----------------------------------------------------------------------------
+bool ChPerfHistory::Compare(const std::string& metric,
+                            double             value,
+                            ChPerfComparison&  result) const
+{
+  result.metric = metric;
+  result.value = value;
+  result.mean = 0;
+  result.stddev = 0;
+  result.num_samples = 0;
+  result.p_value = 1;
+  result.regression = false;
+
+  std::vector<double> samples;
+  for (std::deque<Record>::const_iterator itr = m_records.begin(); itr != m_records.end(); ++itr) {
+    Record::const_iterator entry = itr->find(metric);
+    if (entry != itr->end())
+      samples.push_back(entry->second);
+  }
+
+  size_t n = samples.size();
+  result.num_samples = n;
+
+  if (n < m_min_samples || n < 2)
+    return false;
+
+  double sum = 0;
+  for (size_t i = 0; i < n; i++)
+    sum += samples[i];
+  double mean = sum / n;
+
+  double sum2 = 0;
+  for (size_t i = 0; i < n; i++)
+    sum2 += (samples[i] - mean) * (samples[i] - mean);
+  double stddev = std::sqrt(sum2 / (n - 1));
+
+  result.mean = mean;
+  result.stddev = stddev;
+
+  if (stddev > 0) {
+    double t = (value - mean) / (stddev * std::sqrt(1.0 + 1.0 / n));
+    result.p_value = StudentTUpperTail(t, (double)(n - 1));
+  } else {
+    result.p_value = (value > mean) ? 0 : 1;
+  }
+
+  double increase = (value - mean) / std::abs(mean > 0 ? mean : 1);
+
+  result.regression = (result.p_value < m_alpha) && (increase > m_min_increase);
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Append a record to the history file (atomic with respect to other processes
+// appending to the same file).
+// -----------------------------------------------------------------------------
+bool ChPerfHistory::Append(const std::string& record) const
+{
+  return AppendJsonLine(m_filename, record);
+}
+
+
+// -----------------------------------------------------------------------------
+// Return the name of the host machine.
+// -----------------------------------------------------------------------------
+std::string GetHostName()
+{
+#if defined(_WIN32)
+  const char* name = getenv("COMPUTERNAME");
+  if (name)
+    return std::string(name);
+#else
+  char name[256];
+  if (gethostname(name, sizeof(name)) == 0) {
+    name[sizeof(name) - 1] = '\0';
+    return std::string(name);
+  }
+#endif
+  return std::string("unknown");
+}
+
+// -----------------------------------------------------------------------------
+// Student t distribution, upper tail.
+// Uses the relation P(T > t) = 0.5 * I_x(dof/2, 1/2), x = dof / (dof + t^2),
+// with the regularized incomplete beta function evaluated by its continued
+// fraction representation (modified Lentz's method).
+// -----------------------------------------------------------------------------
+static double BetaContinuedFraction(double a, double b, double x)
+{
+  const int    max_iter = 200;
+  const double eps = 1e-14;
+  const double fpmin = 1e-300;
+
+  double qab = a + b;
+  double qap = a + 1;
+  double qam = a - 1;
+  double c = 1;
+  double d = 1 - qab * x / qap;
+  if (std::abs(d) < fpmin)
+    d = fpmin;
+  d = 1 / d;
+  double h = d;
+
+  for (int m = 1; m <= max_iter; m++) {
+    int m2 = 2 * m;
+    double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+    d = 1 + aa * d;
+    if (std::abs(d) < fpmin)
+      d = fpmin;
+    c = 1 + aa / c;
+    if (std::abs(c) < fpmin)
+      c = fpmin;
+    d = 1 / d;
+    h *= d * c;
+    aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+    d = 1 + aa * d;
+    if (std::abs(d) < fpmin)
+      d = fpmin;
+    c = 1 + aa / c;
+    if (std::abs(c) < fpmin)
+      c = fpmin;
+    d = 1 / d;
+    double del = d * c;
+    h *= del;
+    if (std::abs(del - 1) < eps)
+      break;
+  }
+
+  return h;
+}
+
+static double LogGamma(double x)
+{
+  // Lanczos approximation (g = 7, n = 9)
+  static const double coef[9] = {
+    0.99999999999980993, 676.5203681218851, -1259.1392167224028,
+    771.32342877765313, -176.61502916214059, 12.507343278686905,
+    -0.13857109526572012, 9.9843695780195716e-6, 1.5056327351493116e-7
+  };
+
+  x -= 1;
+  double a = coef[0];
+  double t = x + 7.5;
+  for (int i = 1; i < 9; i++)
+    a += coef[i] / (x + i);
+
+  return 0.5 * std::log(2 * 3.14159265358979323846) + (x + 0.5) * std::log(t) - t + std::log(a);
+}
+
+static double IncompleteBeta(double a, double b, double x)
+{
+  if (x <= 0)
+    return 0;
+  if (x >= 1)
+    return 1;
+
+  double bt = std::exp(LogGamma(a + b) - LogGamma(a) - LogGamma(b) +
+                       a * std::log(x) + b * std::log(1 - x));
+
+  if (x < (a + 1) / (a + b + 2))
+    return bt * BetaContinuedFraction(a, b, x) / a;
+
+  return 1 - bt * BetaContinuedFraction(b, a, 1 - x) / b;
+}
+
+double StudentTUpperTail(double t, double dof)
+{
+  double x = dof / (dof + t * t);
+  double tail = 0.5 * IncompleteBeta(0.5 * dof, 0.5, x);
+
+  return (t > 0) ? tail : 1 - tail;
+}
+
+
+}  // namespace utils
+}  // namespace chrono
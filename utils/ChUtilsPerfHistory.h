@@ -0,0 +1,137 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Local performance history store with regression detection.
+//
+// The history is a JSON Lines file: every line is one complete test record (as
+// produced by BaseTest) augmented with the git revision, host name, and build
+// type of the run. New runs are compared against a rolling baseline made of the
+// most recent passing, regression-free records for the same test, host, build
+// type, and argument signature.
+//
+// =============================================================================
+
+#ifndef CH_UTILS_PERF_HISTORY_H
+#define CH_UTILS_PERF_HISTORY_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+#include "utils/ChApiUtils.h"
+
+
+namespace chrono {
+namespace utils {
+
+/// Result of comparing one metric against its historical baseline.
+struct CH_UTILS_API ChPerfComparison {
+  std::string metric;       ///< name of the compared metric
+  double      value;        ///< value in the current run
+  double      mean;         ///< baseline mean
+  double      stddev;       ///< baseline sample standard deviation
+  size_t      num_samples;  ///< number of baseline samples used
+  double      p_value;      ///< one-sided p-value (current run is larger)
+  bool        regression;   ///< true if significantly (and sufficiently) larger
+};
+
+///
+/// This class manages a local performance history file and detects
+/// regressions with respect to a rolling baseline.
+/// Only metrics for which larger values are worse are tracked: timings (the
+/// overall "execution_time" and metrics whose name contains "Time") and
+/// accuracy metrics (names containing "RMS").
+/// A metric is flagged as a regression if a one-sided Student t test of the
+/// current value against the baseline samples is significant at the specified
+/// level AND the relative increase over the baseline mean exceeds a minimum
+/// threshold (to avoid flagging changes that are significant but irrelevant).
+///
+class CH_UTILS_API ChPerfHistory
+{
+public:
+
+  ChPerfHistory(const std::string& filename);
+  ~ChPerfHistory() {}
+
+  /// Set the maximum number of most recent records used as baseline (default 10).
+  void SetWindow(size_t window) { m_window = window; }
+  /// Set the minimum number of baseline records needed for a comparison (default 3).
+  void SetMinSamples(size_t num) { m_min_samples = num; }
+  /// Set the significance level for the one-sided t test (default 0.01).
+  void SetSignificance(double alpha) { m_alpha = alpha; }
+  /// Set the minimum relative increase flagged as a regression (default 0.05).
+  void SetMinIncrease(double rel) { m_min_increase = rel; }
+
+  /// Return the name of the history file.
+  const std::string& GetFilename() const { return m_filename; }
+
+  /// Load the baseline for the specified test, host, build type, and argument
+  /// signature (the same program run with different arguments, e.g. another
+  /// case selection or thread count, has a separate baseline).
+  /// Records in the history file that do not match are ignored, as are records
+  /// of runs that failed or were flagged as regressions. Only the most recent
+  /// 'window' matching records are kept. Returns the number of baseline records
+  /// loaded (a missing history file is not an error).
+  size_t Load(const std::string& name,
+              const std::string& host,
+              const std::string& build_type,
+              const std::string& signature = "");
+
+  /// Return the number of baseline records currently loaded.
+  size_t GetNumRecords() const { return m_records.size(); }
+
+  /// Return true if the specified metric is tracked for regressions.
+  static bool IsTracked(const std::string& metric);
+
+  /// Compare the specified value against the baseline for that metric.
+  /// Returns false if there are not enough baseline samples for a comparison
+  /// (in which case 'result' is filled in but never flagged).
+  bool Compare(const std::string& metric,
+               double             value,
+               ChPerfComparison&  result) const;
+
+  /// Append the given record to the history file.
+  /// The record must be a single line of JSON (no embedded newlines).
+  bool Append(const std::string& record) const;
+
+private:
+
+  typedef std::map<std::string, double> Record;
+
+  std::string         m_filename;
+  size_t              m_window;
+  size_t              m_min_samples;
+  double              m_alpha;
+  double              m_min_increase;
+  std::deque<Record>  m_records;
+};
+
+// -----------------------------------------------------------------------------
+// Free function declarations
+// -----------------------------------------------------------------------------
+
+/// Return the name of the host machine (or "unknown").
+CH_UTILS_API std::string GetHostName();
+
+/// Upper tail probability P(T > t) of a Student t distribution with the
+/// specified number of degrees of freedom.
+CH_UTILS_API double StudentTUpperTail(double t, double dof);
+
+
+} // namespace utils
+} // namespace chrono
+
+
+#endif
@@ -0,0 +1,990 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Packed store of reference data files.
+//
+// Store file layout (integers are little-endian or varints):
+//   "CHRS", version (1 byte), number of bundles (varint)
+//   index: per bundle, name (string), offset and size of its data (8 bytes
+//          each, offsets relative to the end of the index)
+//   bundles: number of rows of the time column, size of the encoded time
+//          column, number of channels (varints), then the channel directory:
+//            per channel (data file): name, the first three lines of the file
+//            (strings), number of rows and of columns (varints), shared time
+//            flag (1 byte), offset and size of its encoded columns (varints,
+//            offsets relative to the end of the directory),
+//          then the encoded time column (the first column of the first data
+//          file), and the encoded columns of each channel. The first column of
+//          a channel with the shared time flag is the time column, and is not
+//          stored again.
+//   columns: mode (1 byte), then
+//            SCALED:  power of ten p (zigzag varint), stream of mantissas N
+//                     (value = N * 10^p), exceptions
+//            DECIMAL: stream of mantissas m, stream of exponents q
+//                     (value = m * 10^q), exceptions
+//            RAW:     stream of the bits of the doubles
+// A stream is the order of differences along time (1 byte: 1 or 2), followed
+// by the zigzag coded differences, bit-packed in blocks. Exceptions are the
+// values a mode does not reproduce exactly (e.g. -0, or a tiny value in a
+// column of large values): their number (varint), then a stream of their rows
+// and a stream of the bits of the doubles.
+//
+// Decoding a value takes an integer multiplication or division by an exact
+// power of ten (at most 10^22), which is correctly rounded just like parsing
+// the decimal text. Every value is checked against the parsed text when the
+// store is written; the smallest of the encodings of each column is used.
+//
+// =============================================================================
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include "utils/ChUtilsReferenceStore.h"
+#include "utils/ChUtilsBitPacking.h"
+#include "utils/ChUtilsTrace.h"
+
+namespace chrono {
+namespace utils {
+
+
+// -----------------------------------------------------------------------------
+// Column encoding helpers
+// -----------------------------------------------------------------------------
+namespace {
+
+const char    store_magic[4] = {'C', 'H', 'R', 'S'};
+const uint8_t store_version = 2;
+
+enum ColumnMode {
+  COLUMN_SCALED = 0,
+  COLUMN_DECIMAL = 1,
+  COLUMN_RAW = 2
+};
+
+const int     max_pow10 = 22;            // largest exactly representable power of ten
+const int64_t max_mantissa = (1LL << 53) - 1;
+
+const double pow10_table[max_pow10 + 1] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// A decimal value m * 10^q, as written in the text file.
+struct Decimal {
+  int64_t m;
+  int     q;
+  bool    negative;
+  bool    valid;
+};
+
+// Parse a decimal number (e.g. "+5.858380E-16") into its integer mantissa and
+// exponent. Returns false for anything else (more than 18 digits, inf, ...).
+bool ParseDecimal(const std::string& token, Decimal& dec)
+{
+  const char* s = token.c_str();
+  dec.negative = (*s == '-');
+  if (*s == '+' || *s == '-')
+    s++;
+
+  int64_t mag = 0;
+  int     num_digits = 0;
+  int     num_frac = 0;
+  bool    frac = false;
+  for (;; s++) {
+    if (*s >= '0' && *s <= '9') {
+      if (++num_digits > 18)
+        return false;
+      mag = 10 * mag + (*s - '0');
+      if (frac)
+        num_frac++;
+    } else if (*s == '.' && !frac) {
+      frac = true;
+    } else {
+      break;
+    }
+  }
+  if (num_digits == 0)
+    return false;
+
+  int exp = 0;
+  if (*s == 'e' || *s == 'E') {
+    s++;
+    bool neg_exp = (*s == '-');
+    if (*s == '+' || *s == '-')
+      s++;
+    if (*s < '0' || *s > '9')
+      return false;
+    for (; *s >= '0' && *s <= '9'; s++) {
+      exp = 10 * exp + (*s - '0');
+      if (exp > 1000)
+        return false;
+    }
+    if (neg_exp)
+      exp = -exp;
+  }
+  if (*s != 0)
+    return false;
+
+  dec.m = dec.negative ? -mag : mag;
+  dec.q = exp - num_frac;
+  dec.valid = true;
+  return true;
+}
+
+inline int64_t Abs64(int64_t v)
+{
+  return v < 0 ? -v : v;
+}
+
+inline double ScaleDecimal(int64_t m, int q)
+{
+  return (q >= 0) ? (double)m * pow10_table[q] : (double)m / pow10_table[-q];
+}
+
+// Strip trailing zeros of the mantissa (while the exponent is below 'qmax').
+inline void Normalize(Decimal& dec, int qmax)
+{
+  while (dec.m != 0 && dec.m % 10 == 0 && dec.q < qmax) {
+    dec.m /= 10;
+    dec.q++;
+  }
+}
+
+// Append a stream of integers: differences along time (of the order giving the
+// smaller output), zigzag coded and bit-packed.
+void PutStream(std::vector<uint8_t>& buf, const std::vector<int64_t>& values)
+{
+  size_t n = values.size();
+  std::vector<uint64_t> diff(n);
+  std::vector<uint8_t>  best;
+
+  for (int order = 1; order <= 2; order++) {
+    std::vector<uint64_t> cur(values.begin(), values.end());
+    for (int k = 0; k < order; k++) {
+      for (size_t i = n; i-- > 1;)
+        cur[i] -= cur[i - 1];
+    }
+    for (size_t i = 0; i < n; i++)
+      diff[i] = ZigZag((int64_t)cur[i]);
+
+    std::vector<uint8_t> tmp;
+    tmp.push_back((uint8_t)order);
+    PutBlocks(tmp, diff.empty() ? NULL : &diff[0], n);
+    if (best.empty() || tmp.size() < best.size())
+      best.swap(tmp);
+  }
+
+  buf.insert(buf.end(), best.begin(), best.end());
+}
+
+// Destinations of a decoded stream: integers, doubles (from their bits), or
+// integers scaled by a power of ten (multiplied or divided).
+struct IntegerSink {
+  int64_t* out;
+  void operator()(size_t i, uint64_t v) const { out[i] = (int64_t)v; }
+};
+
+struct BitsSink {
+  double* out;
+  void operator()(size_t i, uint64_t v) const { out[i] = BitsDouble(v); }
+};
+
+struct MultiplySink {
+  double* out;
+  double  scale;
+  void operator()(size_t i, uint64_t v) const { out[i] = (double)(int64_t)v * scale; }
+};
+
+struct DivideSink {
+  double* out;
+  double  scale;
+  void operator()(size_t i, uint64_t v) const { out[i] = (double)(int64_t)v / scale; }
+};
+
+// Read a stream of n integers. Each block is unpacked, summed, and passed to
+// the sink while still in cache.
+template <typename Sink>
+bool GetStream(ByteReader& reader, size_t n, const Sink& sink)
+{
+  int order = reader.Byte();
+  if (order < 1 || order > 2) {
+    reader.ok = false;
+    return false;
+  }
+
+  uint64_t work[bitpack_block_size];
+  uint64_t acc = 0;
+  uint64_t vel = 0;
+
+  for (size_t start = 0; start < n; start += bitpack_block_size) {
+    size_t count = std::min(n - start, (size_t)bitpack_block_size);
+    reader.Blocks(work, count);
+    if (!reader.ok)
+      return false;
+
+    if (order == 1) {
+      for (size_t i = 0; i < count; i++) {
+        acc += (uint64_t)UnZigZag(work[i]);
+        sink(start + i, acc);
+      }
+    } else {
+      for (size_t i = 0; i < count; i++) {
+        vel += (uint64_t)UnZigZag(work[i]);
+        acc += vel;
+        sink(start + i, acc);
+      }
+    }
+  }
+
+  return true;
+}
+
+// Read the exceptions of a column and patch the decoded values.
+bool GetExceptions(ByteReader&           reader,
+                   size_t                n,
+                   std::vector<int64_t>& rows,
+                   std::vector<int64_t>& bits,
+                   double*               values)
+{
+  size_t count = (size_t)reader.Varint();
+  if (!reader.ok || count > n)
+    return false;
+  if (count == 0)
+    return true;
+
+  rows.resize(count);
+  bits.resize(count);
+  IntegerSink row_sink = {&rows[0]};
+  IntegerSink bits_sink = {&bits[0]};
+  if (!GetStream(reader, count, row_sink) || !GetStream(reader, count, bits_sink))
+    return false;
+
+  for (size_t i = 0; i < count; i++) {
+    if ((uint64_t)rows[i] >= n)
+      return false;
+    values[rows[i]] = BitsDouble((uint64_t)bits[i]);
+  }
+
+  return true;
+}
+
+// Values that a mode does not reproduce exactly are stored as exceptions: the
+// row and the bits of the double. The mode then repeats the previous integers
+// at that row (so that exceptions do not disturb the differences).
+struct Exceptions {
+  std::vector<int64_t> rows;
+  std::vector<int64_t> bits;
+};
+
+void PutExceptions(std::vector<uint8_t>& buf, const Exceptions& exc)
+{
+  PutVarint(buf, exc.rows.size());
+  if (!exc.rows.empty()) {
+    PutStream(buf, exc.rows);
+    PutStream(buf, exc.bits);
+  }
+}
+
+// SCALED mode: values as integers N times the power of ten 10^p.
+void EncodeScaled(const std::vector<Decimal>& decs,
+                  const DataVector&           values,
+                  int                         p,
+                  std::vector<uint8_t>&       buf)
+{
+  size_t n = decs.size();
+  std::vector<int64_t> N(n);
+  Exceptions           exc;
+  int64_t              prev = 0;
+
+  for (size_t i = 0; i < n; i++) {
+    int  shift = decs[i].q - p;
+    bool ok = decs[i].valid && shift >= 0 && shift <= 15;
+    if (ok) {
+      int64_t scale = 1;
+      for (int k = 0; k < shift; k++)
+        scale *= 10;
+      ok = Abs64(decs[i].m) <= max_mantissa / scale;
+      if (ok)
+        N[i] = decs[i].m * scale;
+    }
+    if (!ok || DoubleBits(ScaleDecimal(N[i], p)) != DoubleBits(values[i])) {
+      N[i] = prev;
+      exc.rows.push_back(i);
+      exc.bits.push_back((int64_t)DoubleBits(values[i]));
+    }
+    prev = N[i];
+  }
+
+  buf.push_back(COLUMN_SCALED);
+  PutVarint(buf, ZigZag(p));
+  PutStream(buf, N);
+  PutExceptions(buf, exc);
+}
+
+// DECIMAL mode: a mantissa and a decimal exponent per value.
+void EncodeDecimal(const std::vector<Decimal>& decs,
+                   const DataVector&           values,
+                   std::vector<uint8_t>&       buf)
+{
+  size_t n = decs.size();
+  std::vector<int64_t> m(n);
+  std::vector<int64_t> q(n);
+  Exceptions           exc;
+
+  for (size_t i = 0; i < n; i++) {
+    Decimal dec = decs[i];
+    if (dec.valid && dec.q < -max_pow10)
+      Normalize(dec, -max_pow10);
+    m[i] = dec.m;
+    q[i] = dec.q;
+    bool ok = dec.valid && Abs64(dec.m) <= max_mantissa && dec.q >= -max_pow10 && dec.q <= max_pow10;
+    if (!ok || DoubleBits(ScaleDecimal(dec.m, dec.q)) != DoubleBits(values[i])) {
+      m[i] = (i > 0) ? m[i - 1] : 0;
+      q[i] = (i > 0) ? q[i - 1] : 0;
+      exc.rows.push_back(i);
+      exc.bits.push_back((int64_t)DoubleBits(values[i]));
+    }
+  }
+
+  buf.push_back(COLUMN_DECIMAL);
+  PutStream(buf, m);
+  PutStream(buf, q);
+  PutExceptions(buf, exc);
+}
+
+// RAW mode: the bits of the doubles.
+void EncodeRaw(const DataVector&     values,
+               std::vector<uint8_t>& buf)
+{
+  std::vector<int64_t> bits(values.size());
+  for (size_t i = 0; i < values.size(); i++)
+    bits[i] = (int64_t)DoubleBits(values[i]);
+
+  buf.push_back(COLUMN_RAW);
+  PutStream(buf, bits);
+}
+
+// Append the smallest encoding of a column: SCALED with any of the exponents
+// of its (normalized) values, DECIMAL, or RAW.
+void PutColumn(const std::vector<Decimal>& decs,
+               const DataVector&           values,
+               std::vector<uint8_t>&       buf)
+{
+  std::vector<Decimal> normalized(decs);
+  std::vector<int>     exps;
+  for (size_t i = 0; i < normalized.size(); i++) {
+    Normalize(normalized[i], max_pow10);
+    if (normalized[i].valid && normalized[i].m != 0 &&
+        normalized[i].q >= -max_pow10 && normalized[i].q <= max_pow10)
+      exps.push_back(normalized[i].q);
+  }
+  std::sort(exps.begin(), exps.end());
+  exps.erase(std::unique(exps.begin(), exps.end()), exps.end());
+  if (exps.empty())
+    exps.push_back(0);
+
+  std::vector<uint8_t> best;
+  std::vector<uint8_t> tmp;
+  for (size_t k = 0; k < exps.size(); k++) {
+    tmp.clear();
+    EncodeScaled(normalized, values, exps[k], tmp);
+    if (best.empty() || tmp.size() < best.size())
+      best.swap(tmp);
+  }
+
+  tmp.clear();
+  EncodeDecimal(decs, values, tmp);
+  if (tmp.size() < best.size())
+    best.swap(tmp);
+
+  tmp.clear();
+  EncodeRaw(values, tmp);
+  if (tmp.size() < best.size())
+    best.swap(tmp);
+
+  buf.insert(buf.end(), best.begin(), best.end());
+}
+
+// Split a text file into lines (without the line terminators).
+bool ReadLines(const std::string& filename, std::vector<std::string>& lines)
+{
+  std::ifstream ifile(filename.c_str());
+  if (!ifile.is_open())
+    return false;
+
+  std::string line;
+  while (std::getline(ifile, line))
+    lines.push_back(line);
+
+  return lines.size() >= 3;
+}
+
+// Return the file name without directory.
+std::string BaseName(const std::string& filename)
+{
+  size_t pos = filename.find_last_of("/\\");
+  return (pos == std::string::npos) ? filename : filename.substr(pos + 1);
+}
+
+// Name of the bundle (case) of a data file: the file name without directory,
+// up to and including the "_ADAMS" source marker, so that channels with an
+// underscore in their name stay with their case (e.g.
+// "RevSpherical_Case01_ADAMS" for "RevSpherical_Case01_ADAMS_Pos.txt" and
+// "..._ADAMS_Rforce_Body1.txt"). Other files: the name without extension and
+// last "_<channel>" part.
+std::string BundleName(const std::string& filename)
+{
+  std::string name = BaseName(filename);
+  size_t      pos = name.find("_ADAMS_");
+  if (pos != std::string::npos && pos > 0)
+    return name.substr(0, pos + 6);
+
+  pos = name.find_last_of('.');
+  if (pos != std::string::npos && pos > 0)
+    name = name.substr(0, pos);
+  pos = name.find_last_of('_');
+  if (pos != std::string::npos && pos > 0)
+    name = name.substr(0, pos);
+  return name;
+}
+
+// Split a line of column headers as ChValidation::ReadDataFile does
+// (std::getline drops an empty last field).
+void SplitHeaders(const std::string& line, Headers& headers)
+{
+  headers.clear();
+  size_t start = 0;
+  while (start < line.size()) {
+    size_t end = line.find('\t', start);
+    if (end == std::string::npos)
+      end = line.size();
+    headers.push_back(line.substr(start, end - start));
+    start = end + 1;
+  }
+}
+
+bool SameColumn(const DataVector& a, const DataVector& b)
+{
+  return a.size() == b.size() && (a.size() == 0 || memcmp(&a[0], &b[0], a.size() * sizeof(double)) == 0);
+}
+
+// A data file, parsed for packing.
+struct ParsedFile {
+  std::string                        lines[3];
+  Headers                            headers;
+  Data                               data;       // values every mode must reproduce exactly
+  std::vector<std::vector<Decimal> > decs;       // their decimal representation
+};
+
+bool ParseFile(const std::string& filename, ParsedFile& file)
+{
+  std::vector<std::string> lines;
+  if (!ReadLines(filename, lines)) {
+    std::cout << "ERROR: cannot read data file " << filename << std::endl;
+    return false;
+  }
+
+  ChValidation::ReadDataFile(filename, '\t', file.headers, file.data);
+
+  size_t num_cols = file.headers.size();
+  size_t num_rows = file.data.empty() ? 0 : file.data[0].size();
+
+  // Decimal representation of the values (one text line per row).
+  file.decs.assign(num_cols, std::vector<Decimal>(num_rows));
+  for (size_t row = 0; row < num_rows; row++) {
+    std::stringstream iss(row + 3 < lines.size() ? lines[row + 3] : std::string());
+    std::string       token;
+    for (size_t col = 0; col < num_cols; col++) {
+      file.decs[col][row].valid = false;
+      if (iss >> token)
+        ParseDecimal(token, file.decs[col][row]);
+    }
+  }
+
+  for (int i = 0; i < 3; i++)
+    file.lines[i] = lines[i];
+
+  return true;
+}
+
+// Encode the data files of one bundle.
+bool EncodeBundle(const std::vector<std::string>& filenames, std::vector<uint8_t>& buf)
+{
+  std::vector<ParsedFile> files(filenames.size());
+  for (size_t i = 0; i < filenames.size(); i++) {
+    if (!ParseFile(filenames[i], files[i]))
+      return false;
+  }
+
+  // The time column is the first column of the first data file.
+  std::vector<uint8_t> time;
+  size_t               num_rows = 0;
+  const ParsedFile*    first = NULL;
+  if (!files.empty() && !files[0].data.empty()) {
+    first = &files[0];
+    num_rows = first->data[0].size();
+    PutColumn(first->decs[0], first->data[0], time);
+  }
+
+  // Channel directory and encoded columns.
+  std::vector<uint8_t> directory;
+  std::vector<uint8_t> columns;
+  for (size_t i = 0; i < files.size(); i++) {
+    const ParsedFile& file = files[i];
+    size_t            num_cols = file.headers.size();
+    bool              shared = first && num_cols > 0 && SameColumn(file.data[0], first->data[0]);
+    size_t            offset = time.size() + columns.size();
+
+    for (size_t col = shared ? 1 : 0; col < num_cols; col++)
+      PutColumn(file.decs[col], file.data[col], columns);
+
+    PutString(directory, BaseName(filenames[i]));
+    for (int k = 0; k < 3; k++)
+      PutString(directory, file.lines[k]);
+    PutVarint(directory, file.data.empty() ? 0 : file.data[0].size());
+    PutVarint(directory, num_cols);
+    directory.push_back(shared ? 1 : 0);
+    PutVarint(directory, offset);
+    PutVarint(directory, time.size() + columns.size() - offset);
+  }
+
+  PutVarint(buf, num_rows);
+  PutVarint(buf, time.size());
+  PutVarint(buf, files.size());
+  buf.insert(buf.end(), directory.begin(), directory.end());
+  buf.insert(buf.end(), time.begin(), time.end());
+  buf.insert(buf.end(), columns.begin(), columns.end());
+
+  return true;
+}
+
+// Multiplier and divisor for each exponent q in [-max_pow10, max_pow10], at
+// index q + max_pow10 (one of the two is 1).
+struct ExponentTables {
+  ExponentTables()
+  {
+    for (int q = -max_pow10; q <= max_pow10; q++) {
+      mul[q + max_pow10] = (q >= 0) ? pow10_table[q] : 1.0;
+      div[q + max_pow10] = (q < 0) ? pow10_table[-q] : 1.0;
+    }
+  }
+  double mul[2 * max_pow10 + 1];
+  double div[2 * max_pow10 + 1];
+};
+
+const ExponentTables exponent_tables;
+
+// Decode one column of n values (s1 and s2 are scratch space).
+bool GetColumn(ByteReader&           reader,
+               size_t                n,
+               double*               out,
+               std::vector<int64_t>& s1,
+               std::vector<int64_t>& s2)
+{
+  switch (reader.Byte()) {
+  case COLUMN_SCALED: {
+    int p = (int)UnZigZag(reader.Varint());
+    if (p > max_pow10 || p < -max_pow10)
+      return false;
+    if (p >= 0) {
+      MultiplySink sink = {out, pow10_table[p]};
+      if (!GetStream(reader, n, sink))
+        return false;
+    } else {
+      DivideSink sink = {out, pow10_table[-p]};
+      if (!GetStream(reader, n, sink))
+        return false;
+    }
+    break;
+  }
+  case COLUMN_DECIMAL: {
+    s1.resize(n);
+    s2.resize(n);
+    IntegerSink m_sink = {&s1[0]};
+    IntegerSink q_sink = {&s2[0]};
+    if (!GetStream(reader, n, m_sink) || !GetStream(reader, n, q_sink))
+      return false;
+    for (size_t i = 0; i < n; i++) {
+      uint64_t k = (uint64_t)(s2[i] + max_pow10);
+      if (k > 2 * max_pow10)
+        return false;
+      out[i] = (double)s1[i] * exponent_tables.mul[k] / exponent_tables.div[k];
+    }
+    break;
+  }
+  case COLUMN_RAW: {
+    BitsSink sink = {out};
+    return GetStream(reader, n, sink);
+  }
+  default:
+    return false;
+  }
+
+  return GetExceptions(reader, n, s1, s2, out);
+}
+
+// Decode num_cols columns of n values each, from the given bytes.
+bool GetColumns(const uint8_t* bytes,
+                size_t         size,
+                size_t         n,
+                size_t         first_col,
+                Data&          data)
+{
+  size_t num_cols = data.size() - first_col;
+
+  // Every column takes at least one byte per block of values.
+  size_t num_blocks = (n + bitpack_block_size - 1) / bitpack_block_size;
+  if (num_cols > size || (num_cols > 0 && num_blocks > size / num_cols))
+    return false;
+
+  ByteReader           reader(bytes, size);
+  std::vector<int64_t> s1;
+  std::vector<int64_t> s2;
+
+  for (size_t col = first_col; col < data.size(); col++) {
+    data[col].resize(n);
+    if (n > 0 && !GetColumn(reader, n, &data[col][0], s1, s2))
+      return false;
+  }
+
+  return reader.ok;
+}
+
+}  // anonymous namespace
+
+
+// -----------------------------------------------------------------------------
+// ChReferenceStore
+// -----------------------------------------------------------------------------
+bool ChReferenceStore::Open(const std::string& filename)
+{
+  ChTraceSpan span(ChTrace::IsEnabled() ? "Open " + filename : std::string(), "io");
+
+  m_buffer.clear();
+  m_bundles.clear();
+  m_channels.clear();
+  m_index.clear();
+
+  std::ifstream ifile(filename.c_str(), std::ios::binary);
+  if (!ifile.is_open())
+    return false;
+
+  ifile.seekg(0, std::ios::end);
+  std::streamoff file_size = ifile.tellg();
+  ifile.seekg(0, std::ios::beg);
+  if (file_size < 5)
+    return false;
+
+  m_buffer.resize((size_t)file_size);
+  if (!ifile.read((char*)&m_buffer[0], file_size))
+    return false;
+
+  ByteReader reader(&m_buffer[0], m_buffer.size());
+  bool valid = (memcmp(&m_buffer[0], store_magic, 4) == 0);
+  reader.p += 4;
+  valid = valid && (reader.Byte() == store_version);
+
+  // Bundle index (offsets are relative to the end of the index).
+  size_t num_bundles = valid ? (size_t)reader.Varint() : 0;
+  std::vector<size_t> offsets;
+  std::vector<size_t> sizes;
+  for (size_t i = 0; i < num_bundles && reader.ok; i++) {
+    reader.String();
+    offsets.push_back((size_t)reader.Fixed(8));
+    sizes.push_back((size_t)reader.Fixed(8));
+  }
+
+  size_t base = reader.p - &m_buffer[0];
+  valid = valid && reader.ok;
+
+  // Channel directories.
+  for (size_t i = 0; i < offsets.size() && valid; i++) {
+    valid = offsets[i] <= m_buffer.size() - base && sizes[i] <= m_buffer.size() - base - offsets[i];
+    if (!valid)
+      break;
+
+    const uint8_t* start = &m_buffer[base + offsets[i]];
+    ByteReader     bundle_reader(start, sizes[i]);
+
+    Bundle bundle;
+    bundle.num_rows = (size_t)bundle_reader.Varint();
+    bundle.time_size = (size_t)bundle_reader.Varint();
+    size_t num_channels = (size_t)bundle_reader.Varint();
+
+    std::vector<Channel> channels;
+    for (size_t k = 0; k < num_channels && bundle_reader.ok; k++) {
+      Channel channel;
+      channel.name = bundle_reader.String();
+      for (int j = 0; j < 3; j++)
+        channel.lines[j] = bundle_reader.String();
+      channel.num_rows = (size_t)bundle_reader.Varint();
+      channel.num_cols = (size_t)bundle_reader.Varint();
+      channel.shared_time = (bundle_reader.Byte() != 0);
+      channel.offset = (size_t)bundle_reader.Varint();
+      channel.size = (size_t)bundle_reader.Varint();
+      channel.bundle = m_bundles.size();
+      channels.push_back(channel);
+    }
+
+    // Offsets in the directory are relative to its end.
+    size_t data_start = base + offsets[i] + (bundle_reader.p - start);
+    size_t data_size = sizes[i] - (bundle_reader.p - start);
+    valid = bundle_reader.ok && bundle.time_size <= data_size;
+    bundle.time_offset = data_start;
+
+    for (size_t k = 0; k < channels.size() && valid; k++) {
+      Channel& channel = channels[k];
+      valid = channel.offset <= data_size && channel.size <= data_size - channel.offset &&
+              (!channel.shared_time ||
+               (bundle.time_size > 0 && channel.num_cols > 0 && channel.num_rows == bundle.num_rows));
+      channel.offset += data_start;
+
+      // The first channel with a given name is used.
+      if (valid && m_index.find(channel.name) == m_index.end()) {
+        bundle.channels.push_back(m_channels.size());
+        m_index[channel.name] = m_channels.size();
+        m_channels.push_back(channel);
+      }
+    }
+
+    m_bundles.push_back(bundle);
+  }
+
+  if (!valid) {
+    m_buffer.clear();
+    m_bundles.clear();
+    m_channels.clear();
+    m_index.clear();
+    return false;
+  }
+
+  return true;
+}
+
+bool ChReferenceStore::DecodeTime(const Bundle& bundle,
+                                  DataVector&   time) const
+{
+  Data data(1);
+  if (!GetColumns(&m_buffer[0] + bundle.time_offset, bundle.time_size, bundle.num_rows, 0, data))
+    return false;
+  time.resize(bundle.num_rows);
+  time = data[0];
+  return true;
+}
+
+bool ChReferenceStore::DecodeChannel(const Channel&    channel,
+                                     const DataVector& time,
+                                     Data&             data) const
+{
+  data.resize(channel.num_cols);
+  if (channel.shared_time) {
+    data[0].resize(time.size());
+    data[0] = time;
+  }
+
+  return GetColumns(&m_buffer[0] + channel.offset, channel.size, channel.num_rows, channel.shared_time ? 1 : 0, data);
+}
+
+bool ChReferenceStore::Decode(const std::string& name,
+                              const Channel*&    channel,
+                              Data&              data) const
+{
+  std::map<std::string, size_t>::const_iterator itr = m_index.find(name);
+  if (itr == m_index.end())
+    return false;
+
+  channel = &m_channels[itr->second];
+
+  DataVector time;
+  if (channel->shared_time && !DecodeTime(m_bundles[channel->bundle], time))
+    return false;
+
+  return DecodeChannel(*channel, time, data);
+}
+
+bool ChReferenceStore::Read(const std::string& name,
+                            Headers&           headers,
+                            Data&              data) const
+{
+  const Channel* channel;
+  if (!Decode(name, channel, data))
+    return false;
+
+  SplitHeaders(channel->lines[2], headers);
+  return headers.size() == data.size();
+}
+
+bool ChReferenceStore::ReadBundle(const std::string&        name,
+                                  std::vector<std::string>& names,
+                                  std::vector<Headers>&     headers,
+                                  std::vector<Data>&        data) const
+{
+  std::map<std::string, size_t>::const_iterator itr = m_index.find(name);
+  if (itr == m_index.end())
+    return false;
+
+  const Bundle& bundle = m_bundles[m_channels[itr->second].bundle];
+
+  // The shared time column is decoded once for all channels.
+  DataVector time;
+  if (bundle.time_size > 0 && !DecodeTime(bundle, time))
+    return false;
+
+  size_t num_channels = bundle.channels.size();
+  names.resize(num_channels);
+  headers.resize(num_channels);
+  data.resize(num_channels);
+
+  for (size_t k = 0; k < num_channels; k++) {
+    const Channel& channel = m_channels[bundle.channels[k]];
+    names[k] = channel.name;
+    SplitHeaders(channel.lines[2], headers[k]);
+    if (!DecodeChannel(channel, time, data[k]) || headers[k].size() != data[k].size())
+      return false;
+  }
+
+  return true;
+}
+
+bool ChReferenceStore::ReadText(const std::string& name,
+                                std::string&       text) const
+{
+  const Channel* channel;
+  Data           data;
+  if (!Decode(name, channel, data))
+    return false;
+
+  size_t num_cols = data.size();
+  size_t num_rows = data.empty() ? 0 : data[0].size();
+
+  text.clear();
+  text.reserve((num_rows + 1) * num_cols * 14 + 256);
+  for (int i = 0; i < 3; i++)
+    text += channel->lines[i] + '\n';
+
+  char buf[32];
+  for (size_t row = 0; row < num_rows; row++) {
+    for (size_t col = 0; col < num_cols; col++) {
+      if (col > 0)
+        text += '\t';
+      sprintf(buf, "%+E", data[col][row]);
+      text += buf;
+    }
+    text += '\n';
+  }
+
+  return true;
+}
+
+
+// -----------------------------------------------------------------------------
+// Write a store with the specified data files, grouped in bundles by case.
+// -----------------------------------------------------------------------------
+bool WriteReferenceStore(const std::vector<std::string>& filenames,
+                         const std::string&              store_filename)
+{
+  std::vector<std::string>              names;
+  std::vector<std::vector<std::string> > groups;
+  std::map<std::string, size_t>         group_index;
+
+  for (size_t i = 0; i < filenames.size(); i++) {
+    std::string name = BundleName(filenames[i]);
+    std::map<std::string, size_t>::iterator itr = group_index.find(name);
+    if (itr == group_index.end()) {
+      itr = group_index.insert(std::make_pair(name, names.size())).first;
+      names.push_back(name);
+      groups.push_back(std::vector<std::string>());
+    }
+    groups[itr->second].push_back(filenames[i]);
+  }
+
+  std::vector<std::vector<uint8_t> > bundles(groups.size());
+  bool ok = true;
+
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < (int)groups.size(); i++) {
+    if (!EncodeBundle(groups[i], bundles[i])) {
+#pragma omp critical(ch_utils_reference_store)
+      ok = false;
+    }
+  }
+
+  if (!ok)
+    return false;
+
+  std::vector<uint8_t> header;
+  header.insert(header.end(), store_magic, store_magic + 4);
+  header.push_back(store_version);
+  PutVarint(header, bundles.size());
+
+  size_t offset = 0;
+  for (size_t i = 0; i < bundles.size(); i++) {
+    PutString(header, names[i]);
+    PutFixed(header, offset, 8);
+    PutFixed(header, bundles[i].size(), 8);
+    offset += bundles[i].size();
+  }
+
+  std::ofstream ofile(store_filename.c_str(), std::ios::binary);
+  if (!ofile.is_open()) {
+    std::cout << "ERROR: cannot write store file " << store_filename << std::endl;
+    return false;
+  }
+
+  ofile.write((const char*)&header[0], header.size());
+  for (size_t i = 0; i < bundles.size(); i++) {
+    if (!bundles[i].empty())
+      ofile.write((const char*)&bundles[i][0], bundles[i].size());
+  }
+
+  return ofile.good();
+}
+
+// -----------------------------------------------------------------------------
+// Name of the store file of the directory of a data file.
+// -----------------------------------------------------------------------------
+std::string GetReferenceStoreFile(const std::string& filename)
+{
+  size_t pos = filename.find_last_of("/\\");
+  if (pos == std::string::npos)
+    return "";
+
+  std::string dir = filename.substr(0, pos);
+  size_t      start = dir.find_last_of("/\\");
+  std::string dirname = (start == std::string::npos) ? dir : dir.substr(start + 1);
+  if (dirname.empty() || dirname == "." || dirname == "..")
+    return "";
+
+  return dir + "/" + dirname + ".refpack";
+}
+
+// -----------------------------------------------------------------------------
+// Name of the bundle file of the case of a data file.
+// -----------------------------------------------------------------------------
+std::string GetReferenceBundleFile(const std::string& filename)
+{
+  size_t pos = filename.find_last_of("/\\");
+  std::string dir = (pos == std::string::npos) ? "" : filename.substr(0, pos + 1);
+
+  return dir + BundleName(filename) + ".refpack";
+}
+
+
+} // namespace utils
+} // namespace chrono
@@ -0,0 +1,164 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Packed store of reference data files.
+//
+// A store holds the reference data files of one directory (e.g. all ADAMS
+// output files in data/revolute_joint/) in a single indexed file, named after
+// the directory: data/revolute_joint/revolute_joint.refpack.
+//
+// The files are grouped in bundles, one per case: the channels of a case
+// (e.g. Revolute_Case01_ADAMS_Pos.txt, ..._Vel.txt, ...) share a single time
+// column, and are listed in the channel directory of the bundle. A store with
+// the files of a single case is a bundle file, named after the case:
+// data/revolute_joint/Revolute_Case01_ADAMS.refpack.
+//
+// Every column of a data file is encoded losslessly (decoding gives the same
+// doubles as parsing the text file with ChValidation::ReadDataFile):
+//  - decimal values are represented exactly by integer mantissas scaled by a
+//    power of ten common to the column (or, if that does not fit, by a
+//    mantissa and a decimal exponent per value; or, as a last resort, by the
+//    raw bits of the doubles),
+//  - the integers are delta coded along time, zigzag coded, and bit-packed in
+//    blocks of 128 values.
+//
+// =============================================================================
+
+#ifndef CH_UTILS_REFERENCE_STORE_H
+#define CH_UTILS_REFERENCE_STORE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+#include "utils/ChApiUtils.h"
+#include "utils/ChUtilsValidation.h"
+
+
+namespace chrono {
+namespace utils {
+
+///
+/// Read access to a packed reference data store.
+///
+class CH_UTILS_API ChReferenceStore
+{
+public:
+
+  ChReferenceStore() {}
+  ~ChReferenceStore() {}
+
+  /// Read the specified store file (the complete file is loaded in memory).
+  /// Returns false if the file cannot be read or is not a valid store.
+  bool Open(const std::string& filename);
+
+  /// Return the number of data files (channels) in the store.
+  size_t GetNumEntries() const { return m_channels.size(); }
+  /// Return the name of the specified data file (file name without directory).
+  const std::string& GetName(size_t i) const { return m_channels[i].name; }
+  /// Return true if the store contains the data file with the given name.
+  bool Contains(const std::string& name) const { return m_index.find(name) != m_index.end(); }
+
+  /// Return the number of bundles (cases) in the store.
+  size_t GetNumBundles() const { return m_bundles.size(); }
+
+  /// Decode the specified data file (same output as ChValidation::ReadDataFile
+  /// for the TAB-delimited text file). Returns false if not found or corrupt.
+  bool Read(const std::string& name,
+            Headers&           headers,
+            Data&              data) const;
+
+  /// Decode all data files in the bundle of the specified data file (i.e. all
+  /// channels of its case), decoding their shared time column only once.
+  /// Returns the names of the files, and their headers and data.
+  bool ReadBundle(const std::string&        name,
+                  std::vector<std::string>& names,
+                  std::vector<Headers>&     headers,
+                  std::vector<Data>&        data) const;
+
+  /// Decode the specified data file and regenerate its text, with the
+  /// original first three lines and values in "%+E" format.
+  bool ReadText(const std::string& name,
+                std::string&       text) const;
+
+private:
+
+  struct Bundle {
+    size_t              num_rows;      // rows of the time column
+    size_t              time_offset;   // encoded time column
+    size_t              time_size;
+    std::vector<size_t> channels;
+  };
+
+  struct Channel {
+    std::string name;
+    std::string lines[3];        // first three lines of the text file
+    size_t      bundle;
+    size_t      num_rows;
+    size_t      num_cols;
+    bool        shared_time;     // first column is the time column of the bundle?
+    size_t      offset;          // encoded columns (other than the shared time)
+    size_t      size;
+  };
+
+  bool DecodeTime(const Bundle& bundle,
+                  DataVector&   time) const;
+  bool DecodeChannel(const Channel&    channel,
+                     const DataVector& time,
+                     Data&             data) const;
+  bool Decode(const std::string& name,
+              const Channel*&    channel,
+              Data&              data) const;
+
+  std::vector<uint8_t>           m_buffer;
+  std::vector<Bundle>            m_bundles;
+  std::vector<Channel>           m_channels;
+  std::map<std::string, size_t>  m_index;      // channel of each file name
+};
+
+// -----------------------------------------------------------------------------
+// Free function declarations
+// -----------------------------------------------------------------------------
+
+/// Pack the specified TAB-delimited data files (e.g. all reference files in a
+/// directory) into a store file. Files are stored under their names without
+/// directory, in one bundle per case (file name up to the "_ADAMS" marker, see
+/// GetReferenceBundleFile). Each file is verified to decode to the same values
+/// as its text.
+/// Returns false if a file cannot be read or the store cannot be written.
+CH_UTILS_API
+bool WriteReferenceStore(const std::vector<std::string>& filenames,
+                         const std::string&              store_filename);
+
+/// Return the name of the store file for the given data file: the file
+/// <dir>/<dir>.refpack in the directory <dir> of the data file.
+CH_UTILS_API
+std::string GetReferenceStoreFile(const std::string& filename);
+
+/// Return the name of the bundle file for the given data file: the file
+/// <case>_ADAMS.refpack next to the data file <case>_ADAMS_<channel>.txt (the
+/// channel may contain underscores, e.g. Rforce_Body1). For files without the
+/// "_ADAMS" marker, <case>.refpack for <case>_<channel>.txt.
+/// This is the only place where bundle names are defined; the build obtains
+/// them from 'reference_pack bundle -l'.
+CH_UTILS_API
+std::string GetReferenceBundleFile(const std::string& filename);
+
+
+} // namespace utils
+} // namespace chrono
+
+
+#endif
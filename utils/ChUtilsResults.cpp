@@ -0,0 +1,217 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Utilities for JSON Lines result files (one JSON test record per line).
+//
+// =============================================================================
+
+#include <fstream>
+#include <fcntl.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#define RAPIDJSON_HAS_STDSTRING 1
+#include "../include/rapidjson/document.h"
+
+#include "utils/ChUtilsResults.h"
+
+namespace chrono {
+namespace utils {
+
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+bool ChResultRecord::GetMetric(const std::string& metric, double& value) const
+{
+  if (metric == "execution_time") {
+    value = execution_time;
+    return true;
+  }
+
+  std::map<std::string, double>::const_iterator itr = metrics.find(metric);
+  if (itr == metrics.end())
+    return false;
+
+  value = itr->second;
+  return true;
+}
+
+
+// -----------------------------------------------------------------------------
+// Load records from a JSON Lines file.
+// -----------------------------------------------------------------------------
+static std::string GetStringMember(const rapidjson::Value& obj, const char* name)
+{
+  if (obj.HasMember(name) && obj[name].IsString())
+    return std::string(obj[name].GetString(), obj[name].GetStringLength());
+  return std::string();
+}
+
+static double GetNumberMember(const rapidjson::Value& obj, const char* name)
+{
+  if (obj.HasMember(name) && obj[name].IsNumber())
+    return obj[name].GetDouble();
+  return 0;
+}
+
+size_t ChResultsReader::Load(const std::string& filename)
+{
+  std::ifstream ifile(filename.c_str());
+  std::string   line;
+  size_t        num_read = 0;
+
+  while (std::getline(ifile, line)) {
+    if (line.empty())
+      continue;
+
+    rapidjson::Document doc;
+    doc.Parse(line.c_str());
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("name")) {
+      m_num_skipped++;
+      continue;
+    }
+
+    ChResultRecord record;
+    record.name = GetStringMember(doc, "name");
+    record.project_name = GetStringMember(doc, "project_name");
+    record.revision = GetStringMember(doc, "revision");
+    record.host = GetStringMember(doc, "host");
+    record.build_type = GetStringMember(doc, "build_type");
+    record.signature = GetStringMember(doc, "signature");
+    record.timestamp = GetNumberMember(doc, "timestamp");
+    record.execution_time = GetNumberMember(doc, "execution_time");
+    record.passed = doc.HasMember("passed") && doc["passed"].IsBool() && doc["passed"].GetBool();
+    record.perf_regression = doc.HasMember("perf_regression") && doc["perf_regression"].IsBool() &&
+                             doc["perf_regression"].GetBool();
+
+    if (doc.HasMember("metrics") && doc["metrics"].IsObject()) {
+      const rapidjson::Value& metrics = doc["metrics"];
+      for (rapidjson::Value::ConstMemberIterator itr = metrics.MemberBegin(); itr != metrics.MemberEnd(); ++itr) {
+        if (itr->value.IsNumber())
+          record.metrics[itr->name.GetString()] = itr->value.GetDouble();
+      }
+    }
+
+    m_index[record.name].push_back(m_records.size());
+    m_records.push_back(record);
+    num_read++;
+  }
+
+  return num_read;
+}
+
+void ChResultsReader::Clear()
+{
+  m_records.clear();
+  m_index.clear();
+  m_num_skipped = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Queries
+// -----------------------------------------------------------------------------
+std::vector<std::string> ChResultsReader::GetTestNames() const
+{
+  std::vector<std::string> names;
+  std::map<std::string, std::vector<size_t> >::const_iterator itr = m_index.begin();
+  for (; itr != m_index.end(); ++itr)
+    names.push_back(itr->first);
+  return names;
+}
+
+const std::vector<size_t>& ChResultsReader::Find(const std::string& name) const
+{
+  static const std::vector<size_t> empty;
+
+  std::map<std::string, std::vector<size_t> >::const_iterator itr = m_index.find(name);
+  return (itr == m_index.end()) ? empty : itr->second;
+}
+
+std::vector<size_t> ChResultsReader::Find(const std::string& name,
+                                          const std::string& revision,
+                                          const std::string& host,
+                                          const std::string& build_type) const
+{
+  const std::vector<size_t>& all = Find(name);
+  std::vector<size_t> found;
+
+  for (size_t i = 0; i < all.size(); i++) {
+    const ChResultRecord& record = m_records[all[i]];
+    if (!revision.empty() && record.revision != revision)
+      continue;
+    if (!host.empty() && record.host != host)
+      continue;
+    if (!build_type.empty() && record.build_type != build_type)
+      continue;
+    found.push_back(all[i]);
+  }
+
+  return found;
+}
+
+int ChResultsReader::FindLatest(const std::string& name,
+                                const std::string& host,
+                                const std::string& build_type) const
+{
+  std::vector<size_t> found = Find(name, "", host, build_type);
+  return found.empty() ? -1 : (int)found.back();
+}
+
+
+// -----------------------------------------------------------------------------
+// Append one record to a JSON Lines file, with a single write() call on a file
+// descriptor opened with O_APPEND. POSIX guarantees that the file offset is set
+// to the end of file and the data written as one atomic step, so records from
+// concurrent processes never interleave.
+// -----------------------------------------------------------------------------
+bool AppendJsonLine(const std::string& filename,
+                    const std::string& record,
+                    bool               sync)
+{
+  std::string line = record + "\n";
+
+#if defined(_WIN32)
+  int fd = _open(filename.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+  if (fd < 0)
+    return false;
+
+  int written = _write(fd, line.c_str(), (unsigned int)line.size());
+  bool ok = (written == (int)line.size());
+  if (sync)
+    ok &= (_commit(fd) == 0);
+  ok &= (_close(fd) == 0);
+#else
+  int fd = open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (fd < 0)
+    return false;
+
+  ssize_t written = write(fd, line.c_str(), line.size());
+  bool ok = (written == (ssize_t)line.size());
+  if (sync)
+    ok &= (fsync(fd) == 0);
+  ok &= (close(fd) == 0);
+#endif
+
+  return ok;
+}
+
+
+}  // namespace utils
+}  // namespace chrono
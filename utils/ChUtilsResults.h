@@ -0,0 +1,129 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Utilities for JSON Lines result files (one JSON test record per line).
+//
+// Records are appended with a single write on a file opened in append mode,
+// so that concurrent test processes (e.g. 'ctest -j') can safely share one
+// results file: every record is either fully present or absent.
+//
+// =============================================================================
+
+#ifndef CH_UTILS_RESULTS_H
+#define CH_UTILS_RESULTS_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "utils/ChApiUtils.h"
+
+
+namespace chrono {
+namespace utils {
+
+/// One test record read from a results file.
+/// Only scalar (numeric) metrics are retained.
+struct CH_UTILS_API ChResultRecord {
+  std::string name;             ///< test name
+  std::string project_name;     ///< project name
+  std::string revision;         ///< git revision of the tests
+  std::string host;             ///< machine that ran the test
+  std::string build_type;       ///< build type (Release, Debug, ...)
+  std::string signature;        ///< arguments of the run (empty if none)
+  double      timestamp;        ///< time of the run (seconds since epoch; 0 if unknown)
+  bool        passed;           ///< did the test pass?
+  bool        perf_regression;  ///< was a performance regression detected?
+  double      execution_time;   ///< total test execution time
+  std::map<std::string, double> metrics;  ///< numeric scalar metrics
+
+  /// Return the value of a metric ("execution_time" is also accepted).
+  /// Returns false if the record does not have the specified metric.
+  bool GetMetric(const std::string& metric, double& value) const;
+};
+
+///
+/// Reader for JSON Lines result files.
+/// Records are loaded in file order and indexed by test name. Lines which
+/// cannot be parsed are skipped (and counted).
+///
+class CH_UTILS_API ChResultsReader
+{
+public:
+
+  ChResultsReader() : m_num_skipped(0) {}
+  ~ChResultsReader() {}
+
+  /// Load all records from the specified file, appending to the records
+  /// already loaded. Returns the number of records read from this file.
+  size_t Load(const std::string& filename);
+
+  /// Remove all loaded records.
+  void Clear();
+
+  /// Return the number of records loaded.
+  size_t GetNumRecords() const { return m_records.size(); }
+  /// Return the number of lines that could not be parsed.
+  size_t GetNumSkipped() const { return m_num_skipped; }
+
+  /// Return the specified record.
+  const ChResultRecord& GetRecord(size_t i) const { return m_records[i]; }
+
+  /// Return the names of all tests with at least one record.
+  std::vector<std::string> GetTestNames() const;
+
+  /// Return the indices (in file order) of all records for the given test.
+  const std::vector<size_t>& Find(const std::string& name) const;
+
+  /// Return the indices (in file order) of the records for the given test
+  /// which also match the given revision, host, and build type. An empty
+  /// string matches any value.
+  std::vector<size_t> Find(const std::string& name,
+                           const std::string& revision,
+                           const std::string& host,
+                           const std::string& build_type) const;
+
+  /// Return the index of the most recent record for the given test (matching
+  /// the given host and build type; empty strings match any value) or -1.
+  int FindLatest(const std::string& name,
+                 const std::string& host = "",
+                 const std::string& build_type = "") const;
+
+private:
+
+  std::vector<ChResultRecord>                   m_records;
+  std::map<std::string, std::vector<size_t> >   m_index;
+  size_t                                        m_num_skipped;
+};
+
+// -----------------------------------------------------------------------------
+// Free function declarations
+// -----------------------------------------------------------------------------
+
+/// Append one record to a JSON Lines file.
+/// The record (which must not contain newlines) and its terminating newline are
+/// written with a single write call on a file opened in append mode, which
+/// makes appends from concurrent processes atomic with respect to each other.
+/// If 'sync' is true, the data is flushed to disk before returning.
+CH_UTILS_API
+bool AppendJsonLine(const std::string& filename,
+                    const std::string& record,
+                    bool               sync = false);
+
+
+} // namespace utils
+} // namespace chrono
+
+
+#endif
@@ -0,0 +1,381 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Compact (quantized) snapshot stream of body poses.
+//
+// File layout (all multi-byte integers little endian):
+//   header:  "CHSS", version (1 byte), resolution (8 bytes, IEEE double),
+//            bits per quaternion component (1 byte)
+//   frames:  payload size (4 bytes), then the payload:
+//            frame type (1 byte, 0: key, 1: delta), time (8 bytes, double),
+//            number of bodies (varint), then 7 value streams (x, y, z,
+//            index of the largest quaternion component, and the other three
+//            quaternion components).
+// In a key frame, each stream starts with its minimum value (zigzag varint)
+// and the values are stored relative to it; in a delta frame, the values are
+// the zigzag-encoded differences from the previous frame. The stream values
+// are then bit-packed in blocks of 128, each block prefixed with its bit width.
+//
+// =============================================================================
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include "utils/ChUtilsSnapshot.h"
+#include "utils/ChUtilsInputOutput.h"
+#include "utils/ChUtilsBitPacking.h"
+
+namespace chrono {
+namespace utils {
+
+
+// -----------------------------------------------------------------------------
+// Local variables
+// -----------------------------------------------------------------------------
+static const char  snapshot_magic[4] = {'C', 'H', 'S', 'S'};
+static const int   snapshot_version = 1;
+static const int   num_streams = 7;     // x, y, z, index, 3 quaternion components
+static const double sqrt2 = 1.41421356237309504880;
+
+// -----------------------------------------------------------------------------
+// Quantization of positions and orientations
+// -----------------------------------------------------------------------------
+static int64_t QuantizePosition(double x, double resolution)
+{
+  return (int64_t)std::floor(x / resolution + 0.5);
+}
+
+// Smallest-three encoding: index of the largest component, and the other three
+// components (of the quaternion with a positive largest component) quantized
+// over [-1/sqrt(2), 1/sqrt(2)].
+static void QuantizeRotation(const ChQuaternion<>& q, int bits, int64_t* out)
+{
+  double c[4] = {q.e0, q.e1, q.e2, q.e3};
+  double len = std::sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3]);
+  if (len == 0) {
+    c[0] = 1;
+    len = 1;
+  }
+
+  int idx = 0;
+  for (int j = 1; j < 4; j++) {
+    if (std::abs(c[j]) > std::abs(c[idx]))
+      idx = j;
+  }
+  double sign = (c[idx] < 0) ? -1.0 : 1.0;
+
+  int64_t max_code = (1 << bits) - 1;
+  double  scale = max_code / sqrt2;
+
+  out[0] = idx;
+  int k = 1;
+  for (int j = 0; j < 4; j++) {
+    if (j == idx)
+      continue;
+    double  v = sign * c[j] / len + 1 / sqrt2;
+    int64_t code = (int64_t)std::floor(v * scale + 0.5);
+    out[k++] = std::max((int64_t)0, std::min(max_code, code));
+  }
+}
+
+static ChQuaternion<> DequantizeRotation(const int64_t* in, int bits)
+{
+  double step = sqrt2 / ((1 << bits) - 1);
+  int    idx = (int)(in[0] & 3);
+
+  double c[4];
+  double sum = 0;
+  int    k = 1;
+  for (int j = 0; j < 4; j++) {
+    if (j == idx)
+      continue;
+    c[j] = in[k++] * step - 1 / sqrt2;
+    sum += c[j] * c[j];
+  }
+  c[idx] = std::sqrt(std::max(0.0, 1 - sum));
+
+  ChQuaternion<> q(c[0], c[1], c[2], c[3]);
+  q.Normalize();
+  return q;
+}
+
+static double RotationErrorBound(int bits)
+{
+  // Each of the three components is within half a step; the largest one is
+  // then within 3 half steps, and the angle within twice the quaternion error.
+  double half_step = 0.5 * sqrt2 / ((1 << bits) - 1);
+  return 2 * std::sqrt(12.0) * half_step;
+}
+
+
+// -----------------------------------------------------------------------------
+// ChSnapshotWriter
+// -----------------------------------------------------------------------------
+ChSnapshotWriter::ChSnapshotWriter(const std::string& filename,
+                                   double             resolution,
+                                   int                rot_bits,
+                                   int                keyframe_interval)
+: m_file(filename.c_str(), std::ios::binary),
+  m_resolution(resolution > 0 ? resolution : 1e-4),
+  m_rot_bits(std::max(10, std::min(16, rot_bits))),
+  m_keyframe_interval(std::max(1, keyframe_interval)),
+  m_num_frames(0),
+  m_num_bytes(0)
+{
+  if (!m_file.is_open())
+    return;
+
+  std::vector<uint8_t> header(snapshot_magic, snapshot_magic + 4);
+  header.push_back((uint8_t)snapshot_version);
+  PutFixed(header, DoubleBits(m_resolution), 8);
+  header.push_back((uint8_t)m_rot_bits);
+
+  m_file.write((const char*)&header[0], header.size());
+  m_num_bytes = header.size();
+}
+
+bool ChSnapshotWriter::WriteFrame(ChSystem* system,
+                                  bool      active_only)
+{
+  std::vector<ChVector<> >     pos;
+  std::vector<ChQuaternion<> > rot;
+
+  std::vector<ChBody*>& bodies = *system->Get_bodylist();
+  pos.reserve(bodies.size());
+  rot.reserve(bodies.size());
+  for (size_t i = 0; i < bodies.size(); i++) {
+    if (active_only && !bodies[i]->IsActive())
+      continue;
+    pos.push_back(bodies[i]->GetPos());
+    rot.push_back(bodies[i]->GetRot());
+  }
+
+  return WriteFrame(system->GetChTime(), pos, rot);
+}
+
+bool ChSnapshotWriter::WriteFrame(double                              time,
+                                  const std::vector<ChVector<> >&     pos,
+                                  const std::vector<ChQuaternion<> >& rot)
+{
+  if (!m_file.is_open() || pos.size() != rot.size())
+    return false;
+
+  int n = (int)pos.size();
+
+  // Quantize all values (stream-major order)
+  m_values.resize((size_t)num_streams * n);
+  int64_t* vx = &m_values[0];
+
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < n; i++) {
+    vx[i] = QuantizePosition(pos[i].x, m_resolution);
+    vx[n + i] = QuantizePosition(pos[i].y, m_resolution);
+    vx[2 * n + i] = QuantizePosition(pos[i].z, m_resolution);
+    int64_t r[4];
+    QuantizeRotation(rot[i], m_rot_bits, r);
+    for (int s = 0; s < 4; s++)
+      vx[(3 + s) * n + i] = r[s];
+  }
+
+  bool key = (m_num_frames % m_keyframe_interval == 0) || (m_prev.size() != m_values.size());
+
+  m_buffer.clear();
+  PutFixed(m_buffer, 0, 4);  // payload size, filled in below
+  m_buffer.push_back(key ? 0 : 1);
+  PutFixed(m_buffer, DoubleBits(time), 8);
+  PutVarint(m_buffer, (uint64_t)n);
+
+  std::vector<uint64_t> codes(n);
+  for (int s = 0; s < num_streams; s++) {
+    const int64_t* v = vx + (size_t)s * n;
+    if (key) {
+      // Values relative to the frame minimum (the frame bounding box, for
+      // positions)
+      int64_t base = (n > 0) ? *std::min_element(v, v + n) : 0;
+      PutVarint(m_buffer, ZigZag(base));
+      for (int i = 0; i < n; i++)
+        codes[i] = (uint64_t)(v[i] - base);
+    } else {
+      const int64_t* p = &m_prev[(size_t)s * n];
+      for (int i = 0; i < n; i++)
+        codes[i] = ZigZag(v[i] - p[i]);
+    }
+    if (n > 0)
+      PutBlocks(m_buffer, &codes[0], n);
+  }
+
+  uint64_t payload = m_buffer.size() - 4;
+  for (int i = 0; i < 4; i++)
+    m_buffer[i] = (uint8_t)(payload >> (8 * i));
+
+  m_file.write((const char*)&m_buffer[0], m_buffer.size());
+  m_file.flush();
+
+  m_num_bytes += m_buffer.size();
+  m_num_frames++;
+  m_prev.swap(m_values);
+
+  return m_file.good();
+}
+
+double ChSnapshotWriter::GetPositionErrorBound() const
+{
+  return 0.5 * m_resolution;
+}
+
+double ChSnapshotWriter::GetRotationErrorBound() const
+{
+  return RotationErrorBound(m_rot_bits);
+}
+
+
+// -----------------------------------------------------------------------------
+// ChSnapshotReader
+// -----------------------------------------------------------------------------
+ChSnapshotReader::ChSnapshotReader(const std::string& filename)
+: m_file(filename.c_str(), std::ios::binary),
+  m_valid(false),
+  m_resolution(0),
+  m_rot_bits(0)
+{
+  m_buffer.resize(14);
+  if (!m_file.read((char*)&m_buffer[0], m_buffer.size()))
+    return;
+  if (memcmp(&m_buffer[0], snapshot_magic, 4) != 0 || m_buffer[4] != snapshot_version)
+    return;
+
+  ByteReader reader(&m_buffer[5], m_buffer.size() - 5);
+  m_resolution = BitsDouble(reader.Fixed(8));
+  m_rot_bits = reader.Byte();
+
+  m_valid = (m_resolution > 0 && m_rot_bits >= 10 && m_rot_bits <= 16);
+}
+
+bool ChSnapshotReader::ReadFrame(double&                       time,
+                                 std::vector<ChVector<> >&     pos,
+                                 std::vector<ChQuaternion<> >& rot)
+{
+  if (!m_valid)
+    return false;
+
+  // Read the frame payload
+  uint8_t size_bytes[4];
+  if (!m_file.read((char*)size_bytes, 4))
+    return false;
+  uint64_t payload = size_bytes[0] | (size_bytes[1] << 8) | (size_bytes[2] << 16) | ((uint64_t)size_bytes[3] << 24);
+
+  m_buffer.resize((size_t)payload);
+  if (payload > 0 && !m_file.read((char*)&m_buffer[0], m_buffer.size()))
+    return false;
+
+  ByteReader reader(m_buffer.empty() ? NULL : &m_buffer[0], m_buffer.size());
+  bool key = (reader.Byte() == 0);
+  time = BitsDouble(reader.Fixed(8));
+  int n = (int)reader.Varint();
+
+  if (!reader.ok || n < 0 || (!key && m_prev.size() != (size_t)num_streams * n)) {
+    m_valid = false;
+    return false;
+  }
+
+  // Decode the value streams
+  m_values.resize((size_t)num_streams * n);
+  std::vector<uint64_t> codes(n);
+  for (int s = 0; s < num_streams && reader.ok; s++) {
+    int64_t* v = &m_values[0] + (size_t)s * n;
+    int64_t  base = key ? UnZigZag(reader.Varint()) : 0;
+    if (n > 0)
+      reader.Blocks(&codes[0], n);
+    if (key) {
+      for (int i = 0; i < n; i++)
+        v[i] = base + (int64_t)codes[i];
+    } else {
+      const int64_t* p = &m_prev[(size_t)s * n];
+      for (int i = 0; i < n; i++)
+        v[i] = p[i] + UnZigZag(codes[i]);
+    }
+  }
+
+  if (!reader.ok) {
+    m_valid = false;
+    return false;
+  }
+
+  // Reconstruct the poses
+  pos.resize(n);
+  rot.resize(n);
+  const int64_t* vx = n > 0 ? &m_values[0] : NULL;
+
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < n; i++) {
+    pos[i] = ChVector<>(vx[i] * m_resolution, vx[n + i] * m_resolution, vx[2 * n + i] * m_resolution);
+    int64_t r[4];
+    for (int s = 0; s < 4; s++)
+      r[s] = vx[(3 + s) * n + i];
+    rot[i] = DequantizeRotation(r, m_rot_bits);
+  }
+
+  m_prev.swap(m_values);
+
+  return true;
+}
+
+double ChSnapshotReader::GetPositionErrorBound() const
+{
+  return 0.5 * m_resolution;
+}
+
+double ChSnapshotReader::GetRotationErrorBound() const
+{
+  return RotationErrorBound(m_rot_bits);
+}
+
+
+// -----------------------------------------------------------------------------
+// DecodeSnapshots
+//
+// Write one CSV file per frame of the snapshot stream.
+// -----------------------------------------------------------------------------
+int DecodeSnapshots(const std::string& filename,
+                    const std::string& prefix,
+                    const std::string& delim)
+{
+  ChSnapshotReader reader(filename);
+  if (!reader.IsOpen())
+    return -1;
+
+  double                       time;
+  std::vector<ChVector<> >     pos;
+  std::vector<ChQuaternion<> > rot;
+
+  int frame = 0;
+  while (reader.ReadFrame(time, pos, rot)) {
+    CSV_writer csv(delim);
+    for (size_t i = 0; i < pos.size(); i++)
+      csv << pos[i] << rot[i] << std::endl;
+
+    char name[16];
+    sprintf(name, "_%04d.csv", frame);
+    csv.write_to_file(prefix + name);
+    frame++;
+  }
+
+  return frame;
+}
+
+
+}  // namespace utils
+}  // namespace chrono
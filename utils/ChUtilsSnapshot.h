@@ -0,0 +1,165 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Compact (quantized) snapshot stream of body poses, for animation output.
+//
+// A snapshot file holds a sequence of frames, each with the time and the
+// position and orientation of all bodies (in body list order):
+//  - positions are quantized to a grid of configurable resolution; in a key
+//    frame they are stored relative to the bounding box of the frame,
+//  - orientations use the "smallest three" encoding: the index of the largest
+//    quaternion component (made positive), and the other three components
+//    quantized with 10 to 16 bits each,
+//  - all other frames are delta frames, storing the differences of the
+//    quantized values from the previous frame. A key frame is written every
+//    few frames, and whenever the number of bodies changes.
+// The quantized values are bit-packed in blocks of 128, with the smallest bit
+// width for each block, so that bodies at rest cost (almost) nothing in delta
+// frames.
+//
+// Error bounds (quantization is the only source of error):
+//  - each position coordinate is within half the grid resolution,
+//  - each of the three smallest quaternion components is within half the
+//    quantization step sqrt(2) / (2^bits - 1); the rotation angle error is then
+//    at most about 7 times this value (to first order).
+//
+// =============================================================================
+
+#ifndef CH_UTILS_SNAPSHOT_H
+#define CH_UTILS_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+
+#include "physics/ChSystem.h"
+
+#include "utils/ChApiUtils.h"
+
+
+namespace chrono {
+namespace utils {
+
+///
+/// Writer of a compact snapshot stream.
+///
+class CH_UTILS_API ChSnapshotWriter
+{
+public:
+
+  /// Create the snapshot file, with the given position resolution (grid size),
+  /// number of bits per quaternion component (clamped to [10, 16]), and number
+  /// of frames between key frames.
+  ChSnapshotWriter(const std::string& filename,
+                   double             resolution = 1e-4,
+                   int                rot_bits = 12,
+                   int                keyframe_interval = 100);
+  ~ChSnapshotWriter() {}
+
+  /// Return true if the snapshot file could be created.
+  bool IsOpen() const { return m_file.is_open(); }
+
+  /// Write a frame with the poses of the bodies of the given system (at the
+  /// current system time). Optionally, only active bodies are written.
+  bool WriteFrame(ChSystem* system,
+                  bool      active_only = false);
+
+  /// Write a frame with the given poses.
+  bool WriteFrame(double                              time,
+                  const std::vector<ChVector<> >&     pos,
+                  const std::vector<ChQuaternion<> >& rot);
+
+  /// Return the number of frames written so far.
+  int GetNumFrames() const { return m_num_frames; }
+  /// Return the number of bytes written so far (including the file header).
+  size_t GetNumBytes() const { return m_num_bytes; }
+
+  /// Return the maximum error of a position coordinate.
+  double GetPositionErrorBound() const;
+  /// Return the (first order) maximum error of the rotation angle, in radians.
+  double GetRotationErrorBound() const;
+
+private:
+
+  std::ofstream         m_file;
+  double                m_resolution;
+  int                   m_rot_bits;
+  int                   m_keyframe_interval;
+  int                   m_num_frames;
+  size_t                m_num_bytes;
+  std::vector<int64_t>  m_prev;     // quantized values of the previous frame
+  std::vector<int64_t>  m_values;
+  std::vector<uint8_t>  m_buffer;
+};
+
+///
+/// Reader of a compact snapshot stream.
+///
+class CH_UTILS_API ChSnapshotReader
+{
+public:
+
+  ChSnapshotReader(const std::string& filename);
+  ~ChSnapshotReader() {}
+
+  /// Return true if the file could be opened and has a valid header.
+  bool IsOpen() const { return m_valid; }
+
+  /// Read the next frame. Returns false at the end of the stream (or if the
+  /// stream is corrupt).
+  bool ReadFrame(double&                       time,
+                 std::vector<ChVector<> >&     pos,
+                 std::vector<ChQuaternion<> >& rot);
+
+  /// Return the position resolution of the stream.
+  double GetResolution() const { return m_resolution; }
+  /// Return the number of bits per quaternion component.
+  int GetRotationBits() const { return m_rot_bits; }
+
+  /// Return the maximum error of a position coordinate.
+  double GetPositionErrorBound() const;
+  /// Return the (first order) maximum error of the rotation angle, in radians.
+  double GetRotationErrorBound() const;
+
+private:
+
+  std::ifstream         m_file;
+  bool                  m_valid;
+  double                m_resolution;
+  int                   m_rot_bits;
+  std::vector<int64_t>  m_prev;
+  std::vector<int64_t>  m_values;
+  std::vector<uint8_t>  m_buffer;
+};
+
+// -----------------------------------------------------------------------------
+// Free function declarations
+// -----------------------------------------------------------------------------
+
+/// Decode a snapshot stream into one CSV file per frame, named
+/// <prefix>_<frame>.csv (frame numbers with 4 digits), in the format of
+/// WriteBodies (position and orientation of each body). Returns the number of
+/// frames decoded, or -1 if the stream cannot be read.
+CH_UTILS_API
+int DecodeSnapshots(const std::string& filename,
+                    const std::string& prefix,
+                    const std::string& delim = ",");
+
+
+} // namespace utils
+} // namespace chrono
+
+
+#endif
@@ -0,0 +1,336 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Timeline tracing in the Chrome Trace Event Format.
+//
+// =============================================================================
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <process.h>
+#else
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../include/rapidjson/writer.h"
+#include "../include/rapidjson/filewritestream.h"
+
+#include "utils/ChUtilsTrace.h"
+
+namespace chrono {
+namespace utils {
+
+
+// -----------------------------------------------------------------------------
+// Local data: buffered events and trace settings
+// -----------------------------------------------------------------------------
+namespace {
+
+struct TraceEvent {
+  char        phase;     // 'X' (complete), 'C' (counter), or 'M' (metadata)
+  std::string name;
+  const char* category;
+  double      ts;        // start time (microseconds)
+  double      dur;       // duration (microseconds) or counter value
+  int         tid;
+};
+
+std::vector<TraceEvent>  trace_events;
+std::vector<std::string> trace_thread_names;
+std::string              trace_filename;
+double                   trace_t0 = 0;
+int                      trace_num_threads = 0;
+
+// Trace identifier of the calling thread (-1 until its first event).
+#if defined(_MSC_VER)
+__declspec(thread) int trace_tid = -1;
+#else
+__thread int trace_tid = -1;
+#endif
+
+double WallTime()
+{
+#if defined(_WIN32)
+  LARGE_INTEGER freq, count;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+  return 1e6 * (double)count.QuadPart / (double)freq.QuadPart;
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return 1e6 * tv.tv_sec + tv.tv_usec;
+#endif
+}
+
+// Threads are numbered in the order of their first event, so that identifiers
+// stay unique across OpenMP parallel regions and nested thread pools.
+int ThreadId()
+{
+  if (trace_tid < 0) {
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_trace)
+#endif
+    trace_tid = trace_num_threads++;
+  }
+  return trace_tid;
+}
+
+int ProcessId()
+{
+#if defined(_WIN32)
+  return _getpid();
+#else
+  return (int)getpid();
+#endif
+}
+
+void Record(const TraceEvent& event)
+{
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_trace)
+#endif
+  trace_events.push_back(event);
+}
+
+}  // anonymous namespace
+
+
+bool ChTrace::m_enabled = false;
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+void ChTrace::Enable(const std::string& filename)
+{
+  trace_filename = filename;
+  trace_t0 = WallTime();
+  m_enabled = true;
+}
+
+bool ChTrace::EnableFromEnvironment()
+{
+  const char* filename = getenv("CHRONO_VALIDATION_TRACE");
+  if (!filename || !*filename)
+    return false;
+
+  Enable(filename);
+  return true;
+}
+
+double ChTrace::Now()
+{
+  return WallTime() - trace_t0;
+}
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+void ChTrace::AddSpan(const std::string& name,
+                      const char*        category,
+                      double             start,
+                      double             duration)
+{
+  if (!m_enabled)
+    return;
+
+  TraceEvent event;
+  event.phase = 'X';
+  event.name = name;
+  event.category = category;
+  event.ts = start;
+  event.dur = duration;
+  event.tid = ThreadId();
+  Record(event);
+}
+
+void ChTrace::AddCounter(const std::string& name, double value)
+{
+  if (!m_enabled)
+    return;
+
+  TraceEvent event;
+  event.phase = 'C';
+  event.name = name;
+  event.category = "counter";
+  event.ts = Now();
+  event.dur = value;
+  event.tid = ThreadId();
+  Record(event);
+}
+
+// Record a thread name event unless the thread already has that name (or, if
+// only_unnamed is true, any name).
+static void NameThread(const std::string& name, bool only_unnamed)
+{
+  int  tid = ThreadId();
+  bool record = false;
+
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_trace)
+#endif
+  {
+    if ((int)trace_thread_names.size() <= tid)
+      trace_thread_names.resize(tid + 1);
+    std::string& current = trace_thread_names[tid];
+    if (current != name && !(only_unnamed && !current.empty())) {
+      current = name;
+      record = true;
+    }
+  }
+
+  if (!record)
+    return;
+
+  TraceEvent event;
+  event.phase = 'M';
+  event.name = name;
+  event.category = "";
+  event.ts = 0;
+  event.dur = 0;
+  event.tid = tid;
+  Record(event);
+}
+
+void ChTrace::SetThreadName(const std::string& name)
+{
+  if (!m_enabled)
+    return;
+
+  NameThread(name, false);
+}
+
+void ChTrace::SetWorkerThreadName()
+{
+  if (!m_enabled)
+    return;
+
+  char name[32];
+#ifdef _OPENMP
+  sprintf(name, "worker %d", omp_get_thread_num());
+#else
+  sprintf(name, "worker");
+#endif
+  NameThread(name, true);
+}
+
+std::string ChTrace::GetFilename()
+{
+  if (!m_enabled)
+    return "";
+
+  // Insert the process id before the extension (if any) of the file name.
+  char pid[16];
+  sprintf(pid, ".%d", ProcessId());
+
+  size_t sep = trace_filename.find_last_of("/\\");
+  size_t dot = trace_filename.find_last_of('.');
+  if (dot == std::string::npos || (sep != std::string::npos && dot < sep) || dot == sep + 1)
+    return trace_filename + pid;
+
+  return trace_filename.substr(0, dot) + pid + trace_filename.substr(dot);
+}
+
+// -----------------------------------------------------------------------------
+// Write the trace file, using the JSON object format:
+//   { "traceEvents": [ {...}, ... ], "displayTimeUnit": "ms" }
+// The events are written to a temporary file which is then renamed, so that
+// readers never see a partial trace.
+// -----------------------------------------------------------------------------
+bool ChTrace::Write()
+{
+  if (!m_enabled)
+    return false;
+
+  std::string filename = GetFilename();
+  std::string partname = filename + ".part";
+
+  FILE* fp = fopen(partname.c_str(), "w");
+  if (!fp)
+    return false;
+
+  char writeBuffer[65536];
+  rapidjson::FileWriteStream os(fp, writeBuffer, sizeof(writeBuffer));
+  rapidjson::Writer<rapidjson::FileWriteStream> writer(os);
+
+  int pid = ProcessId();
+
+  writer.StartObject();
+  writer.String("traceEvents");
+  writer.StartArray();
+
+  for (size_t i = 0; i < trace_events.size(); i++) {
+    const TraceEvent& event = trace_events[i];
+    char phase[2] = { event.phase, '\0' };
+
+    writer.StartObject();
+    writer.String("ph");    writer.String(phase);
+    writer.String("pid");   writer.Int(pid);
+    writer.String("tid");   writer.Int(event.tid);
+
+    switch (event.phase) {
+    case 'X':
+      writer.String("name");  writer.String(event.name.c_str());
+      writer.String("cat");   writer.String(event.category);
+      writer.String("ts");    writer.Double(event.ts);
+      writer.String("dur");   writer.Double(event.dur);
+      break;
+    case 'C':
+      writer.String("name");  writer.String(event.name.c_str());
+      writer.String("ts");    writer.Double(event.ts);
+      writer.String("args");
+      writer.StartObject();
+      writer.String("value"); writer.Double(event.dur);
+      writer.EndObject();
+      break;
+    case 'M':
+      writer.String("name");  writer.String("thread_name");
+      writer.String("args");
+      writer.StartObject();
+      writer.String("name");  writer.String(event.name.c_str());
+      writer.EndObject();
+      break;
+    }
+
+    writer.EndObject();
+  }
+
+  writer.EndArray();
+  writer.String("displayTimeUnit");
+  writer.String("ms");
+  writer.EndObject();
+
+  os.Flush();
+  bool ok = !ferror(fp);
+  ok &= (fclose(fp) == 0);
+
+  if (ok) {
+    remove(filename.c_str());
+    ok = (rename(partname.c_str(), filename.c_str()) == 0);
+  }
+  if (!ok)
+    remove(partname.c_str());
+
+  return ok;
+}
+
+
+}  // namespace utils
+}  // namespace chrono
@@ -0,0 +1,155 @@
+// =============================================================================
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2014 projectchrono.org
+// All right reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be found
+// in the LICENSE file at the top level of the distribution and at
+// http://projectchrono.org/license-chrono.txt.
+//
+// =============================================================================
+// Authors: Felipe Gutierrez
+// =============================================================================
+//
+// Timeline tracing in the Chrome Trace Event Format.
+//
+// The generated JSON file can be loaded in chrome://tracing or in Perfetto
+// (ui.perfetto.dev). Tracing is disabled by default; when disabled, creating a
+// span costs a single branch (plus whatever the caller spends building the span
+// name, so callers composing names should check ChTrace::IsEnabled() first).
+//
+// =============================================================================
+
+#ifndef CH_UTILS_TRACE_H
+#define CH_UTILS_TRACE_H
+
+#include <string>
+
+#include "utils/ChApiUtils.h"
+
+
+namespace chrono {
+namespace utils {
+
+///
+/// Process-wide recorder of trace events.
+/// Events are buffered in memory (safe to call from OpenMP worker threads) and
+/// written to the output file by Write(). Thread identifiers in the trace are
+/// assigned in the order in which threads record their first event.
+///
+class CH_UTILS_API ChTrace
+{
+public:
+
+  /// Enable tracing; events will be written to the specified file.
+  static void Enable(const std::string& filename);
+
+  /// Enable tracing if the CHRONO_VALIDATION_TRACE environment variable is set
+  /// (its value is used as the output file name, see GetFilename()).
+  static bool EnableFromEnvironment();
+
+  /// Return true if tracing is enabled.
+  static bool IsEnabled() { return m_enabled; }
+
+  /// Return the current trace time (microseconds since tracing was enabled).
+  static double Now();
+
+  /// Record a complete event ("X" phase) with given start time and duration.
+  static void AddSpan(const std::string& name,
+                      const char*        category,
+                      double             start,
+                      double             duration);
+
+  /// Record a counter event ("C" phase).
+  static void AddCounter(const std::string& name, double value);
+
+  /// Name the calling thread in the trace viewer.
+  static void SetThreadName(const std::string& name);
+
+  /// Name the calling thread "worker <n>" (n being its OpenMP thread number),
+  /// unless it already has a name. Meant to be called at the top of the body of
+  /// OpenMP parallel loops.
+  static void SetWorkerThreadName();
+
+  /// Return the name of the output file: the file name passed to Enable() with
+  /// the process id inserted before the extension ("trace.json" is written as
+  /// "trace.<pid>.json"), so that concurrent processes do not overwrite each
+  /// other's trace.
+  static std::string GetFilename();
+
+  /// Write all recorded events to the output file.
+  /// Buffered events are kept, so this can be called repeatedly.
+  static bool Write();
+
+private:
+
+  static bool m_enabled;
+};
+
+///
+/// Scoped span: records a complete event from construction to End() (or
+/// destruction, whichever comes first). Restart() closes the current span and
+/// opens a new one (optionally with a new name), which is convenient for
+/// tracing batches of steps inside a simulation loop.
+///
+class CH_UTILS_API ChTraceSpan
+{
+public:
+
+  ChTraceSpan(const std::string& name, const char* category = "validation")
+  : m_active(ChTrace::IsEnabled()),
+    m_category(category)
+  {
+    if (m_active) {
+      m_name = name;
+      m_start = ChTrace::Now();
+    }
+  }
+
+  ~ChTraceSpan() { End(); }
+
+  /// Close the span (no-op if already closed).
+  void End()
+  {
+    if (m_active) {
+      ChTrace::AddSpan(m_name, m_category, m_start, ChTrace::Now() - m_start);
+      m_active = false;
+    }
+  }
+
+  /// Close the current span and start a new one with the same name.
+  void Restart()
+  {
+    End();
+    if (ChTrace::IsEnabled()) {
+      m_active = true;
+      m_start = ChTrace::Now();
+    }
+  }
+
+  /// Close the current span and start a new one with the specified name.
+  void Restart(const std::string& name)
+  {
+    End();
+    if (ChTrace::IsEnabled()) {
+      m_active = true;
+      m_name = name;
+      m_start = ChTrace::Now();
+    }
+  }
+
+private:
+
+  bool        m_active;
+  std::string m_name;
+  const char* m_category;
+  double      m_start;
+};
+
+
+} // namespace utils
+} // namespace chrono
+
+
+#endif
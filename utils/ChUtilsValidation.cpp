@@ -16,7 +16,24 @@
 //
 // =============================================================================
 
+#include <cstdlib>
+#include <list>
+#include <map>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if !defined(_WIN32)
+#include <limits.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "utils/ChUtilsValidation.h"
+#include "utils/ChUtilsReferenceStore.h"
+#include "utils/ChUtilsTrace.h"
 
 namespace chrono {
 namespace utils {
@@ -33,9 +50,57 @@ bool ChValidation::Process(const std::string& sim_filename,
   m_num_rows = ReadDataFile(sim_filename, delim, m_sim_headers, m_sim_data);
   m_num_cols = m_sim_headers.size();
 
-  // Read the reference data file.
-  size_t num_ref_rows = ReadDataFile(ref_filename, delim, m_ref_headers, m_ref_data);
+  // Get the reference data (parsed at most once per process).
+  ChReferenceData ref = ChReferenceCache::Get(ref_filename, delim);
+  m_ref_headers = ref.GetHeaders();
+  m_ref_data = ref.GetData();
+  size_t num_ref_rows = ref.GetNumRows();
+
+  return Compare(sim_filename, ref_filename, num_ref_rows);
+}
+
+bool ChValidation::Process(const std::string& sim_filename,
+                           const Headers&     ref_headers,
+                           const Data&        ref_data,
+                           char               delim)
+{
+  // Read the simulation results file.
+  m_num_rows = ReadDataFile(sim_filename, delim, m_sim_headers, m_sim_data);
+  m_num_cols = m_sim_headers.size();
+
+  // Use the given reference data.
+  m_ref_headers = ref_headers;
+  m_ref_data = ref_data;
+  size_t num_ref_rows = ref_data.empty() ? 0 : ref_data[0].size();
+
+  return Compare(sim_filename, "<reference data>", num_ref_rows);
+}
+
+bool ChValidation::Process(const Headers& sim_headers,
+                           const Data&    sim_data,
+                           const Headers& ref_headers,
+                           const Data&    ref_data)
+{
+  // Use the given simulation and reference data.
+  m_sim_headers = sim_headers;
+  m_sim_data = sim_data;
+  m_num_rows = sim_data.empty() ? 0 : sim_data[0].size();
+  m_num_cols = sim_headers.size();
 
+  m_ref_headers = ref_headers;
+  m_ref_data = ref_data;
+  size_t num_ref_rows = ref_data.empty() ? 0 : ref_data[0].size();
+
+  return Compare("<simulation data>", "<reference data>", num_ref_rows);
+}
+
+// -----------------------------------------------------------------------------
+// Compare the simulation and reference data currently loaded.
+// -----------------------------------------------------------------------------
+bool ChValidation::Compare(const std::string& sim_name,
+                           const std::string& ref_name,
+                           size_t             num_ref_rows)
+{
   // Resize the arrays of norms to zero length
   // (needed if we return with an error below)
   m_L2_norms.resize(0);
@@ -45,23 +110,27 @@ bool ChValidation::Process(const std::string& sim_filename,
   // Perform some sanity checks.
   if (m_num_cols != m_ref_headers.size()) {
     std::cout << "ERROR: the number of columns in the two files is different:" << std::endl;
-    std::cout << "   File " << sim_filename << " has " << m_num_cols << " columns" << std::endl;
-    std::cout << "   File " << ref_filename << " has " << m_ref_headers.size() << " columns" << std::endl;
+    std::cout << "   File " << sim_name << " has " << m_num_cols << " columns" << std::endl;
+    std::cout << "   File " << ref_name << " has " << m_ref_headers.size() << " columns" << std::endl;
     return false;
   }
 
-  if (m_num_rows != num_ref_rows) {
-    std::cout << "ERROR: the number of rows in the two files is different:" << std::endl;
-    std::cout << "   File " << sim_filename << " has " << m_num_rows << " columns" << std::endl;
-    std::cout << "   File " << ref_filename << " has " << num_ref_rows << " columns" << std::endl;
+  // Without resampling, the time columns must be the same.
+  bool same_times = (m_num_rows == num_ref_rows) && (L2norm(m_sim_data[0] - m_ref_data[0]) <= 1e-10);
+
+  if (!same_times && m_interp == INTERP_NONE) {
+    if (m_num_rows != num_ref_rows) {
+      std::cout << "ERROR: the number of rows in the two files is different:" << std::endl;
+      std::cout << "   File " << sim_name << " has " << m_num_rows << " columns" << std::endl;
+      std::cout << "   File " << ref_name << " has " << num_ref_rows << " columns" << std::endl;
+    } else {
+      std::cout << "ERROR: time sequences do not match." << std::endl;
+    }
     return false;
   }
 
-  // Ensure that the first columns (time) are the same.
-  if (L2norm(m_sim_data[0] - m_ref_data[0]) > 1e-10) {
-    std::cout << "ERROR: time sequences do not match." << std::endl;
+  if (!same_times && !Resample(sim_name))
     return false;
-  }
 
   // Resize arrays of norms.
   m_L2_norms.resize(m_num_cols - 1);
@@ -79,6 +148,109 @@ bool ChValidation::Process(const std::string& sim_filename,
 }
 
 
+// -----------------------------------------------------------------------------
+// Resample the simulation data onto the time grid of the reference data.
+//
+// A single merge pass over the two (increasing) time columns locates each
+// reference time in the simulation grid and computes the interpolation weights
+// (the same for all columns); each column is then interpolated with a
+// branch-free loop over these weights.
+// -----------------------------------------------------------------------------
+bool ChValidation::Resample(const std::string& sim_name)
+{
+  const DataVector& ts = m_sim_data[0];
+  const DataVector& tr = m_ref_data[0];
+  size_t ns = ts.size();
+  size_t nr = tr.size();
+
+  if (ns < 2 || nr == 0) {
+    std::cout << "ERROR: not enough data to resample " << sim_name << std::endl;
+    return false;
+  }
+
+  for (size_t k = 1; k < ns; k++) {
+    if (!(ts[k] >= ts[k - 1])) {
+      std::cout << "ERROR: time sequence of " << sim_name << " is not increasing." << std::endl;
+      return false;
+    }
+  }
+
+  if (tr[0] < ts[0] - 1e-10 || tr[nr - 1] > ts[ns - 1] + 1e-10) {
+    std::cout << "ERROR: time sequence of " << sim_name << " [" << ts[0] << ", " << ts[ns - 1]
+              << "] does not cover the reference data [" << tr[0] << ", " << tr[nr - 1] << "]" << std::endl;
+    return false;
+  }
+
+  // Merge pass: interval index and weights of the values (w0, w1) and of the
+  // slopes (w2, w3) at its ends, for each reference time.
+  std::vector<size_t> idx(nr);
+  std::vector<double> w0(nr), w1(nr), w2(nr), w3(nr);
+
+  size_t k = 0;
+  for (size_t i = 0; i < nr; i++) {
+    while (k + 2 < ns && ts[k + 1] < tr[i])
+      k++;
+
+    double h = ts[k + 1] - ts[k];
+    double t = (h > 0) ? (tr[i] - ts[k]) / h : 0;
+    t = std::max(0.0, std::min(1.0, t));
+
+    idx[i] = k;
+    if (m_interp == INTERP_HERMITE) {
+      double t2 = t * t;
+      double t3 = t2 * t;
+      w0[i] = 2 * t3 - 3 * t2 + 1;
+      w1[i] = -2 * t3 + 3 * t2;
+      w2[i] = (t3 - 2 * t2 + t) * h;
+      w3[i] = (t3 - t2) * h;
+    } else {
+      w0[i] = 1 - t;
+      w1[i] = t;
+      w2[i] = 0;
+      w3[i] = 0;
+    }
+  }
+
+  // Slopes at the simulation times (three-point finite differences on the
+  // non-uniform grid, one-sided at the ends).
+  DataVector slope(0.0, ns);
+
+  Data resampled(m_num_cols);
+  resampled[0] = tr;
+
+  for (size_t col = 1; col < m_num_cols; col++) {
+    const DataVector& y = m_sim_data[col];
+
+    if (m_interp == INTERP_HERMITE) {
+      for (size_t j = 0; j < ns; j++) {
+        size_t jm = (j > 0) ? j - 1 : j;
+        size_t jp = (j + 1 < ns) ? j + 1 : j;
+        double hm = ts[j] - ts[jm];
+        double hp = ts[jp] - ts[j];
+        double dm = (hm > 0) ? (y[j] - y[jm]) / hm : 0;
+        double dp = (hp > 0) ? (y[jp] - y[j]) / hp : 0;
+        if (hm > 0 && hp > 0)
+          slope[j] = (dp * hm + dm * hp) / (hm + hp);
+        else
+          slope[j] = (hm > 0) ? dm : dp;
+      }
+    }
+
+    DataVector& out = resampled[col];
+    out.resize(nr);
+    for (size_t i = 0; i < nr; i++) {
+      size_t j = idx[i];
+      out[i] = w0[i] * y[j] + w1[i] * y[j + 1] + w2[i] * slope[j] + w3[i] * slope[j + 1];
+    }
+  }
+
+  m_sim_data.swap(resampled);
+  m_num_rows = nr;
+
+  return true;
+}
+
+
 // -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
 bool ChValidation::Process(const std::string& sim_filename,
@@ -88,6 +260,27 @@ bool ChValidation::Process(const std::string& sim_filename,
   m_num_rows = ReadDataFile(sim_filename, delim, m_sim_headers, m_sim_data);
   m_num_cols = m_sim_headers.size();
 
+  return ColumnNorms();
+}
+
+bool ChValidation::Process(const Headers& sim_headers,
+                           const Data&    sim_data)
+{
+  // Use the given simulation data.
+  m_sim_headers = sim_headers;
+  m_sim_data = sim_data;
+  m_num_rows = sim_data.empty() ? 0 : sim_data[0].size();
+  m_num_cols = sim_headers.size();
+
+  return ColumnNorms();
+}
+
+// Calculate the norms of the columns of the simulation data currently loaded.
+bool ChValidation::ColumnNorms()
+{
+  if (m_num_cols == 0)
+    return false;
+
   // Resize arrays of norms.
   m_L2_norms.resize(m_num_cols - 1);
   m_RMS_norms.resize(m_num_cols - 1);
@@ -170,21 +363,510 @@ size_t ChValidation::ReadDataFile(const std::string& filename,
 }
 
 
+// -----------------------------------------------------------------------------
+// Reference data views and the reference data cache
+//
+// A table is reference counted: one reference per view, plus one while it is
+// held by the cache. Reference counts, the table map, and the LRU list are
+// only accessed in the critical section ch_utils_reference_cache. A table is
+// parsed outside of the critical section, with its load lock set; other
+// threads requesting the same table wait on this lock.
+// -----------------------------------------------------------------------------
+struct ChReferenceData::Table {
+  Headers     headers;
+  Data        data;
+  int         refs;      // number of references (views and cache)
+  bool        cached;    // held by the cache?
+  std::string key;       // cache key
+  time_t      mtime;     // modification time of the file
+  long long   size;      // size of the file
+  size_t      bytes;     // estimated memory use
+  std::list<Table*>::iterator lru;
+#ifdef _OPENMP
+  omp_lock_t  load_lock;
+#endif
+};
+
+namespace {
+
+typedef std::map<std::string, ChReferenceData::Table*> TableMap;
+
+TableMap                             cache_tables;
+std::list<ChReferenceData::Table*>   cache_lru;        // most recently used first
+size_t                               cache_budget = 256 * 1024 * 1024;
+size_t                               cache_bytes = 0;
+ChReferenceCacheStats                cache_stats = {0, 0, 0, 0, 0};
+
+ChReferenceData::Table* NewTable()
+{
+  ChReferenceData::Table* table = new ChReferenceData::Table;
+  table->refs = 1;
+  table->cached = false;
+  table->mtime = 0;
+  table->size = 0;
+  table->bytes = 0;
+#ifdef _OPENMP
+  omp_init_lock(&table->load_lock);
+#endif
+  return table;
+}
+
+void DeleteTable(ChReferenceData::Table* table)
+{
+#ifdef _OPENMP
+  omp_destroy_lock(&table->load_lock);
+#endif
+  delete table;
+}
+
+// Release one reference to the table (to be called in the critical section).
+// Returns true if this was the last reference.
+bool ReleaseTable(ChReferenceData::Table* table)
+{
+  return --table->refs == 0;
+}
+
+// Remove a table from the cache (to be called in the critical section).
+// Returns true if the cache held the last reference.
+bool Uncache(ChReferenceData::Table* table)
+{
+  cache_tables.erase(table->key);
+  cache_lru.erase(table->lru);
+  cache_bytes -= table->bytes;
+  table->cached = false;
+  return ReleaseTable(table);
+}
+
+// Evict least recently used tables (other than the most recent one) until the
+// cache is within its budget (to be called in the critical section). Tables
+// to delete are returned in 'garbage'.
+void Evict(std::vector<ChReferenceData::Table*>& garbage)
+{
+  while (cache_bytes > cache_budget && cache_lru.size() > 1) {
+    ChReferenceData::Table* table = cache_lru.back();
+    cache_stats.evictions++;
+    if (Uncache(table))
+      garbage.push_back(table);
+  }
+}
+
+size_t TableBytes(const ChReferenceData::Table* table)
+{
+  size_t bytes = sizeof(ChReferenceData::Table);
+  for (size_t i = 0; i < table->headers.size(); i++)
+    bytes += sizeof(std::string) + table->headers[i].size();
+  for (size_t i = 0; i < table->data.size(); i++)
+    bytes += sizeof(DataVector) + table->data[i].size() * sizeof(double);
+  return bytes;
+}
+
+// Canonical path, modification time, and size of a file. Returns false if the
+// file does not exist.
+bool GetFileInfo(const std::string& filename, std::string& path, time_t& mtime, long long& size)
+{
+  struct stat info;
+  if (stat(filename.c_str(), &info) != 0)
+    return false;
+  mtime = info.st_mtime;
+  size = (long long)info.st_size;
+
+#if defined(_WIN32)
+  char buf[_MAX_PATH];
+  path = _fullpath(buf, filename.c_str(), _MAX_PATH) ? buf : filename;
+#else
+  char buf[PATH_MAX];
+  path = realpath(filename.c_str(), buf) ? buf : filename;
+#endif
+
+  return true;
+}
+
+// Open reference stores, by canonical path. Stores are only accessed in the
+// critical section ch_utils_reference_stores (decoding an entry is fast).
+struct OpenStore {
+  ChReferenceStore* store;
+  time_t            mtime;
+  long long         size;
+};
+
+typedef std::map<std::string, OpenStore> StoreMap;
+
+StoreMap cache_stores;
+
+// Return the store with the given canonical path, modification time and size,
+// opening it if needed (to be called in the critical section).
+const ChReferenceStore* FindStore(const std::string& path,
+                                  time_t             mtime,
+                                  long long          size)
+{
+  StoreMap::iterator itr = cache_stores.find(path);
+  if (itr != cache_stores.end() && (itr->second.mtime != mtime || itr->second.size != size)) {
+    delete itr->second.store;
+    cache_stores.erase(itr);
+    itr = cache_stores.end();
+  }
+
+  if (itr == cache_stores.end()) {
+    OpenStore entry = {new ChReferenceStore, mtime, size};
+    entry.store->Open(path);
+    itr = cache_stores.insert(std::make_pair(path, entry)).first;
+  }
+
+  return itr->second.store;
+}
+
+// Return true if the store with the given canonical path, modification time
+// and size contains the named file.
+bool StoreContains(const std::string& path,
+                   time_t             mtime,
+                   long long          size,
+                   const std::string& name)
+{
+  bool found;
+
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_reference_stores)
+#endif
+  found = FindStore(path, mtime, size)->Contains(name);
+
+  return found;
+}
+
+// Decode all channels of the bundle holding the named file, in the store with
+// the given canonical path, modification time and size.
+bool ReadStoreBundle(const std::string&        path,
+                     time_t                    mtime,
+                     long long                 size,
+                     const std::string&        name,
+                     std::vector<std::string>& names,
+                     std::vector<Headers>&     headers,
+                     std::vector<Data>&        data)
+{
+  bool found;
+
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_reference_stores)
+#endif
+  found = FindStore(path, mtime, size)->ReadBundle(name, names, headers, data);
+
+  return found;
+}
+
+// Find the packed store holding the given data file: its bundle file, or else
+// the store of its directory. Returns false if neither exists or contains the
+// file.
+bool FindPackedFile(const std::string& filename,
+                    std::string&       path,
+                    time_t&            mtime,
+                    long long&         size,
+                    std::string&       entry)
+{
+  size_t pos = filename.find_last_of("/\\");
+  std::string name = (pos == std::string::npos) ? filename : filename.substr(pos + 1);
+
+  std::string stores[2] = {GetReferenceBundleFile(filename), GetReferenceStoreFile(filename)};
+  for (int i = 0; i < 2; i++) {
+    if (!stores[i].empty() && GetFileInfo(stores[i], path, mtime, size) &&
+        StoreContains(path, mtime, size, name)) {
+      entry = name;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+}  // anonymous namespace
+
+
+ChReferenceData::ChReferenceData(const Headers& headers, const Data& data)
+: m_table(NewTable())
+{
+  m_table->headers = headers;
+  m_table->data = data;
+}
+
+ChReferenceData::ChReferenceData(const ChReferenceData& other)
+: m_table(other.m_table)
+{
+  if (m_table) {
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_reference_cache)
+#endif
+    m_table->refs++;
+  }
+}
+
+ChReferenceData::~ChReferenceData()
+{
+  if (!m_table)
+    return;
+
+  bool last;
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_reference_cache)
+#endif
+  last = ReleaseTable(m_table);
+
+  if (last)
+    DeleteTable(m_table);
+}
+
+ChReferenceData& ChReferenceData::operator=(const ChReferenceData& other)
+{
+  ChReferenceData tmp(other);
+  std::swap(m_table, tmp.m_table);
+  return *this;
+}
+
+const Headers& ChReferenceData::GetHeaders() const
+{
+  static const Headers empty;
+  return m_table ? m_table->headers : empty;
+}
+
+const Data& ChReferenceData::GetData() const
+{
+  static const Data empty;
+  return m_table ? m_table->data : empty;
+}
+
+size_t ChReferenceData::GetNumRows() const
+{
+  return (m_table && !m_table->data.empty()) ? m_table->data[0].size() : 0;
+}
+
+ChReferenceData ChReferenceCache::Get(const std::string& filename,
+                                      char               delim)
+{
+  std::string path;
+  time_t      mtime;
+  long long   size;
+  std::string entry;   // name of the file in the store of its directory
+
+  // Prefer the packed data (the bundle file of the case, or the store of the
+  // directory) over the text file.
+  if (!FindPackedFile(filename, path, mtime, size, entry) &&
+      !GetFileInfo(filename, path, mtime, size))
+    return ChReferenceData();
+
+  std::string key = path + '|' + entry + '|' + delim;
+
+  ChReferenceData::Table* table = NULL;
+  ChReferenceData::Table* stale = NULL;
+  bool load = false;
+
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_reference_cache)
+#endif
+  {
+    TableMap::iterator itr = cache_tables.find(key);
+
+    // Drop a table parsed from an older version of the file.
+    if (itr != cache_tables.end() && (itr->second->mtime != mtime || itr->second->size != size)) {
+      ChReferenceData::Table* old = itr->second;
+      itr = cache_tables.end();
+      if (Uncache(old))
+        stale = old;
+    }
+
+    if (itr != cache_tables.end()) {
+      table = itr->second;
+      table->refs++;
+      cache_lru.erase(table->lru);
+      cache_lru.push_front(table);
+      table->lru = cache_lru.begin();
+      cache_stats.hits++;
+    } else {
+      // Insert a new table (referenced by the cache and the returned view),
+      // locked until it is parsed.
+      table = NewTable();
+      table->refs = 2;
+      table->cached = true;
+      table->key = key;
+      table->mtime = mtime;
+      table->size = size;
+#ifdef _OPENMP
+      omp_set_lock(&table->load_lock);
+#endif
+      cache_tables[key] = table;
+      cache_lru.push_front(table);
+      table->lru = cache_lru.begin();
+      cache_stats.misses++;
+      load = true;
+    }
+  }
+
+  if (stale)
+    DeleteTable(stale);
+
+  if (load) {
+    ChTraceSpan span(ChTrace::IsEnabled() ? "Read " + filename : std::string(), "io");
+
+    // A packed file is decoded with all other channels of its case.
+    std::vector<std::string> names;
+    std::vector<Headers>     headers;
+    std::vector<Data>        data;
+
+    if (!entry.empty()) {
+      ReadStoreBundle(path, mtime, size, entry, names, headers, data);
+      for (size_t i = 0; i < names.size(); i++) {
+        if (names[i] == entry) {
+          table->headers.swap(headers[i]);
+          table->data.swap(data[i]);
+        }
+      }
+    }
+
+    // Parse the text file if there is no packed data (or it cannot be decoded).
+    std::string text_path;
+    time_t      text_mtime;
+    long long   text_size;
+    if (table->data.empty() && GetFileInfo(filename, text_path, text_mtime, text_size))
+      ChValidation::ReadDataFile(filename, delim, table->headers, table->data);
+
+    std::vector<ChReferenceData::Table*> garbage;
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_reference_cache)
+#endif
+    {
+      table->bytes = TableBytes(table);
+
+      // Cache the other channels of the case (if not cached already), so that
+      // they are available without opening and decoding the store again.
+      for (size_t i = 0; i < names.size(); i++) {
+        std::string sibling_key = path + '|' + names[i] + '|' + delim;
+        if (names[i] == entry || cache_tables.find(sibling_key) != cache_tables.end())
+          continue;
+        ChReferenceData::Table* sibling = NewTable();
+        sibling->cached = true;
+        sibling->key = sibling_key;
+        sibling->mtime = mtime;
+        sibling->size = size;
+        sibling->headers.swap(headers[i]);
+        sibling->data.swap(data[i]);
+        sibling->bytes = TableBytes(sibling);
+        cache_tables[sibling_key] = sibling;
+        cache_lru.push_front(sibling);
+        sibling->lru = cache_lru.begin();
+        cache_bytes += sibling->bytes;
+      }
+
+      if (table->cached) {
+        cache_lru.erase(table->lru);
+        cache_lru.push_front(table);
+        table->lru = cache_lru.begin();
+        cache_bytes += table->bytes;
+      }
+
+      Evict(garbage);
+    }
+
+    for (size_t i = 0; i < garbage.size(); i++)
+      DeleteTable(garbage[i]);
+
+#ifdef _OPENMP
+    omp_unset_lock(&table->load_lock);
+#endif
+  } else {
+    // Wait until the table is parsed (if another thread is still loading it).
+#ifdef _OPENMP
+    omp_set_lock(&table->load_lock);
+    omp_unset_lock(&table->load_lock);
+#endif
+  }
+
+  return ChReferenceData(table);
+}
+
+void ChReferenceCache::SetBudget(size_t bytes)
+{
+  std::vector<ChReferenceData::Table*> garbage;
+
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_reference_cache)
+#endif
+  {
+    cache_budget = bytes;
+    Evict(garbage);
+  }
+
+  for (size_t i = 0; i < garbage.size(); i++)
+    DeleteTable(garbage[i]);
+}
+
+size_t ChReferenceCache::GetBudget()
+{
+  size_t bytes;
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_reference_cache)
+#endif
+  bytes = cache_budget;
+  return bytes;
+}
+
+void ChReferenceCache::Clear()
+{
+  std::vector<ChReferenceData::Table*> garbage;
+
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_reference_cache)
+#endif
+  {
+    while (!cache_lru.empty()) {
+      ChReferenceData::Table* table = cache_lru.back();
+      if (Uncache(table))
+        garbage.push_back(table);
+    }
+  }
+
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_reference_stores)
+#endif
+  {
+    for (StoreMap::iterator itr = cache_stores.begin(); itr != cache_stores.end(); ++itr)
+      delete itr->second.store;
+    cache_stores.clear();
+  }
+
+  for (size_t i = 0; i < garbage.size(); i++)
+    DeleteTable(garbage[i]);
+}
+
+ChReferenceCacheStats ChReferenceCache::GetStats()
+{
+  ChReferenceCacheStats stats;
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_reference_cache)
+#endif
+  {
+    stats = cache_stats;
+    stats.num_tables = cache_tables.size();
+    stats.bytes = cache_bytes;
+  }
+  return stats;
+}
+
+
 // -----------------------------------------------------------------------------
 // Compare the data in the two specified files.
 // The comparison is done using the specified norm type and tolerance. The
 // function returns true if the norms of all column differences are below the
-// given tolerance and false otherwise.
+// given tolerance and false otherwise. Optionally, the simulation data is
+// resampled onto the time grid of the reference data.
 // It is assumed that the input files are TAB-delimited.
 // -----------------------------------------------------------------------------
 bool Validate(const std::string& sim_filename,
               const std::string& ref_filename,
               ChNormType         norm_type,
               double             tolerance,
-              DataVector&        norms
+              DataVector&        norms,
+              ChInterpolation    interp
               )
 {
+  ChTraceSpan span(ChTrace::IsEnabled() ? "Validate " + sim_filename : std::string(), "validate");
   ChValidation validator;
+  validator.SetInterpolation(interp);
 
   if (!validator.Process(sim_filename, ref_filename))
     return false;
@@ -207,6 +889,81 @@ bool Validate(const std::string& sim_filename,
 }
 
 
+// -----------------------------------------------------------------------------
+// Compare the data in the specified simulation file against reference data
+// already in memory.
+// -----------------------------------------------------------------------------
+bool Validate(const std::string& sim_filename,
+              const Headers&     ref_headers,
+              const Data&        ref_data,
+              ChNormType         norm_type,
+              double             tolerance,
+              DataVector&        norms,
+              ChInterpolation    interp
+              )
+{
+  ChTraceSpan span(ChTrace::IsEnabled() ? "Validate " + sim_filename : std::string(), "validate");
+  ChValidation validator;
+  validator.SetInterpolation(interp);
+
+  if (!validator.Process(sim_filename, ref_headers, ref_data))
+    return false;
+
+  size_t num_cols = validator.GetNumColumns() - 1;
+  norms.resize(num_cols);
+
+  switch (norm_type) {
+  case L2_NORM:  norms = validator.GetL2norms(); break;
+  case RMS_NORM: norms = validator.GetRMSnorms(); break;
+  case INF_NORM: norms = validator.GetINFnorms(); break;
+  }
+
+  for (size_t col = 0; col < num_cols; col++) {
+    if (norms[col] > tolerance)
+      return false;
+  }
+
+  return true;
+}
+
+
+// -----------------------------------------------------------------------------
+// Compare simulation data and reference data both already in memory.
+// -----------------------------------------------------------------------------
+bool Validate(const Headers&  sim_headers,
+              const Data&     sim_data,
+              const Headers&  ref_headers,
+              const Data&     ref_data,
+              ChNormType      norm_type,
+              double          tolerance,
+              DataVector&     norms,
+              ChInterpolation interp
+              )
+{
+  ChValidation validator;
+  validator.SetInterpolation(interp);
+
+  if (!validator.Process(sim_headers, sim_data, ref_headers, ref_data))
+    return false;
+
+  size_t num_cols = validator.GetNumColumns() - 1;
+  norms.resize(num_cols);
+
+  switch (norm_type) {
+  case L2_NORM:  norms = validator.GetL2norms(); break;
+  case RMS_NORM: norms = validator.GetRMSnorms(); break;
+  case INF_NORM: norms = validator.GetINFnorms(); break;
+  }
+
+  for (size_t col = 0; col < num_cols; col++) {
+    if (norms[col] > tolerance)
+      return false;
+  }
+
+  return true;
+}
+
+
 // -----------------------------------------------------------------------------
 // Validation of a constraint violation data file.
 // The validation is done using the specified norm type and tolerance. The
@@ -219,6 +976,7 @@ bool Validate(const std::string& sim_filename,
               double             tolerance,
               DataVector&        norms)
 {
+  ChTraceSpan span(ChTrace::IsEnabled() ? "Validate " + sim_filename : std::string(), "validate");
   ChValidation validator;
 
   if (!validator.Process(sim_filename))
@@ -242,6 +1000,38 @@ bool Validate(const std::string& sim_filename,
 }
 
 
+// -----------------------------------------------------------------------------
+// Validation of constraint violation data already in memory.
+// -----------------------------------------------------------------------------
+bool Validate(const Headers& sim_headers,
+              const Data&    sim_data,
+              ChNormType     norm_type,
+              double         tolerance,
+              DataVector&    norms)
+{
+  ChValidation validator;
+
+  if (!validator.Process(sim_headers, sim_data))
+    return false;
+
+  size_t num_cols = validator.GetNumColumns() - 1;
+  norms.resize(num_cols);
+
+  switch (norm_type) {
+  case L2_NORM:  norms = validator.GetL2norms(); break;
+  case RMS_NORM: norms = validator.GetRMSnorms(); break;
+  case INF_NORM: norms = validator.GetINFnorms(); break;
+  }
+
+  for (size_t col = 0; col < num_cols; col++) {
+    if (norms[col] > tolerance)
+      return false;
+  }
+
+  return true;
+}
+
+
 // -----------------------------------------------------------------------------
 // Functions for manipulating the validation data directory
 // -----------------------------------------------------------------------------
@@ -251,20 +1041,28 @@ static std::string validation_data_path("../data/");
 // Set the path to the directory containing reference validation data.
 void SetValidationDataPath(const std::string& path)
 {
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_data_path)
+#endif
   validation_data_path = path;
 }
 
 // Obtain the current path to the directory containing reference validation data.
-const std::string& GetValidationDataPath()
+std::string GetValidationDataPath()
 {
-  return validation_data_path;
+  std::string path;
+#ifdef _OPENMP
+#pragma omp critical(ch_utils_data_path)
+#endif
+  path = validation_data_path;
+  return path;
 }
 
 // Obtain the complete path to the specified filename, given relative to the
 // directory containing reference validation data.
 std::string GetValidationDataFile(const std::string& filename)
 {
-  return validation_data_path + filename;
+  return GetValidationDataPath() + filename;
 }
 
 }  // namespace utils
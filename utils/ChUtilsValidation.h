@@ -42,6 +42,13 @@ enum ChNormType {
   INF_NORM
 };
 
+/// Interpolation of simulation data onto the time grid of the reference data
+enum ChInterpolation {
+  INTERP_NONE,      ///< no resampling: the time columns must match
+  INTERP_LINEAR,    ///< piecewise linear
+  INTERP_HERMITE    ///< cubic Hermite, with finite-difference slopes
+};
+
 /// Vector of data file headers.
 typedef std::vector<std::string> Headers;
 
@@ -59,24 +66,50 @@ typedef std::vector<DataVector>  Data;
 /// columns.
 /// In either case, it is assumed that the first column in a data file contains
 /// time values.  This column is never processed.
+/// If an interpolation type is set, the simulation data may be given on any
+/// increasing time grid covering the reference times: it is then resampled
+/// onto the time grid of the reference data before comparison.
 ///
 class CH_UTILS_API ChValidation
 {
 public:
 
-  ChValidation() {}
+  ChValidation() : m_interp(INTERP_NONE) {}
   ~ChValidation() {}
 
+  /// Set the interpolation of simulation data with a time grid different from
+  /// that of the reference data (default: INTERP_NONE, no resampling).
+  void SetInterpolation(ChInterpolation interp) { m_interp = interp; }
+
   /// Read the data from the specified files and process it.
   /// Excluding the first column (which must contain identical values in the two
-  /// input files), we subtract the data in corresponding columns in the two
-  /// files are and calculate the norms of the difference vectors.
+  /// input files, unless resampling is enabled), we subtract the data in
+  /// corresponding columns in the two files are and calculate the norms of the
+  /// difference vectors.
   bool Process(
     const std::string& sim_filename,    ///< name of the file with simulation results
     const std::string& ref_filename,    ///< name of the file with reference data
     char               delim = '\t'     ///< delimiter (default TAB)
     );
 
+  /// Read the data from the specified simulation file and process it against
+  /// reference data already in memory (e.g. shared by several validations).
+  bool Process(
+    const std::string& sim_filename,    ///< name of the file with simulation results
+    const Headers&     ref_headers,     ///< column headers of the reference data
+    const Data&        ref_data,        ///< reference data
+    char               delim = '\t'     ///< delimiter (default TAB)
+    );
+
+  /// Process simulation data and reference data both already in memory (e.g.
+  /// simulation results recorded without output files).
+  bool Process(
+    const Headers&     sim_headers,     ///< column headers of the simulation data
+    const Data&        sim_data,        ///< simulation data
+    const Headers&     ref_headers,     ///< column headers of the reference data
+    const Data&        ref_data         ///< reference data
+    );
+
   /// Read the data in the specified file and process it.
   /// We calculate the vector norms of all columns except the first one.
   bool Process(
@@ -84,6 +117,13 @@ public:
     char               delim = '\t'     ///< delimiter (default TAB)
     );
 
+  /// Process simulation data already in memory.
+  /// We calculate the vector norms of all columns except the first one.
+  bool Process(
+    const Headers&     sim_headers,     ///< column headers of the simulation data
+    const Data&        sim_data         ///< simulation data
+    );
+
   /// Return the number of data columns.
   size_t GetNumColumns() const { return m_num_cols; }
   /// Return the number of rows.
@@ -91,7 +131,7 @@ public:
 
   /// Return the headers in the simulation data file.
   const Headers& GetHeadersSimData() const { return m_sim_headers; }
-  /// Return the simulation data.
+  /// Return the simulation data (after resampling, if any).
   const Data& GetSimData() const { return m_sim_data; }
 
   /// Return the headers in the reference data file.
@@ -125,10 +165,16 @@ public:
 
 private:
 
+  bool Compare(const std::string& sim_name, const std::string& ref_name, size_t num_ref_rows);
+  bool ColumnNorms();
+  bool Resample(const std::string& sim_name);
+
   double L2norm(const DataVector& v);
   double RMSnorm(const DataVector& v);
   double INFnorm(const DataVector& v);
 
+  ChInterpolation m_interp;
+
   size_t m_num_cols;
   size_t m_num_rows;
 
@@ -143,15 +189,103 @@ private:
   DataVector m_INF_norms;
 };
 
+///
+/// Shared, immutable view of a reference data table (column headers and data),
+/// as returned by the reference data cache. Copies of a view share the same
+/// table, which remains valid as long as some view refers to it (even after it
+/// was evicted from the cache). Views can be copied and released from any
+/// thread.
+///
+class CH_UTILS_API ChReferenceData
+{
+public:
+
+  ChReferenceData() : m_table(0) {}
+  /// Create a view of a copy of the given table (not held by the cache).
+  ChReferenceData(const Headers& headers, const Data& data);
+  ChReferenceData(const ChReferenceData& other);
+  ~ChReferenceData();
+
+  ChReferenceData& operator=(const ChReferenceData& other);
+
+  /// Return true if this view does not refer to any table.
+  bool IsNull() const { return m_table == 0; }
+
+  /// Return the column headers (empty for a null view).
+  const Headers& GetHeaders() const;
+  /// Return the data (empty for a null view).
+  const Data& GetData() const;
+  /// Return the number of rows.
+  size_t GetNumRows() const;
+
+  struct Table;
+
+private:
+
+  explicit ChReferenceData(Table* table) : m_table(table) {}
+
+  Table* m_table;
+
+  friend class ChReferenceCache;
+};
+
+/// Statistics of the reference data cache.
+struct CH_UTILS_API ChReferenceCacheStats {
+  size_t hits;        ///< lookups satisfied by a cached table
+  size_t misses;      ///< lookups which parsed the file
+  size_t evictions;   ///< tables evicted to stay within the memory budget
+  size_t num_tables;  ///< number of tables currently cached
+  size_t bytes;       ///< (estimated) memory used by the cached tables
+};
+
+///
+/// Process-wide cache of parsed reference data files.
+/// Tables are keyed by the canonical path of the file (and the delimiter), and
+/// are parsed again only if the modification time or size of the file changed.
+/// Each file is parsed at most once, even if requested concurrently. The least
+/// recently used tables are evicted when the cached tables exceed the memory
+/// budget. All functions are safe to call from OpenMP worker threads; in a
+/// build without OpenMP they are not synchronized (and must not be called
+/// concurrently from other threads).
+///
+class CH_UTILS_API ChReferenceCache
+{
+public:
+
+  /// Return a view of the data in the specified file, loading it if it is not
+  /// cached. The file is decoded from the bundle file of its case or from the
+  /// packed store of its directory if either contains it (see
+  /// ChReferenceStore; stores hold TAB-delimited files), and all other
+  /// channels of the case are cached with it. Otherwise the text file is
+  /// parsed (see ChValidation::ReadDataFile). Returns a null view if none
+  /// exists.
+  static ChReferenceData Get(const std::string& filename,
+                             char               delim = '\t');
+
+  /// Set the memory budget of the cache, in bytes (default 256 MB).
+  static void SetBudget(size_t bytes);
+  /// Return the memory budget of the cache, in bytes.
+  static size_t GetBudget();
+
+  /// Remove all tables from the cache, and close all stores (views in use
+  /// remain valid).
+  static void Clear();
+
+  /// Return the cache statistics.
+  static ChReferenceCacheStats GetStats();
+};
+
 // -----------------------------------------------------------------------------
 // Free function declarations
 // -----------------------------------------------------------------------------
 
 ///
 /// Compare the data in the two specified files.
+/// The reference data is obtained through the reference data cache.
 /// The comparison is done using the specified norm type and tolerance. The
 /// function returns true if the norms of all column differences are below the
-/// given tolerance and false otherwise.
+/// given tolerance and false otherwise. Optionally, the simulation data is
+/// resampled onto the time grid of the reference data.
 /// It is assumed that the input files are TAB-delimited.
 ///
 CH_UTILS_API
@@ -160,7 +294,46 @@ bool Validate(
           const std::string& ref_filename,
           ChNormType         norm_type,
           double             tolerance,
-          DataVector&        norms
+          DataVector&        norms,
+          ChInterpolation    interp = INTERP_NONE
+          );
+
+///
+/// Compare the data in the specified simulation file against reference data
+/// already in memory (see ChValidation::ReadDataFile).
+/// The comparison is done using the specified norm type and tolerance. The
+/// function returns true if the norms of all column differences are below the
+/// given tolerance and false otherwise. Optionally, the simulation data is
+/// resampled onto the time grid of the reference data.
+///
+CH_UTILS_API
+bool Validate(
+          const std::string& sim_filename,
+          const Headers&     ref_headers,
+          const Data&        ref_data,
+          ChNormType         norm_type,
+          double             tolerance,
+          DataVector&        norms,
+          ChInterpolation    interp = INTERP_NONE
+          );
+
+///
+/// Compare simulation data and reference data both already in memory.
+/// The comparison is done using the specified norm type and tolerance. The
+/// function returns true if the norms of all column differences are below the
+/// given tolerance and false otherwise. Optionally, the simulation data is
+/// resampled onto the time grid of the reference data.
+///
+CH_UTILS_API
+bool Validate(
+          const Headers&     sim_headers,
+          const Data&        sim_data,
+          const Headers&     ref_headers,
+          const Data&        ref_data,
+          ChNormType         norm_type,
+          double             tolerance,
+          DataVector&        norms,
+          ChInterpolation    interp = INTERP_NONE
           );
 
 ///
@@ -178,22 +351,35 @@ bool Validate(
           DataVector&        norms
           );
 
+///
+/// Validation of constraint violation data already in memory (same as above).
+///
+CH_UTILS_API
+bool Validate(
+          const Headers&     sim_headers,
+          const Data&        sim_data,
+          ChNormType         norm_type,
+          double             tolerance,
+          DataVector&        norms
+          );
+
 // -----------------------------------------------------------------------------
 // Global functions for accessing the reference validation data.
 // -----------------------------------------------------------------------------
 
 /// Set the path to the reference validation data directory.
-/// (ATTENTION: not thread safe)
+/// (safe to call from OpenMP worker threads)
 CH_UTILS_API void SetValidationDataPath(const std::string& path);
 
 /// Obtain the current path to the reference validation data directory.
-/// (thread safe)
-CH_UTILS_API const std::string& GetValidationDataPath();
+/// The path is returned by value, so that it remains valid if another thread
+/// changes it. (safe to call from OpenMP worker threads)
+CH_UTILS_API std::string GetValidationDataPath();
 
 /// Obtain the complete path to the specified filename.
 /// The given filename is assumed to be relative to the reference validation
 /// data directory.
-/// (thread safe)
+/// (safe to call from OpenMP worker threads)
 CH_UTILS_API std::string GetValidationDataFile(const std::string& filename);
 
 